@@ -0,0 +1,97 @@
+// Constexpr-heavy input for timing constant evaluation. Every function is in
+// the subset -fexperimental-constexpr-interpreter handles, so comparing
+//   clang -cc1 -fsyntax-only -std=c++14 constexpr-interpreter.cpp
+//   clang -cc1 -fsyntax-only -std=c++14 -fexperimental-constexpr-interpreter \
+//     constexpr-interpreter.cpp
+// compares the bytecode interpreter with the tree-walking evaluator. Each
+// evaluation stays under the default -fconstexpr-steps.
+
+constexpr unsigned long long Modulus = 1000000007;
+
+constexpr bool is_prime(unsigned n) {
+  if (n < 2)
+    return false;
+  for (unsigned d = 2; d * d <= n; ++d)
+    if (n % d == 0)
+      return false;
+  return true;
+}
+
+constexpr unsigned count_primes(unsigned lo, unsigned hi) {
+  unsigned count = 0;
+  for (unsigned n = lo; n < hi; ++n)
+    if (is_prime(n))
+      ++count;
+  return count;
+}
+
+constexpr unsigned collatz_length(unsigned long long n) {
+  unsigned length = 0;
+  while (n != 1) {
+    n = n % 2 ? 3 * n + 1 : n / 2;
+    ++length;
+  }
+  return length;
+}
+
+constexpr unsigned longest_collatz(unsigned lo, unsigned hi) {
+  unsigned longest = 0;
+  for (unsigned n = lo; n < hi; ++n) {
+    unsigned length = collatz_length(n);
+    if (length > longest)
+      longest = length;
+  }
+  return longest;
+}
+
+constexpr unsigned long long fib_mod(unsigned n) {
+  unsigned long long a = 0, b = 1;
+  for (unsigned i = 0; i != n; ++i) {
+    unsigned long long c = (a + b) % Modulus;
+    a = b;
+    b = c;
+  }
+  return a;
+}
+
+constexpr unsigned long long gcd(unsigned long long a, unsigned long long b) {
+  while (b != 0) {
+    unsigned long long r = a % b;
+    a = b;
+    b = r;
+  }
+  return a;
+}
+
+constexpr unsigned long long sum_gcd(unsigned lo, unsigned hi) {
+  unsigned long long sum = 0;
+  for (unsigned i = lo; i < hi; ++i)
+    for (unsigned j = 1; j <= 64; ++j)
+      sum += gcd(i, j);
+  return sum;
+}
+
+static_assert(count_primes(0, 1000) == 168, "");
+static_assert(collatz_length(27) == 111, "");
+static_assert(fib_mod(90) == 2880067194370816120ULL % Modulus, "");
+static_assert(gcd(1071, 462) == 21, "");
+
+#define EVALUATE(N)                                                            \
+  constexpr unsigned primes_##N = count_primes(N * 1000, N * 1000 + 1000);    \
+  constexpr unsigned collatz_##N = longest_collatz(N * 100 + 1, N * 100 + 101);\
+  constexpr unsigned long long fib_##N = fib_mod(N * 1000 + 1000);            \
+  constexpr unsigned long long gcd_##N = sum_gcd(N * 50 + 1, N * 50 + 51);
+
+#define EVALUATE_10(N)                                                         \
+  EVALUATE(N##0) EVALUATE(N##1) EVALUATE(N##2) EVALUATE(N##3) EVALUATE(N##4)   \
+  EVALUATE(N##5) EVALUATE(N##6) EVALUATE(N##7) EVALUATE(N##8) EVALUATE(N##9)
+
+EVALUATE_10(1)
+EVALUATE_10(2)
+EVALUATE_10(3)
+EVALUATE_10(4)
+EVALUATE_10(5)
+EVALUATE_10(6)
+EVALUATE_10(7)
+EVALUATE_10(8)
+EVALUATE_10(9)
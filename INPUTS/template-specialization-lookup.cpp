@@ -0,0 +1,56 @@
+// Stresses the lookup of template specializations with long argument packs,
+// as in type-list metaprogramming. Every element access walks a list of up to
+// 200 types, naming each of its suffixes, so most lookups find a
+// specialization which already exists. Time
+//   clang -cc1 -fsyntax-only -std=c++11 template-specialization-lookup.cpp
+// to compare implementations of specialization lookup.
+
+template <typename... Ts> struct list {};
+template <int N> struct tag {};
+
+template <typename T, typename U> struct is_same {
+  static const bool value = false;
+};
+template <typename T> struct is_same<T, T> { static const bool value = true; };
+
+template <typename L, typename T> struct push_back;
+template <typename... Ts, typename T> struct push_back<list<Ts...>, T> {
+  typedef list<Ts..., T> type;
+};
+
+// list<tag<0>, ..., tag<N - 1>>, built one element at a time.
+template <int N> struct make_list {
+  typedef typename push_back<typename make_list<N - 1>::type,
+                             tag<N - 1> >::type type;
+};
+template <> struct make_list<0> { typedef list<> type; };
+
+// The element at index I of the list L.
+template <typename L, int I> struct at;
+template <typename T, typename... Ts, int I>
+struct at<list<T, Ts...>, I> : at<list<Ts...>, I - 1> {};
+template <typename T, typename... Ts> struct at<list<T, Ts...>, 0> {
+  typedef T type;
+};
+
+template <typename... Ts> constexpr int length(list<Ts...>) {
+  return sizeof...(Ts);
+}
+
+typedef make_list<200>::type big;
+
+#define CHECK(I)                                                               \
+  static_assert(is_same<at<big, I>::type, tag<I> >::value, "");               \
+  static_assert(length(make_list<I>::type()) == I, "");
+#define CHECK_10(I)                                                            \
+  CHECK(I##0) CHECK(I##1) CHECK(I##2) CHECK(I##3) CHECK(I##4)                  \
+  CHECK(I##5) CHECK(I##6) CHECK(I##7) CHECK(I##8) CHECK(I##9)
+#define CHECK_200                                                              \
+  CHECK_10() CHECK_10(1) CHECK_10(2) CHECK_10(3) CHECK_10(4) CHECK_10(5)       \
+  CHECK_10(6) CHECK_10(7) CHECK_10(8) CHECK_10(9) CHECK_10(10) CHECK_10(11)    \
+  CHECK_10(12) CHECK_10(13) CHECK_10(14) CHECK_10(15) CHECK_10(16)             \
+  CHECK_10(17) CHECK_10(18) CHECK_10(19)
+
+// The second pass only looks up specializations made by the first.
+namespace first { CHECK_200 }
+namespace second { CHECK_200 }
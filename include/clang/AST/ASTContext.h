@@ -61,6 +61,8 @@ namespace clang {
   class SelectorTable;
   class TargetInfo;
   class CXXABI;
+  class ConstexprCallCache;
+  class ConstexprInterpreter;
   class MangleNumberingContext;
   // Decls
   class MangleContext;
@@ -574,6 +576,11 @@ public:
   size_t getASTAllocatedMemory() const {
     return BumpAlloc.getTotalMemory();
   }
+  /// Return the number of bytes of AST nodes and type information allocated
+  /// so far, as opposed to the slabs reserved for them.
+  size_t getASTAllocatedBytes() const {
+    return BumpAlloc.getBytesAllocated();
+  }
   /// Return the total memory used for various side tables.
   size_t getSideTableAllocatedMemory() const;
   
@@ -1926,6 +1933,14 @@ public:
 
   VTableContextBase *getVTableContext();
 
+  /// \brief Returns the interpreter used to evaluate constexpr calls with
+  /// -fexperimental-constexpr-interpreter.
+  ConstexprInterpreter &getConstexprInterpreter();
+
+  /// \brief Returns the results of constexpr calls memoized by the constant
+  /// evaluator.
+  ConstexprCallCache &getConstexprCallCache();
+
   MangleContext *createMangleContext();
   
   void DeepCollectObjCIvars(const ObjCInterfaceDecl *OI, bool leafClass,
@@ -2545,6 +2560,10 @@ private:
 
   std::unique_ptr<VTableContextBase> VTContext;
 
+  std::unique_ptr<ConstexprInterpreter> ConstexprInterp;
+
+  std::unique_ptr<ConstexprCallCache> ConstexprCalls;
+
 public:
   enum PragmaSectionFlag : unsigned {
     PSF_None = 0,
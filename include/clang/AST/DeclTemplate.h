@@ -18,6 +18,7 @@
 #include "clang/AST/DeclCXX.h"
 #include "clang/AST/Redeclarable.h"
 #include "clang/AST/TemplateBase.h"
+#include "llvm/ADT/FoldingSet.h"
 #include "llvm/ADT/PointerUnion.h"
 #include "llvm/Support/Compiler.h"
 #include "llvm/Support/TrailingObjects.h"
@@ -38,6 +39,68 @@ class TemplateTemplateParmDecl;
 class TypeAliasTemplateDecl;
 class VarTemplateDecl;
 class VarTemplatePartialSpecializationDecl;
+class FunctionTemplateSpecializationInfo;
+class ClassTemplateSpecializationDecl;
+class VarTemplateSpecializationDecl;
+
+/// \brief The FoldingSetTrait of the specializations of a template, which
+/// caches the hash of their template arguments in the specializations.
+///
+/// A FoldingSet profiles every node it compares a lookup against, and every
+/// node when it grows. Profiling a long list of template arguments, such as a
+/// deep argument pack, is expensive, so only the nodes whose cached hash
+/// matches the lookup are profiled again.
+template <typename EntryType> struct SpecializationFoldingSetTrait {
+  static void Profile(EntryType &X, llvm::FoldingSetNodeID &ID) {
+    X.Profile(ID);
+  }
+
+  static unsigned ComputeHash(EntryType &X, llvm::FoldingSetNodeID &TempID) {
+    // A hash of 0 is indistinguishable from one not computed yet, and is
+    // just recomputed.
+    if (!X.ArgumentsHash) {
+      X.Profile(TempID);
+      X.ArgumentsHash = TempID.ComputeHash();
+    }
+    return X.ArgumentsHash;
+  }
+
+  static bool Equals(EntryType &X, const llvm::FoldingSetNodeID &ID,
+                     unsigned IDHash, llvm::FoldingSetNodeID &TempID) {
+    if (ComputeHash(X, TempID) != IDHash)
+      return false;
+    TempID.clear();
+    X.Profile(TempID);
+    return TempID == ID;
+  }
+};
+
+} // end namespace clang
+
+namespace llvm {
+template <>
+struct FoldingSetTrait<clang::FunctionTemplateSpecializationInfo>
+    : clang::SpecializationFoldingSetTrait<
+          clang::FunctionTemplateSpecializationInfo> {};
+template <>
+struct FoldingSetTrait<clang::ClassTemplateSpecializationDecl>
+    : clang::SpecializationFoldingSetTrait<
+          clang::ClassTemplateSpecializationDecl> {};
+template <>
+struct FoldingSetTrait<clang::ClassTemplatePartialSpecializationDecl>
+    : clang::SpecializationFoldingSetTrait<
+          clang::ClassTemplatePartialSpecializationDecl> {};
+template <>
+struct FoldingSetTrait<clang::VarTemplateSpecializationDecl>
+    : clang::SpecializationFoldingSetTrait<
+          clang::VarTemplateSpecializationDecl> {};
+template <>
+struct FoldingSetTrait<clang::VarTemplatePartialSpecializationDecl>
+    : clang::SpecializationFoldingSetTrait<
+          clang::VarTemplatePartialSpecializationDecl> {};
+} // end namespace llvm
+
+namespace clang {
 
 /// \brief Stores a template parameter of any kind.
 typedef llvm::PointerUnion3<TemplateTypeParmDecl*, NonTypeTemplateParmDecl*,
@@ -408,7 +471,7 @@ class FunctionTemplateSpecializationInfo : public llvm::FoldingSetNode {
     Template(Template, TSK - 1),
     TemplateArguments(TemplateArgs),
     TemplateArgumentsAsWritten(TemplateArgsAsWritten),
-    PointOfInstantiation(POI) { }
+    PointOfInstantiation(POI), ArgumentsHash(0) { }
 
 public:
   static FunctionTemplateSpecializationInfo *
@@ -439,6 +502,10 @@ public:
   /// first instantiated.
   SourceLocation PointOfInstantiation;
 
+  /// \brief The hash of the profile of the template arguments, or 0 if it
+  /// has not been computed yet.
+  unsigned ArgumentsHash;
+
   /// \brief Retrieve the template from which this function was specialized.
   FunctionTemplateDecl *getTemplate() const { return Template.getPointer(); }
 
@@ -1577,6 +1644,12 @@ class ClassTemplateSpecializationDecl
   /// Really a value of type TemplateSpecializationKind.
   unsigned SpecializationKind : 3;
 
+  /// \brief The hash of the profile of the template arguments, or 0 if it
+  /// has not been computed yet.
+  unsigned ArgumentsHash;
+
+  template <typename EntryType> friend struct SpecializationFoldingSetTrait;
+
 protected:
   ClassTemplateSpecializationDecl(ASTContext &Context, Kind DK, TagKind TK,
                                   DeclContext *DC, SourceLocation StartLoc,
@@ -2432,6 +2505,12 @@ class VarTemplateSpecializationDecl : public VarDecl,
   /// Really a value of type TemplateSpecializationKind.
   unsigned SpecializationKind : 3;
 
+  /// \brief The hash of the profile of the template arguments, or 0 if it
+  /// has not been computed yet.
+  unsigned ArgumentsHash;
+
+  template <typename EntryType> friend struct SpecializationFoldingSetTrait;
+
 protected:
   VarTemplateSpecializationDecl(Kind DK, ASTContext &Context, DeclContext *DC,
                                 SourceLocation StartLoc, SourceLocation IdLoc,
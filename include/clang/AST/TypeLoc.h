@@ -712,7 +712,7 @@ struct AttributedLocInfo {
     Expr *ExprOperand;
 
     /// A raw SourceLocation.
-    unsigned EnumOperandLoc;
+    SourceLocation::UIntTy EnumOperandLoc;
   };
 
   SourceRange OperandParens;
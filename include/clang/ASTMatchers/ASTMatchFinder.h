@@ -121,6 +121,10 @@ public:
   };
 
   struct MatchFinderOptions {
+    MatchFinderOptions()
+        : MaxMemoizationEntries(10000), MemoizationStats(nullptr),
+          NumThreads(1) {}
+
     struct Profiling {
       Profiling(llvm::StringMap<llvm::TimeRecord> &Records)
           : Records(Records) {}
@@ -133,6 +137,58 @@ public:
     ///
     /// It prints a report after match.
     llvm::Optional<Profiling> CheckProfiling;
+
+    /// \brief Counters for the memoization of recursive matches, such as
+    /// \c hasDescendant() or \c hasAncestor().
+    struct MemoizationStatistics {
+      MemoizationStatistics() : Hits(0), Misses(0), Evictions(0) {}
+
+      MemoizationStatistics &operator+=(const MemoizationStatistics &Other) {
+        Hits += Other.Hits;
+        Misses += Other.Misses;
+        Evictions += Other.Evictions;
+        return *this;
+      }
+
+      /// \brief Number of matches whose result was memoized.
+      uint64_t Hits;
+      /// \brief Number of matches that had to be computed.
+      uint64_t Misses;
+      /// \brief Number of results dropped to stay within
+      /// \c MaxMemoizationEntries.
+      uint64_t Evictions;
+    };
+
+    /// \brief Maximum number of memoized match results kept while matching.
+    ///
+    /// Once the limit is reached, the least recently used result is evicted.
+    /// The default has been found to give a good trade-off of performance
+    /// vs. memory consumption by running matchers that match on every
+    /// statement over a very large codebase.
+    unsigned MaxMemoizationEntries;
+
+    /// \brief If set, the memoization counters of every match are added
+    /// to it.
+    MemoizationStatistics *MemoizationStats;
+
+    /// \brief Number of threads \c matchAST() spreads the top-level
+    /// declarations of a translation unit across.
+    ///
+    /// Every thread traverses its share of the AST with its own memoization
+    /// state, so matchers must only read the AST. The state that matchers
+    /// would otherwise compute lazily, the parent map of \c hasParent() and
+    /// \c hasAncestor() and the type aliases of \c hasDeclaration(), is built
+    /// before the threads start. Matchers that trigger a cache of the
+    /// ASTContext or the AST nodes, such as SourceManager queries, linkage or
+    /// constant evaluation, hold a lock shared by the threads (see
+    /// \c internal::ASTContextLock). Translation units with an external AST
+    /// source (e.g. a PCH or modules) are always matched on the calling
+    /// thread, as they may be deserialized lazily.
+    ///
+    /// Matches are buffered, and the callbacks are run on the calling thread
+    /// in the usual traversal order once all threads are done, so callbacks
+    /// need not be thread-safe.
+    unsigned NumThreads;
   };
 
   MatchFinder(MatchFinderOptions Options = MatchFinderOptions());
@@ -202,6 +258,10 @@ public:
   struct MatchersByType {
     std::vector<std::pair<internal::DynTypedMatcher, MatchCallback *>>
         DeclOrStmt;
+    /// \brief For each matcher in \c DeclOrStmt, the identifiers one of which
+    /// a node must be named by for it to match, or an empty list if the
+    /// matcher can match nodes of any name.
+    std::vector<std::vector<std::string>> DeclOrStmtNames;
     std::vector<std::pair<TypeMatcher, MatchCallback *>> Type;
     std::vector<std::pair<NestedNameSpecifierMatcher, MatchCallback *>>
         NestedNameSpecifier;
@@ -208,6 +208,7 @@ const internal::VariadicDynCastAllOfMatcher<Decl, TypeAliasDecl> typeAliasDecl;
 /// Usable as: Matcher<Decl>, Matcher<Stmt>, Matcher<TypeLoc>
 AST_POLYMORPHIC_MATCHER(isExpansionInMainFile,
                         AST_POLYMORPHIC_SUPPORTED_TYPES(Decl, Stmt, TypeLoc)) {
+  internal::ASTContextLock Lock(*Finder);
   auto &SourceManager = Finder->getASTContext().getSourceManager();
   return SourceManager.isInMainFile(
       SourceManager.getExpansionLoc(Node.getLocStart()));
@@ -229,6 +230,7 @@ AST_POLYMORPHIC_MATCHER(isExpansionInMainFile,
 /// Usable as: Matcher<Decl>, Matcher<Stmt>, Matcher<TypeLoc>
 AST_POLYMORPHIC_MATCHER(isExpansionInSystemHeader,
                         AST_POLYMORPHIC_SUPPORTED_TYPES(Decl, Stmt, TypeLoc)) {
+  internal::ASTContextLock Lock(*Finder);
   auto &SourceManager = Finder->getASTContext().getSourceManager();
   auto ExpansionLoc = SourceManager.getExpansionLoc(Node.getLocStart());
   if (ExpansionLoc.isInvalid()) {
@@ -255,6 +257,7 @@ AST_POLYMORPHIC_MATCHER(isExpansionInSystemHeader,
 AST_POLYMORPHIC_MATCHER_P(isExpansionInFileMatching,
                           AST_POLYMORPHIC_SUPPORTED_TYPES(Decl, Stmt, TypeLoc),
                           std::string, RegExp) {
+  internal::ASTContextLock Lock(*Finder);
   auto &SourceManager = Finder->getASTContext().getSourceManager();
   auto ExpansionLoc = SourceManager.getExpansionLoc(Node.getLocStart());
   if (ExpansionLoc.isInvalid()) {
@@ -3183,6 +3186,8 @@ AST_MATCHER_P(FunctionDecl, returns,
 /// functionDecl(isExternC())
 ///   matches the declaration of f and g, but not the declaration h
 AST_MATCHER(FunctionDecl, isExternC) {
+  // The linkage is computed on demand and cached in the declaration.
+  internal::ASTContextLock Lock(*Finder);
   return Node.isExternC();
 }
 
@@ -3237,6 +3242,9 @@ AST_MATCHER(FunctionDecl, isNoThrow) {
   if (isUnresolvedExceptionSpec(FnTy->getExceptionSpecType()))
     return true;
 
+  // A noexcept expression goes through the constant evaluator, which caches
+  // its results in the ASTContext.
+  internal::ASTContextLock Lock(*Finder);
   return FnTy->isNothrow(Node.getASTContext());
 }
 
@@ -50,6 +50,7 @@
 #include "llvm/ADT/Optional.h"
 #include "llvm/ADT/SmallVector.h"
 #include "llvm/Support/ManagedStatic.h"
+#include "llvm/Support/Mutex.h"
 #include <map>
 #include <string>
 #include <vector>
@@ -246,6 +247,15 @@ public:
   virtual bool dynMatches(const ast_type_traits::DynTypedNode &DynNode,
                           ASTMatchFinder *Finder,
                           BoundNodesTreeBuilder *Builder) const = 0;
+
+  /// \brief Collects the identifiers a node must be named by for this matcher
+  /// to match it.
+  ///
+  /// Returns false if the matcher can match nodes of any name. Otherwise, adds
+  /// the identifiers to \p Names, one of which a matching node must have.
+  virtual bool getRequiredNames(std::vector<std::string> &Names) const {
+    return false;
+  }
 };
 
 /// \brief Generic interface for matchers on an AST node of type T.
@@ -359,6 +369,14 @@ public:
                           ASTMatchFinder *Finder,
                           BoundNodesTreeBuilder *Builder) const;
 
+  /// \brief Collects the identifiers a node must be named by for this matcher
+  /// to match it.
+  ///
+  /// \return \c false if this matcher can match nodes of any name.
+  bool getRequiredNames(std::vector<std::string> &Names) const {
+    return Implementation->getRequiredNames(Names);
+  }
+
   /// \brief Bind the specified \p ID to the matcher.
   /// \return A new matcher with the \p ID bound to it if this matcher supports
   ///   binding. Otherwise, returns an empty \c Optional<>.
@@ -668,6 +686,8 @@ class HasNameMatcher : public SingleNodeMatcherInterface<NamedDecl> {
 
   bool matchesNode(const NamedDecl &Node) const override;
 
+  bool getRequiredNames(std::vector<std::string> &Result) const override;
+
  private:
   /// \brief Unqualified match routine.
   ///
@@ -924,6 +944,11 @@ public:
 
   virtual ASTContext &getASTContext() const = 0;
 
+  /// \brief Returns the mutex that serializes the queries of lazily computed
+  /// AST state when matching on several threads, or null when matching on
+  /// one.
+  virtual llvm::sys::Mutex *getASTContextMutex() const { return nullptr; }
+
 protected:
   virtual bool matchesChildOf(const ast_type_traits::DynTypedNode &Node,
                               const DynTypedMatcher &Matcher,
@@ -942,6 +967,31 @@ protected:
                                  AncestorMatchMode MatchMode) = 0;
 };
 
+/// \brief Holds the ASTContext mutex of an ASTMatchFinder, if it has one,
+/// while a matcher queries state that is computed on demand.
+///
+/// The SourceManager, the linkage computation and the constant evaluator
+/// cache their results in the ASTContext or the AST nodes, so two threads
+/// must not query them at once.
+class ASTContextLock {
+  llvm::sys::Mutex *Mutex;
+
+  ASTContextLock(const ASTContextLock &) = delete;
+  void operator=(const ASTContextLock &) = delete;
+
+public:
+  explicit ASTContextLock(const ASTMatchFinder &Finder)
+      : Mutex(Finder.getASTContextMutex()) {
+    if (Mutex)
+      Mutex->lock();
+  }
+
+  ~ASTContextLock() {
+    if (Mutex)
+      Mutex->unlock();
+  }
+};
+
 /// \brief A type-list implementation.
 ///
 /// A "linked list" of types, accessible by using the ::head and ::tail
@@ -23,6 +23,7 @@
 #include "llvm/ADT/SmallVector.h"
 #include "llvm/ADT/StringMap.h"
 #include "llvm/ADT/StringRef.h"
+#include "llvm/ADT/StringSet.h"
 #include "llvm/Support/Allocator.h"
 #include <memory>
 #include <map>
@@ -152,6 +153,19 @@ class FileManager : public RefCountedBase<FileManager> {
   /// \brief Storage for canonical names that we have computed.
   llvm::BumpPtrAllocator CanonicalNameStorage;
 
+  /// \brief The names of the entries of the directories we have listed,
+  /// lowercased, or null for directories that could not be listed.
+  llvm::DenseMap<const DirectoryEntry *, std::unique_ptr<llvm::StringSet<>>>
+    DirectoryListings;
+
+  /// \brief The contents of the files read through getSharedBufferForFile.
+  ///
+  /// The buffers handed out own these, so the contents of a file are only
+  /// kept while some buffer still refers to them, even past the lifetime of
+  /// the FileManager.
+  llvm::DenseMap<const FileEntry *, std::weak_ptr<llvm::MemoryBuffer>>
+    SharedBuffers;
+
   /// \brief Each FileEntry we create is assigned a unique ID #.
   ///
   unsigned NextFileUID;
@@ -159,6 +173,9 @@ class FileManager : public RefCountedBase<FileManager> {
   // Statistics.
   unsigned NumDirLookups, NumFileLookups;
   unsigned NumDirCacheMisses, NumFileCacheMisses;
+  unsigned NumDirListings;
+  unsigned NumSharedBufferHits;
+  uint64_t NumBytesMapped, NumBytesCopied, NumBytesHugePages;
 
   // Caching.
   std::unique_ptr<FileSystemStatCache> StatCache;
@@ -166,6 +183,15 @@ class FileManager : public RefCountedBase<FileManager> {
   bool getStatValue(const char *Path, FileData &Data, bool isFile,
                     std::unique_ptr<vfs::File> *F);
 
+  /// \brief Counts the bytes of \p Buffer as mapped or copied, whichever
+  /// way it was read.
+  void noteBufferRead(
+      const llvm::ErrorOr<std::unique_ptr<llvm::MemoryBuffer>> &Buffer);
+
+  /// \brief Memory maps the real file \p Entry, whatever its size, or
+  /// returns null if it can't be mapped with a null terminator.
+  std::unique_ptr<llvm::MemoryBuffer> mapFile(const FileEntry *Entry);
+
   /// Add all ancestors of the given path (pointing to either a file
   /// or a directory) as virtual directories.
   void addAncestorsAsVirtualDirs(StringRef Path);
@@ -240,6 +266,18 @@ public:
   llvm::ErrorOr<std::unique_ptr<llvm::MemoryBuffer>>
   getBufferForFile(StringRef Filename);
 
+  /// \brief Open the specified file as a MemoryBuffer which refers to
+  /// contents read only once per FileManager.
+  ///
+  /// Unless \p isVolatile is set, the file is assumed not to change while the
+  /// FileManager is alive, and every SourceManager using this FileManager
+  /// shares its contents, without copying them, for as long as one of them
+  /// holds a buffer for the file. If FileSystemOptions::MapSharedFiles is
+  /// set, files on the real file system are memory mapped even if they are
+  /// small.
+  llvm::ErrorOr<std::unique_ptr<llvm::MemoryBuffer>>
+  getSharedBufferForFile(const FileEntry *Entry, bool isVolatile = false);
+
   /// \brief Get the 'stat' information for the given \p Path.
   ///
   /// If the path is relative, it will be resolved against the WorkingDir of the
@@ -249,7 +287,18 @@ public:
   bool getNoncachedStatValue(StringRef Path,
                              vfs::Status &Result);
 
-  /// \brief Remove the real file \p Entry from the cache.
+  /// \brief Determine whether the directory \p Dir may contain an entry named
+  /// \p Name, without looking the entry up.
+  ///
+  /// The first query about a directory reads its contents, which are then
+  /// remembered like the results of the lookups the FileManager makes, until
+  /// a file of the directory is passed to invalidateCache(). The comparison
+  /// ignores case, so a false result means that a lookup of \p Name in \p Dir
+  /// would certainly fail.
+  bool mayContainEntry(const DirectoryEntry *Dir, StringRef Name);
+
+  /// \brief Remove the real file \p Entry from the cache, along with the
+  /// listing of its directory.
   void invalidateCache(const FileEntry *Entry);
 
   /// \brief If path is not absolute and FileSystemOptions set the working
@@ -25,6 +25,13 @@ public:
   /// \brief If set, paths are resolved as if the working directory was
   /// set to the value of WorkingDir.
   std::string WorkingDir;
+
+  /// \brief If set, the files shared between SourceManagers are memory
+  /// mapped whatever their size, with a hint to back the mapping with huge
+  /// pages where the system supports it.
+  bool MapSharedFiles;
+
+  FileSystemOptions() : MapSharedFiles(false) {}
 };
 
 } // end namespace clang
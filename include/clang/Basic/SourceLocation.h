@@ -19,6 +19,7 @@
 #include "llvm/Support/Compiler.h"
 #include "llvm/Support/PointerLikeTypeTraits.h"
 #include <cassert>
+#include <cstdint>
 #include <functional>
 #include <string>
 #include <utility>
@@ -84,14 +85,28 @@ private:
 /// In addition, one bit of SourceLocation is used for quick access to the
 /// information whether the location is in a file or a macro expansion.
 ///
-/// It is important that this type remains small. It is currently 32 bits wide.
+/// It is important that this type remains small. It is 32 bits wide, unless
+/// clang is built with CLANG_ENABLE_64_BIT_SOURCE_LOCATIONS, which makes it 64
+/// bits wide for translation units too large for a 31-bit offset space.
 class SourceLocation {
-  unsigned ID;
+public:
+  /// \brief The type of the raw encoding, and of the offsets the
+  /// SourceManager hands out.
+#ifdef CLANG_ENABLE_64_BIT_SOURCE_LOCATIONS
+  typedef uint64_t UIntTy;
+  typedef int64_t IntTy;
+#else
+  typedef unsigned UIntTy;
+  typedef int IntTy;
+#endif
+
+private:
+  UIntTy ID;
   friend class SourceManager;
   friend class ASTReader;
   friend class ASTWriter;
-  enum : unsigned {
-    MacroIDBit = 1U << 31
+  enum : UIntTy {
+    MacroIDBit = UIntTy(1) << (8 * sizeof(UIntTy) - 1)
   };
 public:
 
@@ -110,18 +125,18 @@ public:
 
 private:
   /// \brief Return the offset into the manager's global input view.
-  unsigned getOffset() const {
+  UIntTy getOffset() const {
     return ID & ~MacroIDBit;
   }
 
-  static SourceLocation getFileLoc(unsigned ID) {
+  static SourceLocation getFileLoc(UIntTy ID) {
     assert((ID & MacroIDBit) == 0 && "Ran out of source locations!");
     SourceLocation L;
     L.ID = ID;
     return L;
   }
 
-  static SourceLocation getMacroLoc(unsigned ID) {
+  static SourceLocation getMacroLoc(UIntTy ID) {
     assert((ID & MacroIDBit) == 0 && "Ran out of source locations!");
     SourceLocation L;
     L.ID = MacroIDBit | ID;
@@ -131,7 +146,7 @@ public:
 
   /// \brief Return a source location with the specified offset from this
   /// SourceLocation.
-  SourceLocation getLocWithOffset(int Offset) const {
+  SourceLocation getLocWithOffset(IntTy Offset) const {
     assert(((getOffset()+Offset) & MacroIDBit) == 0 && "offset overflow");
     SourceLocation L;
     L.ID = ID+Offset;
@@ -139,17 +154,17 @@ public:
   }
 
   /// \brief When a SourceLocation itself cannot be used, this returns
-  /// an (opaque) 32-bit integer encoding for it.
+  /// an (opaque) integer encoding for it, of type UIntTy.
   ///
   /// This should only be passed to SourceLocation::getFromRawEncoding, it
   /// should not be inspected directly.
-  unsigned getRawEncoding() const { return ID; }
+  UIntTy getRawEncoding() const { return ID; }
 
   /// \brief Turn a raw encoding of a SourceLocation object into
   /// a real SourceLocation.
   ///
   /// \see getRawEncoding.
-  static SourceLocation getFromRawEncoding(unsigned Encoding) {
+  static SourceLocation getFromRawEncoding(UIntTy Encoding) {
     SourceLocation X;
     X.ID = Encoding;
     return X;
@@ -161,6 +176,8 @@ public:
   /// This should only be passed to SourceLocation::getFromPtrEncoding, it
   /// should not be inspected directly.
   void* getPtrEncoding() const {
+    static_assert(sizeof(UIntTy) <= sizeof(uintptr_t),
+                  "64-bit source locations need a 64-bit host");
     // Double cast to avoid a warning "cast to pointer from integer of different
     // size".
     return (void*)(uintptr_t)getRawEncoding();
@@ -169,7 +186,7 @@ public:
   /// \brief Turn a pointer encoding of a SourceLocation object back
   /// into a real SourceLocation.
   static SourceLocation getFromPtrEncoding(const void *Encoding) {
-    return getFromRawEncoding((unsigned)(uintptr_t)Encoding);
+    return getFromRawEncoding((UIntTy)(uintptr_t)Encoding);
   }
 
   void print(raw_ostream &OS, const SourceManager &SM) const;
@@ -428,7 +445,7 @@ namespace llvm {
       return L.getPtrEncoding();
     }
     static inline clang::SourceLocation getFromVoidPointer(void *P) {
-      return clang::SourceLocation::getFromRawEncoding((unsigned)(uintptr_t)P);
+      return clang::SourceLocation::getFromPtrEncoding(P);
     }
     enum { NumLowBitsAvailable = 0 };
   };
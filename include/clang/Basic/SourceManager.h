@@ -50,10 +50,16 @@
 #include "llvm/Support/DataTypes.h"
 #include "llvm/Support/MemoryBuffer.h"
 #include <cassert>
+#include <cstring>
+#include <future>
 #include <map>
 #include <memory>
 #include <vector>
 
+namespace llvm {
+class ThreadPool;
+}
+
 namespace clang {
 
 class DiagnosticsEngine;
@@ -243,18 +249,23 @@ namespace SrcMgr {
     /// \brief The location of the \#include that brought in this file.
     ///
     /// This is an invalid SLOC for the main file (top of the \#include chain).
-    unsigned IncludeLoc;  // Really a SourceLocation
-
-    /// \brief Number of FileIDs (files and macros) that were created during
-    /// preprocessing of this \#include, including this SLocEntry.
-    ///
-    /// Zero means the preprocessor didn't provide such info for this SLocEntry.
-    unsigned NumCreatedFIDs;
+    SourceLocation::UIntTy IncludeLoc;  // Really a SourceLocation
 
     /// \brief Contains the ContentCache* and the bits indicating the
     /// characteristic of the file and whether it has \#line info, all
     /// bitmangled together.
-    uintptr_t Data;
+    ///
+    /// This is stored as 32-bit words, so that a FileInfo is no more aligned
+    /// than an ExpansionInfo and SLocEntry needs no padding after its offset.
+    /// Most SLocEntries are macro expansions, and this keeps them at 16 bytes.
+    uint32_t Data[sizeof(uintptr_t) / 4];
+
+    uintptr_t getData() const {
+      uintptr_t D;
+      memcpy(&D, Data, sizeof(D));
+      return D;
+    }
+    void setData(uintptr_t D) { memcpy(Data, &D, sizeof(D)); }
 
     friend class clang::SourceManager;
     friend class clang::ASTWriter;
@@ -265,11 +276,10 @@ namespace SrcMgr {
                         CharacteristicKind FileCharacter) {
       FileInfo X;
       X.IncludeLoc = IL.getRawEncoding();
-      X.NumCreatedFIDs = 0;
-      X.Data = (uintptr_t)Con;
-      assert((X.Data & 7) == 0 &&"ContentCache pointer insufficiently aligned");
+      uintptr_t Data = (uintptr_t)Con;
+      assert((Data & 7) == 0 && "ContentCache pointer insufficiently aligned");
       assert((unsigned)FileCharacter < 4 && "invalid file character");
-      X.Data |= (unsigned)FileCharacter;
+      X.setData(Data | (unsigned)FileCharacter);
       return X;
     }
 
@@ -277,21 +287,21 @@ namespace SrcMgr {
       return SourceLocation::getFromRawEncoding(IncludeLoc);
     }
     const ContentCache* getContentCache() const {
-      return reinterpret_cast<const ContentCache*>(Data & ~uintptr_t(7));
+      return reinterpret_cast<const ContentCache*>(getData() & ~uintptr_t(7));
     }
 
     /// \brief Return whether this is a system header or not.
     CharacteristicKind getFileCharacteristic() const {
-      return (CharacteristicKind)(Data & 3);
+      return (CharacteristicKind)(getData() & 3);
     }
 
     /// \brief Return true if this FileID has \#line directives in it.
-    bool hasLineDirectives() const { return (Data & 4) != 0; }
+    bool hasLineDirectives() const { return (getData() & 4) != 0; }
 
     /// \brief Set the flag that indicates that this FileID has
     /// line table entries associated with it.
     void setHasLineDirectives() {
-      Data |= 4;
+      setData(getData() | 4);
     }
   };
 
@@ -302,7 +312,7 @@ namespace SrcMgr {
     // Really these are all SourceLocations.
 
     /// \brief Where the spelling for the token can be found.
-    unsigned SpellingLoc;
+    SourceLocation::UIntTy SpellingLoc;
 
     /// In a macro expansion, ExpansionLocStart and ExpansionLocEnd
     /// indicate the start and end of the expansion. In object-like macros,
@@ -310,7 +320,7 @@ namespace SrcMgr {
     /// will be the identifier and the end will be the ')'. Finally, in
     /// macro-argument instantiations, the end will be 'SourceLocation()', an
     /// invalid location.
-    unsigned ExpansionLocStart, ExpansionLocEnd;
+    SourceLocation::UIntTy ExpansionLocStart, ExpansionLocEnd;
 
   public:
     SourceLocation getSpellingLoc() const {
@@ -393,14 +403,15 @@ namespace SrcMgr {
   /// SourceManager keeps an array of these objects, and they are uniquely
   /// identified by the FileID datatype.
   class SLocEntry {
-    unsigned Offset : 31;
-    unsigned IsExpansion : 1;
+    static const unsigned OffsetBits = 8 * sizeof(SourceLocation::UIntTy) - 1;
+    SourceLocation::UIntTy Offset : OffsetBits;
+    SourceLocation::UIntTy IsExpansion : 1;
     union {
       FileInfo File;
       ExpansionInfo Expansion;
     };
   public:
-    unsigned getOffset() const { return Offset; }
+    SourceLocation::UIntTy getOffset() const { return Offset; }
 
     bool isExpansion() const { return IsExpansion; }
     bool isFile() const { return !isExpansion(); }
@@ -415,8 +426,8 @@ namespace SrcMgr {
       return Expansion;
     }
 
-    static SLocEntry get(unsigned Offset, const FileInfo &FI) {
-      assert(!(Offset & (1 << 31)) && "Offset is too large");
+    static SLocEntry get(SourceLocation::UIntTy Offset, const FileInfo &FI) {
+      assert(!(Offset >> OffsetBits) && "Offset is too large");
       SLocEntry E;
       E.Offset = Offset;
       E.IsExpansion = false;
@@ -424,8 +435,9 @@ namespace SrcMgr {
       return E;
     }
 
-    static SLocEntry get(unsigned Offset, const ExpansionInfo &Expansion) {
-      assert(!(Offset & (1 << 31)) && "Offset is too large");
+    static SLocEntry get(SourceLocation::UIntTy Offset,
+                         const ExpansionInfo &Expansion) {
+      assert(!(Offset >> OffsetBits) && "Offset is too large");
       SLocEntry E;
       E.Offset = Offset;
       E.IsExpansion = true;
@@ -605,26 +617,40 @@ class SourceManager : public RefCountedBase<SourceManager> {
   /// expansion.
   SmallVector<SrcMgr::SLocEntry, 0> LocalSLocEntryTable;
 
+  /// \brief The offsets of the entries of LocalSLocEntryTable.
+  ///
+  /// getFileIDLocal binary searches these rather than the entries themselves,
+  /// as many more offsets than entries fit in a cache line.
+  SmallVector<SourceLocation::UIntTy, 0> LocalSLocEntryOffsets;
+
   /// \brief The table of SLocEntries that are loaded from other modules.
   ///
   /// Negative FileIDs are indexes into this table. To get from ID to an index,
   /// use (-ID - 2).
   mutable SmallVector<SrcMgr::SLocEntry, 0> LoadedSLocEntryTable;
 
+  /// \brief The number of FileIDs (files and macros) that were created during
+  /// preprocessing of a file, including it, for the files the preprocessor
+  /// provided this for.
+  ///
+  /// Only few SLocEntries are files, so this is not kept in FileInfo.
+  mutable llvm::DenseMap<FileID, unsigned> NumCreatedFIDs;
+
   /// \brief The starting offset of the next local SLocEntry.
   ///
   /// This is LocalSLocEntryTable.back().Offset + the size of that entry.
-  unsigned NextLocalOffset;
+  SourceLocation::UIntTy NextLocalOffset;
 
   /// \brief The starting offset of the latest batch of loaded SLocEntries.
   ///
   /// This is LoadedSLocEntryTable.back().Offset, except that that entry might
   /// not have been loaded, so that value would be unknown.
-  unsigned CurrentLoadedOffset;
+  SourceLocation::UIntTy CurrentLoadedOffset;
 
-  /// \brief The highest possible offset is 2^31-1, so CurrentLoadedOffset
-  /// starts at 2^31.
-  static const unsigned MaxLoadedOffset = 1U << 31U;
+  /// \brief The highest possible offset is 2^31-1 (2^63-1 with 64-bit source
+  /// locations), so CurrentLoadedOffset starts at 2^31 (2^63).
+  static const SourceLocation::UIntTy MaxLoadedOffset =
+      SourceLocation::UIntTy(1) << (8 * sizeof(SourceLocation::UIntTy) - 1);
 
   /// \brief A bitmap that indicates whether the entries of LoadedSLocEntryTable
   /// have already been loaded from the external source.
@@ -653,6 +679,21 @@ class SourceManager : public RefCountedBase<SourceManager> {
   mutable unsigned LastLineNoFilePos;
   mutable unsigned LastLineNoResult;
 
+  /// \brief A line table being computed on another thread.
+  struct PrefetchedLineTable {
+    std::shared_future<void> Done;
+    std::shared_ptr<SmallVector<unsigned, 0>> LineOffsets;
+  };
+
+  /// \brief The line tables requested by prefetchLineTable which haven't been
+  /// needed yet.
+  mutable llvm::DenseMap<const SrcMgr::ContentCache *, PrefetchedLineTable>
+      PrefetchedLineTables;
+
+  /// \brief The thread computing prefetched line tables, created on the first
+  /// call to prefetchLineTable.
+  std::unique_ptr<llvm::ThreadPool> LineTableThread;
+
   /// \brief The file ID for the main source file of the translation unit.
   FileID MainFileID;
 
@@ -661,6 +702,7 @@ class SourceManager : public RefCountedBase<SourceManager> {
 
   // Statistics for -print-stats.
   mutable unsigned NumLinearScans, NumBinaryProbes;
+  mutable unsigned NumLineTablesPrefetched;
 
   /// \brief Associates a FileID with its "included/expanded in" decomposed
   /// location.
@@ -777,7 +819,8 @@ public:
   /// This translates NULL into standard input.
   FileID createFileID(const FileEntry *SourceFile, SourceLocation IncludePos,
                       SrcMgr::CharacteristicKind FileCharacter,
-                      int LoadedID = 0, unsigned LoadedOffset = 0) {
+                      int LoadedID = 0,
+                      SourceLocation::UIntTy LoadedOffset = 0) {
     const SrcMgr::ContentCache *
       IR = getOrCreateContentCache(SourceFile,
                               /*isSystemFile=*/FileCharacter != SrcMgr::C_User);
@@ -791,7 +834,7 @@ public:
   /// MemoryBuffer, so only pass a MemoryBuffer to this once.
   FileID createFileID(std::unique_ptr<llvm::MemoryBuffer> Buffer,
                       SrcMgr::CharacteristicKind FileCharacter = SrcMgr::C_User,
-                      int LoadedID = 0, unsigned LoadedOffset = 0,
+                      int LoadedID = 0, SourceLocation::UIntTy LoadedOffset = 0,
                       SourceLocation IncludeLoc = SourceLocation()) {
     return createFileID(createMemBufferContentCache(std::move(Buffer)),
                         IncludeLoc, FileCharacter, LoadedID, LoadedOffset);
@@ -822,7 +865,7 @@ public:
                                     SourceLocation ExpansionLocEnd,
                                     unsigned TokLength,
                                     int LoadedID = 0,
-                                    unsigned LoadedOffset = 0);
+                                    SourceLocation::UIntTy LoadedOffset = 0);
 
   /// \brief Retrieve the memory buffer associated with the given file.
   ///
@@ -959,7 +1002,7 @@ public:
     if (Invalid || !Entry.isFile())
       return 0;
 
-    return Entry.getFile().NumCreatedFIDs;
+    return NumCreatedFIDs.lookup(FID);
   }
 
   /// \brief Set the number of FileIDs (files and macros) that were created
@@ -970,8 +1013,9 @@ public:
     if (Invalid || !Entry.isFile())
       return;
 
-    assert(Entry.getFile().NumCreatedFIDs == 0 && "Already set!");
-    const_cast<SrcMgr::FileInfo &>(Entry.getFile()).NumCreatedFIDs = NumFIDs;
+    unsigned &Num = NumCreatedFIDs[FID];
+    assert(Num == 0 && "Already set!");
+    Num = NumFIDs;
   }
 
   //===--------------------------------------------------------------------===//
@@ -985,7 +1029,7 @@ public:
   /// the entry in SLocEntryTable which contains the specified location.
   ///
   FileID getFileID(SourceLocation SpellingLoc) const {
-    unsigned SLocOffset = SpellingLoc.getOffset();
+    SourceLocation::UIntTy SLocOffset = SpellingLoc.getOffset();
 
     // If our one-entry cache covers this offset, just return it.
     if (isOffsetInFileID(LastFileIDLookup, SLocOffset))
@@ -1009,7 +1053,7 @@ public:
     if (Invalid || !Entry.isFile())
       return SourceLocation();
 
-    unsigned FileOffset = Entry.getOffset();
+    SourceLocation::UIntTy FileOffset = Entry.getOffset();
     return SourceLocation::getFileLoc(FileOffset);
   }
   
@@ -1021,7 +1065,7 @@ public:
     if (Invalid || !Entry.isFile())
       return SourceLocation();
     
-    unsigned FileOffset = Entry.getOffset();
+    SourceLocation::UIntTy FileOffset = Entry.getOffset();
     return SourceLocation::getFileLoc(FileOffset + getFileIDSize(FID));
   }
 
@@ -1218,9 +1262,9 @@ public:
             (Start.getOffset() >= CurrentLoadedOffset &&
                 Start.getOffset()+Length < MaxLoadedOffset)) &&
            "Chunk is not valid SLoc address space");
-    unsigned LocOffs = Loc.getOffset();
-    unsigned BeginOffs = Start.getOffset();
-    unsigned EndOffs = BeginOffs + Length;
+    SourceLocation::UIntTy LocOffs = Loc.getOffset();
+    SourceLocation::UIntTy BeginOffs = Start.getOffset();
+    SourceLocation::UIntTy EndOffs = BeginOffs + Length;
     if (LocOffs >= BeginOffs && LocOffs < EndOffs) {
       if (RelativeOffset)
         *RelativeOffset = LocOffs - BeginOffs;
@@ -1236,8 +1280,8 @@ public:
   /// If it's true and \p RelativeOffset is non-null, it will be set to the
   /// offset of \p RHS relative to \p LHS.
   bool isInSameSLocAddrSpace(SourceLocation LHS, SourceLocation RHS,
-                             int *RelativeOffset) const {
-    unsigned LHSOffs = LHS.getOffset(), RHSOffs = RHS.getOffset();
+                             SourceLocation::IntTy *RelativeOffset) const {
+    SourceLocation::UIntTy LHSOffs = LHS.getOffset(), RHSOffs = RHS.getOffset();
     bool LHSLoaded = LHSOffs >= CurrentLoadedOffset;
     bool RHSLoaded = RHSOffs >= CurrentLoadedOffset;
 
@@ -1283,6 +1327,13 @@ public:
   /// MemoryBuffer, so this is not cheap: use only when about to emit a
   /// diagnostic.
   unsigned getLineNumber(FileID FID, unsigned FilePos, bool *Invalid = nullptr) const;
+
+  /// \brief Start computing the line table of \p FID on another thread.
+  ///
+  /// This is for clients which know that they will need line numbers in a
+  /// file, so that the line table is ready by then rather than computed on
+  /// the first call to getLineNumber.
+  void prefetchLineTable(FileID FID);
   unsigned getSpellingLineNumber(SourceLocation Loc, bool *Invalid = nullptr) const;
   unsigned getExpansionLineNumber(SourceLocation Loc, bool *Invalid = nullptr) const;
   unsigned getPresumedLineNumber(SourceLocation Loc, bool *Invalid = nullptr) const;
@@ -1370,7 +1421,7 @@ public:
   /// of FileID) to \p relativeOffset.
   bool isInFileID(SourceLocation Loc, FileID FID,
                   unsigned *RelativeOffset = nullptr) const {
-    unsigned Offs = Loc.getOffset();
+    SourceLocation::UIntTy Offs = Loc.getOffset();
     if (isOffsetInFileID(FID, Offs)) {
       if (RelativeOffset)
         *RelativeOffset = Offs - getSLocEntry(FID).getOffset();
@@ -1477,8 +1528,9 @@ public:
   /// offset in the "source location address space".
   ///
   /// Note that we always consider source locations loaded from
-  bool isBeforeInSLocAddrSpace(SourceLocation LHS, unsigned RHS) const {
-    unsigned LHSOffset = LHS.getOffset();
+  bool isBeforeInSLocAddrSpace(SourceLocation LHS,
+                               SourceLocation::UIntTy RHS) const {
+    SourceLocation::UIntTy LHSOffset = LHS.getOffset();
     bool LHSLoaded = LHSOffset >= CurrentLoadedOffset;
     bool RHSLoaded = RHS >= CurrentLoadedOffset;
     if (LHSLoaded == RHSLoaded)
@@ -1533,7 +1585,9 @@ public:
     return getSLocEntryByID(FID.ID, Invalid);
   }
 
-  unsigned getNextLocalOffset() const { return NextLocalOffset; }
+  SourceLocation::UIntTy getNextLocalOffset() const {
+    return NextLocalOffset;
+  }
 
   void setExternalSLocEntrySource(ExternalSLocEntrySource *Source) {
     assert(LoadedSLocEntryTable.empty() &&
@@ -1547,8 +1601,9 @@ public:
   /// NumSLocEntries will be allocated, which occupy a total of TotalSize space
   /// in the global source view. The lowest ID and the base offset of the
   /// entries will be returned.
-  std::pair<int, unsigned>
-  AllocateLoadedSLocEntries(unsigned NumSLocEntries, unsigned TotalSize);
+  std::pair<int, SourceLocation::UIntTy>
+  AllocateLoadedSLocEntries(unsigned NumSLocEntries,
+                            SourceLocation::UIntTy TotalSize);
 
   /// \brief Returns true if \p Loc came from a PCH/Module.
   bool isLoadedSourceLocation(SourceLocation Loc) const {
@@ -1593,6 +1648,14 @@ private:
 
   const SrcMgr::SLocEntry &loadSLocEntry(unsigned Index, bool *Invalid) const;
 
+  /// \brief Compute the line table of \p Content, or take it from
+  /// prefetchLineTable.
+  void computeLineTable(SrcMgr::ContentCache *Content, bool &Invalid) const;
+
+  /// \brief Wait for the line table prefetched for \p Content, if any, and
+  /// drop it, as the buffer it is computed from is going away.
+  void dropPrefetchedLineTable(const SrcMgr::ContentCache *Content);
+
   /// \brief Get the entry with the given unwrapped FileID.
   const SrcMgr::SLocEntry &getSLocEntryByID(int ID,
                                             bool *Invalid = nullptr) const {
@@ -1609,14 +1672,15 @@ private:
 
   /// Implements the common elements of storing an expansion info struct into
   /// the SLocEntry table and producing a source location that refers to it.
-  SourceLocation createExpansionLocImpl(const SrcMgr::ExpansionInfo &Expansion,
-                                        unsigned TokLength,
-                                        int LoadedID = 0,
-                                        unsigned LoadedOffset = 0);
+  SourceLocation
+  createExpansionLocImpl(const SrcMgr::ExpansionInfo &Expansion,
+                         unsigned TokLength, int LoadedID = 0,
+                         SourceLocation::UIntTy LoadedOffset = 0);
 
   /// \brief Return true if the specified FileID contains the
   /// specified SourceLocation offset.  This is a very hot method.
-  inline bool isOffsetInFileID(FileID FID, unsigned SLocOffset) const {
+  inline bool isOffsetInFileID(FileID FID,
+                               SourceLocation::UIntTy SLocOffset) const {
     const SrcMgr::SLocEntry &Entry = getSLocEntry(FID);
     // If the entry is after the offset, it can't contain it.
     if (SLocOffset < Entry.getOffset()) return false;
@@ -1650,7 +1714,7 @@ private:
   FileID createFileID(const SrcMgr::ContentCache* File,
                       SourceLocation IncludePos,
                       SrcMgr::CharacteristicKind DirCharacter,
-                      int LoadedID, unsigned LoadedOffset);
+                      int LoadedID, SourceLocation::UIntTy LoadedOffset);
 
   const SrcMgr::ContentCache *
     getOrCreateContentCache(const FileEntry *SourceFile,
@@ -1660,9 +1724,9 @@ private:
   const SrcMgr::ContentCache *
   createMemBufferContentCache(std::unique_ptr<llvm::MemoryBuffer> Buf);
 
-  FileID getFileIDSlow(unsigned SLocOffset) const;
-  FileID getFileIDLocal(unsigned SLocOffset) const;
-  FileID getFileIDLoaded(unsigned SLocOffset) const;
+  FileID getFileIDSlow(SourceLocation::UIntTy SLocOffset) const;
+  FileID getFileIDLocal(SourceLocation::UIntTy SLocOffset) const;
+  FileID getFileIDLoaded(SourceLocation::UIntTy SLocOffset) const;
 
   SourceLocation getExpansionLocSlowCase(SourceLocation Loc) const;
   SourceLocation getSpellingLocSlowCase(SourceLocation Loc) const;
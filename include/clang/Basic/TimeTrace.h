@@ -0,0 +1,126 @@
+//===--- TimeTrace.h - Hierarchical trace of compilation phases -*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file
+/// \brief Defines the TimeTraceProfiler class, which records how long the
+/// phases of a compilation take, and TimeTraceScope, which traces a scope.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_CLANG_BASIC_TIMETRACE_H
+#define LLVM_CLANG_BASIC_TIMETRACE_H
+
+#include "clang/Basic/LLVM.h"
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/StringMap.h"
+#include <chrono>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace clang {
+
+/// \brief Records nested events, such as the processing of a header or the
+/// instantiation of a template, with the time they took, and writes them in
+/// the Chrome trace event format.
+///
+/// A profiler is installed for the thread which creates it, until it is
+/// destroyed. Code which wants to be traced uses TimeTraceScope, which does
+/// nothing unless a profiler is installed.
+class TimeTraceProfiler {
+  typedef std::chrono::steady_clock Clock;
+
+  struct Event {
+    std::string Name;
+    std::string Detail;
+    Clock::time_point Start;
+    Clock::duration Duration;
+    /// The memory counter when the event began, then how much it grew
+    /// until the event ended.
+    size_t Memory;
+  };
+
+  TimeTraceProfiler *OuterProfiler;
+  Clock::time_point StartTime;
+
+  /// The events which have not ended yet, innermost last.
+  std::vector<Event> Stack;
+
+  /// The events which ended.
+  std::vector<Event> Events;
+
+  /// Sampled when each event begins and ends, if set.
+  std::function<size_t()> MemoryCounter;
+  std::string MemoryCounterName;
+
+  /// The number of events with each name, and the time they took. Events
+  /// nested in events with the same name are not counted twice.
+  llvm::StringMap<std::pair<unsigned, Clock::duration>> Totals;
+
+  TimeTraceProfiler(const TimeTraceProfiler &) = delete;
+  void operator=(const TimeTraceProfiler &) = delete;
+
+public:
+  TimeTraceProfiler();
+  ~TimeTraceProfiler();
+
+  /// \brief Returns the profiler installed for the current thread, if any.
+  static TimeTraceProfiler *get();
+
+  /// \brief Records in the arg \p Name of each event how much \p Counter,
+  /// e.g. the number of bytes allocated for the AST, grew during the event.
+  /// \p Counter is called twice per event, so it must be cheap.
+  void setMemoryCounter(StringRef Name, std::function<size_t()> Counter);
+
+  /// \brief Begins an event, and returns its depth in the stack of events
+  /// which have not ended.
+  unsigned begin(StringRef Name, StringRef Detail);
+
+  /// \brief Ends the event at depth \p Depth, and any event which began
+  /// after it and hasn't ended. Does nothing if that event already ended.
+  void end(unsigned Depth);
+
+  /// \brief Writes the events in the Chrome trace event format, ending those
+  /// which have not ended yet.
+  void write(raw_ostream &OS);
+};
+
+/// \brief Traces an event from its construction to its destruction, if a
+/// TimeTraceProfiler is installed.
+class TimeTraceScope {
+  TimeTraceProfiler *Profiler;
+  unsigned Depth;
+
+  TimeTraceScope(const TimeTraceScope &) = delete;
+  void operator=(const TimeTraceScope &) = delete;
+
+public:
+  explicit TimeTraceScope(StringRef Name)
+      : Profiler(TimeTraceProfiler::get()), Depth(0) {
+    if (Profiler)
+      Depth = Profiler->begin(Name, StringRef());
+  }
+
+  /// \param Detail Computes what the event is about, e.g. the name of a
+  /// function. It is only called if the event is traced.
+  TimeTraceScope(StringRef Name, llvm::function_ref<std::string()> Detail)
+      : Profiler(TimeTraceProfiler::get()), Depth(0) {
+    if (Profiler)
+      Depth = Profiler->begin(Name, Detail());
+  }
+
+  ~TimeTraceScope() {
+    if (Profiler)
+      Profiler->end(Depth);
+  }
+};
+
+} // end namespace clang
+
+#endif
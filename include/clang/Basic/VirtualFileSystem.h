@@ -16,8 +16,10 @@
 #include "clang/Basic/LLVM.h"
 #include "llvm/ADT/IntrusiveRefCntPtr.h"
 #include "llvm/ADT/Optional.h"
+#include "llvm/ADT/StringMap.h"
 #include "llvm/Support/ErrorOr.h"
 #include "llvm/Support/FileSystem.h"
+#include "llvm/Support/Mutex.h"
 #include "llvm/Support/SourceMgr.h"
 #include "llvm/Support/raw_ostream.h"
 
@@ -227,6 +229,14 @@ public:
 /// the operating system.
 IntrusiveRefCntPtr<FileSystem> getRealFileSystem();
 
+/// \brief Create a new \p vfs::FileSystem for the 'real' file system that
+/// keeps its own working directory.
+///
+/// Unlike the file system returned by \c getRealFileSystem(), changing the
+/// working directory of the returned file system does not chdir the process,
+/// so several instances can be used concurrently from different threads.
+IntrusiveRefCntPtr<FileSystem> createPhysicalFileSystem();
+
 /// \brief A file system that allows overlaying one \p AbstractFileSystem on top
 /// of another.
 ///
@@ -302,6 +312,81 @@ public:
   std::error_code setCurrentWorkingDirectory(const Twine &Path) override;
 };
 
+/// \brief A thread-safe cache of file status and contents that is shared by
+/// many \p CachingFileSystem instances.
+///
+/// Status results (including "no such file" results) are cached by absolute
+/// path. Files that are opened more than once have their contents read once
+/// and kept alive by the cache; subsequent opens are served from the same
+/// buffer without touching the file system. The cache assumes that the
+/// underlying files do not change while it is in use, so it is suited for
+/// batch runs over a source tree such as those performed by ClangTool.
+///
+/// Buffers handed out by files opened through the cache point into memory
+/// owned by the cache, so the cache must outlive their users.
+class SharedFileSystemCache
+    : public llvm::ThreadSafeRefCountedBase<SharedFileSystemCache> {
+public:
+  SharedFileSystemCache();
+  ~SharedFileSystemCache();
+
+  /// \brief Number of status requests answered from the cache.
+  unsigned getNumStatHits() const { return NumStatHits; }
+  /// \brief Number of status requests forwarded to the file system.
+  unsigned getNumStatMisses() const { return NumStatMisses; }
+  /// \brief Number of opens answered with a cached buffer.
+  unsigned getNumBufferHits() const { return NumBufferHits; }
+  /// \brief Total size of the buffers kept alive by the cache.
+  uint64_t getNumBytesCached() const { return NumBytesCached; }
+
+  /// \brief Drops all cached status results and buffers.
+  ///
+  /// Must not be called while buffers handed out by the cache are in use.
+  void clear();
+
+  void PrintStats(raw_ostream &OS) const;
+
+private:
+  struct Entry {
+    Status Stat;
+    std::error_code StatError;
+    bool HasStat;
+    unsigned NumOpens;
+    std::unique_ptr<llvm::MemoryBuffer> Buffer;
+
+    Entry() : HasStat(false), NumOpens(0) {}
+  };
+
+  mutable llvm::sys::Mutex Lock;
+  llvm::StringMap<Entry> Entries;
+  unsigned NumStatHits, NumStatMisses, NumBufferHits;
+  uint64_t NumBytesCached;
+
+  friend class CachingFileSystem;
+};
+
+/// \brief A file system that answers status and read requests from a
+/// \p SharedFileSystemCache, forwarding misses to an underlying file system.
+///
+/// Relative paths are resolved against the working directory of the
+/// underlying file system, so several instances with different working
+/// directories can share one cache.
+class CachingFileSystem : public FileSystem {
+  IntrusiveRefCntPtr<SharedFileSystemCache> Cache;
+  IntrusiveRefCntPtr<FileSystem> ExternalFS;
+
+public:
+  CachingFileSystem(IntrusiveRefCntPtr<SharedFileSystemCache> Cache,
+                    IntrusiveRefCntPtr<FileSystem> ExternalFS);
+
+  llvm::ErrorOr<Status> status(const Twine &Path) override;
+  llvm::ErrorOr<std::unique_ptr<File>>
+  openFileForRead(const Twine &Path) override;
+  directory_iterator dir_begin(const Twine &Dir, std::error_code &EC) override;
+  llvm::ErrorOr<std::string> getCurrentWorkingDirectory() const override;
+  std::error_code setCurrentWorkingDirectory(const Twine &Path) override;
+};
+
 /// \brief Get a globally unique ID for a virtual file or directory.
 llvm::sys::fs::UniqueID getNextVirtualUniqueID();
 
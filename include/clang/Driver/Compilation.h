@@ -80,6 +80,20 @@ class Compilation {
   /// Whether we're compiling for diagnostic purposes.
   bool ForDiagnostics;
 
+  /// The maximum number of jobs to execute concurrently.
+  unsigned NumParallelJobs;
+
+  /// PrintCommand - Print \p C for -v and CC_PRINT_OPTIONS, if enabled.
+  ///
+  /// \return false if the options log file could not be opened.
+  bool PrintCommand(const Command &C) const;
+
+  /// ExecuteJobsInParallel - Execute \p Jobs on up to NumParallelJobs
+  /// threads, respecting the dependencies between their actions.
+  void ExecuteJobsInParallel(
+      const JobList &Jobs,
+      SmallVectorImpl<std::pair<int, const Command *>> &FailingCommands) const;
+
 public:
   Compilation(const Driver &D, const ToolChain &DefaultToolChain,
               llvm::opt::InputArgList *Args,
@@ -135,6 +149,12 @@ public:
   /// Returns the sysroot path.
   StringRef getSysRoot() const;
 
+  unsigned getNumParallelJobs() const { return NumParallelJobs; }
+
+  /// setNumParallelJobs - Set the maximum number of jobs that ExecuteJobs may
+  /// run at the same time.
+  void setNumParallelJobs(unsigned N) { NumParallelJobs = N; }
+
   /// getArgsForToolChain - Return the derived argument list for the
   /// tool chain \p TC (or the default tool chain, if TC is not specified).
   ///
@@ -195,6 +215,10 @@ public:
 
   /// ExecuteJob - Execute a single job.
   ///
+  /// If more than one parallel job is allowed, commands whose actions do not
+  /// depend on each other are run concurrently. Their output is buffered and
+  /// replayed in job order, so it looks the same as for sequential execution.
+  ///
   /// \param FailingCommands - For non-zero results, this will be a vector of
   /// failing commands and their associated result code.
   void ExecuteJobs(
@@ -41,7 +41,7 @@ class EditedSource {
   typedef std::map<FileOffset, FileEdit> FileEditsTy;
   FileEditsTy FileEdits;
 
-  llvm::DenseMap<unsigned, llvm::TinyPtrVector<IdentifierInfo*>>
+  llvm::DenseMap<SourceLocation::UIntTy, llvm::TinyPtrVector<IdentifierInfo*>>
     ExpansionToArgMap;
   SmallVector<std::pair<SourceLocation, IdentifierInfo*>, 2>
     CurrCommitMacroArgExps;
@@ -230,6 +230,16 @@ protected:
   void ExecuteAction() override;
 };
 
+/// \brief Preprocess only the directives of the input file and of the files it
+/// includes, which is enough to find its dependencies.
+///
+/// The contents of each file are replaced by its directives once, when it is
+/// first entered, so that the preprocessor never lexes the rest of its tokens.
+class ScanDependenciesAction : public PreprocessOnlyAction {
+protected:
+  bool BeginSourceFileAction(CompilerInstance &CI, StringRef Filename) override;
+};
+
 class PrintPreprocessedAction : public PreprocessorFrontendAction {
 protected:
   void ExecuteAction() override;
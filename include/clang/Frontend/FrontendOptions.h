@@ -56,7 +56,8 @@ namespace frontend {
     RewriteTest,            ///< Rewriter playground
     RunAnalysis,            ///< Run one or more source code analyses.
     MigrateSource,          ///< Run migrator.
-    RunPreprocessorOnly     ///< Just lex, no output.
+    RunPreprocessorOnly,    ///< Just lex, no output.
+    ScanDependencies        ///< Only preprocess the directives of each file.
   };
 }
 
@@ -129,6 +130,8 @@ public:
                                            /// metrics and statistics.
   unsigned ShowTimers : 1;                 ///< Show timers for individual
                                            /// actions.
+  unsigned PrintTemplateProfile : 1;       ///< Show the cost of template
+                                           /// instantiations.
   unsigned ShowVersion : 1;                ///< Show the -version text.
   unsigned FixWhatYouCan : 1;              ///< Apply fixes even if there are
                                            /// unfixable errors.
@@ -219,6 +222,13 @@ public:
   /// If given, filter dumped AST Decl nodes by this substring.
   std::string ASTDumpFilter;
 
+  /// If given, the file to write a Chrome trace of the compilation phases to.
+  std::string TimeTracePath;
+
+  /// If given, the file to write the cost of template instantiations to, as
+  /// JSON.
+  std::string TemplateProfilePath;
+
   /// If given, enable code completion at the provided location.
   ParsedSourceLocation CodeCompletionAt;
 
@@ -271,7 +281,8 @@ public:
 public:
   FrontendOptions() :
     DisableFree(false), RelocatablePCH(false), ShowHelp(false),
-    ShowStats(false), ShowTimers(false), ShowVersion(false),
+    ShowStats(false), ShowTimers(false), PrintTemplateProfile(false),
+    ShowVersion(false),
     FixWhatYouCan(false), FixOnlyWarnings(false), FixAndRecompile(false),
     FixToTemporaries(false), ARCMTMigrateEmitARCErrors(false),
     SkipFunctionBodies(false), UseGlobalModuleIndex(true),
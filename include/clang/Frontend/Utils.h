@@ -168,9 +168,18 @@ void AttachHeaderIncludeGen(Preprocessor &PP,
                             StringRef OutputPath = "",
                             bool ShowDepth = true, bool MSStyle = false);
 
+/// AttachTimeTraceGen - Create a generator of an event for each source file in
+/// the TimeTraceProfiler of the current thread, if there is one, and attach it
+/// to the given preprocessor.
+void AttachTimeTraceGen(Preprocessor &PP);
+
 /// Cache tokens for use with PCH. Note that this requires a seekable stream.
 void CacheTokens(Preprocessor &PP, raw_pwrite_stream *OS);
 
+/// Write the token caches of the headers that the header token cache of \p PP
+/// missed.
+void CacheHeaderTokens(Preprocessor &PP);
+
 /// The ChainedIncludesSource class converts headers to chained PCHs in
 /// memory, mainly for testing.
 IntrusiveRefCntPtr<ExternalSemaSource>
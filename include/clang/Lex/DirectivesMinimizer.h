@@ -0,0 +1,43 @@
+//===--- DirectivesMinimizer.h - Strip a file to its directives -*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file
+/// \brief Defines minimizeSourceToDirectives, which strips a source file down
+/// to the preprocessor directives that determine its dependencies.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_CLANG_LEX_DIRECTIVESMINIMIZER_H
+#define LLVM_CLANG_LEX_DIRECTIVESMINIMIZER_H
+
+#include "clang/Basic/LLVM.h"
+#include "llvm/ADT/SmallVector.h"
+
+namespace llvm {
+class MemoryBuffer;
+}
+
+namespace clang {
+class LangOptions;
+
+/// \brief Copy the preprocessor directives of \p Input to \p Output, dropping
+/// every other token, comment and blank line.
+///
+/// Preprocessing the result defines the same macros and includes the same
+/// files as preprocessing \p Input does, as long as the directives don't
+/// depend on the line numbers, on _Pragma or on modules imported by
+/// \@import. Each directive is copied verbatim, including its comments and
+/// escaped newlines, and followed by a newline.
+void minimizeSourceToDirectives(const llvm::MemoryBuffer &Input,
+                                const LangOptions &LangOpts,
+                                SmallVectorImpl<char> &Output);
+
+} // end namespace clang
+
+#endif
@@ -235,11 +235,31 @@ class HeaderSearch {
 
   /// \brief Entity used to look up stored header file information.
   ExternalHeaderFileInfoSource *ExternalSource;
-  
+
+  /// This structure is used to record entries in the header guard cache.
+  struct HeaderGuardCacheEntry {
+    /// The modification time and size of the header when its controlling
+    /// macro was found.
+    uint64_t ModTime, Size;
+
+    /// The name of the controlling macro of the header.
+    std::string ControllingMacro;
+
+    HeaderGuardCacheEntry() : ModTime(0), Size(0) {}
+  };
+
+  /// \brief The controlling macros of headers found by previous compilations,
+  /// loaded from the header guard cache file and keyed by the absolute path of
+  /// the header.
+  llvm::StringMap<HeaderGuardCacheEntry> HeaderGuardCache;
+  bool HeaderGuardCacheLoaded;
+
   // Various statistics we track for performance analysis.
   unsigned NumIncluded;
   unsigned NumMultiIncludeFileOptzn;
+  unsigned NumHeaderGuardCacheOptzn;
   unsigned NumFrameworkLookups, NumSubFrameworkLookups;
+  unsigned NumDirLookupsAvoided;
 
   const LangOptions &LangOpts;
 
@@ -505,6 +525,12 @@ public:
   
   void IncrementFrameworkLookupCount() { ++NumFrameworkLookups; }
 
+  /// \brief Determine whether the search directory \p Dir may contain the
+  /// file \p Filename, from a listing of \p Dir rather than a lookup of the
+  /// file, which is much cheaper when most search directories don't contain
+  /// the file.
+  bool mayContainFile(const DirectoryEntry *Dir, StringRef Filename);
+
   /// \brief Determine whether there is a module map that may map the header
   /// with the given file name to a (sub)module.
   /// Always returns false if modules are disabled.
@@ -634,6 +660,11 @@ public:
   /// \brief Retrieve a uniqued framework name.
   StringRef getUniqueFrameworkName(StringRef Framework);
   
+  /// \brief Record the controlling macros of the headers included so far in
+  /// the header guard cache file, so that later compilations don't need to
+  /// open these headers to know that including them again has no effect.
+  void writeHeaderGuardCache();
+
   void PrintStats();
   
   size_t getTotalMemory() const;
@@ -642,6 +673,18 @@ public:
                                               FileManager &FileMgr);
 
 private:
+  /// \brief Retrieve the controlling macro recorded for \p File by a previous
+  /// compilation, or null if there is none or the file has changed since.
+  const IdentifierInfo *getCachedControllingMacro(Preprocessor &PP,
+                                                  const FileEntry *File);
+
+  /// \brief Load the header guard cache file into \p Cache.
+  void readHeaderGuardCache(llvm::StringMap<HeaderGuardCacheEntry> &Cache);
+
+  /// \brief Merge the controlling macros of the headers included so far into
+  /// the header guard cache file. The caller holds the lock of the file.
+  void updateHeaderGuardCache();
+
   /// \brief Describes what happened when we tried to load a module map file.
   enum LoadModuleMapResult {
     /// \brief The module map file had already been loaded.
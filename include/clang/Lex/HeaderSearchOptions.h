@@ -96,6 +96,10 @@ public:
   /// The module/pch container format.
   std::string ModuleFormat;
 
+  /// \brief The file used to remember the include guards of headers between
+  /// compilations.
+  std::string HeaderGuardCachePath;
+
   /// \brief Whether we should disable the use of the hash string within the
   /// module cache.
   ///
@@ -0,0 +1,114 @@
+//===--- HeaderTokenCache.h - Shared cache of header tokens -----*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file
+/// \brief Defines the HeaderTokenCache class, which lexes headers from PTH
+/// files shared between compilations.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_CLANG_LEX_HEADERTOKENCACHE_H
+#define LLVM_CLANG_LEX_HEADERTOKENCACHE_H
+
+#include "clang/Basic/LLVM.h"
+#include "clang/Basic/SourceLocation.h"
+#include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/DenseSet.h"
+#include "llvm/ADT/StringMap.h"
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace llvm {
+class MemoryBuffer;
+}
+
+namespace clang {
+
+class PTHLexer;
+class PTHManager;
+class Preprocessor;
+
+/// \brief A directory of PTH files, each holding the tokens and the
+/// conditional directive table of one header.
+///
+/// A PTH file is named after a hash of the contents of the header and of the
+/// language options that affect lexing, so it can be used by every
+/// compilation that includes a header with these contents, wherever the
+/// header is. PTH files are memory mapped and never modified once written,
+/// so concurrent compilations can share them.
+///
+/// The headers whose PTH file is missing are recorded, for CacheHeaderTokens
+/// to write their PTH files at the end of the compilation.
+///
+/// Tokens replayed from a PTH file are not diagnosed by the lexer again, so
+/// headers the lexer diagnosed while they were lexed, even with a diagnostic
+/// that was ignored, are never cached. Neither are headers in which a
+/// conditional block was skipped, since the lexer doesn't diagnose skipped
+/// blocks, which another compilation may enter.
+class HeaderTokenCache {
+  Preprocessor &PP;
+  std::string Dir;
+
+  /// The hash of the language options that affect lexing.
+  std::string LangOptsHash;
+
+  /// The PTH files which were opened, by key, or null for the keys which
+  /// have no PTH file.
+  llvm::StringMap<std::unique_ptr<PTHManager>> Files;
+
+  /// The files entered without a PTH file, with their keys.
+  std::vector<std::pair<FileID, std::string>> MissedFiles;
+
+  /// The files the lexer issued diagnostics or skipped conditional blocks in.
+  llvm::DenseSet<FileID> UncacheableFiles;
+
+  unsigned NumHits, NumMisses;
+
+  /// \brief Returns the key of the PTH file of a header with contents \p Buf.
+  std::string getKey(const llvm::MemoryBuffer &Buf) const;
+
+public:
+  HeaderTokenCache(Preprocessor &PP, StringRef Dir);
+  ~HeaderTokenCache();
+
+  StringRef getDirectory() const { return Dir; }
+
+  /// \brief Returns the path of the PTH file with key \p Key.
+  std::string getPath(StringRef Key) const;
+
+  /// \brief Returns a PTHLexer for the file \p FID, or null if \p FID isn't
+  /// a header or has no PTH file.
+  PTHLexer *CreateLexer(FileID FID);
+
+  /// \brief Returns the headers without a PTH file entered so far, with the
+  /// key of the PTH file they should be given.
+  ArrayRef<std::pair<FileID, std::string>> getMissedFiles() const {
+    return MissedFiles;
+  }
+
+  /// \brief Records that the lexer issued a diagnostic at \p Loc, so that
+  /// the file it is in isn't cached.
+  void noteLexerDiagnostic(SourceLocation Loc);
+
+  /// \brief Records that the conditional block starting at \p IfLoc was
+  /// skipped, so that the file it is in isn't cached.
+  void noteSkippedBlock(SourceLocation IfLoc);
+
+  /// \brief Returns true if the lexer issued a diagnostic or skipped a
+  /// conditional block in \p FID.
+  bool isUncacheable(FileID FID) const { return UncacheableFiles.count(FID); }
+
+  void PrintStats() const;
+};
+
+} // end namespace clang
+
+#endif
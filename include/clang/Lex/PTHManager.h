@@ -83,6 +83,11 @@ class PTHManager : public IdentifierInfoLookup {
   ///  if the file (if any) that was to used to generate the PTH cache.
   const char* OriginalSourceFile;
 
+  /// UsesPPIdentifiers - True if the identifiers in the PTH file are looked
+  ///  up in the preprocessor's identifier table, instead of this PTHManager
+  ///  being the external lookup of that table.
+  bool UsesPPIdentifiers;
+
   /// This constructor is intended to only be called by the static 'Create'
   /// method.
   PTHManager(std::unique_ptr<const llvm::MemoryBuffer> buf,
@@ -109,6 +114,16 @@ class PTHManager : public IdentifierInfoLookup {
   }
   IdentifierInfo* LazilyCreateIdentifierInfo(unsigned PersistentID);
 
+  /// Create - Creates a PTHManager for the PTH file in \p File, reporting
+  ///  errors to \p Diags if not null.
+  static PTHManager *Create(std::unique_ptr<llvm::MemoryBuffer> File,
+                            StringRef FileName, DiagnosticsEngine *Diags);
+
+  /// createLexerAt - Return a PTHLexer for the token data at the given
+  ///  offsets of the PTH file.
+  PTHLexer *createLexerAt(FileID FID, uint32_t TokenOffset,
+                          uint32_t PPCondOffset);
+
 public:
   // The current PTH version.
   enum { Version = 10 };
@@ -131,6 +146,14 @@ public:
   ///  is the name of the PTH file.  This method returns NULL upon failure.
   static PTHManager *Create(StringRef file, DiagnosticsEngine &Diags);
 
+  /// CreateForHeader - Creates a PTHManager for a PTH file of the header token
+  ///  cache, which holds the tokens of a single header.  Unlike the PTH file
+  ///  of a translation unit, its identifiers are looked up in the identifier
+  ///  table of the preprocessor.  This method returns NULL if the file is
+  ///  invalid.
+  static PTHManager *
+  CreateForHeader(std::unique_ptr<llvm::MemoryBuffer> File);
+
   void setPreprocessor(Preprocessor *pp) { PP = pp; }
 
   /// CreateLexer - Return a PTHLexer that "lexes" the cached tokens for the
@@ -138,6 +161,10 @@ public:
   ///  It is the responsibility of the caller to 'delete' the returned object.
   PTHLexer *CreateLexer(FileID FID);
 
+  /// CreateLexer - Return a PTHLexer that "lexes" the cached tokens stored
+  ///  under \p Name for the specified file.
+  PTHLexer *CreateLexer(FileID FID, StringRef Name);
+
   /// createStatCache - Returns a FileSystemStatCache object for use with
   ///  FileManager objects.  These objects use the PTH data to speed up
   ///  calls to stat by memoizing their results from when the PTH file
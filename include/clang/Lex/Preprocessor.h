@@ -30,6 +30,7 @@
 #include "llvm/ADT/IntrusiveRefCntPtr.h"
 #include "llvm/ADT/SmallPtrSet.h"
 #include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/StringMap.h"
 #include "llvm/ADT/TinyPtrVector.h"
 #include "llvm/Support/Allocator.h"
 #include "llvm/Support/Registry.h"
@@ -55,6 +56,7 @@ class TargetInfo;
 class PPCallbacks;
 class CodeCompletionHandler;
 class DirectoryLookup;
+class HeaderTokenCache;
 class PreprocessingRecord;
 class ModuleLoader;
 class PTHManager;
@@ -114,6 +116,10 @@ class Preprocessor : public RefCountedBase<Preprocessor> {
   /// a token cache rather than lexing the original source file.
   std::unique_ptr<PTHManager> PTH;
 
+  /// An optional cache of the tokens of headers, shared between
+  /// compilations.
+  std::unique_ptr<HeaderTokenCache> HeaderTokens;
+
   /// A BumpPtrAllocator object used to quickly allocate and release
   /// objects internal to the Preprocessor.
   llvm::BumpPtrAllocator BP;
@@ -370,6 +376,75 @@ class Preprocessor : public RefCountedBase<Preprocessor> {
   };
   SmallVector<MacroExpandsInfo, 2> DelayedMacroExpandsCallbacks;
 
+  /// \brief A recorded expansion of a macro which only depends on the macro
+  /// definitions and, for a function-like macro, on the spelling and layout
+  /// of its arguments, so that later identical expansions of the macro can
+  /// replay it instead of expanding it again.
+  ///
+  /// Only built with -cache-macro-expansions; see EnterCachedMacroExpansion.
+  struct CachedMacroExpansion {
+    /// A location within the expansion: the index of the macro expansion
+    /// SLocEntry it is in, or ~0U for the macro invocation, and its offset in
+    /// that entry, or from the expanded macro name.
+    struct RelativeLoc {
+      unsigned Entry, Offset;
+    };
+
+    /// A macro expansion SLocEntry created by the expansion.
+    struct ExpansionEntry {
+      /// The spelling location of the entry, or an invalid location if it is
+      /// spelled in the macro invocation or in an earlier entry, at Spelling.
+      SourceLocation SpellingLoc;
+      RelativeLoc Spelling, ExpansionStart, ExpansionEnd;
+      unsigned Length;
+      /// Whether this is the expansion of a macro argument, which has no
+      /// ExpansionEnd.
+      bool IsMacroArg;
+    };
+
+    /// A macro expanded by the expansion, for the MacroExpands callbacks.
+    struct NestedExpansion {
+      Token MacroNameTok;
+      RelativeLoc Start, End;
+    };
+
+    /// The value of MacroDefinitionGeneration the expansion was recorded in.
+    unsigned Generation;
+
+    /// Whether the expansion can be replayed. This is false if the expansion
+    /// depends on more than the macro definitions and arguments.
+    bool IsCacheable;
+
+    /// Whether the expansion was recorded. An invocation of a function-like
+    /// macro is only recorded the second time it is seen, since most
+    /// invocations have arguments of their own.
+    bool IsRecorded;
+
+    /// The macros the expansion expands, which must not be disabled when the
+    /// expansion is replayed.
+    SmallVector<MacroInfo *, 4> NestedMacros;
+
+    SmallVector<ExpansionEntry, 4> Entries;
+    SmallVector<NestedExpansion, 4> NestedExpansions;
+    SmallVector<Token, 8> Tokens;
+    SmallVector<RelativeLoc, 8> TokenLocs;
+
+    CachedMacroExpansion()
+        : Generation(~0U), IsCacheable(false), IsRecorded(false) {}
+  };
+
+  /// \brief The recorded macro expansions, keyed by the MacroInfo and, for
+  /// function-like macros, the spelling and layout of the arguments.
+  llvm::StringMap<CachedMacroExpansion> MacroExpansionCache;
+
+  /// \brief Incremented whenever a macro is defined or undefined, or an
+  /// identifier is poisoned, which invalidates the MacroExpansionCache.
+  unsigned MacroDefinitionGeneration;
+
+  /// \brief The macros expanded so far while recording an expansion for the
+  /// MacroExpansionCache, if one is being recorded.
+  SmallVectorImpl<std::pair<Token, SourceRange>> *RecordedMacroExpansions;
+
   /// Information about a name that has been used to define a module macro.
   struct ModuleMacroInfo {
     ModuleMacroInfo(MacroDirective *MD)
@@ -581,6 +656,8 @@ class Preprocessor : public RefCountedBase<Preprocessor> {
   unsigned NumMacroExpanded, NumFnMacroExpanded, NumBuiltinMacroExpanded;
   unsigned NumFastMacroExpanded, NumTokenPaste, NumFastTokenPaste;
   unsigned NumSkipped;
+  unsigned NumMacroExpansionsCached, NumCachedMacroExpanded;
+  unsigned NumCachedFnMacroExpanded;
 
   /// \brief The predefined macros that preprocessor should use from the
   /// command line etc.
@@ -704,6 +781,10 @@ public:
 
   PTHManager *getPTHManager() { return PTH.get(); }
 
+  void setHeaderTokenCache(std::unique_ptr<HeaderTokenCache> Cache);
+
+  HeaderTokenCache *getHeaderTokenCache() { return HeaderTokens.get(); }
+
   void setExternalSource(ExternalPreprocessorSource *Source) {
     ExternalSource = Source;
   }
@@ -1780,6 +1861,25 @@ private:
   /// otherwise the caller should lex again.
   bool HandleMacroExpandedIdentifier(Token &Tok, const MacroDefinition &MD);
 
+  /// \brief Enter the expansion of the macro \p MI with arguments \p Args
+  /// from the MacroExpansionCache, recording it first if needed.
+  ///
+  /// \returns false if the expansion of \p MI can't be cached, in which case
+  /// the caller should expand the macro as usual. Otherwise, this takes
+  /// ownership of \p Args.
+  bool EnterCachedMacroExpansion(Token &Identifier, SourceLocation ExpansionEnd,
+                                 MacroInfo *MI, MacroArgs *Args);
+
+  /// \brief Expand the macro \p MI with arguments \p Args, and record the
+  /// expansion in \p Cached.
+  void RecordMacroExpansion(Token &Identifier, SourceLocation ExpansionEnd,
+                            MacroInfo *MI, MacroArgs *Args,
+                            CachedMacroExpansion &Cached);
+
+  /// \brief Returns the approximate number of bytes used by the
+  /// MacroExpansionCache.
+  size_t getMacroExpansionCacheMemory() const;
+
   /// \brief Cache macro expanded tokens for TokenLexers.
   //
   /// Works like a stack; a TokenLexer adds the macro expanded tokens that is
@@ -55,6 +55,14 @@ public:
   /// definitions and expansions.
   unsigned DetailedRecord : 1;
 
+  /// \brief Whether the line tables of the files entered should be computed
+  /// on another thread, for clients which will need their line numbers.
+  unsigned PrefetchLineTables : 1;
+
+  /// \brief Whether macro expansions which only depend on the macro
+  /// definitions and arguments should be recorded once and replayed.
+  unsigned CacheMacroExpansions : 1;
+
   /// The implicit PCH included at the start of the translation unit, or empty.
   std::string ImplicitPCHInclude;
 
@@ -89,6 +97,10 @@ public:
   /// If given, a PTH cache file to use for speeding up header parsing.
   std::string TokenCache;
 
+  /// If given, a directory of token caches of headers, shared between
+  /// compilations.
+  std::string TokenCacheDir;
+
   /// \brief True if the SourceManager should report the original file name for
   /// contents of files that were remapped to other files. Defaults to true.
   bool RemappedFilesKeepOriginalName;
@@ -141,6 +153,8 @@ public:
 
 public:
   PreprocessorOptions() : UsePredefines(true), DetailedRecord(false),
+                          PrefetchLineTables(false),
+                          CacheMacroExpansions(false),
                           DisablePCHValidation(false),
                           AllowPCHWithCompilerErrors(false),
                           DumpDeserializedPCHDecls(false),
@@ -174,6 +188,7 @@ public:
     ImplicitPCHInclude.clear();
     ImplicitPTHInclude.clear();
     TokenCache.clear();
+    TokenCacheDir.clear();
     RetainRemappedFileBuffers = true;
     PrecompiledPreambleBytes.first = 0;
     PrecompiledPreambleBytes.second = 0;
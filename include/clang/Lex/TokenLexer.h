@@ -69,7 +69,7 @@ class TokenLexer {
   
   /// \brief The offset of the macro expansion in the
   /// "source location address space".
-  unsigned MacroStartSLocOffset;
+  SourceLocation::UIntTy MacroStartSLocOffset;
 
   /// \brief Location of the macro definition.
   SourceLocation MacroDefStart;
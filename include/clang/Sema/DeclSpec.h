@@ -914,7 +914,7 @@ public:
     /// Different operators have different numbers of tokens in their name,
     /// up to three. Any remaining source locations in this array will be
     /// set to an invalid value for operators with fewer than three tokens.
-    unsigned SymbolLocations[3];
+    SourceLocation::UIntTy SymbolLocations[3];
   };
 
   /// \brief Anonymous union that holds extra data associated with the
@@ -1117,16 +1117,16 @@ struct DeclaratorChunk {
     unsigned TypeQuals : 4;
 
     /// The location of the const-qualifier, if any.
-    unsigned ConstQualLoc;
+    SourceLocation::UIntTy ConstQualLoc;
 
     /// The location of the volatile-qualifier, if any.
-    unsigned VolatileQualLoc;
+    SourceLocation::UIntTy VolatileQualLoc;
 
     /// The location of the restrict-qualifier, if any.
-    unsigned RestrictQualLoc;
+    SourceLocation::UIntTy RestrictQualLoc;
 
     /// The location of the _Atomic-qualifier, if any.
-    unsigned AtomicQualLoc;
+    SourceLocation::UIntTy AtomicQualLoc;
 
     void destroy() {
     }
@@ -1224,13 +1224,13 @@ struct DeclaratorChunk {
     unsigned HasTrailingReturnType : 1;
 
     /// The location of the left parenthesis in the source.
-    unsigned LParenLoc;
+    SourceLocation::UIntTy LParenLoc;
 
     /// When isVariadic is true, the location of the ellipsis in the source.
-    unsigned EllipsisLoc;
+    SourceLocation::UIntTy EllipsisLoc;
 
     /// The location of the right parenthesis in the source.
-    unsigned RParenLoc;
+    SourceLocation::UIntTy RParenLoc;
 
     /// NumParams - This is the number of formal parameters specified by the
     /// declarator.
@@ -1243,32 +1243,32 @@ struct DeclaratorChunk {
     /// \brief The location of the ref-qualifier, if any.
     ///
     /// If this is an invalid location, there is no ref-qualifier.
-    unsigned RefQualifierLoc;
+    SourceLocation::UIntTy RefQualifierLoc;
 
     /// \brief The location of the const-qualifier, if any.
     ///
     /// If this is an invalid location, there is no const-qualifier.
-    unsigned ConstQualifierLoc;
+    SourceLocation::UIntTy ConstQualifierLoc;
 
     /// \brief The location of the volatile-qualifier, if any.
     ///
     /// If this is an invalid location, there is no volatile-qualifier.
-    unsigned VolatileQualifierLoc;
+    SourceLocation::UIntTy VolatileQualifierLoc;
 
     /// \brief The location of the restrict-qualifier, if any.
     ///
     /// If this is an invalid location, there is no restrict-qualifier.
-    unsigned RestrictQualifierLoc;
+    SourceLocation::UIntTy RestrictQualifierLoc;
 
     /// \brief The location of the 'mutable' qualifer in a lambda-declarator, if
     /// any.
-    unsigned MutableLoc;
+    SourceLocation::UIntTy MutableLoc;
 
     /// \brief The beginning location of the exception specification, if any.
-    unsigned ExceptionSpecLocBeg;
+    SourceLocation::UIntTy ExceptionSpecLocBeg;
 
     /// \brief The end location of the exception specification, if any.
-    unsigned ExceptionSpecLocEnd;
+    SourceLocation::UIntTy ExceptionSpecLocEnd;
 
     /// Params - This is a pointer to a new[]'d array of ParamInfo objects that
     /// describe the parameters specified by this function declarator.  null if
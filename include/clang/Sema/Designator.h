@@ -44,18 +44,18 @@ private:
 
   struct FieldDesignatorInfo {
     const IdentifierInfo *II;
-    unsigned DotLoc;
-    unsigned NameLoc;
+    SourceLocation::UIntTy DotLoc;
+    SourceLocation::UIntTy NameLoc;
   };
   struct ArrayDesignatorInfo {
     Expr *Index;
-    unsigned LBracketLoc;
-    mutable unsigned  RBracketLoc;
+    SourceLocation::UIntTy LBracketLoc;
+    mutable SourceLocation::UIntTy RBracketLoc;
   };
   struct ArrayRangeDesignatorInfo {
     Expr *Start, *End;
-    unsigned LBracketLoc, EllipsisLoc;
-    mutable unsigned RBracketLoc;
+    SourceLocation::UIntTy LBracketLoc, EllipsisLoc;
+    mutable SourceLocation::UIntTy RBracketLoc;
   };
 
   union {
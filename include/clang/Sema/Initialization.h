@@ -111,7 +111,7 @@ private:
     /// location of the 'return', 'throw', or 'new' keyword,
     /// respectively. When Kind == EK_Temporary, the location where
     /// the temporary is being created.
-    unsigned Location;
+    SourceLocation::UIntTy Location;
 
     /// \brief Whether the entity being initialized may end up using the
     /// named return value optimization (NRVO).
@@ -123,7 +123,7 @@ private:
     IdentifierInfo *VarID;
 
     /// \brief The source location at which the capture occurs.
-    unsigned Location;
+    SourceLocation::UIntTy Location;
   };
 
   union {
@@ -167,6 +167,7 @@ namespace clang {
   class TemplateDecl;
   class TemplateParameterList;
   class TemplatePartialOrderingContext;
+  class TemplateInstantiationProfiler;
   class TemplateTemplateParmDecl;
   class Token;
   class TypeAliasDecl;
@@ -448,6 +449,10 @@ public:
   /// FieldCollector - Collects CXXFieldDecls during parsing of C++ classes.
   std::unique_ptr<CXXFieldCollector> FieldCollector;
 
+  /// \brief If set, records the cost of the class and function template
+  /// instantiations.
+  std::unique_ptr<TemplateInstantiationProfiler> TemplateProfiler;
+
   typedef llvm::SmallSetVector<const NamedDecl*, 16> NamedDeclSetType;
 
   /// \brief Set containing all declared private fields that are not used.
@@ -0,0 +1,123 @@
+//===--- TemplateInstantiationProfiler.h - Instantiation costs --*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+//  This file defines the TemplateInstantiationProfiler class, which records
+//  the cost of the template instantiations Sema performs.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_CLANG_SEMA_TEMPLATEINSTANTIATIONPROFILER_H
+#define LLVM_CLANG_SEMA_TEMPLATEINSTANTIATIONPROFILER_H
+
+#include "clang/Basic/LLVM.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/SmallVector.h"
+#include <chrono>
+#include <vector>
+
+namespace clang {
+  class ASTContext;
+  class Decl;
+  class NamedDecl;
+
+/// \brief Records the time, the nested instantiations and the AST memory of
+/// each class and function template instantiation, and sums them up by
+/// primary template.
+///
+/// The members of a class template are counted separately from the class
+/// template itself, under the member of the template definition.
+class TemplateInstantiationProfiler {
+public:
+  typedef std::chrono::steady_clock Clock;
+
+  /// \brief The cost of the instantiations of one template.
+  struct Entry {
+    /// The primary template, or the member of a class template definition.
+    const NamedDecl *Template;
+    /// The number of instantiations.
+    unsigned Count;
+    /// The number of instantiations they triggered in turn.
+    unsigned Nested;
+    /// The bytes of AST they allocated.
+    uint64_t Bytes;
+    /// The time they took, including nested instantiations.
+    Clock::duration Total;
+    /// The time they took, excluding nested instantiations.
+    Clock::duration Self;
+  };
+
+private:
+  struct Frame {
+    const NamedDecl *Template;
+    Clock::time_point Start;
+    /// The time taken by the instantiations nested in this one.
+    Clock::duration Children;
+    size_t Bytes;
+    unsigned Instantiations;
+  };
+
+  const ASTContext &Context;
+
+  /// The instantiations which have not finished yet, innermost last.
+  SmallVector<Frame, 8> Stack;
+
+  /// The cost of each template. Instantiations nested in an instantiation
+  /// of the same template only add to its count and self time.
+  llvm::DenseMap<const NamedDecl *, Entry> Entries;
+
+  /// The number of instantiations begun so far.
+  unsigned NumInstantiations;
+
+  TemplateInstantiationProfiler(const TemplateInstantiationProfiler &) = delete;
+  void operator=(const TemplateInstantiationProfiler &) = delete;
+
+public:
+  explicit TemplateInstantiationProfiler(const ASTContext &Context)
+      : Context(Context), NumInstantiations(0) {}
+
+  /// \brief Begins the instantiation of a class or function.
+  void begin(const Decl *Instantiation);
+
+  /// \brief Ends the innermost instantiation which has not ended.
+  void end();
+
+  /// \brief Returns the cost of each template, most expensive first.
+  std::vector<Entry> getEntries() const;
+
+  /// \brief Prints the cost of each template as a table.
+  void printText(raw_ostream &OS) const;
+
+  /// \brief Prints the cost of each template as JSON.
+  void printJSON(raw_ostream &OS) const;
+
+  /// \brief Profiles an instantiation from its construction to its
+  /// destruction, if a profiler is given.
+  class Scope {
+    TemplateInstantiationProfiler *Profiler;
+
+    Scope(const Scope &) = delete;
+    void operator=(const Scope &) = delete;
+
+  public:
+    Scope(TemplateInstantiationProfiler *Profiler, const Decl *Instantiation)
+        : Profiler(Profiler) {
+      if (Profiler)
+        Profiler->begin(Instantiation);
+    }
+
+    ~Scope() {
+      if (Profiler)
+        Profiler->end();
+    }
+  };
+};
+
+} // end namespace clang
+
+#endif
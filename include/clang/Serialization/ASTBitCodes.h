@@ -22,6 +22,7 @@
 #include "llvm/ADT/DenseMap.h"
 #include "llvm/Bitcode/BitCodes.h"
 #include "llvm/Support/DataTypes.h"
+#include <cstring>
 
 namespace clang {
   namespace serialization {
@@ -162,44 +163,55 @@ namespace clang {
     /// \brief The number of predefined submodule IDs.
     const unsigned int NUM_PREDEF_SUBMODULE_IDS = 1;
 
+    /// \brief The raw encoding of a source location, kept in 32-bit words.
+    ///
+    /// Arrays of structures holding raw source locations are read in place
+    /// from AST file blobs, which are only 4-byte aligned, so a 64-bit
+    /// source location is split in two words.
+    class RawLocEncoding {
+      uint32_t Words[sizeof(SourceLocation::UIntTy) / sizeof(uint32_t)];
+
+    public:
+      RawLocEncoding(SourceLocation Loc = SourceLocation()) { set(Loc); }
+
+      void set(SourceLocation Loc) {
+        SourceLocation::UIntTy Raw = Loc.getRawEncoding();
+        memcpy(Words, &Raw, sizeof(Raw));
+      }
+      SourceLocation get() const {
+        SourceLocation::UIntTy Raw;
+        memcpy(&Raw, Words, sizeof(Raw));
+        return SourceLocation::getFromRawEncoding(Raw);
+      }
+    };
+
     /// \brief Source range/offset of a preprocessed entity.
     struct PPEntityOffset {
       /// \brief Raw source location of beginning of range.
-      unsigned Begin;
+      RawLocEncoding Begin;
       /// \brief Raw source location of end of range.
-      unsigned End;
+      RawLocEncoding End;
       /// \brief Offset in the AST file.
       uint32_t BitOffset;
 
       PPEntityOffset(SourceRange R, uint32_t BitOffset)
-        : Begin(R.getBegin().getRawEncoding()),
-          End(R.getEnd().getRawEncoding()),
-          BitOffset(BitOffset) { }
-      SourceLocation getBegin() const {
-        return SourceLocation::getFromRawEncoding(Begin);
-      }
-      SourceLocation getEnd() const {
-        return SourceLocation::getFromRawEncoding(End);
-      }
+        : Begin(R.getBegin()), End(R.getEnd()), BitOffset(BitOffset) { }
+      SourceLocation getBegin() const { return Begin.get(); }
+      SourceLocation getEnd() const { return End.get(); }
     };
 
     /// \brief Source range/offset of a preprocessed entity.
     struct DeclOffset {
       /// \brief Raw source location.
-      unsigned Loc;
+      RawLocEncoding Loc;
       /// \brief Offset in the AST file.
       uint32_t BitOffset;
 
-      DeclOffset() : Loc(0), BitOffset(0) { }
+      DeclOffset() : BitOffset(0) { }
       DeclOffset(SourceLocation Loc, uint32_t BitOffset)
-        : Loc(Loc.getRawEncoding()),
-          BitOffset(BitOffset) { }
-      void setLocation(SourceLocation L) {
-        Loc = L.getRawEncoding();
-      }
-      SourceLocation getLocation() const {
-        return SourceLocation::getFromRawEncoding(Loc);
-      }
+        : Loc(Loc), BitOffset(BitOffset) { }
+      void setLocation(SourceLocation L) { Loc.set(L); }
+      SourceLocation getLocation() const { return Loc.get(); }
     };
 
     /// \brief The number of predefined preprocessed entity IDs.
@@ -227,7 +227,7 @@ public:
   int SLocEntryBaseID;
 
   /// \brief The base offset in the source manager's view of this module.
-  unsigned SLocEntryBaseOffset;
+  SourceLocation::UIntTy SLocEntryBaseOffset;
 
   /// \brief Offsets for all of the source location entries in the
   /// AST file.
@@ -237,7 +237,8 @@ public:
   SmallVector<uint64_t, 4> PreloadSLocEntries;
 
   /// \brief Remapping table for source locations in this module.
-  ContinuousRangeMap<uint32_t, int, 2> SLocRemap;
+  ContinuousRangeMap<SourceLocation::UIntTy, SourceLocation::IntTy, 2>
+      SLocRemap;
 
   // === Identifiers ===
 
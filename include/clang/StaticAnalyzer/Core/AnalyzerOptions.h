@@ -250,6 +250,9 @@ private:
   /// \sa getGraphTrimInterval
   Optional<unsigned> GraphTrimInterval;
 
+  /// \sa shouldCompactGraph
+  Optional<bool> CompactGraph;
+
   /// \sa getMaxTimesInlineLarge
   Optional<unsigned> MaxTimesInlineLarge;
 
@@ -265,6 +268,12 @@ private:
   /// \sa shouldWidenLoops
   Optional<bool> WidenLoops;
 
+  /// \sa getShardCount
+  Optional<unsigned> ShardCount;
+
+  /// \sa getShardIndex
+  Optional<unsigned> ShardIndex;
+
   /// A helper function that retrieves option for a given full-qualified
   /// checker name.
   /// Options for checkers can be specified via 'analyzer-config' command-line
@@ -506,6 +515,15 @@ public:
   /// node reclamation, set the option to "0".
   unsigned getGraphTrimInterval();
 
+  /// Returns true if node reclamation should also recycle the nodes that are
+  /// only kept to make path notes more precise, such as those for lvalue
+  /// expressions. This trades the precision of some path notes for a smaller
+  /// exploded graph; the same bugs are found.
+  ///
+  /// This is controlled by the 'compact-graph' config option, which defaults
+  /// to false. It has no effect if 'graph-trim-interval' is 0.
+  bool shouldCompactGraph();
+
   /// Returns the maximum times a large function could be inlined.
   ///
   /// This is controlled by the 'max-times-inline-large' config option.
@@ -533,6 +551,32 @@ public:
   /// This is controlled by the 'widen-loops' config option.
   bool shouldWidenLoops();
 
+  /// Returns the number of shards the top level functions of the translation
+  /// unit are split into. Each analyzer invocation only analyzes the
+  /// functions of the shard given by getShardIndex(), so that several
+  /// invocations can analyze one translation unit concurrently. Without
+  /// inlining, the first shard analyzes all functions.
+  /// 1 is default, which analyzes all functions.
+  ///
+  /// This is controlled by the 'shard-count' config option.
+  unsigned getShardCount();
+
+  /// Returns the shard of top level functions to analyze, between 0 and
+  /// getShardCount() - 1. Checks that are not path-sensitive only run in
+  /// shard 0.
+  ///
+  /// This is controlled by the 'shard-index' config option.
+  unsigned getShardIndex();
+
+  /// Returns the directory in which the results of analyzing top level
+  /// functions are kept between analyzer invocations. A function whose
+  /// previous analysis found no bugs is not analyzed again as long as neither
+  /// it, nor the code it depends on, nor the analyzer configuration changed.
+  /// The cache is disabled if the path is empty, which is the default.
+  ///
+  /// This is controlled by the 'summary-cache-dir' config option.
+  StringRef getSummaryCacheDir();
+
 public:
   AnalyzerOptions() :
     AnalysisStoreOpt(RegionStoreModel),
@@ -273,6 +273,10 @@ protected:
   
   /// A list of recently allocated nodes that can potentially be recycled.
   NodeVector ChangedNodes;
+
+  /// Nodes that had no successor yet the last time nodes were reclaimed.
+  /// They get one more chance to be recycled.
+  NodeVector PendingNodes;
   
   /// A list of nodes that can be reused.
   NodeVector FreeNodes;
@@ -281,6 +285,10 @@ protected:
   ///
   /// If this is 0, nodes will never be reclaimed.
   unsigned ReclaimNodeInterval;
+
+  /// Whether nodes that are only kept for precise path notes are reclaimed
+  /// as well.
+  bool CompactNodes;
   
   /// Counter to determine when to reclaim nodes.
   unsigned ReclaimCounter;
@@ -376,13 +384,16 @@ public:
        InterExplodedGraphMap *InverseMap = nullptr) const;
 
   /// Enable tracking of recently allocated nodes for potential reclamation
-  /// when calling reclaimRecentlyAllocatedNodes().
-  void enableNodeReclamation(unsigned Interval) {
+  /// when calling reclaimRecentlyAllocatedNodes(). If \p Compact is true,
+  /// nodes that are only kept for precise path notes are reclaimed as well.
+  void enableNodeReclamation(unsigned Interval, bool Compact = false) {
     ReclaimCounter = ReclaimNodeInterval = Interval;
+    CompactNodes = Compact;
   }
 
   /// Reclaim "uninteresting" nodes created since the last time this method
-  /// was called.
+  /// was called, as well as nodes that were still on the frontier the last
+  /// time.
   void reclaimRecentlyAllocatedNodes();
 
   /// \brief Returns true if nodes for the given expression kind are always
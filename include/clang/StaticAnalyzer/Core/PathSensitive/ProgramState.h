@@ -448,6 +448,12 @@ private:
   /// Eng - The SubEngine that owns this state manager.
   SubEngine *Eng; /* Can be null. */
 
+  /// Allocators for the environments and the generic data maps of the
+  /// states. They are kept apart from \c Alloc so that the memory used by
+  /// each component of the states can be reported.
+  llvm::BumpPtrAllocator EnvironmentAlloc;
+  llvm::BumpPtrAllocator GDMAlloc;
+
   EnvironmentManager                   EnvMgr;
   std::unique_ptr<StoreManager>        StoreMgr;
   std::unique_ptr<ConstraintManager>   ConstraintMgr;
@@ -495,6 +501,19 @@ public:
     return *svalBuilder;
   }
 
+  /// Returns the number of bytes allocated for the environments of all
+  /// states.
+  size_t getEnvironmentMemory() const {
+    return EnvironmentAlloc.getTotalMemory();
+  }
+
+  /// Returns the number of bytes allocated for the stores of all states.
+  size_t getStoreMemory() const { return StoreMgr->getTotalMemory(); }
+
+  /// Returns the number of bytes allocated for the generic data maps of all
+  /// states, including the data checkers keep in them.
+  size_t getGDMMemory() const { return GDMAlloc.getTotalMemory(); }
+
   SymbolManager &getSymbolManager() {
     return svalBuilder->getSymbolManager();
   }
@@ -232,6 +232,10 @@ public:
   /// iterBindings - Iterate over the bindings in the Store.
   virtual void iterBindings(Store store, BindingsHandler& f) = 0;
 
+  /// Returns the number of bytes allocated for the bindings of all stores
+  /// created by this manager.
+  virtual size_t getTotalMemory() const { return 0; }
+
 protected:
   const MemRegion *MakeElementRegion(const MemRegion *baseRegion,
                                      QualType pointeeTy, uint64_t index = 0);
@@ -21,6 +21,7 @@
 
 #include "clang/Tooling/Core/Replacement.h"
 #include "clang/Tooling/Tooling.h"
+#include "llvm/Support/Mutex.h"
 #include <string>
 
 namespace clang {
@@ -46,6 +47,14 @@ public:
   /// be added during the run of the tool.
   Replacements &getReplacements();
 
+  /// \brief Adds \p Replaces to the set returned by getReplacements().
+  ///
+  /// Unlike inserting into getReplacements() directly, this may be called
+  /// from actions running concurrently (see ClangTool::setNumThreads()).
+  /// Since the replacements are kept ordered, the merged result does not
+  /// depend on the order in which translation units finish.
+  void addReplacements(const Replacements &Replaces);
+
   /// \brief Call run(), apply all generated replacements, and immediately save
   /// the results to disk.
   ///
@@ -66,6 +75,7 @@ private:
 
 private:
   Replacements Replace;
+  llvm::sys::Mutex ReplaceLock;
 };
 
 /// \brief Groups \p Replaces by the file path and applies each group of
@@ -40,6 +40,7 @@
 #include "clang/Lex/ModuleLoader.h"
 #include "clang/Tooling/ArgumentsAdjusters.h"
 #include "clang/Tooling/CompilationDatabase.h"
+#include "llvm/ADT/STLExtras.h"
 #include "llvm/ADT/StringMap.h"
 #include "llvm/ADT/Twine.h"
 #include "llvm/Option/Option.h"
@@ -318,25 +319,54 @@ class ClangTool {
   /// \brief Clear the command line arguments adjuster chain.
   void clearArgumentsAdjusters();
 
+  /// \brief Set the number of translation units processed concurrently by
+  /// run().
+  ///
+  /// With a value greater than one, the compile commands for all source files
+  /// are collected up front and then processed on a pool of \p NumThreads
+  /// worker threads. Each translation unit gets its own FileManager and
+  /// working directory, and diagnostics are serialized so output from
+  /// different translation units is never interleaved. The ToolAction passed
+  /// to run() is shared between the workers and must be thread-safe.
+  ///
+  /// A value of 0 uses one thread per hardware thread.
+  void setNumThreads(unsigned NumThreads);
+
+  /// \brief Serve file status and contents from \p Cache.
+  ///
+  /// The cache deduplicates the stat calls and reads of headers that are
+  /// included by many translation units, and may be shared by several tools
+  /// in the same process. This resets the file manager returned by getFiles(),
+  /// so it should be called before the tool is run.
+  void setFileSystemCache(IntrusiveRefCntPtr<vfs::SharedFileSystemCache> Cache);
+
   /// Runs an action over all files specified in the command line.
   ///
   /// \param Action Tool action.
   int run(ToolAction *Action);
 
   /// \brief Create an AST for each file specified in the command line and
-  /// append them to ASTs.
+  /// append them to ASTs, in the order of the files, even when they are
+  /// processed in parallel.
   int buildASTs(std::vector<std::unique_ptr<ASTUnit>> &ASTs);
 
   /// \brief Returns the file manager used in the tool.
   ///
-  /// The file manager is shared between all translation units.
+  /// The file manager is shared between all translation units, unless they
+  /// are processed in parallel (see setNumThreads()).
   FileManager &getFiles() { return *Files; }
 
  private:
+  /// \brief Runs the compile commands on a pool of threads, each with the
+  /// action \p NextAction returns for it. \p NextAction is called on the
+  /// calling thread, once per compile command, in the order of SourcePaths.
+  int runInParallel(llvm::function_ref<ToolAction *()> NextAction);
+
   const CompilationDatabase &Compilations;
   std::vector<std::string> SourcePaths;
   std::shared_ptr<PCHContainerOperations> PCHContainerOps;
 
+  llvm::IntrusiveRefCntPtr<vfs::SharedFileSystemCache> FileSystemCache;
   llvm::IntrusiveRefCntPtr<vfs::OverlayFileSystem> OverlayFileSystem;
   llvm::IntrusiveRefCntPtr<vfs::InMemoryFileSystem> InMemoryFileSystem;
   llvm::IntrusiveRefCntPtr<FileManager> Files;
@@ -347,6 +377,8 @@ class ClangTool {
   ArgumentsAdjuster ArgsAdjuster;
 
   DiagnosticConsumer *DiagConsumer;
+
+  unsigned NumThreads;
 };
 
 template <typename T>
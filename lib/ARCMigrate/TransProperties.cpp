@@ -66,7 +66,7 @@ class PropertiesRewriter {
   };
 
   typedef SmallVector<PropData, 2> PropsTy;
-  typedef std::map<unsigned, PropsTy> AtPropDeclsTy;
+  typedef std::map<SourceLocation::UIntTy, PropsTy> AtPropDeclsTy;
   AtPropDeclsTy AtProps;
   llvm::DenseMap<IdentifierInfo *, PropActionKind> ActionOnProp;
 
@@ -79,7 +79,7 @@ public:
     for (auto *Prop : D->instance_properties()) {
       if (Prop->getAtLoc().isInvalid())
         continue;
-      unsigned RawLoc = Prop->getAtLoc().getRawEncoding();
+      SourceLocation::UIntTy RawLoc = Prop->getAtLoc().getRawEncoding();
       if (PrevAtProps)
         if (PrevAtProps->find(RawLoc) != PrevAtProps->end())
           continue;
@@ -114,7 +114,7 @@ public:
       ObjCIvarDecl *ivarD = implD->getPropertyIvarDecl();
       if (!ivarD || ivarD->isInvalidDecl())
         continue;
-      unsigned rawAtLoc = propD->getAtLoc().getRawEncoding();
+      SourceLocation::UIntTy rawAtLoc = propD->getAtLoc().getRawEncoding();
       AtPropDeclsTy::iterator findAtLoc = AtProps.find(rawAtLoc);
       if (findAtLoc == AtProps.end())
         continue;
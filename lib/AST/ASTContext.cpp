@@ -13,6 +13,8 @@
 
 #include "clang/AST/ASTContext.h"
 #include "CXXABI.h"
+#include "ConstexprCallCache.h"
+#include "ConstexprInterpreter.h"
 #include "clang/AST/ASTMutationListener.h"
 #include "clang/AST/Attr.h"
 #include "clang/AST/CharUnits.h"
@@ -871,6 +873,9 @@ void ASTContext::PrintStats() const {
                << NumImplicitDestructors
                << " implicit destructors created\n";
 
+  if (ConstexprCalls)
+    ConstexprCalls->PrintStats();
+
   if (ExternalSource) {
     llvm::errs() << "\n";
     ExternalSource->PrintStats();
@@ -8618,6 +8623,18 @@ VTableContextBase *ASTContext::getVTableContext() {
   return VTContext.get();
 }
 
+ConstexprInterpreter &ASTContext::getConstexprInterpreter() {
+  if (!ConstexprInterp)
+    ConstexprInterp.reset(new ConstexprInterpreter(*this));
+  return *ConstexprInterp;
+}
+
+ConstexprCallCache &ASTContext::getConstexprCallCache() {
+  if (!ConstexprCalls)
+    ConstexprCalls.reset(new ConstexprCallCache());
+  return *ConstexprCalls;
+}
+
 MangleContext *ASTContext::createMangleContext() {
   switch (Target->getCXXABI().getKind()) {
   case TargetCXXABI::GenericAArch64:
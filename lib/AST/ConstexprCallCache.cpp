@@ -0,0 +1,92 @@
+//===--- ConstexprCallCache.cpp - Results of constexpr calls --------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+//  This file implements the ConstexprCallCache class.
+//
+//===----------------------------------------------------------------------===//
+
+#include "ConstexprCallCache.h"
+#include "clang/AST/Decl.h"
+#include "llvm/Support/raw_ostream.h"
+using namespace clang;
+
+static void profileCall(llvm::FoldingSetNodeID &ID, const FunctionDecl *FD,
+                        ArrayRef<APValue> Args, unsigned Mode) {
+  ID.AddPointer(FD->getCanonicalDecl());
+  ID.AddInteger(Mode);
+  for (const APValue &Arg : Args) {
+    ID.AddInteger(Arg.getKind());
+    if (Arg.isInt())
+      Arg.getInt().Profile(ID);
+    else
+      Arg.getFloat().Profile(ID);
+  }
+}
+
+ConstexprCallCache::ConstexprCallCache()
+    : NumEntries(0), NumLookups(0), NumHits(0), NumFlushes(0) {}
+
+ConstexprCallCache::~ConstexprCallCache() { clear(); }
+
+void ConstexprCallCache::clear() {
+  // The entries live in the allocator, but their results may own memory.
+  for (auto I = Entries.begin(), E = Entries.end(); I != E;) {
+    Entry &Destroyed = *I++;
+    Destroyed.~Entry();
+  }
+  Entries.clear();
+  NumEntries = 0;
+  Allocator.Reset();
+}
+
+bool ConstexprCallCache::isCacheable(ArrayRef<APValue> Values) {
+  for (const APValue &V : Values)
+    if (!V.isInt() && !V.isFloat())
+      return false;
+  return true;
+}
+
+const ConstexprCallCache::Entry *
+ConstexprCallCache::lookup(const FunctionDecl *FD, ArrayRef<APValue> Args,
+                           unsigned Mode) {
+  ++NumLookups;
+  llvm::FoldingSetNodeID ID;
+  profileCall(ID, FD, Args, Mode);
+  void *InsertPos;
+  const Entry *E = Entries.FindNodeOrInsertPos(ID, InsertPos);
+  if (E)
+    ++NumHits;
+  return E;
+}
+
+void ConstexprCallCache::insert(const FunctionDecl *FD, ArrayRef<APValue> Args,
+                                unsigned Mode, const APValue &Result,
+                                unsigned Steps, unsigned Depth) {
+  if (NumEntries == MaxEntries) {
+    clear();
+    ++NumFlushes;
+  }
+
+  llvm::FoldingSetNodeID ID;
+  profileCall(ID, FD, Args, Mode);
+  void *InsertPos;
+  if (Entries.FindNodeOrInsertPos(ID, InsertPos))
+    return;
+  Entry *E = new (Allocator.Allocate<Entry>())
+      Entry(ID.Intern(Allocator), Result, Steps, Depth);
+  Entries.InsertNode(E, InsertPos);
+  ++NumEntries;
+}
+
+void ConstexprCallCache::PrintStats() const {
+  llvm::errs() << NumHits << "/" << NumLookups
+               << " constexpr calls reused a memoized result, "
+               << NumEntries << " results memoized, " << NumFlushes
+               << " flushes\n";
+}
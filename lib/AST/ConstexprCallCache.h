@@ -0,0 +1,95 @@
+//===--- ConstexprCallCache.h - Results of constexpr calls ------*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This provides a cache of the results of calls to constexpr functions, so
+// that calls repeated across evaluations are only evaluated once.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_CLANG_LIB_AST_CONSTEXPRCALLCACHE_H
+#define LLVM_CLANG_LIB_AST_CONSTEXPRCALLCACHE_H
+
+#include "clang/AST/APValue.h"
+#include "clang/Basic/LLVM.h"
+#include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/FoldingSet.h"
+#include "llvm/Support/Allocator.h"
+
+namespace clang {
+
+class FunctionDecl;
+
+/// \brief The results of calls to constexpr functions, by callee, argument
+/// values and evaluation mode.
+///
+/// Only calls whose arguments and result are integers or floating-point
+/// values are cached, and only if their evaluation noted nothing. Such an
+/// evaluation depends on nothing but the arguments, except for the step and
+/// depth limits: each result therefore records how many steps and how deep a
+/// call stack it took, and ExprConstant.cpp only reuses it if the evaluation
+/// would have stayed within the limits.
+///
+/// The cache is flushed whenever it reaches MaxEntries results, which bounds
+/// its memory use.
+class ConstexprCallCache {
+public:
+  struct Entry : llvm::FoldingSetNode {
+    llvm::FoldingSetNodeIDRef Key;
+    APValue Result;
+    /// The number of statements evaluated for the call.
+    unsigned Steps;
+    /// The depth of the call stack of the call, counting the call itself.
+    unsigned Depth;
+
+    Entry(llvm::FoldingSetNodeIDRef Key, const APValue &Result, unsigned Steps,
+          unsigned Depth)
+        : Key(Key), Result(Result), Steps(Steps), Depth(Depth) {}
+
+    void Profile(llvm::FoldingSetNodeID &ID) const {
+      ID = llvm::FoldingSetNodeID(Key);
+    }
+  };
+
+  enum { MaxEntries = 1 << 16 };
+
+private:
+  llvm::FoldingSet<Entry> Entries;
+  unsigned NumEntries;
+
+  /// \brief Holds the entries and their keys.
+  llvm::BumpPtrAllocator Allocator;
+
+  unsigned NumLookups, NumHits, NumFlushes;
+
+  void clear();
+
+public:
+  ConstexprCallCache();
+  ~ConstexprCallCache();
+
+  /// \brief Determines whether calls with these values as arguments or result
+  /// can be cached.
+  static bool isCacheable(ArrayRef<APValue> Values);
+
+  /// \brief Returns the result of an earlier call to \p FD with the same
+  /// arguments in evaluation mode \p Mode, or null.
+  const Entry *lookup(const FunctionDecl *FD, ArrayRef<APValue> Args,
+                      unsigned Mode);
+
+  /// \brief Records the result of a call which was evaluated without noting
+  /// anything.
+  void insert(const FunctionDecl *FD, ArrayRef<APValue> Args, unsigned Mode,
+              const APValue &Result, unsigned Steps, unsigned Depth);
+
+  void PrintStats() const;
+};
+
+} // end namespace clang
+
+#endif
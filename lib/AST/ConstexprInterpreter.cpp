@@ -0,0 +1,957 @@
+//===--- ConstexprInterpreter.cpp - Bytecode for constexpr calls ----------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+//  This file implements the ConstexprInterpreter class.
+//
+//===----------------------------------------------------------------------===//
+
+#include "ConstexprInterpreter.h"
+#include "clang/AST/APValue.h"
+#include "clang/AST/ASTContext.h"
+#include "clang/AST/DeclCXX.h"
+#include "clang/AST/Expr.h"
+#include "clang/AST/ExprCXX.h"
+#include "clang/AST/Stmt.h"
+#include "llvm/ADT/APSInt.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/Support/MathExtras.h"
+using namespace clang;
+
+namespace {
+/// The operations of the interpreter. They pop their operands from the stack
+/// and push their results on it.
+enum Opcode : uint8_t {
+  OP_Const,       ///< Push Arg.
+  OP_Load,        ///< Push the value of variable Arg.
+  OP_Store,       ///< Pop a value into variable Arg.
+  OP_Dup,         ///< Push the value on top of the stack again.
+  OP_Swap,        ///< Swap the two values on top of the stack.
+  OP_Pop,         ///< Pop a value.
+  OP_Add, OP_Sub, OP_Mul, OP_Div, OP_Rem, OP_Shl, OP_Shr,
+  OP_And, OP_Or, OP_Xor,
+  OP_LT, OP_GT, OP_LE, OP_GE, OP_EQ, OP_NE,
+  OP_Neg, OP_Not, OP_LNot,
+  OP_Cast,        ///< Convert a value to the type of the instruction.
+  OP_Jump,        ///< Continue at instruction Arg.
+  OP_JumpIfFalse, ///< Pop a value, and continue at Arg if it is zero.
+  OP_JumpIfTrue,  ///< Pop a value, and continue at Arg if it isn't zero.
+  OP_Call,        ///< Replace the arguments of callee Arg by its result.
+  OP_Return,      ///< Return the value on top of the stack.
+  OP_Step,        ///< Count a statement against the step limit.
+  OP_Fail         ///< Stop the evaluation, e.g. at the end of a function.
+};
+
+/// An instruction. Arithmetic is performed in the type of the instruction, an
+/// integer of Width bits which is Signed or not.
+struct Instr {
+  Opcode Op;
+  uint8_t Width;
+  bool Signed;
+  int64_t Arg;
+};
+} // end anonymous namespace
+
+/// A compiled function.
+struct ConstexprInterpreter::Function {
+  unsigned NumParams;
+  /// The number of variables, including the parameters.
+  unsigned NumVars;
+  /// The type of the result.
+  unsigned Width;
+  bool Signed;
+  std::vector<Instr> Code;
+  /// The functions called, in the order OP_Call refers to them.
+  std::vector<const FunctionDecl *> Callees;
+};
+
+/// Returns \p V as an integer of the given type. Values of signed types are
+/// kept sign extended to 64 bits, and values of unsigned types zero extended.
+static int64_t normalize(uint64_t V, unsigned Width, bool Signed) {
+  if (Width == 64)
+    return V;
+  if (Signed)
+    return llvm::SignExtend64(V, Width);
+  return V & ((uint64_t(1) << Width) - 1);
+}
+
+static int64_t getMinSignedValue(unsigned Width) {
+  return -int64_t(uint64_t(1) << (Width - 1));
+}
+
+static bool fitsSigned(int64_t V, unsigned Width) {
+  return Width == 64 || llvm::SignExtend64(V, Width) == V;
+}
+
+/// Determines how values of type \p T are represented, or returns false if
+/// the interpreter does not support them.
+static bool getIntType(const ASTContext &Ctx, QualType T, unsigned &Width,
+                       bool &Signed) {
+  if (!T->isIntegralOrEnumerationType() || T.isVolatileQualified())
+    return false;
+  Width = Ctx.getIntWidth(T);
+  Signed = !T->isUnsignedIntegerOrEnumerationType();
+  return Width && Width <= 64;
+}
+
+static int64_t getIntValue(const llvm::APSInt &V) {
+  return V.isSigned() ? V.getSExtValue() : int64_t(V.getZExtValue());
+}
+
+namespace {
+/// Compiles the body of a function.
+class Compiler {
+  ASTContext &Ctx;
+  ConstexprInterpreter::Function &F;
+
+  /// The variables of the function, with the index of their values.
+  llvm::DenseMap<const VarDecl *, unsigned> Vars;
+
+  /// The jumps out of and to the next iteration of the enclosing loops.
+  struct Loop {
+    SmallVector<size_t, 4> Breaks, Continues;
+  };
+  SmallVector<Loop, 4> Loops;
+
+  size_t emit(Opcode Op, int64_t Arg = 0, unsigned Width = 0,
+              bool Signed = false) {
+    Instr I = {Op, uint8_t(Width), Signed, Arg};
+    F.Code.push_back(I);
+    return F.Code.size() - 1;
+  }
+
+  /// Makes the jumps \p Jumps continue at instruction \p Target.
+  void patch(ArrayRef<size_t> Jumps, size_t Target) {
+    for (size_t Jump : Jumps)
+      F.Code[Jump].Arg = Target;
+  }
+
+  bool addVar(const VarDecl *VD) {
+    unsigned Width;
+    bool Signed;
+    if (!getIntType(Ctx, VD->getType(), Width, Signed))
+      return false;
+    Vars[VD] = F.NumVars++;
+    return true;
+  }
+
+  bool compileLoopBody(const Stmt *Body, size_t &Continue, Loop &L);
+  bool compileConstant(const VarDecl *VD, unsigned Width, bool Signed);
+  bool compileCall(const CallExpr *E);
+  bool compileIncDec(const UnaryOperator *E, unsigned &Var, bool PushOld);
+  bool compileAssignment(const BinaryOperator *E, unsigned &Var);
+  bool compileLValue(const Expr *E, unsigned &Var);
+  bool compileCondition(const Expr *E);
+  bool compileDiscarded(const Expr *E);
+  bool compileExpr(const Expr *E);
+  bool compileStmt(const Stmt *S);
+
+public:
+  Compiler(ASTContext &Ctx, ConstexprInterpreter::Function &F)
+      : Ctx(Ctx), F(F) {}
+
+  bool compile(const FunctionDecl *FD, const Stmt *Body);
+};
+} // end anonymous namespace
+
+static Opcode getOpcode(BinaryOperatorKind Opc) {
+  switch (Opc) {
+  case BO_Mul: case BO_MulAssign: return OP_Mul;
+  case BO_Div: case BO_DivAssign: return OP_Div;
+  case BO_Rem: case BO_RemAssign: return OP_Rem;
+  case BO_Add: case BO_AddAssign: return OP_Add;
+  case BO_Sub: case BO_SubAssign: return OP_Sub;
+  case BO_Shl: case BO_ShlAssign: return OP_Shl;
+  case BO_Shr: case BO_ShrAssign: return OP_Shr;
+  case BO_And: case BO_AndAssign: return OP_And;
+  case BO_Xor: case BO_XorAssign: return OP_Xor;
+  case BO_Or: case BO_OrAssign: return OP_Or;
+  case BO_LT: return OP_LT;
+  case BO_GT: return OP_GT;
+  case BO_LE: return OP_LE;
+  case BO_GE: return OP_GE;
+  case BO_EQ: return OP_EQ;
+  case BO_NE: return OP_NE;
+  default: return OP_Fail;
+  }
+}
+
+bool Compiler::compile(const FunctionDecl *FD, const Stmt *Body) {
+  if (!getIntType(Ctx, FD->getReturnType(), F.Width, F.Signed))
+    return false;
+  for (const ParmVarDecl *Param : FD->parameters())
+    if (!addVar(Param))
+      return false;
+  F.NumParams = F.NumVars;
+
+  if (!compileStmt(Body))
+    return false;
+  // Flowing off the end of the function.
+  emit(OP_Fail);
+  return true;
+}
+
+bool Compiler::compileLoopBody(const Stmt *Body, size_t &Continue, Loop &L) {
+  Loops.push_back(Loop());
+  if (!compileStmt(Body))
+    return false;
+  Continue = F.Code.size();
+  L = Loops.pop_back_val();
+  patch(L.Continues, Continue);
+  return true;
+}
+
+bool Compiler::compileStmt(const Stmt *S) {
+  // The tree-walking evaluator counts each statement it evaluates as a step.
+  emit(OP_Step);
+
+  switch (S->getStmtClass()) {
+  case Stmt::NullStmtClass:
+    return true;
+
+  case Stmt::CompoundStmtClass:
+    for (const Stmt *Child : cast<CompoundStmt>(S)->body())
+      if (!compileStmt(Child))
+        return false;
+    return true;
+
+  case Stmt::DeclStmtClass:
+    for (const Decl *D : cast<DeclStmt>(S)->decls()) {
+      const VarDecl *VD = dyn_cast<VarDecl>(D);
+      if (!VD)
+        continue;
+      if (!VD->hasLocalStorage() || !VD->getInit() ||
+          !compileExpr(VD->getInit()) || !addVar(VD))
+        return false;
+      emit(OP_Store, Vars[VD]);
+    }
+    return true;
+
+  case Stmt::ReturnStmtClass: {
+    const Expr *RetValue = cast<ReturnStmt>(S)->getRetValue();
+    if (!RetValue || !compileExpr(RetValue))
+      return false;
+    emit(OP_Cast, 0, F.Width, F.Signed);
+    emit(OP_Return);
+    return true;
+  }
+
+  case Stmt::IfStmtClass: {
+    const IfStmt *IS = cast<IfStmt>(S);
+    if (IS->getConditionVariable() || !compileCondition(IS->getCond()))
+      return false;
+    size_t ToElse = emit(OP_JumpIfFalse);
+    if (!compileStmt(IS->getThen()))
+      return false;
+    if (!IS->getElse()) {
+      patch(ToElse, F.Code.size());
+      return true;
+    }
+    size_t ToEnd = emit(OP_Jump);
+    patch(ToElse, F.Code.size());
+    if (!compileStmt(IS->getElse()))
+      return false;
+    patch(ToEnd, F.Code.size());
+    return true;
+  }
+
+  case Stmt::WhileStmtClass: {
+    const WhileStmt *WS = cast<WhileStmt>(S);
+    size_t Top = F.Code.size();
+    if (WS->getConditionVariable() || !compileCondition(WS->getCond()))
+      return false;
+    size_t ToEnd = emit(OP_JumpIfFalse);
+    size_t Continue;
+    Loop L;
+    if (!compileLoopBody(WS->getBody(), Continue, L))
+      return false;
+    emit(OP_Jump, Top);
+    patch(ToEnd, F.Code.size());
+    patch(L.Breaks, F.Code.size());
+    return true;
+  }
+
+  case Stmt::DoStmtClass: {
+    const DoStmt *DS = cast<DoStmt>(S);
+    size_t Top = F.Code.size();
+    size_t Continue;
+    Loop L;
+    if (!compileLoopBody(DS->getBody(), Continue, L) ||
+        !compileCondition(DS->getCond()))
+      return false;
+    emit(OP_JumpIfTrue, Top);
+    patch(L.Breaks, F.Code.size());
+    return true;
+  }
+
+  case Stmt::ForStmtClass: {
+    const ForStmt *FS = cast<ForStmt>(S);
+    if (FS->getConditionVariable() ||
+        (FS->getInit() && !compileStmt(FS->getInit())))
+      return false;
+    size_t Top = F.Code.size();
+    SmallVector<size_t, 1> ToEnd;
+    if (FS->getCond()) {
+      if (!compileCondition(FS->getCond()))
+        return false;
+      ToEnd.push_back(emit(OP_JumpIfFalse));
+    }
+    size_t Continue;
+    Loop L;
+    if (!compileLoopBody(FS->getBody(), Continue, L) ||
+        (FS->getInc() && !compileDiscarded(FS->getInc())))
+      return false;
+    emit(OP_Jump, Top);
+    patch(ToEnd, F.Code.size());
+    patch(L.Breaks, F.Code.size());
+    return true;
+  }
+
+  case Stmt::BreakStmtClass:
+    if (Loops.empty())
+      return false;
+    Loops.back().Breaks.push_back(emit(OP_Jump));
+    return true;
+
+  case Stmt::ContinueStmtClass:
+    if (Loops.empty())
+      return false;
+    Loops.back().Continues.push_back(emit(OP_Jump));
+    return true;
+
+  default:
+    if (const Expr *E = dyn_cast<Expr>(S))
+      return compileDiscarded(E);
+    return false;
+  }
+}
+
+bool Compiler::compileConstant(const VarDecl *VD, unsigned Width,
+                               bool Signed) {
+  // Only read the variables whose value the tree-walking evaluator would use
+  // without noting anything.
+  if (!VD->isConstexpr() || VD->hasLocalStorage())
+    return false;
+  SmallVector<PartialDiagnosticAt, 8> Notes;
+  const APValue *Value = VD->evaluateValue(Notes);
+  if (!Value || !Value->isInt() || !VD->checkInitIsICE())
+    return false;
+  emit(OP_Const, normalize(getIntValue(Value->getInt()), Width, Signed));
+  return true;
+}
+
+bool Compiler::compileCall(const CallExpr *E) {
+  const FunctionDecl *Callee = E->getDirectCallee();
+  if (!Callee || Callee->getBuiltinID() ||
+      !isa<DeclRefExpr>(E->getCallee()->IgnoreParenImpCasts()) ||
+      Callee->getNumParams() != E->getNumArgs())
+    return false;
+  if (const CXXMethodDecl *MD = dyn_cast<CXXMethodDecl>(Callee))
+    if (!MD->isStatic())
+      return false;
+
+  for (const Expr *Arg : E->arguments())
+    if (!compileExpr(Arg))
+      return false;
+  emit(OP_Call, F.Callees.size());
+  F.Callees.push_back(Callee);
+  return true;
+}
+
+bool Compiler::compileIncDec(const UnaryOperator *E, unsigned &Var,
+                             bool PushOld) {
+  const Expr *Sub = E->getSubExpr();
+  unsigned Width;
+  bool Signed;
+  if (Sub->getType()->isBooleanType() ||
+      !getIntType(Ctx, Sub->getType(), Width, Signed) ||
+      !compileLValue(Sub, Var))
+    return false;
+  emit(OP_Load, Var);
+  if (PushOld)
+    emit(OP_Dup);
+  emit(OP_Const, 1);
+  emit(E->isIncrementOp() ? OP_Add : OP_Sub, 0, Width, Signed);
+  emit(OP_Store, Var);
+  return true;
+}
+
+bool Compiler::compileAssignment(const BinaryOperator *E, unsigned &Var) {
+  unsigned Width;
+  bool Signed;
+  if (!getIntType(Ctx, E->getLHS()->getType(), Width, Signed) ||
+      !compileLValue(E->getLHS(), Var) || !compileExpr(E->getRHS()))
+    return false;
+
+  if (const CompoundAssignOperator *CAO = dyn_cast<CompoundAssignOperator>(E)) {
+    // Like the tree-walking evaluator, read the variable after evaluating the
+    // right-hand side, and compute in the promoted type of the variable.
+    unsigned CompWidth;
+    bool CompSigned;
+    if (!getIntType(Ctx, CAO->getComputationLHSType(), CompWidth, CompSigned))
+      return false;
+    emit(OP_Load, Var);
+    emit(OP_Cast, 0, CompWidth, CompSigned);
+    emit(OP_Swap);
+    emit(getOpcode(CAO->getOpcode()), 0, CompWidth, CompSigned);
+  }
+  emit(OP_Cast, 0, Width, Signed);
+  emit(OP_Store, Var);
+  return true;
+}
+
+bool Compiler::compileLValue(const Expr *E, unsigned &Var) {
+  if (E->getType().isVolatileQualified())
+    return false;
+
+  if (const ParenExpr *PE = dyn_cast<ParenExpr>(E))
+    return compileLValue(PE->getSubExpr(), Var);
+
+  if (const DeclRefExpr *DRE = dyn_cast<DeclRefExpr>(E)) {
+    const VarDecl *VD = dyn_cast<VarDecl>(DRE->getDecl());
+    auto Known = VD ? Vars.find(VD) : Vars.end();
+    if (Known == Vars.end())
+      return false;
+    Var = Known->second;
+    return true;
+  }
+
+  if (const ImplicitCastExpr *ICE = dyn_cast<ImplicitCastExpr>(E))
+    return ICE->getCastKind() == CK_NoOp &&
+           compileLValue(ICE->getSubExpr(), Var);
+
+  if (const BinaryOperator *BO = dyn_cast<BinaryOperator>(E)) {
+    if (BO->isAssignmentOp())
+      return compileAssignment(BO, Var);
+    if (BO->getOpcode() == BO_Comma)
+      return compileDiscarded(BO->getLHS()) && compileLValue(BO->getRHS(), Var);
+    return false;
+  }
+
+  if (const UnaryOperator *UO = dyn_cast<UnaryOperator>(E))
+    return UO->isPrefix() && UO->isIncrementDecrementOp() &&
+           compileIncDec(UO, Var, /*PushOld=*/false);
+
+  return false;
+}
+
+bool Compiler::compileCondition(const Expr *E) {
+  if (E->getType()->isBooleanType())
+    return compileExpr(E);
+
+  // In C, conditions are not converted to bool.
+  unsigned Width;
+  bool Signed;
+  if (!getIntType(Ctx, E->getType(), Width, Signed) || !compileExpr(E))
+    return false;
+  emit(OP_Const, 0);
+  emit(OP_NE, 0, Width, Signed);
+  return true;
+}
+
+bool Compiler::compileDiscarded(const Expr *E) {
+  unsigned Var;
+  if (const ParenExpr *PE = dyn_cast<ParenExpr>(E))
+    return compileDiscarded(PE->getSubExpr());
+
+  if (const BinaryOperator *BO = dyn_cast<BinaryOperator>(E)) {
+    if (BO->isAssignmentOp())
+      return compileAssignment(BO, Var);
+    if (BO->getOpcode() == BO_Comma)
+      return compileDiscarded(BO->getLHS()) && compileDiscarded(BO->getRHS());
+  }
+
+  if (const UnaryOperator *UO = dyn_cast<UnaryOperator>(E))
+    if (UO->isIncrementDecrementOp())
+      return compileIncDec(UO, Var, /*PushOld=*/false);
+
+  if (const CastExpr *CE = dyn_cast<CastExpr>(E))
+    if (CE->getCastKind() == CK_ToVoid)
+      return compileDiscarded(CE->getSubExpr());
+
+  if (E->isGLValue())
+    return compileLValue(E, Var);
+  if (!compileExpr(E))
+    return false;
+  emit(OP_Pop);
+  return true;
+}
+
+bool Compiler::compileExpr(const Expr *E) {
+  unsigned Width;
+  bool Signed;
+  if (E->isGLValue() || !getIntType(Ctx, E->getType(), Width, Signed))
+    return false;
+
+  switch (E->getStmtClass()) {
+  case Stmt::IntegerLiteralClass: {
+    llvm::APSInt Value(cast<IntegerLiteral>(E)->getValue(), !Signed);
+    emit(OP_Const, normalize(getIntValue(Value), Width, Signed));
+    return true;
+  }
+
+  case Stmt::CharacterLiteralClass:
+    emit(OP_Const,
+         normalize(cast<CharacterLiteral>(E)->getValue(), Width, Signed));
+    return true;
+
+  case Stmt::CXXBoolLiteralExprClass:
+    emit(OP_Const, cast<CXXBoolLiteralExpr>(E)->getValue());
+    return true;
+
+  case Stmt::CXXScalarValueInitExprClass:
+  case Stmt::ImplicitValueInitExprClass:
+    emit(OP_Const, 0);
+    return true;
+
+  case Stmt::UnaryExprOrTypeTraitExprClass: {
+    llvm::APSInt Value;
+    if (!E->EvaluateAsInt(Value, Ctx))
+      return false;
+    emit(OP_Const, normalize(getIntValue(Value), Width, Signed));
+    return true;
+  }
+
+  case Stmt::DeclRefExprClass: {
+    const EnumConstantDecl *ECD =
+        dyn_cast<EnumConstantDecl>(cast<DeclRefExpr>(E)->getDecl());
+    if (!ECD)
+      return false;
+    emit(OP_Const, normalize(getIntValue(ECD->getInitVal()), Width, Signed));
+    return true;
+  }
+
+  case Stmt::ParenExprClass:
+    return compileExpr(cast<ParenExpr>(E)->getSubExpr());
+
+  case Stmt::CXXDefaultArgExprClass:
+    return compileExpr(cast<CXXDefaultArgExpr>(E)->getExpr());
+
+  case Stmt::SubstNonTypeTemplateParmExprClass:
+    return compileExpr(
+        cast<SubstNonTypeTemplateParmExpr>(E)->getReplacement());
+
+  case Stmt::InitListExprClass: {
+    const InitListExpr *ILE = cast<InitListExpr>(E);
+    if (ILE->getNumInits() > 1)
+      return false;
+    if (ILE->getNumInits() == 0) {
+      emit(OP_Const, 0);
+      return true;
+    }
+    return compileExpr(ILE->getInit(0));
+  }
+
+  case Stmt::CallExprClass:
+  case Stmt::CXXOperatorCallExprClass:
+    return compileCall(cast<CallExpr>(E));
+
+  case Stmt::ConditionalOperatorClass: {
+    const ConditionalOperator *CO = cast<ConditionalOperator>(E);
+    if (!compileCondition(CO->getCond()))
+      return false;
+    size_t ToFalse = emit(OP_JumpIfFalse);
+    if (!compileExpr(CO->getTrueExpr()))
+      return false;
+    size_t ToEnd = emit(OP_Jump);
+    patch(ToFalse, F.Code.size());
+    if (!compileExpr(CO->getFalseExpr()))
+      return false;
+    patch(ToEnd, F.Code.size());
+    return true;
+  }
+
+  case Stmt::UnaryOperatorClass: {
+    const UnaryOperator *UO = cast<UnaryOperator>(E);
+    unsigned Var;
+    switch (UO->getOpcode()) {
+    case UO_PostInc:
+    case UO_PostDec:
+      return compileIncDec(UO, Var, /*PushOld=*/true);
+    case UO_PreInc:
+    case UO_PreDec:
+      // In C, these yield the new value rather than the variable.
+      if (!compileIncDec(UO, Var, /*PushOld=*/false))
+        return false;
+      emit(OP_Load, Var);
+      return true;
+    case UO_Plus:
+      return compileExpr(UO->getSubExpr());
+    case UO_Minus:
+    case UO_Not:
+      if (!compileExpr(UO->getSubExpr()))
+        return false;
+      emit(UO->getOpcode() == UO_Minus ? OP_Neg : OP_Not, 0, Width, Signed);
+      return true;
+    case UO_LNot:
+      if (!compileCondition(UO->getSubExpr()))
+        return false;
+      emit(OP_LNot);
+      return true;
+    default:
+      return false;
+    }
+  }
+
+  case Stmt::BinaryOperatorClass:
+  case Stmt::CompoundAssignOperatorClass: {
+    const BinaryOperator *BO = cast<BinaryOperator>(E);
+    unsigned Var;
+    if (BO->isAssignmentOp()) {
+      // In C, assignments yield the new value rather than the variable.
+      if (!compileAssignment(BO, Var))
+        return false;
+      emit(OP_Load, Var);
+      return true;
+    }
+
+    switch (BO->getOpcode()) {
+    case BO_Comma:
+      return compileDiscarded(BO->getLHS()) && compileExpr(BO->getRHS());
+
+    case BO_LAnd:
+    case BO_LOr: {
+      if (!compileCondition(BO->getLHS()))
+        return false;
+      emit(OP_Dup);
+      size_t ToEnd =
+          emit(BO->getOpcode() == BO_LAnd ? OP_JumpIfFalse : OP_JumpIfTrue);
+      emit(OP_Pop);
+      if (!compileCondition(BO->getRHS()))
+        return false;
+      patch(ToEnd, F.Code.size());
+      return true;
+    }
+
+    default: {
+      Opcode Op = getOpcode(BO->getOpcode());
+      if (Op == OP_Fail)
+        return false;
+      // Comparisons are performed in the type of their operands, and shifts
+      // in the type of their left operand.
+      if (BO->isComparisonOp() &&
+          !getIntType(Ctx, BO->getLHS()->getType(), Width, Signed))
+        return false;
+      if (!compileExpr(BO->getLHS()) || !compileExpr(BO->getRHS()))
+        return false;
+      emit(Op, 0, Width, Signed);
+      return true;
+    }
+    }
+  }
+
+  default:
+    break;
+  }
+
+  const CastExpr *CE = dyn_cast<CastExpr>(E);
+  if (!CE)
+    return false;
+  const Expr *Sub = CE->getSubExpr();
+  unsigned SubWidth;
+  bool SubSigned;
+  if (!getIntType(Ctx, Sub->getType(), SubWidth, SubSigned))
+    return false;
+
+  switch (CE->getCastKind()) {
+  case CK_LValueToRValue: {
+    unsigned Var;
+    const DeclRefExpr *DRE = dyn_cast<DeclRefExpr>(Sub->IgnoreParens());
+    const VarDecl *VD = DRE ? dyn_cast<VarDecl>(DRE->getDecl()) : nullptr;
+    if (VD && !Vars.count(VD))
+      return compileConstant(VD, Width, Signed);
+    if (!compileLValue(Sub, Var))
+      return false;
+    emit(OP_Load, Var);
+    return true;
+  }
+
+  case CK_NoOp:
+  case CK_IntegralCast:
+    if (!compileExpr(Sub))
+      return false;
+    emit(OP_Cast, 0, Width, Signed);
+    return true;
+
+  case CK_IntegralToBoolean:
+    if (!compileExpr(Sub))
+      return false;
+    emit(OP_Const, 0);
+    emit(OP_NE, 0, SubWidth, SubSigned);
+    return true;
+
+  default:
+    return false;
+  }
+}
+
+/// Performs the operation \p I on \p V. Returns false if the result is
+/// undefined.
+static bool unaryOp(const Instr &I, int64_t &V) {
+  switch (I.Op) {
+  case OP_Neg:
+    if (I.Signed && V == getMinSignedValue(I.Width))
+      return false;
+    V = normalize(-uint64_t(V), I.Width, I.Signed);
+    return true;
+  case OP_Not:
+    V = normalize(~uint64_t(V), I.Width, I.Signed);
+    return true;
+  case OP_LNot:
+    V = !V;
+    return true;
+  case OP_Cast:
+    V = normalize(V, I.Width, I.Signed);
+    return true;
+  default:
+    llvm_unreachable("not a unary operation");
+  }
+}
+
+/// Performs the operation \p I on \p L and \p R, storing the result in \p L.
+/// Returns false if the result is undefined, or isn't a constant expression.
+static bool binaryOp(const Instr &I, int64_t &L, int64_t R) {
+  unsigned Width = I.Width;
+  bool Signed = I.Signed;
+  uint64_t UL = L, UR = R;
+
+  switch (I.Op) {
+  case OP_Add:
+  case OP_Sub: {
+    bool IsAdd = I.Op == OP_Add;
+    if (!Signed) {
+      L = normalize(IsAdd ? UL + UR : UL - UR, Width, Signed);
+      return true;
+    }
+    if (Width < 64) {
+      // Neither operand has more than 63 bits, so this can't overflow.
+      L = IsAdd ? L + R : L - R;
+      return fitsSigned(L, Width);
+    }
+    int64_t V = IsAdd ? UL + UR : UL - UR;
+    bool Overflow = IsAdd ? ((L ^ V) & (R ^ V)) < 0 : ((L ^ R) & (L ^ V)) < 0;
+    L = V;
+    return !Overflow;
+  }
+
+  case OP_Mul: {
+    if (!Signed) {
+      L = normalize(UL * UR, Width, Signed);
+      return true;
+    }
+    if (Width <= 32) {
+      L *= R;
+      return fitsSigned(L, Width);
+    }
+    bool Overflow;
+    llvm::APInt V = llvm::APInt(Width, UL, true)
+                        .smul_ov(llvm::APInt(Width, UR, true), Overflow);
+    L = V.getSExtValue();
+    return !Overflow;
+  }
+
+  case OP_Div:
+  case OP_Rem:
+    if (R == 0 ||
+        (Signed && R == -1 && L == getMinSignedValue(Width)))
+      return false;
+    if (Signed)
+      L = I.Op == OP_Div ? L / R : L % R;
+    else
+      L = I.Op == OP_Div ? UL / UR : UL % UR;
+    return true;
+
+  case OP_Shl:
+    if (R < 0 || uint64_t(R) >= Width)
+      return false;
+    // A signed left shift must not shift out set bits, nor a negative value.
+    if (Signed &&
+        (L < 0 || int(llvm::countLeadingZeros(UL)) - int(64 - Width) < R))
+      return false;
+    L = normalize(UL << R, Width, Signed);
+    return true;
+
+  case OP_Shr:
+    if (R < 0 || uint64_t(R) >= Width)
+      return false;
+    L = Signed ? L >> R : int64_t(UL >> R);
+    return true;
+
+  case OP_And: L &= R; return true;
+  case OP_Or: L |= R; return true;
+  case OP_Xor: L ^= R; return true;
+
+  case OP_LT: L = Signed ? L < R : UL < UR; return true;
+  case OP_GT: L = Signed ? L > R : UL > UR; return true;
+  case OP_LE: L = Signed ? L <= R : UL <= UR; return true;
+  case OP_GE: L = Signed ? L >= R : UL >= UR; return true;
+  case OP_EQ: L = L == R; return true;
+  case OP_NE: L = L != R; return true;
+
+  default:
+    llvm_unreachable("not a binary operation");
+  }
+}
+
+ConstexprInterpreter::ConstexprInterpreter(ASTContext &Ctx)
+    : Ctx(Ctx), StepsLeft(0), MaxDepth(0), DeepestCall(0), Active(false) {}
+
+ConstexprInterpreter::~ConstexprInterpreter() {}
+
+const ConstexprInterpreter::Function *
+ConstexprInterpreter::getFunction(const FunctionDecl *FD) {
+  FD = FD->getCanonicalDecl();
+  auto Known = Functions.find(FD);
+  if (Known != Functions.end())
+    return Known->second.get();
+
+  // A function may be defined after its first use; don't remember that it
+  // couldn't be compiled until then.
+  const FunctionDecl *Definition = nullptr;
+  const Stmt *Body = FD->getBody(Definition);
+  if (!Body)
+    return nullptr;
+
+  std::unique_ptr<Function> F(new Function());
+  F->NumParams = F->NumVars = 0;
+  if (!Definition->isConstexpr() || Definition->isInvalidDecl() ||
+      Definition->isVariadic() ||
+      !Compiler(Ctx, *F).compile(Definition, Body))
+    F.reset();
+
+  const Function *Result = F.get();
+  Functions[FD] = std::move(F);
+  return Result;
+}
+
+bool ConstexprInterpreter::execute(const Function &F, size_t Base,
+                                   unsigned Depth, int64_t &Result) {
+  const Instr *Code = F.Code.data();
+  for (size_t PC = 0;;) {
+    const Instr &I = Code[PC++];
+    switch (I.Op) {
+    case OP_Const:
+      Stack.push_back(I.Arg);
+      break;
+    case OP_Load:
+      Stack.push_back(Stack[Base + I.Arg]);
+      break;
+    case OP_Store:
+      Stack[Base + I.Arg] = Stack.back();
+      Stack.pop_back();
+      break;
+    case OP_Dup:
+      Stack.push_back(Stack.back());
+      break;
+    case OP_Swap:
+      std::swap(Stack.end()[-1], Stack.end()[-2]);
+      break;
+    case OP_Pop:
+      Stack.pop_back();
+      break;
+
+    case OP_Neg:
+    case OP_Not:
+    case OP_LNot:
+    case OP_Cast:
+      if (!unaryOp(I, Stack.back()))
+        return false;
+      break;
+
+    case OP_Jump:
+      PC = I.Arg;
+      break;
+    case OP_JumpIfFalse:
+    case OP_JumpIfTrue: {
+      bool Cond = Stack.back() != 0;
+      Stack.pop_back();
+      if (Cond == (I.Op == OP_JumpIfTrue))
+        PC = I.Arg;
+      break;
+    }
+
+    case OP_Call: {
+      if (Depth >= MaxDepth)
+        return false;
+      const Function *Callee = getFunction(F.Callees[I.Arg]);
+      if (!Callee)
+        return false;
+      DeepestCall = std::max(DeepestCall, Depth + 1);
+      // The arguments become the first variables of the callee.
+      size_t CalleeBase = Stack.size() - Callee->NumParams;
+      Stack.resize(CalleeBase + Callee->NumVars);
+      int64_t Value;
+      if (!execute(*Callee, CalleeBase, Depth + 1, Value))
+        return false;
+      Stack.resize(CalleeBase);
+      Stack.push_back(Value);
+      break;
+    }
+
+    case OP_Return:
+      Result = Stack.back();
+      return true;
+
+    case OP_Step:
+      if (!StepsLeft)
+        return false;
+      --StepsLeft;
+      break;
+
+    case OP_Fail:
+      return false;
+
+    default: {
+      int64_t R = Stack.back();
+      Stack.pop_back();
+      if (!binaryOp(I, Stack.back(), R))
+        return false;
+      break;
+    }
+    }
+  }
+}
+
+bool ConstexprInterpreter::call(const FunctionDecl *FD, ArrayRef<APValue> Args,
+                                unsigned &Steps, unsigned &Depth,
+                                APValue &Result) {
+  // Compiling a function may evaluate the initializer of a variable it reads,
+  // which may call a constexpr function in turn. Leave such calls to the
+  // tree-walking evaluator, as well as the OpenCL rules for shifts.
+  if (Active || Ctx.getLangOpts().OpenCL)
+    return false;
+
+  Active = true;
+  const Function *F = getFunction(FD);
+  bool Success = F && F->NumParams == Args.size();
+  if (Success) {
+    Stack.resize(F->NumVars);
+    for (unsigned I = 0; I != Args.size() && Success; ++I) {
+      Success = Args[I].isInt() && Args[I].getInt().getBitWidth() <= 64;
+      if (Success)
+        Stack[I] = getIntValue(Args[I].getInt());
+    }
+  }
+
+  int64_t Value = 0;
+  if (Success) {
+    StepsLeft = Steps;
+    MaxDepth = Depth;
+    DeepestCall = 0;
+    Success = execute(*F, 0, 0, Value);
+  }
+  Stack.clear();
+  Active = false;
+  if (!Success)
+    return false;
+
+  Steps = StepsLeft;
+  Depth = DeepestCall;
+  Result = APValue(llvm::APSInt(llvm::APInt(F->Width, Value), !F->Signed));
+  return true;
+}
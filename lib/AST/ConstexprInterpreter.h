@@ -0,0 +1,98 @@
+//===--- ConstexprInterpreter.h - Bytecode for constexpr calls --*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This provides an interpreter for calls to constexpr functions, which compiles
+// each function to bytecode once rather than walking its body on each call.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_CLANG_LIB_AST_CONSTEXPRINTERPRETER_H
+#define LLVM_CLANG_LIB_AST_CONSTEXPRINTERPRETER_H
+
+#include "clang/Basic/LLVM.h"
+#include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/DenseMap.h"
+#include <memory>
+#include <vector>
+
+namespace clang {
+
+class APValue;
+class ASTContext;
+class FunctionDecl;
+
+/// \brief Evaluates calls to constexpr functions over integers by compiling
+/// them to the bytecode of a stack machine.
+///
+/// Only functions whose parameters, variables and result have integral or
+/// enumeration types no wider than 64 bits, and which only call such
+/// functions, are supported. All the calls being evaluated share one stack of
+/// 64-bit values.
+///
+/// A call fails whenever the tree-walking evaluator of ExprConstant.cpp would
+/// note something about it, e.g. an overflow, a division by zero or reaching
+/// the step limit. The caller then evaluates the call again without the
+/// interpreter, so the interpreter never changes the result of an evaluation,
+/// nor the diagnostics produced for it.
+class ConstexprInterpreter {
+public:
+  struct Function;
+
+private:
+  ASTContext &Ctx;
+
+  /// \brief The compiled functions, or null for those which are not
+  /// supported.
+  llvm::DenseMap<const FunctionDecl *, std::unique_ptr<Function>> Functions;
+
+  /// \brief The variables and temporaries of the calls being evaluated.
+  std::vector<int64_t> Stack;
+
+  /// \brief The number of statements the calls may still evaluate.
+  unsigned StepsLeft;
+
+  /// \brief The maximum depth of the calls the current call may make.
+  unsigned MaxDepth;
+
+  /// \brief The depth of the deepest call the current call made.
+  unsigned DeepestCall;
+
+  /// \brief Whether a call is being evaluated.
+  bool Active;
+
+  /// \brief Returns the compiled function \p FD, compiling it if needed, or
+  /// null if it is not supported.
+  const Function *getFunction(const FunctionDecl *FD);
+
+  /// \brief Executes \p F, whose variables start at \p Base in the stack.
+  bool execute(const Function &F, size_t Base, unsigned Depth,
+               int64_t &Result);
+
+public:
+  explicit ConstexprInterpreter(ASTContext &Ctx);
+  ~ConstexprInterpreter();
+
+  /// \brief Evaluates a call to the constexpr function \p FD.
+  ///
+  /// \param Args The values of the arguments.
+  /// \param StepsLeft The number of statements the call may evaluate. On
+  /// success, the number evaluated is subtracted from it.
+  /// \param Depth The maximum depth of the calls \p FD may make in turn. On
+  /// success, set to the depth of the deepest call it made.
+  /// \param Result Set to the value the call returns.
+  ///
+  /// \returns false if the call is not supported or can't be evaluated, in
+  /// which case nothing was changed.
+  bool call(const FunctionDecl *FD, ArrayRef<APValue> Args,
+            unsigned &StepsLeft, unsigned &Depth, APValue &Result);
+};
+
+} // end namespace clang
+
+#endif
@@ -592,12 +592,12 @@ SourceLocation DeclarationNameInfo::getEndLoc() const {
     return NameLoc;
 
   case DeclarationName::CXXOperatorName: {
-    unsigned raw = LocInfo.CXXOperatorName.EndOpNameLoc;
+    SourceLocation::UIntTy raw = LocInfo.CXXOperatorName.EndOpNameLoc;
     return SourceLocation::getFromRawEncoding(raw);
   }
 
   case DeclarationName::CXXLiteralOperatorName: {
-    unsigned raw = LocInfo.CXXLiteralOperatorName.OpNameLoc;
+    SourceLocation::UIntTy raw = LocInfo.CXXLiteralOperatorName.OpNameLoc;
     return SourceLocation::getFromRawEncoding(raw);
   }
 
@@ -33,6 +33,8 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include "ConstexprCallCache.h"
+#include "ConstexprInterpreter.h"
 #include "clang/AST/APValue.h"
 #include "clang/AST/ASTContext.h"
 #include "clang/AST/ASTDiagnostic.h"
@@ -446,6 +448,10 @@ namespace {
     /// CallStackDepth - The number of calls in the call stack right now.
     unsigned CallStackDepth;
 
+    /// MaxCallStackDepth - The largest CallStackDepth reached so far, which
+    /// HandleFunctionCall resets to measure the depth of a call.
+    unsigned MaxCallStackDepth;
+
     /// NextCallIndex - The next call index to assign.
     unsigned NextCallIndex;
 
@@ -455,7 +461,7 @@ namespace {
     unsigned StepsLeft;
 
     /// BottomFrame - The frame in which evaluation started. This must be
-    /// initialized after CurrentCall and CallStackDepth.
+    /// initialized after CurrentCall, CallStackDepth and MaxCallStackDepth.
     CallStackFrame BottomFrame;
 
     /// A stack of values whose lifetimes end at the end of some surrounding
@@ -478,6 +484,13 @@ namespace {
     /// fold (not just why it's not strictly a constant expression)?
     bool HasFoldFailureDiagnostic;
 
+    /// \brief The number of notes produced so far, whether they were kept or
+    /// not, of overflow warnings, and of accesses to the object whose
+    /// initializer is being evaluated. The result of a call during which any
+    /// of these happened may depend on more than its arguments, so it is not
+    /// memoized.
+    unsigned NumUncacheableEvents;
+
     enum EvaluationMode {
       /// Evaluate as a constant expression. Stop if we find that the expression
       /// is not a constant expression.
@@ -537,12 +550,13 @@ namespace {
 
     EvalInfo(const ASTContext &C, Expr::EvalStatus &S, EvaluationMode Mode)
       : Ctx(const_cast<ASTContext &>(C)), EvalStatus(S), CurrentCall(nullptr),
-        CallStackDepth(0), NextCallIndex(1),
+        CallStackDepth(0), MaxCallStackDepth(0), NextCallIndex(1),
         StepsLeft(getLangOpts().ConstexprStepLimit),
         BottomFrame(*this, SourceLocation(), nullptr, nullptr, nullptr),
         EvaluatingDecl((const ValueDecl *)nullptr),
         EvaluatingDeclValue(nullptr), HasActiveDiagnostic(false),
-        HasFoldFailureDiagnostic(false), EvalMode(Mode) {}
+        HasFoldFailureDiagnostic(false), NumUncacheableEvents(0),
+        EvalMode(Mode) {}
 
     void setEvaluatingDecl(APValue::LValueBase Base, APValue &Value) {
       EvaluatingDecl = Base;
@@ -603,6 +617,7 @@ namespace {
     OptionalDiagnostic Diag(SourceLocation Loc, diag::kind DiagId
                               = diag::note_invalid_subexpr_in_const_expr,
                             unsigned ExtraNotes = 0, bool IsCCEDiag = false) {
+      ++NumUncacheableEvents;
       if (EvalStatus.Diag) {
         // If we have a prior diagnostic, it will be noting that the expression
         // isn't a constant expression. This diagnostic is more important,
@@ -653,6 +668,7 @@ namespace {
                             unsigned ExtraNotes = 0, bool IsCCEDiag = false) {
       if (EvalStatus.Diag)
         return Diag(E->getExprLoc(), DiagId, ExtraNotes, IsCCEDiag);
+      ++NumUncacheableEvents;
       HasActiveDiagnostic = false;
       return OptionalDiagnostic();
     }
@@ -669,6 +685,7 @@ namespace {
       // Don't override a previous diagnostic. Don't bother collecting
       // diagnostics if we're evaluating for overflow.
       if (!EvalStatus.Diag || !EvalStatus.Diag->empty()) {
+        ++NumUncacheableEvents;
         HasActiveDiagnostic = false;
         return OptionalDiagnostic();
       }
@@ -797,6 +814,24 @@ namespace {
     }
   };
 
+  /// Measures the depth of the call stack of a call, counting the call.
+  class CallDepthRAII {
+  public:
+    explicit CallDepthRAII(EvalInfo &Info)
+        : Info(Info), StartDepth(Info.CallStackDepth),
+          OuterMaxDepth(Info.MaxCallStackDepth) {
+      Info.MaxCallStackDepth = StartDepth;
+    }
+    ~CallDepthRAII() {
+      Info.MaxCallStackDepth = std::max(Info.MaxCallStackDepth, OuterMaxDepth);
+    }
+    unsigned getDepth() const { return Info.MaxCallStackDepth - StartDepth; }
+  private:
+    EvalInfo &Info;
+    unsigned StartDepth;
+    unsigned OuterMaxDepth;
+  };
+
   /// RAII object used to treat the current evaluation as the correct pointer
   /// offset fold for the current EvalMode
   struct FoldOffsetRAII {
@@ -901,6 +936,8 @@ CallStackFrame::CallStackFrame(EvalInfo &Info, SourceLocation CallLoc,
       Index(Info.NextCallIndex++), This(This), Arguments(Arguments) {
   Info.CurrentCall = this;
   ++Info.CallStackDepth;
+  Info.MaxCallStackDepth =
+      std::max(Info.MaxCallStackDepth, Info.CallStackDepth);
 }
 
 CallStackFrame::~CallStackFrame() {
@@ -1713,12 +1750,14 @@ static bool CheckedIntArithmetic(EvalInfo &Info, const Expr *E,
   APSInt Value(Op(LHS.extend(BitWidth), RHS.extend(BitWidth)), false);
   Result = Value.trunc(LHS.getBitWidth());
   if (Result.extend(BitWidth) != Value) {
-    if (Info.checkingForOverflow())
+    if (Info.checkingForOverflow()) {
+      ++Info.NumUncacheableEvents;
       Info.Ctx.getDiagnostics().Report(E->getExprLoc(),
                                        diag::warn_integer_constant_overflow)
           << Result.toString(10) << E->getType();
-    else
+    } else {
       return HandleOverflow(Info, E, Value, E->getType());
+    }
   }
   return true;
 }
@@ -2078,6 +2117,7 @@ static bool evaluateVarDeclInit(EvalInfo &Info, const Expr *E,
   // If we're currently evaluating the initializer of this declaration, use that
   // in-flight value.
   if (Info.EvaluatingDecl.dyn_cast<const ValueDecl*>() == VD) {
+    ++Info.NumUncacheableEvents;
     Result = Info.EvaluatingDeclValue;
     return true;
   }
@@ -2753,6 +2793,8 @@ static CompleteObject findCompleteObject(EvalInfo &Info, const Expr *E,
 
         BaseVal = Info.Ctx.getMaterializedTemporaryValue(MTE, false);
         assert(BaseVal && "got reference to unevaluated temporary");
+        if (VD && VD->getCanonicalDecl() == ED->getCanonicalDecl())
+          ++Info.NumUncacheableEvents;
       } else {
         Info.Diag(E);
         return CompleteObject();
@@ -2780,6 +2822,7 @@ static CompleteObject findCompleteObject(EvalInfo &Info, const Expr *E,
   // and this doesn't do quite the right thing for const subobjects of the
   // object under construction.
   if (LVal.getLValueBase() == Info.EvaluatingDecl) {
+    ++Info.NumUncacheableEvents;
     BaseType = Info.Ctx.getCanonicalType(BaseType);
     BaseType.removeLocalConst();
   }
@@ -3839,6 +3882,45 @@ static bool HandleFunctionCall(SourceLocation CallLoc,
   if (!Info.CheckCallLimit(CallLoc))
     return false;
 
+  // Reuse the result of an earlier call with the same arguments, provided
+  // that evaluating the call again would stay within the limits.
+  unsigned DepthLimit = Info.getLangOpts().ConstexprCallDepth;
+  ConstexprCallCache &Cache = Info.Ctx.getConstexprCallCache();
+  bool Memoize = !This && !ResultSlot &&
+                 !Info.checkingPotentialConstantExpression() &&
+                 !Info.EvalStatus.HasSideEffects &&
+                 !Info.EvalStatus.HasUndefinedBehavior &&
+                 ConstexprCallCache::isCacheable(ArgValues);
+  if (Memoize) {
+    const ConstexprCallCache::Entry *Memoized =
+        Cache.lookup(Callee, ArgValues, Info.EvalMode);
+    if (Memoized && Memoized->Steps <= Info.StepsLeft &&
+        Info.CallStackDepth + Memoized->Depth - 1 <= DepthLimit) {
+      Info.StepsLeft -= Memoized->Steps;
+      Info.MaxCallStackDepth = std::max(
+          Info.MaxCallStackDepth, Info.CallStackDepth + Memoized->Depth);
+      Result = Memoized->Result;
+      return true;
+    }
+  }
+
+  // Let the interpreter evaluate the calls it supports. If it can't, evaluate
+  // the call here, which produces the notes explaining why.
+  unsigned InterpreterDepth = DepthLimit - Info.CallStackDepth;
+  if (Info.getLangOpts().ConstexprInterpreter && !This && !ResultSlot &&
+      !Info.checkingPotentialConstantExpression() &&
+      Info.Ctx.getConstexprInterpreter().call(Callee, ArgValues,
+                                              Info.StepsLeft,
+                                              InterpreterDepth, Result)) {
+    Info.MaxCallStackDepth =
+        std::max(Info.MaxCallStackDepth,
+                 Info.CallStackDepth + 1 + InterpreterDepth);
+    return true;
+  }
+
+  unsigned StepsLeft = Info.StepsLeft;
+  unsigned NumUncacheableEvents = Info.NumUncacheableEvents;
+  CallDepthRAII CallDepth(Info);
   CallStackFrame Frame(Info, CallLoc, Callee, This, ArgValues.data());
 
   // For a trivial copy or move assignment, perform an APValue copy. This is
@@ -3873,7 +3955,16 @@ static bool HandleFunctionCall(SourceLocation CallLoc,
       return true;
     Info.Diag(Callee->getLocEnd(), diag::note_constexpr_no_return);
   }
-  return ESR == ESR_Returned;
+  if (ESR != ESR_Returned)
+    return false;
+
+  if (Memoize && Info.NumUncacheableEvents == NumUncacheableEvents &&
+      !Info.EvalStatus.HasSideEffects &&
+      !Info.EvalStatus.HasUndefinedBehavior &&
+      ConstexprCallCache::isCacheable(Result))
+    Cache.insert(Callee, ArgValues, Info.EvalMode, Result,
+                 StepsLeft - Info.StepsLeft, CallDepth.getDepth());
+  return true;
 }
 
 /// Evaluate a constructor call.
@@ -22,8 +22,11 @@
 #include "clang/AST/RecursiveASTVisitor.h"
 #include "llvm/ADT/DenseMap.h"
 #include "llvm/ADT/StringMap.h"
+#include "llvm/Support/ThreadPool.h"
 #include "llvm/Support/Timer.h"
+#include <atomic>
 #include <deque>
+#include <list>
 #include <memory>
 #include <set>
 
@@ -34,16 +37,6 @@ namespace {
 
 typedef MatchFinder::MatchCallback MatchCallback;
 
-// The maximum number of memoization entries to store.
-// 10k has been experimentally found to give a good trade-off
-// of performance vs. memory consumption by running matcher
-// that match on every statement over a very large codebase.
-//
-// FIXME: Do some performance optimization in general and
-// revisit this number; also, put up micro-benchmarks that we can
-// optimize this on.
-static const unsigned MaxMemoizationEntries = 10000;
-
 // We use memoization to avoid running the same matcher on the same
 // AST node twice.  This struct is the key for looking up match
 // result.  It consists of an ID of the MatcherInterface (for
@@ -73,6 +66,66 @@ struct MemoizedMatchResult {
   BoundNodesTreeBuilder Nodes;
 };
 
+// Maps (matcher, node) -> the match result for memoization.
+//
+// Holds at most MaxEntries results; once full, the least recently used
+// result is evicted. Results are returned by pointer and must be copied out
+// before the next insert().
+class MemoizationCache {
+public:
+  typedef MatchFinder::MatchFinderOptions::MemoizationStatistics Statistics;
+
+  explicit MemoizationCache(unsigned MaxEntries)
+      : MaxEntries(std::max(MaxEntries, 1u)) {}
+
+  const MemoizedMatchResult *find(const MatchKey &Key) {
+    auto I = Results.find(Key);
+    if (I == Results.end()) {
+      ++Stats.Misses;
+      return nullptr;
+    }
+    ++Stats.Hits;
+    UseList.splice(UseList.begin(), UseList, I->second.Use);
+    return &I->second.Result;
+  }
+
+  const MemoizedMatchResult &insert(const MatchKey &Key,
+                                    MemoizedMatchResult Result) {
+    auto Inserted = Results.insert(std::make_pair(Key, Entry()));
+    Entry &E = Inserted.first->second;
+    E.Result = std::move(Result);
+    if (Inserted.second) {
+      UseList.push_front(&Inserted.first->first);
+      E.Use = UseList.begin();
+    } else {
+      UseList.splice(UseList.begin(), UseList, E.Use);
+    }
+    // The entry we just inserted is the most recently used one, so it is
+    // never evicted here.
+    while (Results.size() > MaxEntries) {
+      Results.erase(*UseList.back());
+      UseList.pop_back();
+      ++Stats.Evictions;
+    }
+    return E.Result;
+  }
+
+  const Statistics &getStatistics() const { return Stats; }
+
+private:
+  struct Entry {
+    MemoizedMatchResult Result;
+    // The position of this entry in UseList.
+    std::list<const MatchKey *>::iterator Use;
+  };
+
+  const unsigned MaxEntries;
+  std::map<MatchKey, Entry> Results;
+  // The keys of Results, most recently used first.
+  std::list<const MatchKey *> UseList;
+  Statistics Stats;
+};
+
 // A RecursiveASTVisitor that traverses all children or all descendants of
 // a node.
 class MatchChildASTVisitor
@@ -288,6 +341,68 @@ private:
   bool Matches;
 };
 
+// Maps a canonical type to its TypedefDecls.
+typedef llvm::DenseMap<const Type *, std::set<const TypedefNameDecl *>>
+    TypeAliasMap;
+
+// Matches found on a worker thread, to be passed to their callbacks later.
+typedef std::vector<std::pair<MatchCallback *, BoundNodes>> BufferedMatchList;
+
+static void addTypeAlias(ASTContext &Context, TypeAliasMap &TypeAliases,
+                         const TypedefNameDecl *DeclNode) {
+  // When we see 'typedef A B', we add name 'B' to the set of names
+  // A's canonical type maps to.  This is necessary for implementing
+  // isDerivedFrom(x) properly, where x can be the name of the base
+  // class or any of its aliases.
+  //
+  // In general, the is-alias-of (as defined by typedefs) relation
+  // is tree-shaped, as you can typedef a type more than once.  For
+  // example,
+  //
+  //   typedef A B;
+  //   typedef A C;
+  //   typedef C D;
+  //   typedef C E;
+  //
+  // gives you
+  //
+  //   A
+  //   |- B
+  //   `- C
+  //      |- D
+  //      `- E
+  //
+  // It is wrong to assume that the relation is a chain.  A correct
+  // implementation of isDerivedFrom() needs to recognize that B and
+  // E are aliases, even though neither is a typedef of the other.
+  // Therefore, we cannot simply walk through one typedef chain to
+  // find out whether the type name matches.
+  const Type *TypeNode = DeclNode->getUnderlyingType().getTypePtr();
+  const Type *CanonicalType =  // root of the typedef tree
+      Context.getCanonicalType(TypeNode);
+  TypeAliases[CanonicalType].insert(DeclNode);
+}
+
+// Collects the type aliases of a whole translation unit up front, so that
+// threads matching different parts of it share one complete alias map.
+class TypeAliasCollector : public RecursiveASTVisitor<TypeAliasCollector> {
+public:
+  TypeAliasCollector(ASTContext &Context, TypeAliasMap &TypeAliases)
+      : Context(Context), TypeAliases(TypeAliases) {}
+
+  bool VisitTypedefNameDecl(TypedefNameDecl *DeclNode) {
+    addTypeAlias(Context, TypeAliases, DeclNode);
+    return true;
+  }
+
+  bool shouldVisitTemplateInstantiations() const { return true; }
+  bool shouldVisitImplicitCode() const { return true; }
+
+private:
+  ASTContext &Context;
+  TypeAliasMap &TypeAliases;
+};
+
 // Controls the outermost traversal of the AST and allows to match multiple
 // matchers.
 class MatchASTVisitor : public RecursiveASTVisitor<MatchASTVisitor>,
@@ -295,12 +410,17 @@ class MatchASTVisitor : public RecursiveASTVisitor<MatchASTVisitor>,
 public:
   MatchASTVisitor(const MatchFinder::MatchersByType *Matchers,
                   const MatchFinder::MatchFinderOptions &Options)
-      : Matchers(Matchers), Options(Options), ActiveASTContext(nullptr) {}
+      : Matchers(Matchers), Options(Options), ActiveASTContext(nullptr),
+        SharedTypeAliases(nullptr), MatchBuffer(nullptr),
+        ASTContextMutex(nullptr),
+        ResultCache(Options.MaxMemoizationEntries) {}
 
   ~MatchASTVisitor() override {
     if (Options.CheckProfiling) {
       Options.CheckProfiling->Records = std::move(TimeByBucket);
     }
+    if (Options.MemoizationStats)
+      *Options.MemoizationStats += ResultCache.getStatistics();
   }
 
   void onStartOfTranslationUnit() {
@@ -327,41 +447,44 @@ public:
     ActiveASTContext = NewActiveASTContext;
   }
 
+  /// \brief Use the precomputed \p TypeAliases instead of collecting them
+  /// during the traversal.
+  void setSharedTypeAliases(const TypeAliasMap *TypeAliases) {
+    SharedTypeAliases = TypeAliases;
+  }
+
+  /// \brief Serialize the queries of lazily computed AST state with \p Mutex.
+  void setASTContextMutex(llvm::sys::Mutex *Mutex) {
+    ASTContextMutex = Mutex;
+  }
+
+  /// \brief Append matches to \p Buffer instead of running their callbacks.
+  void setMatchBuffer(BufferedMatchList *Buffer) { MatchBuffer = Buffer; }
+
+  /// \brief Runs the callbacks of matches buffered by another visitor.
+  void runBufferedMatches(const BufferedMatchList &Matches) {
+    const bool EnableCheckProfiling = Options.CheckProfiling.hasValue();
+    TimeBucketRegion Timer;
+    for (const auto &Match : Matches) {
+      if (EnableCheckProfiling)
+        Timer.setBucket(&TimeByBucket[Match.first->getID()]);
+      Match.first->run(MatchFinder::MatchResult(Match.second,
+                                                ActiveASTContext));
+    }
+  }
+
+  /// \brief Adds the per-check timings of another visitor to ours.
+  void addTimeRecords(const llvm::StringMap<llvm::TimeRecord> &Records) {
+    for (const auto &Record : Records)
+      TimeByBucket[Record.getKey()] += Record.getValue();
+  }
+
   // The following Visit*() and Traverse*() functions "override"
   // methods in RecursiveASTVisitor.
 
   bool VisitTypedefNameDecl(TypedefNameDecl *DeclNode) {
-    // When we see 'typedef A B', we add name 'B' to the set of names
-    // A's canonical type maps to.  This is necessary for implementing
-    // isDerivedFrom(x) properly, where x can be the name of the base
-    // class or any of its aliases.
-    //
-    // In general, the is-alias-of (as defined by typedefs) relation
-    // is tree-shaped, as you can typedef a type more than once.  For
-    // example,
-    //
-    //   typedef A B;
-    //   typedef A C;
-    //   typedef C D;
-    //   typedef C E;
-    //
-    // gives you
-    //
-    //   A
-    //   |- B
-    //   `- C
-    //      |- D
-    //      `- E
-    //
-    // It is wrong to assume that the relation is a chain.  A correct
-    // implementation of isDerivedFrom() needs to recognize that B and
-    // E are aliases, even though neither is a typedef of the other.
-    // Therefore, we cannot simply walk through one typedef chain to
-    // find out whether the type name matches.
-    const Type *TypeNode = DeclNode->getUnderlyingType().getTypePtr();
-    const Type *CanonicalType =  // root of the typedef tree
-        ActiveASTContext->getCanonicalType(TypeNode);
-    TypeAliases[CanonicalType].insert(DeclNode);
+    if (!SharedTypeAliases)
+      addTypeAlias(*ActiveASTContext, TypeAliases, DeclNode);
     return true;
   }
 
@@ -388,10 +511,9 @@ public:
     // Note that we key on the bindings *before* the match.
     Key.BoundNodes = *Builder;
 
-    MemoizationMap::iterator I = ResultCache.find(Key);
-    if (I != ResultCache.end()) {
-      *Builder = I->second.Nodes;
-      return I->second.ResultOfMatch;
+    if (const MemoizedMatchResult *Cached = ResultCache.find(Key)) {
+      *Builder = Cached->Nodes;
+      return Cached->ResultOfMatch;
     }
 
     MemoizedMatchResult Result;
@@ -399,8 +521,8 @@ public:
     Result.ResultOfMatch = matchesRecursively(Node, Matcher, &Result.Nodes,
                                               MaxDepth, Traversal, Bind);
 
-    MemoizedMatchResult &CachedResult = ResultCache[Key];
-    CachedResult = std::move(Result);
+    const MemoizedMatchResult &CachedResult =
+        ResultCache.insert(Key, std::move(Result));
 
     *Builder = CachedResult.Nodes;
     return CachedResult.ResultOfMatch;
@@ -426,8 +548,6 @@ public:
                       BoundNodesTreeBuilder *Builder,
                       TraversalKind Traversal,
                       BindKind Bind) override {
-    if (ResultCache.size() > MaxMemoizationEntries)
-      ResultCache.clear();
     return memoizedMatchesRecursively(Node, Matcher, Builder, 1, Traversal,
                                       Bind);
   }
@@ -436,8 +556,6 @@ public:
                            const DynTypedMatcher &Matcher,
                            BoundNodesTreeBuilder *Builder,
                            BindKind Bind) override {
-    if (ResultCache.size() > MaxMemoizationEntries)
-      ResultCache.clear();
     return memoizedMatchesRecursively(Node, Matcher, Builder, INT_MAX,
                                       TK_AsIs, Bind);
   }
@@ -446,10 +564,6 @@ public:
                          const DynTypedMatcher &Matcher,
                          BoundNodesTreeBuilder *Builder,
                          AncestorMatchMode MatchMode) override {
-    // Reset the cache outside of the recursive call to make sure we
-    // don't invalidate any iterators.
-    if (ResultCache.size() > MaxMemoizationEntries)
-      ResultCache.clear();
     return memoizedMatchesAncestorOfRecursively(Node, Matcher, Builder,
                                                 MatchMode);
   }
@@ -482,6 +596,10 @@ public:
   // Implements ASTMatchFinder::getASTContext.
   ASTContext &getASTContext() const override { return *ActiveASTContext; }
 
+  llvm::sys::Mutex *getASTContextMutex() const override {
+    return ASTContextMutex;
+  }
+
   bool shouldVisitTemplateInstantiations() const { return true; }
   bool shouldVisitImplicitCode() const { return true; }
 
@@ -526,7 +644,7 @@ private:
         Timer.setBucket(&TimeByBucket[MP.second->getID()]);
       BoundNodesTreeBuilder Builder;
       if (MP.first.matches(Node, this, &Builder)) {
-        MatchVisitor Visitor(ActiveASTContext, MP.second);
+        MatchVisitor Visitor(ActiveASTContext, MP.second, MatchBuffer);
         Builder.visitMatches(&Visitor);
       }
     }
@@ -538,32 +656,82 @@ private:
     const auto &Filter =
         it != MatcherFiltersMap.end() ? it->second : getFilterForKind(Kind);
 
-    if (Filter.empty())
+    if (Filter.All.empty())
       return;
 
     const bool EnableCheckProfiling = Options.CheckProfiling.hasValue();
     TimeBucketRegion Timer;
     auto &Matchers = this->Matchers->DeclOrStmt;
-    for (unsigned short I : Filter) {
+    auto MatchOne = [&](unsigned short I) {
       auto &MP = Matchers[I];
       if (EnableCheckProfiling)
         Timer.setBucket(&TimeByBucket[MP.second->getID()]);
       BoundNodesTreeBuilder Builder;
       if (MP.first.matchesNoKindCheck(DynNode, this, &Builder)) {
-        MatchVisitor Visitor(ActiveASTContext, MP.second);
+        MatchVisitor Visitor(ActiveASTContext, MP.second, MatchBuffer);
         Builder.visitMatches(&Visitor);
       }
+    };
+
+    // Nodes without a plain identifier may still match a matcher that
+    // requires a name (e.g. constructors), so they get all the matchers.
+    const NamedDecl *ND =
+        Filter.ByName.empty() ? nullptr : DynNode.get<NamedDecl>();
+    if (!ND || !ND->getIdentifier()) {
+      for (unsigned short I : Filter.All)
+        MatchOne(I);
+      return;
+    }
+
+    auto NamedIt = Filter.ByName.find(ND->getName());
+    if (NamedIt == Filter.ByName.end()) {
+      for (unsigned short I : Filter.Unnamed)
+        MatchOne(I);
+      return;
+    }
+
+    // Run both lists in the order the matchers were added.
+    const auto &Unnamed = Filter.Unnamed;
+    const auto &Named = NamedIt->second;
+    size_t U = 0, N = 0;
+    while (U != Unnamed.size() || N != Named.size()) {
+      if (N == Named.size() ||
+          (U != Unnamed.size() && Unnamed[U] < Named[N]))
+        MatchOne(Unnamed[U++]);
+      else
+        MatchOne(Named[N++]);
     }
   }
 
-  const std::vector<unsigned short> &
-  getFilterForKind(ast_type_traits::ASTNodeKind Kind) {
+  /// \brief The indices of the \c DeclOrStmt matchers that can match one
+  /// node kind.
+  struct MatcherFilter {
+    /// \brief All matchers that can match the kind.
+    std::vector<unsigned short> All;
+    /// \brief The matchers that can match nodes of any name.
+    std::vector<unsigned short> Unnamed;
+    /// \brief The other matchers, by the identifiers they require.
+    llvm::StringMap<std::vector<unsigned short>> ByName;
+  };
+
+  const MatcherFilter &getFilterForKind(ast_type_traits::ASTNodeKind Kind) {
     auto &Filter = MatcherFiltersMap[Kind];
     auto &Matchers = this->Matchers->DeclOrStmt;
+    auto &Names = this->Matchers->DeclOrStmtNames;
     assert((Matchers.size() < USHRT_MAX) && "Too many matchers.");
     for (unsigned I = 0, E = Matchers.size(); I != E; ++I) {
-      if (Matchers[I].first.canMatchNodesOfKind(Kind)) {
-        Filter.push_back(I);
+      if (!Matchers[I].first.canMatchNodesOfKind(Kind))
+        continue;
+      Filter.All.push_back(I);
+      if (Names[I].empty()) {
+        Filter.Unnamed.push_back(I);
+        continue;
+      }
+      for (const std::string &Name : Names[I]) {
+        auto &Named = Filter.ByName[Name];
+        // hasAnyName() may list the same identifier more than once.
+        if (Named.empty() || Named.back() != I)
+          Named.push_back(I);
       }
     }
     return Filter;
@@ -625,12 +793,11 @@ private:
     Key.Node = Node;
     Key.BoundNodes = *Builder;
 
-    // Note that we cannot use insert and reuse the iterator, as recursive
-    // calls to match might invalidate the result cache iterators.
-    MemoizationMap::iterator I = ResultCache.find(Key);
-    if (I != ResultCache.end()) {
-      *Builder = I->second.Nodes;
-      return I->second.ResultOfMatch;
+    // Note that we cannot insert first and fill in the result later, as
+    // recursive calls to match might evict the entry.
+    if (const MemoizedMatchResult *Cached = ResultCache.find(Key)) {
+      *Builder = Cached->Nodes;
+      return Cached->ResultOfMatch;
     }
 
     MemoizedMatchResult Result;
@@ -638,8 +805,8 @@ private:
     Result.ResultOfMatch =
         matchesAncestorOfRecursively(Node, Matcher, &Result.Nodes, MatchMode);
 
-    MemoizedMatchResult &CachedResult = ResultCache[Key];
-    CachedResult = std::move(Result);
+    const MemoizedMatchResult &CachedResult =
+        ResultCache.insert(Key, std::move(Result));
 
     *Builder = CachedResult.Nodes;
     return CachedResult.ResultOfMatch;
@@ -697,17 +864,23 @@ private:
   class MatchVisitor : public BoundNodesTreeBuilder::Visitor {
   public:
     MatchVisitor(ASTContext* Context,
-                 MatchFinder::MatchCallback* Callback)
+                 MatchFinder::MatchCallback* Callback,
+                 BufferedMatchList *Buffer)
       : Context(Context),
-        Callback(Callback) {}
+        Callback(Callback),
+        Buffer(Buffer) {}
 
     void visitMatch(const BoundNodes& BoundNodesView) override {
-      Callback->run(MatchFinder::MatchResult(BoundNodesView, Context));
+      if (Buffer)
+        Buffer->push_back(std::make_pair(Callback, BoundNodesView));
+      else
+        Callback->run(MatchFinder::MatchResult(BoundNodesView, Context));
     }
 
   private:
     ASTContext* Context;
     MatchFinder::MatchCallback* Callback;
+    BufferedMatchList *Buffer;
   };
 
   // Returns true if 'TypeNode' has an alias that matches the given matcher.
@@ -716,7 +889,9 @@ private:
                             BoundNodesTreeBuilder *Builder) {
     const Type *const CanonicalType =
       ActiveASTContext->getCanonicalType(TypeNode);
-    for (const TypedefNameDecl *Alias : TypeAliases.lookup(CanonicalType)) {
+    const TypeAliasMap &Aliases =
+        SharedTypeAliases ? *SharedTypeAliases : TypeAliases;
+    for (const TypedefNameDecl *Alias : Aliases.lookup(CanonicalType)) {
       BoundNodesTreeBuilder Result(*Builder);
       if (Matcher.matches(*Alias, this, &Result)) {
         *Builder = std::move(Result);
@@ -741,18 +916,30 @@ private:
   /// We precalculate a list of matchers that pass the toplevel restrict check.
   /// This also allows us to skip the restrict check at matching time. See
   /// use \c matchesNoKindCheck() above.
-  llvm::DenseMap<ast_type_traits::ASTNodeKind, std::vector<unsigned short>>
+  /// Matchers rooted in \c hasName() are further indexed by the identifier
+  /// they require, so they are only tried on nodes of that name.
+  llvm::DenseMap<ast_type_traits::ASTNodeKind, MatcherFilter>
       MatcherFiltersMap;
 
   const MatchFinder::MatchFinderOptions &Options;
   ASTContext *ActiveASTContext;
 
   // Maps a canonical type to its TypedefDecls.
-  llvm::DenseMap<const Type*, std::set<const TypedefNameDecl*> > TypeAliases;
+  TypeAliasMap TypeAliases;
 
-  // Maps (matcher, node) -> the match result for memoization.
-  typedef std::map<MatchKey, MemoizedMatchResult> MemoizationMap;
-  MemoizationMap ResultCache;
+  // If set, the aliases of the whole translation unit, used instead of
+  // TypeAliases.
+  const TypeAliasMap *SharedTypeAliases;
+
+  // If set, matches are collected here instead of being passed to their
+  // callbacks.
+  BufferedMatchList *MatchBuffer;
+
+  // If set, held by matchers while they query state that the AST computes
+  // and caches on demand, such as SourceManager lookups or linkage.
+  llvm::sys::Mutex *ASTContextMutex;
+
+  MemoizationCache ResultCache;
 };
 
 static CXXRecordDecl *
@@ -864,6 +1051,76 @@ bool MatchASTVisitor::TraverseNestedNameSpecifierLoc(
       RecursiveASTVisitor<MatchASTVisitor>::TraverseNestedNameSpecifierLoc(NNS);
 }
 
+// Matches the declarations of the translation unit on Options.NumThreads
+// threads. \p Visitor matches the translation unit declaration itself and
+// runs the callbacks of the matches buffered by the threads, so callbacks
+// always run on the calling thread.
+static void matchTranslationUnitInParallel(
+    MatchASTVisitor &Visitor, const MatchFinder::MatchersByType &Matchers,
+    const MatchFinder::MatchFinderOptions &Options, ASTContext &Context) {
+  TranslationUnitDecl *TU = Context.getTranslationUnitDecl();
+
+  // Both the parent map and the alias map are built lazily when matching
+  // serially; build them before the threads can race on them.
+  Context.getParents(ast_type_traits::DynTypedNode::create(*TU));
+  TypeAliasMap TypeAliases;
+  TypeAliasCollector(Context, TypeAliases).TraverseDecl(TU);
+
+  Visitor.match(*TU);
+
+  // This mirrors RecursiveASTVisitor's traversal of a DeclContext.
+  std::vector<Decl *> TopLevelDecls;
+  for (Decl *Child : TU->decls())
+    if (!isa<BlockDecl>(Child) && !isa<CapturedDecl>(Child))
+      TopLevelDecls.push_back(Child);
+
+  // Hand out small chunks of consecutive declarations, so that all threads
+  // stay busy even if some declarations are much more expensive than others.
+  // Buffered matches are kept per chunk to replay them in traversal order.
+  const unsigned NumThreads = Options.NumThreads;
+  const size_t ChunkSize =
+      std::max<size_t>(1, TopLevelDecls.size() / (NumThreads * 16));
+  const size_t NumChunks = (TopLevelDecls.size() + ChunkSize - 1) / ChunkSize;
+  std::vector<BufferedMatchList> ChunkMatches(NumChunks);
+  std::vector<llvm::StringMap<llvm::TimeRecord>> ThreadRecords(NumThreads);
+  std::vector<MatchFinder::MatchFinderOptions::MemoizationStatistics>
+      ThreadStats(NumThreads);
+  std::atomic<size_t> NextChunk(0);
+  llvm::sys::Mutex ASTContextMutex;
+
+  llvm::ThreadPool Pool(NumThreads);
+  for (unsigned Thread = 0; Thread != NumThreads; ++Thread) {
+    Pool.async([&, Thread]() {
+      MatchFinder::MatchFinderOptions ThreadOptions;
+      if (Options.CheckProfiling)
+        ThreadOptions.CheckProfiling.emplace(ThreadRecords[Thread]);
+      ThreadOptions.MaxMemoizationEntries = Options.MaxMemoizationEntries;
+      if (Options.MemoizationStats)
+        ThreadOptions.MemoizationStats = &ThreadStats[Thread];
+      MatchASTVisitor ThreadVisitor(&Matchers, ThreadOptions);
+      ThreadVisitor.set_active_ast_context(&Context);
+      ThreadVisitor.setSharedTypeAliases(&TypeAliases);
+      ThreadVisitor.setASTContextMutex(&ASTContextMutex);
+      for (size_t Chunk = NextChunk++; Chunk < NumChunks;
+           Chunk = NextChunk++) {
+        ThreadVisitor.setMatchBuffer(&ChunkMatches[Chunk]);
+        size_t End = std::min(TopLevelDecls.size(), (Chunk + 1) * ChunkSize);
+        for (size_t I = Chunk * ChunkSize; I != End; ++I)
+          ThreadVisitor.TraverseDecl(TopLevelDecls[I]);
+      }
+    });
+  }
+  Pool.wait();
+
+  for (const auto &Records : ThreadRecords)
+    Visitor.addTimeRecords(Records);
+  if (Options.MemoizationStats)
+    for (const auto &Stats : ThreadStats)
+      *Options.MemoizationStats += Stats;
+  for (const auto &Matches : ChunkMatches)
+    Visitor.runBufferedMatches(Matches);
+}
+
 class MatchASTConsumer : public ASTConsumer {
 public:
   MatchASTConsumer(MatchFinder *Finder,
@@ -898,12 +1155,21 @@ MatchFinder::MatchFinder(MatchFinderOptions Options)
 
 MatchFinder::~MatchFinder() {}
 
-void MatchFinder::addMatcher(const DeclarationMatcher &NodeMatch,
-                             MatchCallback *Action) {
+static void addDeclOrStmtMatcher(MatchFinder::MatchersByType &Matchers,
+                                 const internal::DynTypedMatcher &NodeMatch,
+                                 MatchFinder::MatchCallback *Action) {
   Matchers.DeclOrStmt.emplace_back(NodeMatch, Action);
+  Matchers.DeclOrStmtNames.emplace_back();
+  if (!NodeMatch.getRequiredNames(Matchers.DeclOrStmtNames.back()))
+    Matchers.DeclOrStmtNames.back().clear();
   Matchers.AllCallbacks.insert(Action);
 }
 
+void MatchFinder::addMatcher(const DeclarationMatcher &NodeMatch,
+                             MatchCallback *Action) {
+  addDeclOrStmtMatcher(Matchers, NodeMatch, Action);
+}
+
 void MatchFinder::addMatcher(const TypeMatcher &NodeMatch,
                              MatchCallback *Action) {
   Matchers.Type.emplace_back(NodeMatch, Action);
@@ -912,8 +1178,7 @@ void MatchFinder::addMatcher(const TypeMatcher &NodeMatch,
 
 void MatchFinder::addMatcher(const StatementMatcher &NodeMatch,
                              MatchCallback *Action) {
-  Matchers.DeclOrStmt.emplace_back(NodeMatch, Action);
-  Matchers.AllCallbacks.insert(Action);
+  addDeclOrStmtMatcher(Matchers, NodeMatch, Action);
 }
 
 void MatchFinder::addMatcher(const NestedNameSpecifierMatcher &NodeMatch,
@@ -973,7 +1238,11 @@ void MatchFinder::matchAST(ASTContext &Context) {
   internal::MatchASTVisitor Visitor(&Matchers, Options);
   Visitor.set_active_ast_context(&Context);
   Visitor.onStartOfTranslationUnit();
-  Visitor.TraverseDecl(Context.getTranslationUnitDecl());
+  if (Options.NumThreads > 1 && !Context.getExternalSource())
+    internal::matchTranslationUnitInParallel(Visitor, Matchers, Options,
+                                             Context);
+  else
+    Visitor.TraverseDecl(Context.getTranslationUnitDecl());
   Visitor.onEndOfTranslationUnit();
 }
 
@@ -13,6 +13,7 @@
 
 #include "clang/ASTMatchers/ASTMatchers.h"
 #include "clang/ASTMatchers/ASTMatchersInternal.h"
+#include "clang/Basic/CharInfo.h"
 #include "llvm/ADT/SmallString.h"
 #include "llvm/ADT/SmallVector.h"
 #include "llvm/Support/ManagedStatic.h"
@@ -67,6 +68,31 @@ public:
     return Func(DynNode, Finder, Builder, InnerMatchers);
   }
 
+  bool getRequiredNames(std::vector<std::string> &Names) const override {
+    // allOf() requires the names of any one of its inner matchers.
+    if (Func == AllOfVariadicOperator) {
+      for (const DynTypedMatcher &InnerMatcher : InnerMatchers) {
+        std::vector<std::string> InnerNames;
+        if (InnerMatcher.getRequiredNames(InnerNames)) {
+          Names.insert(Names.end(), InnerNames.begin(), InnerNames.end());
+          return true;
+        }
+      }
+      return false;
+    }
+    // anyOf() and eachOf() require the names of all their inner matchers.
+    if (Func == AnyOfVariadicOperator || Func == EachOfVariadicOperator) {
+      std::vector<std::string> AllNames;
+      for (const DynTypedMatcher &InnerMatcher : InnerMatchers) {
+        if (!InnerMatcher.getRequiredNames(AllNames))
+          return false;
+      }
+      Names.insert(Names.end(), AllNames.begin(), AllNames.end());
+      return true;
+    }
+    return false;
+  }
+
 private:
   std::vector<DynTypedMatcher> InnerMatchers;
 };
@@ -85,6 +111,10 @@ class IdDynMatcher : public DynMatcherInterface {
     return Result;
   }
 
+  bool getRequiredNames(std::vector<std::string> &Names) const override {
+    return InnerMatcher->getRequiredNames(Names);
+  }
+
  private:
   const std::string ID;
   const IntrusiveRefCntPtr<DynMatcherInterface> InnerMatcher;
@@ -502,6 +532,23 @@ bool HasNameMatcher::matchesNode(const NamedDecl &Node) const {
   return matchesNodeFullFast(Node);
 }
 
+bool HasNameMatcher::getRequiredNames(std::vector<std::string> &Result) const {
+  // Only the last component of each name is required. Names that do not end
+  // in an identifier (e.g. operators) may match nodes without one, so they
+  // do not restrict the nodes we can match.
+  std::vector<std::string> Identifiers;
+  for (StringRef Name : Names) {
+    size_t Pos = Name.rfind("::");
+    StringRef Identifier =
+        Pos == StringRef::npos ? Name : Name.drop_front(Pos + 2);
+    if (!isValidIdentifier(Identifier))
+      return false;
+    Identifiers.push_back(Identifier);
+  }
+  Result.insert(Result.end(), Identifiers.begin(), Identifiers.end());
+  return true;
+}
+
 } // end namespace internal
 } // end namespace ast_matchers
 } // end namespace clang
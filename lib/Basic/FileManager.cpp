@@ -25,11 +25,15 @@
 #include "llvm/Support/FileSystem.h"
 #include "llvm/Support/MemoryBuffer.h"
 #include "llvm/Support/Path.h"
+#include "llvm/Support/Process.h"
 #include "llvm/Support/raw_ostream.h"
 #include <map>
 #include <set>
 #include <string>
 #include <system_error>
+#ifdef LLVM_ON_UNIX
+#include <sys/mman.h>
+#endif
 
 using namespace clang;
 
@@ -51,6 +55,9 @@ FileManager::FileManager(const FileSystemOptions &FSO,
     SeenDirEntries(64), SeenFileEntries(64), NextFileUID(0) {
   NumDirLookups = NumFileLookups = 0;
   NumDirCacheMisses = NumFileCacheMisses = 0;
+  NumDirListings = 0;
+  NumSharedBufferHits = 0;
+  NumBytesMapped = NumBytesCopied = NumBytesHugePages = 0;
 
   // If the caller doesn't provide a virtual file system, just grab the real
   // file system.
@@ -400,8 +407,10 @@ bool FileManager::FixupRelativePath(SmallVectorImpl<char> &path) const {
 bool FileManager::makeAbsolutePath(SmallVectorImpl<char> &Path) const {
   bool Changed = FixupRelativePath(Path);
 
+  // Resolve against the working directory of the file system, which need not
+  // be the one of the process.
   if (!llvm::sys::path::is_absolute(StringRef(Path.data(), Path.size()))) {
-    llvm::sys::fs::make_absolute(Path);
+    FS->makeAbsolute(Path);
     Changed = true;
   }
 
@@ -427,29 +436,163 @@ FileManager::getBufferForFile(const FileEntry *Entry, bool isVolatile,
     // FileEntry is open or not.
     if (ShouldCloseOpenFile)
       Entry->closeFile();
+    noteBufferRead(Result);
     return Result;
   }
 
   // Otherwise, open the file.
 
-  if (FileSystemOpts.WorkingDir.empty())
-    return FS->getBufferForFile(Filename, FileSize,
-                                /*RequiresNullTerminator=*/true, isVolatile);
+  if (FileSystemOpts.WorkingDir.empty()) {
+    auto Result = FS->getBufferForFile(Filename, FileSize,
+                                       /*RequiresNullTerminator=*/true,
+                                       isVolatile);
+    noteBufferRead(Result);
+    return Result;
+  }
 
   SmallString<128> FilePath(Entry->getName());
   FixupRelativePath(FilePath);
-  return FS->getBufferForFile(FilePath, FileSize,
-                              /*RequiresNullTerminator=*/true, isVolatile);
+  auto Result = FS->getBufferForFile(FilePath, FileSize,
+                                     /*RequiresNullTerminator=*/true,
+                                     isVolatile);
+  noteBufferRead(Result);
+  return Result;
 }
 
 llvm::ErrorOr<std::unique_ptr<llvm::MemoryBuffer>>
 FileManager::getBufferForFile(StringRef Filename) {
-  if (FileSystemOpts.WorkingDir.empty())
-    return FS->getBufferForFile(Filename);
+  if (FileSystemOpts.WorkingDir.empty()) {
+    auto Result = FS->getBufferForFile(Filename);
+    noteBufferRead(Result);
+    return Result;
+  }
 
   SmallString<128> FilePath(Filename);
   FixupRelativePath(FilePath);
-  return FS->getBufferForFile(FilePath.c_str());
+  auto Result = FS->getBufferForFile(FilePath.c_str());
+  noteBufferRead(Result);
+  return Result;
+}
+
+namespace {
+/// A MemoryBuffer which refers to the contents of a file kept by the
+/// FileManager.
+class SharedFileBuffer : public llvm::MemoryBuffer {
+  std::shared_ptr<llvm::MemoryBuffer> Contents;
+
+public:
+  explicit SharedFileBuffer(std::shared_ptr<llvm::MemoryBuffer> Contents)
+      : Contents(std::move(Contents)) {
+    init(this->Contents->getBufferStart(), this->Contents->getBufferEnd(),
+         /*RequiresNullTerminator=*/true);
+  }
+
+  const char *getBufferIdentifier() const override {
+    return Contents->getBufferIdentifier();
+  }
+
+  // Report the kind of the shared contents, so that the memory used by the
+  // SourceManager is still accounted as mapped or malloc'ed.
+  BufferKind getBufferKind() const override {
+    return Contents->getBufferKind();
+  }
+};
+
+/// A MemoryBuffer which owns a read-only mapping of a file.
+class MappedFileBuffer : public llvm::MemoryBuffer {
+  llvm::sys::fs::mapped_file_region Region;
+  std::string Name;
+
+public:
+  MappedFileBuffer(int FD, uint64_t Size, StringRef Name, std::error_code &EC)
+      : Region(FD, llvm::sys::fs::mapped_file_region::readonly, Size, 0, EC),
+        Name(Name) {
+    if (!EC)
+      init(Region.const_data(), Region.const_data() + Size,
+           /*RequiresNullTerminator=*/true);
+  }
+
+  /// \brief Advise the system to back the mapping with huge pages. Returns
+  /// false if it can't.
+  bool adviseHugePages() {
+#if defined(LLVM_ON_UNIX) && defined(MADV_HUGEPAGE)
+    return ::madvise(const_cast<char *>(Region.const_data()), Region.size(),
+                     MADV_HUGEPAGE) == 0;
+#else
+    return false;
+#endif
+  }
+
+  const char *getBufferIdentifier() const override { return Name.c_str(); }
+
+  BufferKind getBufferKind() const override { return MemoryBuffer_MMap; }
+};
+} // end anonymous namespace
+
+std::unique_ptr<llvm::MemoryBuffer>
+FileManager::mapFile(const FileEntry *Entry) {
+  // The contents are followed by the zeros filling the rest of their last
+  // page, which terminate them, unless they end on a page boundary.
+  uint64_t Size = Entry->getSize();
+  if (Size == 0 || Size % llvm::sys::Process::getPageSize() == 0)
+    return nullptr;
+
+  SmallString<128> FilePath(Entry->getName());
+  FixupRelativePath(FilePath);
+  int FD;
+  if (llvm::sys::fs::openFileForRead(FilePath, FD))
+    return nullptr;
+  std::error_code EC;
+  auto Buffer = llvm::make_unique<MappedFileBuffer>(FD, Size, FilePath, EC);
+  llvm::sys::Process::SafelyCloseFileDescriptor(FD);
+  if (EC)
+    return nullptr;
+
+  NumBytesMapped += Size;
+  if (Buffer->adviseHugePages())
+    NumBytesHugePages += Size;
+  return std::move(Buffer);
+}
+
+llvm::ErrorOr<std::unique_ptr<llvm::MemoryBuffer>>
+FileManager::getSharedBufferForFile(const FileEntry *Entry, bool isVolatile) {
+  // The contents of a volatile file must be read again by each user.
+  if (isVolatile)
+    return getBufferForFile(Entry, isVolatile);
+
+  std::weak_ptr<llvm::MemoryBuffer> &Shared = SharedBuffers[Entry];
+  if (std::shared_ptr<llvm::MemoryBuffer> Contents = Shared.lock()) {
+    ++NumSharedBufferHits;
+    // Don't hold on to a file descriptor we won't read from.
+    Entry->closeFile();
+    return llvm::make_unique<SharedFileBuffer>(std::move(Contents));
+  }
+
+  // Only the files of the real file system can be mapped directly.
+  std::shared_ptr<llvm::MemoryBuffer> Contents;
+  if (FileSystemOpts.MapSharedFiles && FS == vfs::getRealFileSystem()) {
+    Contents = mapFile(Entry);
+    if (Contents)
+      Entry->closeFile();
+  }
+  if (!Contents) {
+    auto BufferOrError = getBufferForFile(Entry);
+    if (!BufferOrError)
+      return BufferOrError.getError();
+    Contents = std::move(*BufferOrError);
+  }
+  Shared = Contents;
+  return llvm::make_unique<SharedFileBuffer>(std::move(Contents));
+}
+
+void FileManager::noteBufferRead(
+    const llvm::ErrorOr<std::unique_ptr<llvm::MemoryBuffer>> &Buffer) {
+  if (!Buffer)
+    return;
+  if ((*Buffer)->getBufferKind() == llvm::MemoryBuffer::MemoryBuffer_MMap)
+    NumBytesMapped += (*Buffer)->getBufferSize();
+  else
+    NumBytesCopied += (*Buffer)->getBufferSize();
 }
 
 /// getStatValue - Get the 'stat' information for the specified path,
@@ -483,10 +626,56 @@ bool FileManager::getNoncachedStatValue(StringRef Path,
   return false;
 }
 
+bool FileManager::mayContainEntry(const DirectoryEntry *Dir, StringRef Name) {
+  // Directory listings don't include "." and "..", nor the files a stat cache
+  // may know about.
+  if (Name == "." || Name == ".." || StatCache)
+    return true;
+
+  // Virtual files and directories aren't listed either, so check what we
+  // already know about the entry first.
+  SmallString<128> Path(Dir->getName());
+  llvm::sys::path::append(Path, Name);
+  auto KnownFile = SeenFileEntries.find(Path);
+  if (KnownFile != SeenFileEntries.end() && KnownFile->second)
+    return KnownFile->second != NON_EXISTENT_FILE;
+  auto KnownDir = SeenDirEntries.find(Path);
+  if (KnownDir != SeenDirEntries.end() && KnownDir->second &&
+      KnownDir->second != NON_EXISTENT_DIR)
+    return true;
+
+  auto Known = DirectoryListings.find(Dir);
+  if (Known == DirectoryListings.end()) {
+    ++NumDirListings;
+    SmallString<128> DirPath(Dir->getName());
+    FixupRelativePath(DirPath);
+
+    // File systems may be case-insensitive, so remember the names lowercased.
+    // This can only make us answer true for entries that don't exist.
+    auto Listing = llvm::make_unique<llvm::StringSet<>>();
+    std::error_code EC;
+    for (vfs::directory_iterator Entry = FS->dir_begin(DirPath, EC), End;
+         !EC && Entry != End; Entry.increment(EC))
+      Listing->insert(llvm::sys::path::filename(Entry->getName()).lower());
+    if (EC)
+      Listing.reset();
+
+    Known = DirectoryListings.insert(std::make_pair(Dir, std::move(Listing)))
+                .first;
+  }
+
+  return !Known->second || Known->second->count(Name.lower());
+}
+
 void FileManager::invalidateCache(const FileEntry *Entry) {
   assert(Entry && "Cannot invalidate a NULL FileEntry");
 
   SeenFileEntries.erase(Entry->getName());
+  SharedBuffers.erase(Entry);
+
+  // The file may have been created or renamed since we listed its directory.
+  if (Entry->getDir())
+    DirectoryListings.erase(Entry->getDir());
 
   // FileEntry invalidation should not block future optimizations in the file
   // caches. Possible alternatives are cache truncation (invalidate last N) or
@@ -560,6 +749,12 @@ void FileManager::PrintStats() const {
                << NumDirCacheMisses << " dir cache misses.\n";
   llvm::errs() << NumFileLookups << " file lookups, "
                << NumFileCacheMisses << " file cache misses.\n";
+  llvm::errs() << NumDirListings << " dir listings read.\n";
+  llvm::errs() << NumBytesMapped << " bytes of files mapped, "
+               << NumBytesCopied << " bytes of files copied, "
+               << NumSharedBufferHits << " file reads shared.\n";
+  llvm::errs() << NumBytesHugePages
+               << " bytes of files mapped with huge-page hints.\n";
 
   //llvm::errs() << PagesMapped << BytesOfPagesMapped << FSLookups;
 }
@@ -22,6 +22,7 @@
 #include "llvm/Support/Compiler.h"
 #include "llvm/Support/MemoryBuffer.h"
 #include "llvm/Support/Path.h"
+#include "llvm/Support/ThreadPool.h"
 #include "llvm/Support/raw_ostream.h"
 #include <algorithm>
 #include <cstring>
@@ -31,6 +32,9 @@ using namespace clang;
 using namespace SrcMgr;
 using llvm::MemoryBuffer;
 
+static_assert(sizeof(SourceLocation::UIntTy) != 4 || sizeof(SLocEntry) == 16,
+              "SLocEntry should be as small as an offset and three locations");
+
 //===----------------------------------------------------------------------===//
 // SourceManager Helper Classes
 //===----------------------------------------------------------------------===//
@@ -96,7 +100,7 @@ llvm::MemoryBuffer *ContentCache::getBuffer(DiagnosticsEngine &Diag,
 
   bool isVolatile = SM.userFilesAreVolatile() && !IsSystemFile;
   auto BufferOrError =
-      SM.getFileManager().getBufferForFile(ContentsEntry, isVolatile);
+      SM.getFileManager().getSharedBufferForFile(ContentsEntry, isVolatile);
 
   // If we were unable to open the file, then we are in an inconsistent
   // situation where the content cache referenced a file which no longer
@@ -363,7 +367,7 @@ SourceManager::SourceManager(DiagnosticsEngine &Diag, FileManager &FileMgr,
   : Diag(Diag), FileMgr(FileMgr), OverridenFilesKeepOriginalName(true),
     UserFilesAreVolatile(UserFilesAreVolatile), FilesAreTransient(false),
     ExternalSLocEntries(nullptr), LineTable(nullptr), NumLinearScans(0),
-    NumBinaryProbes(0) {
+    NumBinaryProbes(0), NumLineTablesPrefetched(0) {
   clearIDTables();
   Diag.setSourceManager(this);
 }
@@ -371,6 +375,9 @@ SourceManager::SourceManager(DiagnosticsEngine &Diag, FileManager &FileMgr,
 SourceManager::~SourceManager() {
   delete LineTable;
 
+  // Let the line tables being prefetched finish before freeing their buffers.
+  LineTableThread.reset();
+
   // Delete FileEntry objects corresponding to content caches.  Since the actual
   // content cache objects are bump pointer allocated, we just have to run the
   // dtors, but we call the deallocate method for completeness.
@@ -394,8 +401,10 @@ SourceManager::~SourceManager() {
 void SourceManager::clearIDTables() {
   MainFileID = FileID();
   LocalSLocEntryTable.clear();
+  LocalSLocEntryOffsets.clear();
   LoadedSLocEntryTable.clear();
   SLocEntryLoaded.clear();
+  NumCreatedFIDs.clear();
   LastLineNoFileIDQuery = FileID();
   LastLineNoContentCache = nullptr;
   LastFileIDLookup = FileID();
@@ -476,9 +485,9 @@ const SrcMgr::SLocEntry &SourceManager::loadSLocEntry(unsigned Index,
   return LoadedSLocEntryTable[Index];
 }
 
-std::pair<int, unsigned>
+std::pair<int, SourceLocation::UIntTy>
 SourceManager::AllocateLoadedSLocEntries(unsigned NumSLocEntries,
-                                         unsigned TotalSize) {
+                                         SourceLocation::UIntTy TotalSize) {
   assert(ExternalSLocEntries && "Don't have an external sloc source");
   // Make sure we're not about to run out of source locations.
   if (CurrentLoadedOffset - TotalSize < NextLocalOffset)
@@ -559,7 +568,8 @@ FileID SourceManager::getNextFileID(FileID FID) const {
 FileID SourceManager::createFileID(const ContentCache *File,
                                    SourceLocation IncludePos,
                                    SrcMgr::CharacteristicKind FileCharacter,
-                                   int LoadedID, unsigned LoadedOffset) {
+                                   int LoadedID,
+                                   SourceLocation::UIntTy LoadedOffset) {
   if (LoadedID < 0) {
     assert(LoadedID != -1 && "Loading sentinel FileID");
     unsigned Index = unsigned(-LoadedID) - 2;
@@ -573,6 +583,7 @@ FileID SourceManager::createFileID(const ContentCache *File,
   LocalSLocEntryTable.push_back(SLocEntry::get(NextLocalOffset,
                                                FileInfo::get(IncludePos, File,
                                                              FileCharacter)));
+  LocalSLocEntryOffsets.push_back(NextLocalOffset);
   unsigned FileSize = File->getSize();
   assert(NextLocalOffset + FileSize + 1 > NextLocalOffset &&
          NextLocalOffset + FileSize + 1 <= CurrentLoadedOffset &&
@@ -602,7 +613,7 @@ SourceManager::createExpansionLoc(SourceLocation SpellingLoc,
                                   SourceLocation ExpansionLocEnd,
                                   unsigned TokLength,
                                   int LoadedID,
-                                  unsigned LoadedOffset) {
+                                  SourceLocation::UIntTy LoadedOffset) {
   ExpansionInfo Info = ExpansionInfo::create(SpellingLoc, ExpansionLocStart,
                                              ExpansionLocEnd);
   return createExpansionLocImpl(Info, TokLength, LoadedID, LoadedOffset);
@@ -612,7 +623,7 @@ SourceLocation
 SourceManager::createExpansionLocImpl(const ExpansionInfo &Info,
                                       unsigned TokLength,
                                       int LoadedID,
-                                      unsigned LoadedOffset) {
+                                      SourceLocation::UIntTy LoadedOffset) {
   if (LoadedID < 0) {
     assert(LoadedID != -1 && "Loading sentinel FileID");
     unsigned Index = unsigned(-LoadedID) - 2;
@@ -623,6 +634,7 @@ SourceManager::createExpansionLocImpl(const ExpansionInfo &Info,
     return SourceLocation::getMacroLoc(LoadedOffset);
   }
   LocalSLocEntryTable.push_back(SLocEntry::get(NextLocalOffset, Info));
+  LocalSLocEntryOffsets.push_back(NextLocalOffset);
   assert(NextLocalOffset + TokLength + 1 > NextLocalOffset &&
          NextLocalOffset + TokLength + 1 <= CurrentLoadedOffset &&
          "Ran out of source locations!");
@@ -644,6 +656,7 @@ void SourceManager::overrideFileContents(const FileEntry *SourceFile,
   const SrcMgr::ContentCache *IR = getOrCreateContentCache(SourceFile);
   assert(IR && "getOrCreateContentCache() cannot return NULL");
 
+  dropPrefetchedLineTable(IR);
   const_cast<SrcMgr::ContentCache *>(IR)->replaceBuffer(Buffer, DoNotFree);
   const_cast<SrcMgr::ContentCache *>(IR)->BufferOverridden = true;
 
@@ -666,6 +679,7 @@ void SourceManager::disableFileContentsOverride(const FileEntry *File) {
     return;
 
   const SrcMgr::ContentCache *IR = getOrCreateContentCache(File);
+  dropPrefetchedLineTable(IR);
   const_cast<SrcMgr::ContentCache *>(IR)->replaceBuffer(nullptr);
   const_cast<SrcMgr::ContentCache *>(IR)->ContentsEntry = IR->OrigEntry;
 
@@ -708,7 +722,7 @@ StringRef SourceManager::getBufferData(FileID FID, bool *Invalid) const {
 /// This is the cache-miss path of getFileID. Not as hot as that function, but
 /// still very important. It is responsible for finding the entry in the
 /// SLocEntry tables that contains the specified location.
-FileID SourceManager::getFileIDSlow(unsigned SLocOffset) const {
+FileID SourceManager::getFileIDSlow(SourceLocation::UIntTy SLocOffset) const {
   if (!SLocOffset)
     return FileID::get(0);
 
@@ -723,7 +737,7 @@ FileID SourceManager::getFileIDSlow(unsigned SLocOffset) const {
 ///
 /// This function knows that the SourceLocation is in a local buffer, not a
 /// loaded one.
-FileID SourceManager::getFileIDLocal(unsigned SLocOffset) const {
+FileID SourceManager::getFileIDLocal(SourceLocation::UIntTy SLocOffset) const {
   assert(SLocOffset < NextLocalOffset && "Bad function choice");
 
   // After the first and second level caches, I see two common sorts of
@@ -733,32 +747,34 @@ FileID SourceManager::getFileIDLocal(unsigned SLocOffset) const {
   //
   // To handle this, we do a linear search for up to 8 steps to catch #1 quickly
   // then we fall back to a less cache efficient, but more scalable, binary
-  // search to find the location.
+  // search to find the location.  Both only look at the dense array of entry
+  // offsets.
+  const SourceLocation::UIntTy *Offsets = LocalSLocEntryOffsets.data();
 
   // See if this is near the file point - worst case we start scanning from the
   // most newly created FileID.
-  const SrcMgr::SLocEntry *I;
+  unsigned GreaterIndex;
 
   if (LastFileIDLookup.ID < 0 ||
-      LocalSLocEntryTable[LastFileIDLookup.ID].getOffset() < SLocOffset) {
+      Offsets[LastFileIDLookup.ID] <= SLocOffset) {
     // Neither loc prunes our search.
-    I = LocalSLocEntryTable.end();
+    GreaterIndex = LocalSLocEntryOffsets.size();
   } else {
     // Perhaps it is near the file point.
-    I = LocalSLocEntryTable.begin()+LastFileIDLookup.ID;
+    GreaterIndex = LastFileIDLookup.ID;
   }
 
-  // Find the FileID that contains this.  "I" is an iterator that points to a
-  // FileID whose offset is known to be larger than SLocOffset.
+  // Find the FileID that contains this.  "GreaterIndex" is the index of an
+  // entry whose offset is known to be larger than SLocOffset.
   unsigned NumProbes = 0;
   while (1) {
-    --I;
-    if (I->getOffset() <= SLocOffset) {
-      FileID Res = FileID::get(int(I - LocalSLocEntryTable.begin()));
+    --GreaterIndex;
+    if (Offsets[GreaterIndex] <= SLocOffset) {
+      FileID Res = FileID::get(GreaterIndex);
 
       // If this isn't an expansion, remember it.  We have good locality across
       // FileID lookups.
-      if (!I->isExpansion())
+      if (!LocalSLocEntryTable[GreaterIndex].isExpansion())
         LastFileIDLookup = Res;
       NumLinearScans += NumProbes+1;
       return Res;
@@ -767,54 +783,40 @@ FileID SourceManager::getFileIDLocal(unsigned SLocOffset) const {
       break;
   }
 
-  // Convert "I" back into an index.  We know that it is an entry whose index is
-  // larger than the offset we are looking for.
-  unsigned GreaterIndex = I - LocalSLocEntryTable.begin();
   // LessIndex - This is the lower bound of the range that we're searching.
-  // We know that the offset corresponding to the FileID is is less than
-  // SLocOffset.
+  // The first entry starts at offset 0, so it is at or before SLocOffset.
+  // The entries are sorted by offset, so the one containing SLocOffset is
+  // the last one that starts at or before it.
   unsigned LessIndex = 0;
   NumProbes = 0;
-  while (1) {
-    bool Invalid = false;
+  while (GreaterIndex - LessIndex > 1) {
     unsigned MiddleIndex = (GreaterIndex-LessIndex)/2+LessIndex;
-    unsigned MidOffset = getLocalSLocEntry(MiddleIndex, &Invalid).getOffset();
-    if (Invalid)
-      return FileID::get(0);
-    
     ++NumProbes;
 
     // If the offset of the midpoint is too large, chop the high side of the
-    // range to the midpoint.
-    if (MidOffset > SLocOffset) {
+    // range to the midpoint.  Otherwise, move the low side up to it.
+    if (Offsets[MiddleIndex] > SLocOffset)
       GreaterIndex = MiddleIndex;
-      continue;
-    }
-
-    // If the middle index contains the value, succeed and return.
-    // FIXME: This could be made faster by using a function that's aware of
-    // being in the local area.
-    if (isOffsetInFileID(FileID::get(MiddleIndex), SLocOffset)) {
-      FileID Res = FileID::get(MiddleIndex);
+    else
+      LessIndex = MiddleIndex;
+  }
 
-      // If this isn't a macro expansion, remember it.  We have good locality
-      // across FileID lookups.
-      if (!LocalSLocEntryTable[MiddleIndex].isExpansion())
-        LastFileIDLookup = Res;
-      NumBinaryProbes += NumProbes;
-      return Res;
-    }
+  FileID Res = FileID::get(LessIndex);
 
-    // Otherwise, move the low-side up to the middle index.
-    LessIndex = MiddleIndex;
-  }
+  // If this isn't a macro expansion, remember it.  We have good locality
+  // across FileID lookups.
+  if (!LocalSLocEntryTable[LessIndex].isExpansion())
+    LastFileIDLookup = Res;
+  NumBinaryProbes += NumProbes;
+  return Res;
 }
 
 /// \brief Return the FileID for a SourceLocation with a high offset.
 ///
 /// This function knows that the SourceLocation is in a loaded buffer, not a
 /// local one.
-FileID SourceManager::getFileIDLoaded(unsigned SLocOffset) const {
+FileID
+SourceManager::getFileIDLoaded(SourceLocation::UIntTy SLocOffset) const {
   // Sanity checking, otherwise a bug may lead to hanging in release build.
   if (SLocOffset < CurrentLoadedOffset) {
     assert(0 && "Invalid SLocOffset or bad function choice");
@@ -1191,27 +1193,17 @@ unsigned SourceManager::getPresumedColumnNumber(SourceLocation Loc,
 #include <emmintrin.h>
 #endif
 
-static LLVM_ATTRIBUTE_NOINLINE void
-ComputeLineNumbers(DiagnosticsEngine &Diag, ContentCache *FI,
-                   llvm::BumpPtrAllocator &Alloc,
-                   const SourceManager &SM, bool &Invalid);
-static void ComputeLineNumbers(DiagnosticsEngine &Diag, ContentCache *FI,
-                               llvm::BumpPtrAllocator &Alloc,
-                               const SourceManager &SM, bool &Invalid) {
-  // Note that calling 'getBuffer()' may lazily page in the file.
-  MemoryBuffer *Buffer = FI->getBuffer(Diag, SM, SourceLocation(), &Invalid);
-  if (Invalid)
-    return;
-
-  // Find the file offsets of all of the *physical* source lines.  This does
-  // not look at trigraphs, escaped newlines, or anything else tricky.
-  SmallVector<unsigned, 256> LineOffsets;
-
+/// ComputeLineOffsets - Find the file offsets of all of the *physical* source
+/// lines of Buffer.  This does not look at trigraphs, escaped newlines, or
+/// anything else tricky.  It may run on another thread than the
+/// SourceManager's.
+static void ComputeLineOffsets(const MemoryBuffer &Buffer,
+                               SmallVectorImpl<unsigned> &LineOffsets) {
   // Line #1 starts at char 0.
   LineOffsets.push_back(0);
 
-  const unsigned char *Buf = (const unsigned char *)Buffer->getBufferStart();
-  const unsigned char *End = (const unsigned char *)Buffer->getBufferEnd();
+  const unsigned char *Buf = (const unsigned char *)Buffer.getBufferStart();
+  const unsigned char *End = (const unsigned char *)Buffer.getBufferEnd();
   unsigned Offs = 0;
   while (1) {
     // Skip over the contents of the line.
@@ -1273,13 +1265,85 @@ FoundSpecialChar:
       ++Buf;
     }
   }
+}
 
+static void SetLineOffsets(ContentCache *FI, ArrayRef<unsigned> LineOffsets,
+                           llvm::BumpPtrAllocator &Alloc) {
   // Copy the offsets into the FileInfo structure.
   FI->NumLines = LineOffsets.size();
   FI->SourceLineCache = Alloc.Allocate<unsigned>(LineOffsets.size());
   std::copy(LineOffsets.begin(), LineOffsets.end(), FI->SourceLineCache);
 }
 
+static LLVM_ATTRIBUTE_NOINLINE void
+ComputeLineNumbers(DiagnosticsEngine &Diag, ContentCache *FI,
+                   llvm::BumpPtrAllocator &Alloc,
+                   const SourceManager &SM, bool &Invalid);
+static void ComputeLineNumbers(DiagnosticsEngine &Diag, ContentCache *FI,
+                               llvm::BumpPtrAllocator &Alloc,
+                               const SourceManager &SM, bool &Invalid) {
+  // Note that calling 'getBuffer()' may lazily page in the file.
+  MemoryBuffer *Buffer = FI->getBuffer(Diag, SM, SourceLocation(), &Invalid);
+  if (Invalid)
+    return;
+
+  SmallVector<unsigned, 256> LineOffsets;
+  ComputeLineOffsets(*Buffer, LineOffsets);
+  SetLineOffsets(FI, LineOffsets, Alloc);
+}
+
+void SourceManager::computeLineTable(ContentCache *Content,
+                                     bool &Invalid) const {
+  auto Prefetched = PrefetchedLineTables.find(Content);
+  if (Prefetched == PrefetchedLineTables.end()) {
+    ComputeLineNumbers(Diag, Content, ContentCacheAlloc, *this, Invalid);
+    return;
+  }
+
+  Prefetched->second.Done.wait();
+  std::shared_ptr<SmallVector<unsigned, 0>> LineOffsets =
+      std::move(Prefetched->second.LineOffsets);
+  PrefetchedLineTables.erase(Prefetched);
+  SetLineOffsets(Content, *LineOffsets, ContentCacheAlloc);
+  Invalid = false;
+}
+
+void SourceManager::prefetchLineTable(FileID FID) {
+  bool Invalid = false;
+  const SLocEntry &Entry = getSLocEntry(FID, &Invalid);
+  if (Invalid || !Entry.isFile())
+    return;
+
+  const ContentCache *Content = Entry.getFile().getContentCache();
+  if (!Content || Content->SourceLineCache ||
+      PrefetchedLineTables.count(Content))
+    return;
+
+  // Load the buffer on this thread, as loading it may emit diagnostics.
+  const MemoryBuffer *Buffer =
+      Content->getBuffer(Diag, *this, SourceLocation(), &Invalid);
+  if (Invalid)
+    return;
+
+  if (!LineTableThread)
+    LineTableThread = llvm::make_unique<llvm::ThreadPool>(1);
+
+  auto LineOffsets = std::make_shared<SmallVector<unsigned, 0>>();
+  PrefetchedLineTable &Prefetched = PrefetchedLineTables[Content];
+  Prefetched.LineOffsets = LineOffsets;
+  Prefetched.Done = LineTableThread->async(
+      [Buffer, LineOffsets] { ComputeLineOffsets(*Buffer, *LineOffsets); });
+  ++NumLineTablesPrefetched;
+}
+
+void SourceManager::dropPrefetchedLineTable(const ContentCache *Content) {
+  auto Prefetched = PrefetchedLineTables.find(Content);
+  if (Prefetched == PrefetchedLineTables.end())
+    return;
+  Prefetched->second.Done.wait();
+  PrefetchedLineTables.erase(Prefetched);
+}
+
 /// getLineNumber - Given a SourceLocation, return the spelling line number
 /// for the position indicated.  This requires building and caching a table of
 /// line offsets for the MemoryBuffer, so this is not cheap: use only when
@@ -1311,7 +1375,7 @@ unsigned SourceManager::getLineNumber(FileID FID, unsigned FilePos,
   /// SourceLineCache for it on demand.
   if (!Content->SourceLineCache) {
     bool MyInvalid = false;
-    ComputeLineNumbers(Diag, Content, ContentCacheAlloc, *this, MyInvalid);
+    computeLineTable(Content, MyInvalid);
     if (Invalid)
       *Invalid = MyInvalid;
     if (MyInvalid)
@@ -1552,7 +1616,7 @@ unsigned SourceManager::getFileIDSize(FileID FID) const {
     return 0;
 
   int ID = FID.ID;
-  unsigned NextOffset;
+  SourceLocation::UIntTy NextOffset;
   if ((ID > 0 && unsigned(ID+1) == local_sloc_entry_size()))
     NextOffset = getNextLocalOffset();
   else if (ID+1 == -1)
@@ -1748,7 +1812,7 @@ SourceLocation SourceManager::translateLineCol(FileID FID,
   // SourceLineCache for it on demand.
   if (!Content->SourceLineCache) {
     bool MyInvalid = false;
-    ComputeLineNumbers(Diag, Content, ContentCacheAlloc, *this, MyInvalid);
+    computeLineTable(Content, MyInvalid);
     if (MyInvalid)
       return SourceLocation();
   }
@@ -1816,8 +1880,8 @@ void SourceManager::computeMacroArgsCache(MacroArgsMap *&CachePtr,
 
       // Skip the files/macros of the #include'd file, we only care about macros
       // that lexed macro arguments from our file.
-      if (Entry.getFile().NumCreatedFIDs)
-        ID += Entry.getFile().NumCreatedFIDs - 1/*because of next ++ID*/;
+      if (unsigned NumFIDs = NumCreatedFIDs.lookup(FileID::get(ID)))
+        ID += NumFIDs - 1/*because of next ++ID*/;
       continue;
     }
 
@@ -1845,8 +1909,8 @@ void SourceManager::associateFileChunkWithMacroArgExp(
                                          SourceLocation ExpansionLoc,
                                          unsigned ExpansionLength) const {
   if (!SpellLoc.isFileID()) {
-    unsigned SpellBeginOffs = SpellLoc.getOffset();
-    unsigned SpellEndOffs = SpellBeginOffs + ExpansionLength;
+    SourceLocation::UIntTy SpellBeginOffs = SpellLoc.getOffset();
+    SourceLocation::UIntTy SpellEndOffs = SpellBeginOffs + ExpansionLength;
 
     // The spelling range for this macro argument expansion can span multiple
     // consecutive FileID entries. Go through each entry contained in the
@@ -1858,9 +1922,9 @@ void SourceManager::associateFileChunkWithMacroArgExp(
     std::tie(SpellFID, SpellRelativeOffs) = getDecomposedLoc(SpellLoc);
     while (1) {
       const SLocEntry &Entry = getSLocEntry(SpellFID);
-      unsigned SpellFIDBeginOffs = Entry.getOffset();
+      SourceLocation::UIntTy SpellFIDBeginOffs = Entry.getOffset();
       unsigned SpellFIDSize = getFileIDSize(SpellFID);
-      unsigned SpellFIDEndOffs = SpellFIDBeginOffs + SpellFIDSize;
+      SourceLocation::UIntTy SpellFIDEndOffs = SpellFIDBeginOffs + SpellFIDSize;
       const ExpansionInfo &Info = Entry.getExpansion();
       if (Info.isMacroArgExpansion()) {
         unsigned CurrSpellLength;
@@ -2134,7 +2198,9 @@ void SourceManager::PrintStats() const {
                << " bytes of capacity), "
                << NextLocalOffset << "B of Sloc address space used.\n";
   llvm::errs() << LoadedSLocEntryTable.size()
-               << " loaded SLocEntries allocated, "
+               << " loaded SLocEntries allocated ("
+               << llvm::capacity_in_bytes(LoadedSLocEntryTable)
+               << " bytes of capacity), "
                << MaxLoadedOffset - CurrentLoadedOffset
                << "B of Sloc address space used.\n";
   
@@ -2149,6 +2215,8 @@ void SourceManager::PrintStats() const {
   llvm::errs() << NumFileBytesMapped << " bytes of files mapped, "
                << NumLineNumsComputed << " files with line #'s computed, "
                << NumMacroArgsComputed << " files with macro args computed.\n";
+  llvm::errs() << NumLineTablesPrefetched
+               << " line tables computed on another thread.\n";
   llvm::errs() << "FileID scans: " << NumLinearScans << " linear, "
                << NumBinaryProbes << " binary.\n";
 }
@@ -2166,9 +2234,8 @@ LLVM_DUMP_METHOD void SourceManager::dump() const {
       out << "???\?>\n";
     if (Entry.isFile()) {
       auto &FI = Entry.getFile();
-      if (FI.NumCreatedFIDs)
-        out << "  covers <FileID " << ID << ":" << int(ID + FI.NumCreatedFIDs)
-            << ">\n";
+      if (unsigned NumFIDs = NumCreatedFIDs.lookup(FileID::get(ID)))
+        out << "  covers <FileID " << ID << ":" << int(ID + NumFIDs) << ">\n";
       if (FI.getIncludeLoc().isValid())
         out << "  included from " << FI.getIncludeLoc().getOffset() << "\n";
       if (auto *CC = FI.getContentCache()) {
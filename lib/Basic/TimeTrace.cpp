@@ -0,0 +1,140 @@
+//===--- TimeTrace.cpp - Hierarchical trace of compilation phases ---------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+//  This file implements the TimeTraceProfiler class.
+//
+//===----------------------------------------------------------------------===//
+
+#include "clang/Basic/TimeTrace.h"
+#include "llvm/Support/Compiler.h"
+#include "llvm/Support/Format.h"
+#include "llvm/Support/raw_ostream.h"
+#include <algorithm>
+using namespace clang;
+
+static LLVM_THREAD_LOCAL TimeTraceProfiler *CurrentProfiler = nullptr;
+
+template <typename Duration> static int64_t toMicroseconds(Duration D) {
+  return std::chrono::duration_cast<std::chrono::microseconds>(D).count();
+}
+
+static void writeString(raw_ostream &OS, StringRef Str) {
+  OS << '"';
+  for (char C : Str) {
+    if (C == '"' || C == '\\')
+      OS << '\\' << C;
+    else if (static_cast<unsigned char>(C) < 0x20)
+      OS << llvm::format("\\u%04x", static_cast<unsigned>(C));
+    else
+      OS << C;
+  }
+  OS << '"';
+}
+
+TimeTraceProfiler::TimeTraceProfiler()
+    : OuterProfiler(CurrentProfiler), StartTime(Clock::now()) {
+  CurrentProfiler = this;
+}
+
+TimeTraceProfiler::~TimeTraceProfiler() { CurrentProfiler = OuterProfiler; }
+
+TimeTraceProfiler *TimeTraceProfiler::get() { return CurrentProfiler; }
+
+void TimeTraceProfiler::setMemoryCounter(StringRef Name,
+                                         std::function<size_t()> Counter) {
+  MemoryCounterName = Name.str();
+  MemoryCounter = std::move(Counter);
+}
+
+unsigned TimeTraceProfiler::begin(StringRef Name, StringRef Detail) {
+  Event E;
+  E.Name = Name;
+  E.Detail = Detail;
+  E.Start = Clock::now();
+  E.Duration = Clock::duration::zero();
+  E.Memory = MemoryCounter ? MemoryCounter() : 0;
+  Stack.push_back(std::move(E));
+  return Stack.size() - 1;
+}
+
+void TimeTraceProfiler::end(unsigned Depth) {
+  if (Depth >= Stack.size())
+    return;
+
+  Clock::time_point Now = Clock::now();
+  size_t Memory = MemoryCounter ? MemoryCounter() : 0;
+  while (Stack.size() > Depth) {
+    Event E = std::move(Stack.back());
+    Stack.pop_back();
+    E.Duration = Now - E.Start;
+    // The counter may have been reset during the event, e.g. by the
+    // ASTContext it counts being replaced.
+    E.Memory = Memory > E.Memory ? Memory - E.Memory : 0;
+
+    auto &Total = Totals[E.Name];
+    ++Total.first;
+    if (std::none_of(Stack.begin(), Stack.end(),
+                     [&](const Event &Outer) { return Outer.Name == E.Name; }))
+      Total.second += E.Duration;
+    Events.push_back(std::move(E));
+  }
+}
+
+void TimeTraceProfiler::write(raw_ostream &OS) {
+  end(0);
+
+  OS << "{\"traceEvents\":[\n";
+  for (const Event &E : Events) {
+    OS << "{\"pid\":1,\"tid\":0,\"ph\":\"X\",\"ts\":"
+       << toMicroseconds(E.Start - StartTime)
+       << ",\"dur\":" << toMicroseconds(E.Duration) << ",\"name\":";
+    writeString(OS, E.Name);
+    if (!E.Detail.empty() || MemoryCounter) {
+      OS << ",\"args\":{";
+      if (!E.Detail.empty()) {
+        OS << "\"detail\":";
+        writeString(OS, E.Detail);
+        if (MemoryCounter)
+          OS << ',';
+      }
+      if (MemoryCounter) {
+        writeString(OS, MemoryCounterName);
+        OS << ':' << E.Memory;
+      }
+      OS << '}';
+    }
+    OS << "},\n";
+  }
+
+  // Lay the totals end to end in a second row, longest first.
+  std::vector<std::pair<StringRef, std::pair<unsigned, Clock::duration>>>
+      SortedTotals;
+  for (const auto &Total : Totals)
+    SortedTotals.push_back(std::make_pair(Total.getKey(), Total.getValue()));
+  std::sort(SortedTotals.begin(), SortedTotals.end(),
+            [](const decltype(SortedTotals)::value_type &A,
+               const decltype(SortedTotals)::value_type &B) {
+              return A.second.second > B.second.second;
+            });
+  int64_t Start = 0;
+  for (const auto &Total : SortedTotals) {
+    int64_t Duration = toMicroseconds(Total.second.second);
+    OS << "{\"pid\":1,\"tid\":1,\"ph\":\"X\",\"ts\":" << Start
+       << ",\"dur\":" << Duration << ",\"name\":";
+    writeString(OS, ("Total " + Total.first).str());
+    OS << ",\"args\":{\"count\":" << Total.second.first << "}},\n";
+    Start += Duration;
+  }
+
+  OS << "{\"pid\":1,\"tid\":0,\"ph\":\"M\",\"name\":\"thread_name\","
+        "\"args\":{\"name\":\"clang\"}},\n"
+     << "{\"pid\":1,\"tid\":1,\"ph\":\"M\",\"name\":\"thread_name\","
+        "\"args\":{\"name\":\"totals\"}}\n"
+     << "]}\n";
+}
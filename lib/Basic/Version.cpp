@@ -112,6 +112,11 @@ std::string getClangFullRepositoryVersion() {
       OS << LLVMRepo << ' ';
     OS << LLVMRev << ')';
   }
+#ifdef CLANG_ENABLE_64_BIT_SOURCE_LOCATIONS
+  // AST files and module caches are only compatible between builds with the
+  // same source location width.
+  OS << " (64-bit source locations)";
+#endif
   return OS.str();
 }
 
@@ -184,33 +184,73 @@ std::error_code RealFile::close() {
 
 namespace {
 /// \brief The file system according to your operating system.
+///
+/// If \c LinkCWDToProcess is false, the file system keeps a private working
+/// directory that relative paths are resolved against, instead of using (and
+/// changing) the working directory of the process.
 class RealFileSystem : public FileSystem {
 public:
+  explicit RealFileSystem(bool LinkCWDToProcess);
+
   ErrorOr<Status> status(const Twine &Path) override;
   ErrorOr<std::unique_ptr<File>> openFileForRead(const Twine &Path) override;
   directory_iterator dir_begin(const Twine &Dir, std::error_code &EC) override;
 
   llvm::ErrorOr<std::string> getCurrentWorkingDirectory() const override;
   std::error_code setCurrentWorkingDirectory(const Twine &Path) override;
+
+private:
+  /// \brief Resolves \p Path against the private working directory, if any.
+  StringRef adjustPath(const Twine &Path, SmallVectorImpl<char> &Storage) const;
+
+  bool LinkCWDToProcess;
+  /// \brief The private working directory, if not linked to the process.
+  std::string WD;
 };
 } // end anonymous namespace
 
+RealFileSystem::RealFileSystem(bool LinkCWDToProcess)
+    : LinkCWDToProcess(LinkCWDToProcess) {
+  if (LinkCWDToProcess)
+    return;
+  SmallString<256> Dir;
+  if (!llvm::sys::fs::current_path(Dir))
+    WD = Dir.str();
+}
+
+StringRef RealFileSystem::adjustPath(const Twine &Path,
+                                     SmallVectorImpl<char> &Storage) const {
+  StringRef P = Path.toStringRef(Storage);
+  if (LinkCWDToProcess || llvm::sys::path::is_absolute(P))
+    return P;
+  SmallString<256> Absolute(WD);
+  llvm::sys::path::append(Absolute, P);
+  Storage.assign(Absolute.begin(), Absolute.end());
+  return StringRef(Storage.data(), Storage.size());
+}
+
 ErrorOr<Status> RealFileSystem::status(const Twine &Path) {
+  SmallString<256> Storage;
   sys::fs::file_status RealStatus;
-  if (std::error_code EC = sys::fs::status(Path, RealStatus))
+  if (std::error_code EC =
+          sys::fs::status(adjustPath(Path, Storage), RealStatus))
     return EC;
   return Status::copyWithNewName(RealStatus, Path.str());
 }
 
 ErrorOr<std::unique_ptr<File>>
 RealFileSystem::openFileForRead(const Twine &Name) {
+  SmallString<256> Storage;
   int FD;
-  if (std::error_code EC = sys::fs::openFileForRead(Name, FD))
+  if (std::error_code EC =
+          sys::fs::openFileForRead(adjustPath(Name, Storage), FD))
     return EC;
   return std::unique_ptr<File>(new RealFile(FD, Name.str()));
 }
 
 llvm::ErrorOr<std::string> RealFileSystem::getCurrentWorkingDirectory() const {
+  if (!LinkCWDToProcess)
+    return WD;
   SmallString<256> Dir;
   if (std::error_code EC = llvm::sys::fs::current_path(Dir))
     return EC;
@@ -218,6 +258,18 @@ llvm::ErrorOr<std::string> RealFileSystem::getCurrentWorkingDirectory() const {
 }
 
 std::error_code RealFileSystem::setCurrentWorkingDirectory(const Twine &Path) {
+  if (!LinkCWDToProcess) {
+    SmallString<256> Storage;
+    StringRef Dir = adjustPath(Path, Storage);
+    bool IsDirectory;
+    if (std::error_code EC = llvm::sys::fs::is_directory(Dir, IsDirectory))
+      return EC;
+    if (!IsDirectory)
+      return make_error_code(llvm::errc::not_a_directory);
+    WD = Dir.str();
+    return std::error_code();
+  }
+
   // FIXME: chdir is thread hostile; on the other hand, creating the same
   // behavior as chdir is complex: chdir resolves the path once, thus
   // guaranteeing that all subsequent relative path operations work
@@ -225,6 +277,8 @@ std::error_code RealFileSystem::setCurrentWorkingDirectory(const Twine &Path) {
   // difference for example on network filesystems, where symlinks might be
   // switched during runtime of the tool. Fixing this depends on having a
   // file system abstraction that allows openat() style interactions.
+  // Clients that need a thread-safe working directory should use
+  // createPhysicalFileSystem() instead.
   SmallString<256> Storage;
   StringRef Dir = Path.toNullTerminatedStringRef(Storage);
   if (int Err = ::chdir(Dir.data()))
@@ -233,10 +287,15 @@ std::error_code RealFileSystem::setCurrentWorkingDirectory(const Twine &Path) {
 }
 
 IntrusiveRefCntPtr<FileSystem> vfs::getRealFileSystem() {
-  static IntrusiveRefCntPtr<FileSystem> FS = new RealFileSystem();
+  static IntrusiveRefCntPtr<FileSystem> FS =
+      new RealFileSystem(/*LinkCWDToProcess=*/true);
   return FS;
 }
 
+IntrusiveRefCntPtr<FileSystem> vfs::createPhysicalFileSystem() {
+  return new RealFileSystem(/*LinkCWDToProcess=*/false);
+}
+
 namespace {
 class RealFSDirIter : public clang::vfs::detail::DirIterImpl {
   std::string Path;
@@ -271,7 +330,9 @@ public:
 
 directory_iterator RealFileSystem::dir_begin(const Twine &Dir,
                                              std::error_code &EC) {
-  return directory_iterator(std::make_shared<RealFSDirIter>(Dir, EC));
+  SmallString<256> Storage;
+  return directory_iterator(
+      std::make_shared<RealFSDirIter>(adjustPath(Dir, Storage), EC));
 }
 
 //===-----------------------------------------------------------------------===/
@@ -685,6 +746,157 @@ std::error_code InMemoryFileSystem::setCurrentWorkingDirectory(const Twine &P) {
 }
 }
 
+//===-----------------------------------------------------------------------===/
+// CachingFileSystem implementation
+//===-----------------------------------------------------------------------===/
+
+SharedFileSystemCache::SharedFileSystemCache()
+    : NumStatHits(0), NumStatMisses(0), NumBufferHits(0), NumBytesCached(0) {}
+
+SharedFileSystemCache::~SharedFileSystemCache() {}
+
+void SharedFileSystemCache::clear() {
+  llvm::sys::ScopedLock Guard(Lock);
+  Entries.clear();
+  NumBytesCached = 0;
+}
+
+void SharedFileSystemCache::PrintStats(raw_ostream &OS) const {
+  llvm::sys::ScopedLock Guard(Lock);
+  OS << "\n*** Shared File System Cache Stats:\n";
+  OS << Entries.size() << " paths cached, " << NumStatHits << " stat hits, "
+     << NumStatMisses << " stat misses.\n";
+  OS << NumBufferHits << " opens served from " << NumBytesCached
+     << " bytes of cached file contents.\n";
+}
+
+namespace {
+/// \brief A file whose contents are owned by a SharedFileSystemCache.
+class CachedFile : public File {
+  Status S;
+  const llvm::MemoryBuffer &Buffer;
+
+public:
+  CachedFile(Status S, const llvm::MemoryBuffer &Buffer)
+      : S(std::move(S)), Buffer(Buffer) {}
+
+  llvm::ErrorOr<Status> status() override { return S; }
+  llvm::ErrorOr<std::unique_ptr<llvm::MemoryBuffer>>
+  getBuffer(const Twine &Name, int64_t FileSize, bool RequiresNullTerminator,
+            bool IsVolatile) override {
+    return llvm::MemoryBuffer::getMemBuffer(Buffer.getBuffer(), Name.str(),
+                                            RequiresNullTerminator);
+  }
+  std::error_code close() override { return std::error_code(); }
+};
+} // end anonymous namespace
+
+CachingFileSystem::CachingFileSystem(
+    IntrusiveRefCntPtr<SharedFileSystemCache> Cache,
+    IntrusiveRefCntPtr<FileSystem> ExternalFS)
+    : Cache(std::move(Cache)), ExternalFS(std::move(ExternalFS)) {}
+
+ErrorOr<Status> CachingFileSystem::status(const Twine &Path) {
+  SmallString<256> AbsPath;
+  Path.toVector(AbsPath);
+  if (ExternalFS->makeAbsolute(AbsPath))
+    return ExternalFS->status(Path);
+
+  {
+    llvm::sys::ScopedLock Guard(Cache->Lock);
+    auto I = Cache->Entries.find(AbsPath);
+    if (I != Cache->Entries.end() && I->second.HasStat) {
+      ++Cache->NumStatHits;
+      if (I->second.StatError)
+        return I->second.StatError;
+      return Status::copyWithNewName(I->second.Stat, Path.str());
+    }
+  }
+
+  ErrorOr<Status> Result = ExternalFS->status(AbsPath);
+  // Only remember definite answers; transient errors are retried.
+  if (!Result && Result.getError() != llvm::errc::no_such_file_or_directory)
+    return Result;
+
+  llvm::sys::ScopedLock Guard(Cache->Lock);
+  ++Cache->NumStatMisses;
+  SharedFileSystemCache::Entry &E = Cache->Entries[AbsPath];
+  if (!E.HasStat) {
+    E.HasStat = true;
+    if (Result)
+      E.Stat = *Result;
+    else
+      E.StatError = Result.getError();
+  }
+  if (!Result)
+    return Result.getError();
+  return Status::copyWithNewName(*Result, Path.str());
+}
+
+ErrorOr<std::unique_ptr<File>>
+CachingFileSystem::openFileForRead(const Twine &Path) {
+  SmallString<256> AbsPath;
+  Path.toVector(AbsPath);
+  if (ExternalFS->makeAbsolute(AbsPath))
+    return ExternalFS->openFileForRead(Path);
+
+  {
+    llvm::sys::ScopedLock Guard(Cache->Lock);
+    SharedFileSystemCache::Entry &E = Cache->Entries[AbsPath];
+    if (E.HasStat && E.StatError)
+      return E.StatError;
+    if (E.Buffer) {
+      ++Cache->NumBufferHits;
+      return std::unique_ptr<File>(new CachedFile(
+          Status::copyWithNewName(E.Stat, Path.str()), *E.Buffer));
+    }
+    // Files that are only ever opened once (typically main files) are not
+    // worth keeping in memory.
+    if (++E.NumOpens < 2)
+      return ExternalFS->openFileForRead(Path);
+  }
+
+  auto F = ExternalFS->openFileForRead(AbsPath);
+  if (!F)
+    return F;
+  ErrorOr<Status> S = (*F)->status();
+  if (!S || !S->isRegularFile())
+    return ExternalFS->openFileForRead(Path);
+  auto Buffer = (*F)->getBuffer(AbsPath, S->getSize(),
+                                /*RequiresNullTerminator=*/true,
+                                /*IsVolatile=*/false);
+  if (!Buffer)
+    return Buffer.getError();
+
+  llvm::sys::ScopedLock Guard(Cache->Lock);
+  SharedFileSystemCache::Entry &E = Cache->Entries[AbsPath];
+  // Another thread may have filled the entry while the file was read.
+  if (!E.Buffer) {
+    Cache->NumBytesCached += (*Buffer)->getBufferSize();
+    E.Buffer = std::move(*Buffer);
+    E.Stat = *S;
+    E.StatError = std::error_code();
+    E.HasStat = true;
+  }
+  return std::unique_ptr<File>(new CachedFile(
+      Status::copyWithNewName(E.Stat, Path.str()), *E.Buffer));
+}
+
+directory_iterator CachingFileSystem::dir_begin(const Twine &Dir,
+                                                std::error_code &EC) {
+  return ExternalFS->dir_begin(Dir, EC);
+}
+
+llvm::ErrorOr<std::string>
+CachingFileSystem::getCurrentWorkingDirectory() const {
+  return ExternalFS->getCurrentWorkingDirectory();
+}
+
+std::error_code
+CachingFileSystem::setCurrentWorkingDirectory(const Twine &Path) {
+  return ExternalFS->setCurrentWorkingDirectory(Path);
+}
+
 //===-----------------------------------------------------------------------===/
 // RedirectingFileSystem implementation
 //===-----------------------------------------------------------------------===/
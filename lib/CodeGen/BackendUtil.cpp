@@ -11,6 +11,7 @@
 #include "clang/Basic/Diagnostic.h"
 #include "clang/Basic/LangOptions.h"
 #include "clang/Basic/TargetOptions.h"
+#include "clang/Basic/TimeTrace.h"
 #include "clang/Frontend/CodeGenOptions.h"
 #include "clang/Frontend/FrontendDiagnostic.h"
 #include "clang/Frontend/Utils.h"
@@ -715,6 +716,7 @@ void EmitAssemblyHelper::EmitAssembly(BackendAction Action,
 
   if (PerFunctionPasses) {
     PrettyStackTraceString CrashInfo("Per-function optimization");
+    TimeTraceScope TimeScope("PerFunctionPasses");
 
     PerFunctionPasses->doInitialization();
     for (Function &F : *TheModule)
@@ -725,11 +727,13 @@ void EmitAssemblyHelper::EmitAssembly(BackendAction Action,
 
   if (PerModulePasses) {
     PrettyStackTraceString CrashInfo("Per-module optimization passes");
+    TimeTraceScope TimeScope("PerModulePasses");
     PerModulePasses->run(*TheModule);
   }
 
   if (CodeGenPasses) {
     PrettyStackTraceString CrashInfo("Code generation");
+    TimeTraceScope TimeScope("CodeGenPasses");
     CodeGenPasses->run(*TheModule);
   }
 }
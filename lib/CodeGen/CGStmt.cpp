@@ -1714,6 +1714,22 @@ llvm::Value* CodeGenFunction::EmitAsmInput(
                             InputExpr->getExprLoc());
 }
 
+/// Returns the cookie identifying \p Loc in the !srcloc metadata of an inline
+/// asm call. Cookies are only 32 bits wide, so a 64-bit source location which
+/// doesn't fit is replaced by the file location it was expanded at, or else by
+/// an invalid location.
+static llvm::Constant *getAsmSrcLocCookie(SourceLocation Loc,
+                                          CodeGenFunction &CGF) {
+  SourceLocation::UIntTy Raw = Loc.getRawEncoding();
+  if (static_cast<uint32_t>(Raw) != Raw) {
+    const SourceManager &SM = CGF.CGM.getContext().getSourceManager();
+    Raw = SM.getFileLoc(Loc).getRawEncoding();
+    if (static_cast<uint32_t>(Raw) != Raw)
+      Raw = 0;
+  }
+  return llvm::ConstantInt::get(CGF.Int32Ty, Raw);
+}
+
 /// getAsmSrcLocInfo - Return the !srcloc metadata node to attach to an inline
 /// asm call instruction.  The !srcloc MDNode contains a list of constant
 /// integers which are the source locations of the start of each line in the
@@ -1722,8 +1738,8 @@ static llvm::MDNode *getAsmSrcLocInfo(const StringLiteral *Str,
                                       CodeGenFunction &CGF) {
   SmallVector<llvm::Metadata *, 8> Locs;
   // Add the location of the first line to the MDNode.
-  Locs.push_back(llvm::ConstantAsMetadata::get(llvm::ConstantInt::get(
-      CGF.Int32Ty, Str->getLocStart().getRawEncoding())));
+  Locs.push_back(llvm::ConstantAsMetadata::get(
+      getAsmSrcLocCookie(Str->getLocStart(), CGF)));
   StringRef StrVal = Str->getString();
   if (!StrVal.empty()) {
     const SourceManager &SM = CGF.CGM.getContext().getSourceManager();
@@ -1738,7 +1754,7 @@ static llvm::MDNode *getAsmSrcLocInfo(const StringLiteral *Str,
       SourceLocation LineLoc = Str->getLocationOfByte(
           i + 1, SM, LangOpts, CGF.getTarget(), &StartToken, &ByteOffset);
       Locs.push_back(llvm::ConstantAsMetadata::get(
-          llvm::ConstantInt::get(CGF.Int32Ty, LineLoc.getRawEncoding())));
+          getAsmSrcLocCookie(LineLoc, CGF)));
     }
   }
 
@@ -2039,7 +2055,7 @@ void CodeGenFunction::EmitAsmStmt(const AsmStmt &S) {
                                                    *this));
   } else {
     // At least put the line number on MS inline asm blobs.
-    auto Loc = llvm::ConstantInt::get(Int32Ty, S.getAsmLoc().getRawEncoding());
+    auto Loc = getAsmSrcLocCookie(S.getAsmLoc(), *this);
     Result->setMetadata("srcloc",
                         llvm::MDNode::get(getLLVMContext(),
                                           llvm::ConstantAsMetadata::get(Loc)));
@@ -14,9 +14,14 @@
 #include "clang/Driver/Options.h"
 #include "clang/Driver/ToolChain.h"
 #include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/SmallPtrSet.h"
 #include "llvm/Option/ArgList.h"
 #include "llvm/Support/FileSystem.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/ThreadPool.h"
 #include "llvm/Support/raw_ostream.h"
+#include <condition_variable>
+#include <mutex>
 
 using namespace clang::driver;
 using namespace clang;
@@ -27,7 +32,7 @@ Compilation::Compilation(const Driver &D, const ToolChain &_DefaultToolChain,
     : TheDriver(D), DefaultToolChain(_DefaultToolChain),
       CudaHostToolChain(&DefaultToolChain), CudaDeviceToolChain(nullptr),
       Args(_Args), TranslatedArgs(_TranslatedArgs), Redirects(nullptr),
-      ForDiagnostics(false) {}
+      ForDiagnostics(false), NumParallelJobs(1) {}
 
 Compilation::~Compilation() {
   delete TranslatedArgs;
@@ -118,8 +123,7 @@ bool Compilation::CleanupFileMap(const ArgStringMap &Files,
   return Success;
 }
 
-int Compilation::ExecuteCommand(const Command &C,
-                                const Command *&FailingCommand) const {
+bool Compilation::PrintCommand(const Command &C) const {
   if ((getDriver().CCPrintOptions ||
        getArgs().hasArg(options::OPT_v)) && !getDriver().CCGenDiagnostics) {
     raw_ostream *OS = &llvm::errs();
@@ -134,9 +138,8 @@ int Compilation::ExecuteCommand(const Command &C,
       if (EC) {
         getDriver().Diag(clang::diag::err_drv_cc_print_options_failure)
             << EC.message();
-        FailingCommand = &C;
         delete OS;
-        return 1;
+        return false;
       }
     }
 
@@ -148,6 +151,15 @@ int Compilation::ExecuteCommand(const Command &C,
     if (OS != &llvm::errs())
       delete OS;
   }
+  return true;
+}
+
+int Compilation::ExecuteCommand(const Command &C,
+                                const Command *&FailingCommand) const {
+  if (!PrintCommand(C)) {
+    FailingCommand = &C;
+    return 1;
+  }
 
   std::string Error;
   bool ExecutionFailed;
@@ -166,6 +178,10 @@ int Compilation::ExecuteCommand(const Command &C,
 void Compilation::ExecuteJobs(
     const JobList &Jobs,
     SmallVectorImpl<std::pair<int, const Command *>> &FailingCommands) const {
+  // Redirected compilations (e.g. for crash diagnostics) stay sequential.
+  if (NumParallelJobs > 1 && Jobs.size() > 1 && !Redirects)
+    return ExecuteJobsInParallel(Jobs, FailingCommands);
+
   for (const auto &Job : Jobs) {
     const Command *FailingCommand = nullptr;
     if (int Res = ExecuteCommand(Job, FailingCommand)) {
@@ -177,6 +193,145 @@ void Compilation::ExecuteJobs(
   }
 }
 
+/// Collect \p A and all actions it (transitively) consumes.
+static void collectInputActions(const Action *A,
+                                llvm::SmallPtrSetImpl<const Action *> &Seen) {
+  if (!Seen.insert(A).second)
+    return;
+  for (const Action *Input : A->getInputs())
+    collectInputActions(Input, Seen);
+}
+
+namespace {
+/// The state of a single command executed by ExecuteJobsInParallel.
+struct ParallelJob {
+  enum JobStatus { Pending, Running, Finished, Skipped };
+
+  const Command *Cmd;
+  /// Indices of earlier jobs that produce inputs of this one.
+  SmallVector<unsigned, 4> Deps;
+  JobStatus Status;
+  int Res;
+  bool ExecutionFailed;
+  std::string Error;
+  /// Files capturing the job's stdout and stderr.
+  SmallString<128> OutputFile, ErrorFile;
+
+  ParallelJob(const Command *Cmd)
+      : Cmd(Cmd), Status(Pending), Res(0), ExecutionFailed(false) {}
+};
+} // end anonymous namespace
+
+/// Append the contents of \p File to \p OS and remove it.
+static void replayOutput(StringRef File, raw_ostream &OS) {
+  if (File.empty())
+    return;
+  if (auto Buffer = llvm::MemoryBuffer::getFile(File))
+    OS << (*Buffer)->getBuffer();
+  OS.flush();
+  llvm::sys::fs::remove(File);
+}
+
+void Compilation::ExecuteJobsInParallel(
+    const JobList &Jobs,
+    SmallVectorImpl<std::pair<int, const Command *>> &FailingCommands) const {
+  // Jobs are created in dependency order, so a job can only depend on the
+  // jobs before it. A job depends on an earlier one if the earlier job's
+  // action is among the actions it consumes.
+  std::vector<ParallelJob> State;
+  for (const Command &Job : Jobs) {
+    llvm::SmallPtrSet<const Action *, 16> Inputs;
+    collectInputActions(&Job.getSource(), Inputs);
+    ParallelJob J(&Job);
+    for (unsigned I = 0, E = State.size(); I != E; ++I)
+      if (Inputs.count(&State[I].Cmd->getSource()))
+        J.Deps.push_back(I);
+    State.push_back(std::move(J));
+  }
+
+  std::mutex Lock;
+  std::condition_variable JobFinished;
+  llvm::ThreadPool Pool(NumParallelJobs);
+  unsigned NumRunning = 0, NextToReport = 0;
+  bool AnyFailed = false;
+
+  std::unique_lock<std::mutex> Guard(Lock);
+  while (NextToReport != State.size()) {
+    // Report finished jobs strictly in order, so that output and diagnostics
+    // appear as if the jobs had been executed one after the other.
+    while (NextToReport != State.size() &&
+           (State[NextToReport].Status == ParallelJob::Finished ||
+            State[NextToReport].Status == ParallelJob::Skipped)) {
+      ParallelJob &J = State[NextToReport++];
+      if (J.Status == ParallelJob::Skipped)
+        continue;
+      replayOutput(J.OutputFile, llvm::outs());
+      replayOutput(J.ErrorFile, llvm::errs());
+      if (!J.Error.empty()) {
+        assert(J.Res && "Error string set with 0 result code!");
+        getDriver().Diag(clang::diag::err_drv_command_failure) << J.Error;
+      }
+      if (J.Res)
+        FailingCommands.push_back(
+            std::make_pair(J.ExecutionFailed ? 1 : J.Res, J.Cmd));
+    }
+
+    // Start every job whose inputs are available. As in the sequential case,
+    // no new jobs are started once one of them has failed.
+    for (unsigned I = NextToReport, E = State.size();
+         I != E && NumRunning < NumParallelJobs; ++I) {
+      ParallelJob &J = State[I];
+      if (J.Status != ParallelJob::Pending)
+        continue;
+      if (AnyFailed) {
+        J.Status = ParallelJob::Skipped;
+        continue;
+      }
+      bool Ready = true;
+      for (unsigned Dep : J.Deps)
+        Ready &= State[Dep].Status == ParallelJob::Finished;
+      if (!Ready)
+        continue;
+
+      if (!PrintCommand(*J.Cmd)) {
+        J.Status = ParallelJob::Finished;
+        J.Res = 1;
+        AnyFailed = true;
+        continue;
+      }
+      llvm::sys::fs::createTemporaryFile("clang-job", "out", J.OutputFile);
+      llvm::sys::fs::createTemporaryFile("clang-job", "err", J.ErrorFile);
+      J.Status = ParallelJob::Running;
+      ++NumRunning;
+      Pool.async([&, I]() {
+        ParallelJob &Job = State[I];
+        StringRef Output = Job.OutputFile, Errors = Job.ErrorFile;
+        const StringRef *JobRedirects[] = {nullptr,
+                                           Output.empty() ? nullptr : &Output,
+                                           Errors.empty() ? nullptr : &Errors};
+        std::string Error;
+        bool ExecutionFailed;
+        int Res = Job.Cmd->Execute(JobRedirects, &Error, &ExecutionFailed);
+
+        std::lock_guard<std::mutex> JobGuard(Lock);
+        Job.Res = Res;
+        Job.ExecutionFailed = ExecutionFailed;
+        Job.Error = std::move(Error);
+        Job.Status = ParallelJob::Finished;
+        if (Res)
+          AnyFailed = true;
+        --NumRunning;
+        JobFinished.notify_one();
+      });
+    }
+
+    if (NumRunning)
+      JobFinished.wait(Guard);
+  }
+  Guard.unlock();
+  Pool.wait();
+}
+
 void Compilation::initCompilationForDiagnostics() {
   ForDiagnostics = true;
 
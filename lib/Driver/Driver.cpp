@@ -1773,6 +1773,18 @@ void Driver::BuildJobs(Compilation &C) const {
     }
   }
 
+  // Parse -parallel-jobs= here so that it is claimed before we warn about
+  // unused arguments below.
+  if (Arg *A = C.getArgs().getLastArg(options::OPT_parallel_jobs_EQ)) {
+    unsigned NumParallelJobs;
+    if (StringRef(A->getValue()).getAsInteger(10, NumParallelJobs) ||
+        NumParallelJobs == 0)
+      Diag(clang::diag::err_drv_invalid_int_value)
+          << A->getAsString(C.getArgs()) << A->getValue();
+    else
+      C.setNumParallelJobs(NumParallelJobs);
+  }
+
   // Collect the list of architectures.
   llvm::StringSet<> ArchNames;
   if (C.getDefaultToolChain().getTriple().isOSBinFormatMachO())
@@ -2272,9 +2284,8 @@ const char *Driver::GetNamedOutputPath(Compilation &C, const JobAction &JA,
   // then avoid overwriting input file.
   if (!AtTopLevel && isSaveTempsEnabled() && NamedOutput == BaseName) {
     bool SameFile = false;
-    SmallString<256> Result;
-    llvm::sys::fs::current_path(Result);
-    llvm::sys::path::append(Result, BaseName);
+    SmallString<256> Result(BaseName);
+    getVFS().makeAbsolute(Result);
     llvm::sys::fs::equivalent(BaseInput, Result.c_str(), SameFile);
     // Must share the same path to conflict.
     if (SameFile) {
@@ -18,6 +18,7 @@
 #include "clang/Basic/FileSystemStatCache.h"
 #include "clang/Basic/IdentifierTable.h"
 #include "clang/Basic/SourceManager.h"
+#include "clang/Lex/HeaderTokenCache.h"
 #include "clang/Lex/Lexer.h"
 #include "clang/Lex/PTHManager.h"
 #include "clang/Lex/Preprocessor.h"
@@ -62,20 +63,28 @@ class PTHEntryKeyVariant {
   union { const FileEntry* FE; const char* Path; };
   enum { IsFE = 0x1, IsDE = 0x2, IsNoExist = 0x0 } Kind;
   FileData *Data;
+  /// The name a file is looked up by, if not its path.
+  const char *Name;
 
 public:
-  PTHEntryKeyVariant(const FileEntry *fe) : FE(fe), Kind(IsFE), Data(nullptr) {}
+  PTHEntryKeyVariant(const FileEntry *fe)
+      : FE(fe), Kind(IsFE), Data(nullptr), Name(nullptr) {}
+
+  PTHEntryKeyVariant(const FileEntry *fe, const char *name)
+      : FE(fe), Kind(IsFE), Data(nullptr), Name(name) {}
 
   PTHEntryKeyVariant(FileData *Data, const char *path)
-      : Path(path), Kind(IsDE), Data(new FileData(*Data)) {}
+      : Path(path), Kind(IsDE), Data(new FileData(*Data)), Name(nullptr) {}
 
   explicit PTHEntryKeyVariant(const char *path)
-      : Path(path), Kind(IsNoExist), Data(nullptr) {}
+      : Path(path), Kind(IsNoExist), Data(nullptr), Name(nullptr) {}
 
   bool isFile() const { return Kind == IsFE; }
 
   StringRef getString() const {
-    return Kind == IsFE ? FE->getName() : Path;
+    if (Kind == IsFE)
+      return Name ? Name : FE->getName();
+    return Path;
   }
 
   unsigned getKind() const { return (unsigned) Kind; }
@@ -192,6 +201,11 @@ class PTHWriter {
   Offset CurStrOffset;
   std::vector<llvm::StringMapEntry<OffsetOpt>*> StrEntries;
 
+  /// Whether a file was lexed which can't be preprocessed faithfully from
+  /// its tokens: the text of #error and #warning directives isn't kept, and
+  /// token lengths are stored in 16 bits.
+  bool NeedsSourceText;
+
   //// Get the persistent id for the given IdentifierInfo*.
   uint32_t ResolveID(const IdentifierInfo* II);
 
@@ -236,12 +250,26 @@ class PTHWriter {
   PTHEntry LexTokens(Lexer& L);
   Offset EmitCachedSpellings();
 
+  /// EmitPrologue - Emits the prologue of the PTH file, leaving room for the
+  ///  offsets of the tables, and returns where these offsets go.
+  Offset EmitPrologue(StringRef MainFile);
+
+  /// EmitTables - Emits the tables of the PTH file, and their offsets in the
+  ///  prologue.
+  void EmitTables(Offset PrologueOffset);
+
 public:
   PTHWriter(raw_pwrite_stream &out, Preprocessor &pp)
-      : Out(out), PP(pp), idcount(0), CurStrOffset(0) {}
+      : Out(out), PP(pp), idcount(0), CurStrOffset(0),
+        NeedsSourceText(false) {}
 
   PTHMap &getPM() { return PM; }
   void GeneratePTH(StringRef MainFile);
+
+  /// GenerateHeaderPTH - Generates a PTH file for the header token cache,
+  ///  holding the tokens of \p FID under the name \p Key.  Returns false if
+  ///  the header can't be cached.
+  bool GenerateHeaderPTH(FileID FID, const char *Key);
 };
 } // end anonymous namespace
 
@@ -259,6 +287,9 @@ uint32_t PTHWriter::ResolveID(const IdentifierInfo* II) {
 }
 
 void PTHWriter::EmitToken(const Token& T) {
+  if (T.getLength() > 0xFFFF)
+    NeedsSourceText = true;
+
   // Emit the token kind, flags, and length.
   Emit32(((uint32_t) T.getKind()) | ((((uint32_t) T.getFlags())) << 8)|
          (((uint32_t) T.getLength()) << 16));
@@ -366,6 +397,11 @@ PTHEntry PTHWriter::LexTokens(Lexer& L) {
       default:
         break;
 
+      case tok::pp_error:
+      case tok::pp_warning:
+        NeedsSourceText = true;
+        break;
+
       case tok::pp_include:
       case tok::pp_import:
       case tok::pp_include_next: {
@@ -479,7 +515,7 @@ static void pwrite32le(raw_pwrite_stream &OS, uint32_t Val, uint64_t &Off) {
   Off += 4;
 }
 
-void PTHWriter::GeneratePTH(StringRef MainFile) {
+Offset PTHWriter::EmitPrologue(StringRef MainFile) {
   // Generate the prologue.
   Out << "cfe-pth" << '\0';
   Emit32(PTHManager::Version);
@@ -497,6 +533,11 @@ void PTHWriter::GeneratePTH(StringRef MainFile) {
     Emit16(0);
   }
   Emit8(0);
+  return PrologueOffset;
+}
+
+void PTHWriter::GeneratePTH(StringRef MainFile) {
+  Offset PrologueOffset = EmitPrologue(MainFile);
 
   // Iterate over all the files in SourceManager.  Create a lexer
   // for each file and cache the tokens.
@@ -521,6 +562,23 @@ void PTHWriter::GeneratePTH(StringRef MainFile) {
     PM.insert(FE, LexTokens(L));
   }
 
+  EmitTables(PrologueOffset);
+}
+
+bool PTHWriter::GenerateHeaderPTH(FileID FID, const char *Key) {
+  Offset PrologueOffset = EmitPrologue(StringRef());
+
+  // The tokens are lexed from the buffer the header token cache hashed, with
+  // their offsets relative to the start of the file.
+  SourceManager &SM = PP.getSourceManager();
+  Lexer L(FID, SM.getBuffer(FID), SM, PP.getLangOpts());
+  PM.insert(PTHEntryKeyVariant(SM.getFileEntryForID(FID), Key), LexTokens(L));
+
+  EmitTables(PrologueOffset);
+  return !NeedsSourceText;
+}
+
+void PTHWriter::EmitTables(Offset PrologueOffset) {
   // Write out the identifier table.
   const std::pair<Offset,Offset> &IdTableOff = EmitIdentifierTable();
 
@@ -598,6 +656,52 @@ void clang::CacheTokens(Preprocessor &PP, raw_pwrite_stream *OS) {
   PW.GeneratePTH(MainFilePath.str());
 }
 
+void clang::CacheHeaderTokens(Preprocessor &PP) {
+  HeaderTokenCache *Cache = PP.getHeaderTokenCache();
+  if (!Cache || Cache->getMissedFiles().empty())
+    return;
+
+  // The conditional directives of a header that was diagnosed may not be
+  // balanced, which LexTokens requires.
+  if (PP.getDiagnostics().hasErrorOccurred())
+    return;
+
+  if (llvm::sys::fs::create_directories(Cache->getDirectory()))
+    return;
+
+  for (const auto &Missed : Cache->getMissedFiles()) {
+    // The lexer diagnostics of the header, or of its skipped blocks, would be
+    // lost when replaying it.
+    if (Cache->isUncacheable(Missed.first))
+      continue;
+
+    // Another compilation may have cached the header since.
+    std::string Path = Cache->getPath(Missed.second);
+    if (llvm::sys::fs::exists(Path))
+      continue;
+
+    // Write the PTH file to a temporary file first, so that concurrent
+    // compilations never see a partially written one.
+    SmallString<128> TempPath;
+    int FD;
+    if (llvm::sys::fs::createUniqueFile(Path + "-%%%%%%%%", FD, TempPath))
+      continue;
+
+    bool Failed;
+    {
+      llvm::raw_fd_ostream OS(FD, /*shouldClose=*/true);
+      PTHWriter PW(OS, PP);
+      Failed = !PW.GenerateHeaderPTH(Missed.first, Missed.second.c_str());
+      OS.close();
+      Failed |= OS.has_error();
+      OS.clear_error();
+    }
+
+    if (Failed || llvm::sys::fs::rename(TempPath, Path))
+      llvm::sys::fs::remove(TempPath);
+  }
+}
+
 //===----------------------------------------------------------------------===//
 
 namespace {
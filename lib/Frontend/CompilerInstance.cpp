@@ -15,6 +15,7 @@
 #include "clang/Basic/FileManager.h"
 #include "clang/Basic/SourceManager.h"
 #include "clang/Basic/TargetInfo.h"
+#include "clang/Basic/TimeTrace.h"
 #include "clang/Basic/Version.h"
 #include "clang/Config/config.h"
 #include "clang/Frontend/ChainedDiagnosticConsumer.h"
@@ -27,10 +28,12 @@
 #include "clang/Frontend/Utils.h"
 #include "clang/Frontend/VerifyDiagnosticConsumer.h"
 #include "clang/Lex/HeaderSearch.h"
+#include "clang/Lex/HeaderTokenCache.h"
 #include "clang/Lex/PTHManager.h"
 #include "clang/Lex/Preprocessor.h"
 #include "clang/Sema/CodeCompleteConsumer.h"
 #include "clang/Sema/Sema.h"
+#include "clang/Sema/TemplateInstantiationProfiler.h"
 #include "clang/Serialization/ASTReader.h"
 #include "clang/Serialization/GlobalModuleIndex.h"
 #include "llvm/ADT/Statistic.h"
@@ -320,6 +323,12 @@ void CompilerInstance::createPreprocessor(TranslationUnitKind TUKind) {
     PP->setPTHManager(PTHMgr);
   }
 
+  // PTH can't be used with modules: a module has to be built from the
+  // sources of its headers.
+  if (!PPOpts.TokenCacheDir.empty() && !getLangOpts().Modules)
+    PP->setHeaderTokenCache(
+        llvm::make_unique<HeaderTokenCache>(*PP, PPOpts.TokenCacheDir));
+
   if (PPOpts.DetailedRecord)
     PP->createPreprocessingRecord();
 
@@ -349,6 +358,9 @@ void CompilerInstance::createPreprocessor(TranslationUnitKind TUKind) {
     AttachDependencyGraphGen(*PP, DepOpts.DOTOutputFile,
                              getHeaderSearchOpts().Sysroot);
 
+  if (!getFrontendOpts().TimeTracePath.empty())
+    AttachTimeTraceGen(*PP);
+
   // If we don't have a collector, but we are collecting module dependencies,
   // then we're the top level compiler instance and need to create one.
   if (!ModuleDepCollector && !DepOpts.ModuleDependencyOutputDir.empty()) {
@@ -535,6 +547,11 @@ void CompilerInstance::createSema(TranslationUnitKind TUKind,
                                   CodeCompleteConsumer *CompletionConsumer) {
   TheSema.reset(new Sema(getPreprocessor(), getASTContext(), getASTConsumer(),
                          TUKind, CompletionConsumer));
+
+  if (getFrontendOpts().PrintTemplateProfile ||
+      !getFrontendOpts().TemplateProfilePath.empty())
+    TheSema->TemplateProfiler.reset(
+        new TemplateInstantiationProfiler(getASTContext()));
 }
 
 // Output Files
@@ -863,7 +880,17 @@ bool CompilerInstance::ExecuteAction(FrontendAction &Act) {
   if (getFrontendOpts().ShowStats)
     llvm::EnableStatistics();
 
+  std::unique_ptr<TimeTraceProfiler> TimeTrace;
+  if (!getFrontendOpts().TimeTracePath.empty()) {
+    TimeTrace.reset(new TimeTraceProfiler());
+    TimeTrace->setMemoryCounter("ast_bytes", [this]() -> size_t {
+      return hasASTContext() ? getASTContext().getASTAllocatedBytes() : 0;
+    });
+  }
+
   for (const FrontendInputFile &FIF : getFrontendOpts().Inputs) {
+    TimeTraceScope TimeScope("Frontend", [&] { return FIF.getFile().str(); });
+
     // Reset the ID tables if we are reusing the SourceManager and parsing
     // regular files.
     if (hasSourceManager() && !Act.isModelParsingAction())
@@ -875,6 +902,17 @@ bool CompilerInstance::ExecuteAction(FrontendAction &Act) {
     }
   }
 
+  if (TimeTrace) {
+    const std::string &Path = getFrontendOpts().TimeTracePath;
+    std::error_code EC;
+    llvm::raw_fd_ostream OS(Path, EC, llvm::sys::fs::F_Text);
+    if (EC)
+      getDiagnostics().Report(diag::err_fe_unable_to_open_output)
+          << Path << EC.message();
+    else
+      TimeTrace->write(OS);
+  }
+
   // Notify the diagnostic client that all files were processed.
   getDiagnostics().getClient()->finish();
 
@@ -966,6 +1004,9 @@ static bool compileModuleImpl(CompilerInstance &ImportingInstance,
   FrontendOpts.DisableFree = false;
   FrontendOpts.GenerateGlobalModuleIndex = false;
   FrontendOpts.BuildingImplicitModule = true;
+  FrontendOpts.TimeTracePath.clear();
+  FrontendOpts.PrintTemplateProfile = false;
+  FrontendOpts.TemplateProfilePath.clear();
   FrontendOpts.Inputs.clear();
   InputKind IK = getSourceInputKindFromOptions(*Invocation->getLangOpts());
 
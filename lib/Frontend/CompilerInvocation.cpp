@@ -300,6 +300,22 @@ static bool ParseAnalyzerArgs(AnalyzerOptions &Opts, ArgList &Args,
     }
   }
 
+  // Every shard of a translation unit is analyzed by a different invocation,
+  // so a shard index past the last shard would silently analyze nothing.
+  unsigned ShardCount = 1, ShardIndex = 0;
+  auto ShardIndexIt = Opts.Config.find("shard-index");
+  if (ShardIndexIt != Opts.Config.end() &&
+      !StringRef(ShardIndexIt->getValue()).getAsInteger(10, ShardIndex)) {
+    auto ShardCountIt = Opts.Config.find("shard-count");
+    if (ShardCountIt != Opts.Config.end())
+      StringRef(ShardCountIt->getValue()).getAsInteger(10, ShardCount);
+    if (ShardIndex >= std::max(ShardCount, 1u)) {
+      Diags.Report(diag::err_analyzer_config_invalid_shard_index)
+          << ShardIndex << ShardCount;
+      Success = false;
+    }
+  }
+
   return Success;
 }
 
@@ -935,6 +951,7 @@ bool clang::ParseDiagnosticArgs(DiagnosticOptions &Opts, ArgList &Args,
 
 static void ParseFileSystemArgs(FileSystemOptions &Opts, ArgList &Args) {
   Opts.WorkingDir = Args.getLastArgValue(OPT_working_directory);
+  Opts.MapSharedFiles = Args.hasArg(OPT_map_shared_files);
 }
 
 /// Parse the argument to the -ftest-module-file-extension
@@ -1033,6 +1050,8 @@ static InputKind ParseFrontendArgs(FrontendOptions &Opts, ArgList &Args,
       Opts.ProgramAction = frontend::MigrateSource; break;
     case OPT_Eonly:
       Opts.ProgramAction = frontend::RunPreprocessorOnly; break;
+    case OPT_depscan:
+      Opts.ProgramAction = frontend::ScanDependencies; break;
     }
   }
 
@@ -1080,6 +1099,9 @@ static InputKind ParseFrontendArgs(FrontendOptions &Opts, ArgList &Args,
   Opts.ShowHelp = Args.hasArg(OPT_help);
   Opts.ShowStats = Args.hasArg(OPT_print_stats);
   Opts.ShowTimers = Args.hasArg(OPT_ftime_report);
+  Opts.TimeTracePath = Args.getLastArgValue(OPT_ftime_trace_EQ);
+  Opts.PrintTemplateProfile = Args.hasArg(OPT_print_template_profile);
+  Opts.TemplateProfilePath = Args.getLastArgValue(OPT_template_profile_json_EQ);
   Opts.ShowVersion = Args.hasArg(OPT_version);
   Opts.ASTMergeFiles = Args.getAllArgValues(OPT_ast_merge);
   Opts.LLVMArgs = Args.getAllArgValues(OPT_mllvm);
@@ -1255,6 +1277,7 @@ static void ParseHeaderSearchArgs(HeaderSearchOptions &Opts, ArgList &Args) {
   Opts.ModuleCachePath = Args.getLastArgValue(OPT_fmodules_cache_path);
   Opts.ModuleUserBuildPath = Args.getLastArgValue(OPT_fmodules_user_build_path);
   Opts.DisableModuleHash = Args.hasArg(OPT_fdisable_module_hash);
+  Opts.HeaderGuardCachePath = Args.getLastArgValue(OPT_header_guard_cache);
   Opts.ImplicitModuleMaps = Args.hasArg(OPT_fimplicit_module_maps);
   Opts.ModuleMapFileHomeIsCwd = Args.hasArg(OPT_fmodule_map_file_home_is_cwd);
   Opts.ModuleCachePruneInterval =
@@ -1740,6 +1763,8 @@ static void ParseLangArgs(LangOptions &Opts, ArgList &Args, InputKind IK,
       getLastArgIntValue(Args, OPT_fconstexpr_depth, 512, Diags);
   Opts.ConstexprStepLimit =
       getLastArgIntValue(Args, OPT_fconstexpr_steps, 1048576, Diags);
+  Opts.ConstexprInterpreter =
+      Args.hasArg(OPT_fexperimental_constexpr_interpreter);
   Opts.BracketDepth = getLastArgIntValue(Args, OPT_fbracket_depth, 256, Diags);
   Opts.DelayedTemplateParsing = Args.hasArg(OPT_fdelayed_template_parsing);
   Opts.NumLargeByValueCopy =
@@ -1946,8 +1971,11 @@ static void ParsePreprocessorArgs(PreprocessorOptions &Opts, ArgList &Args,
       Opts.TokenCache = A->getValue();
   else
     Opts.TokenCache = Opts.ImplicitPTHInclude;
+  Opts.TokenCacheDir = Args.getLastArgValue(OPT_token_cache_dir);
   Opts.UsePredefines = !Args.hasArg(OPT_undef);
   Opts.DetailedRecord = Args.hasArg(OPT_detailed_preprocessing_record);
+  Opts.PrefetchLineTables = Args.hasArg(OPT_prefetch_line_tables);
+  Opts.CacheMacroExpansions = Args.hasArg(OPT_cache_macro_expansions);
   Opts.DisablePCHValidation = Args.hasArg(OPT_fno_validate_pch);
 
   Opts.DumpDeserializedPCHDecls = Args.hasArg(OPT_dump_deserialized_pch_decls);
@@ -2052,6 +2080,7 @@ static void ParsePreprocessorOutputArgs(PreprocessorOutputOptions &Opts,
   case frontend::PrintPreprocessedInput:
   case frontend::RewriteMacros:
   case frontend::RunPreprocessorOnly:
+  case frontend::ScanDependencies:
     Opts.ShowCPP = !Args.hasArg(OPT_dM);
     break;
   }
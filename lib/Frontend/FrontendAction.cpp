@@ -21,6 +21,8 @@
 #include "clang/Lex/HeaderSearch.h"
 #include "clang/Lex/Preprocessor.h"
 #include "clang/Parse/ParseAST.h"
+#include "clang/Sema/Sema.h"
+#include "clang/Sema/TemplateInstantiationProfiler.h"
 #include "clang/Serialization/ASTDeserializationListener.h"
 #include "clang/Serialization/ASTReader.h"
 #include "clang/Serialization/GlobalModuleIndex.h"
@@ -477,8 +479,10 @@ void FrontendAction::EndSourceFile() {
   CI.getDiagnosticClient().EndSourceFile();
 
   // Inform the preprocessor we are done.
-  if (CI.hasPreprocessor())
+  if (CI.hasPreprocessor()) {
     CI.getPreprocessor().EndSourceFile();
+    CacheHeaderTokens(CI.getPreprocessor());
+  }
 
   // Finalize the action.
   EndSourceFileAction();
@@ -555,6 +559,23 @@ void ASTFrontendAction::ExecuteAction() {
 
   ParseAST(CI.getSema(), CI.getFrontendOpts().ShowStats,
            CI.getFrontendOpts().SkipFunctionBodies);
+
+  if (TemplateInstantiationProfiler *Profiler =
+          CI.getSema().TemplateProfiler.get()) {
+    if (CI.getFrontendOpts().PrintTemplateProfile)
+      Profiler->printText(llvm::errs());
+
+    const std::string &Path = CI.getFrontendOpts().TemplateProfilePath;
+    if (!Path.empty()) {
+      std::error_code EC;
+      llvm::raw_fd_ostream OS(Path, EC, llvm::sys::fs::F_Text);
+      if (EC)
+        CI.getDiagnostics().Report(diag::err_fe_unable_to_open_output)
+            << Path << EC.message();
+      else
+        Profiler->printJSON(OS);
+    }
+  }
 }
 
 void PluginASTAction::anchor() { }
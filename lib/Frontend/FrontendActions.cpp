@@ -16,6 +16,7 @@
 #include "clang/Frontend/FrontendDiagnostic.h"
 #include "clang/Frontend/MultiplexConsumer.h"
 #include "clang/Frontend/Utils.h"
+#include "clang/Lex/DirectivesMinimizer.h"
 #include "clang/Lex/HeaderSearch.h"
 #include "clang/Lex/Pragma.h"
 #include "clang/Lex/Preprocessor.h"
@@ -661,6 +662,61 @@ void PreprocessOnlyAction::ExecuteAction() {
   } while (Tok.isNot(tok::eof));
 }
 
+namespace {
+/// \brief Replaces the contents of the files the preprocessor enters by their
+/// directives.
+class DirectivesOnlyCallbacks : public PPCallbacks {
+  SourceManager &SM;
+  const LangOptions &LangOpts;
+
+public:
+  DirectivesOnlyCallbacks(SourceManager &SM, const LangOptions &LangOpts)
+      : SM(SM), LangOpts(LangOpts) {}
+
+  void minimizeFile(const FileEntry *File) {
+    // The source manager keeps the directives of the file for the next time
+    // it is entered.
+    if (SM.isFileOverridden(File))
+      return;
+
+    bool Invalid = false;
+    llvm::MemoryBuffer *Buffer = SM.getMemoryBufferForFile(File, &Invalid);
+    if (Invalid)
+      return;
+
+    SmallString<1024> Directives;
+    minimizeSourceToDirectives(*Buffer, LangOpts, Directives);
+    std::unique_ptr<llvm::MemoryBuffer> Minimized =
+        llvm::MemoryBuffer::getMemBufferCopy(Directives,
+                                             Buffer->getBufferIdentifier());
+    SM.overrideFileContents(File, std::move(Minimized));
+  }
+
+  void InclusionDirective(SourceLocation HashLoc, const Token &IncludeTok,
+                          StringRef FileName, bool IsAngled,
+                          CharSourceRange FilenameRange, const FileEntry *File,
+                          StringRef SearchPath, StringRef RelativePath,
+                          const Module *Imported) override {
+    if (File && !Imported)
+      minimizeFile(File);
+  }
+};
+} // end anonymous namespace
+
+bool ScanDependenciesAction::BeginSourceFileAction(CompilerInstance &CI,
+                                                   StringRef Filename) {
+  auto Callbacks = llvm::make_unique<DirectivesOnlyCallbacks>(
+      CI.getSourceManager(), CI.getLangOpts());
+
+  // The main file isn't entered through an include directive.
+  if (Filename != "-")
+    if (const FileEntry *File = CI.getFileManager().getFile(Filename))
+      Callbacks->minimizeFile(File);
+
+  CI.getPreprocessor().addPPCallbacks(std::move(Callbacks));
+  return true;
+}
+
 void PrintPreprocessedAction::ExecuteAction() {
   CompilerInstance &CI = getCompilerInstance();
   // Output file may need to be set to 'Binary', to avoid converting Unix style
@@ -0,0 +1,58 @@
+//===--- TimeTraceGen.cpp - Trace the time spent in each source file ------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "clang/Frontend/Utils.h"
+#include "clang/Basic/SourceManager.h"
+#include "clang/Basic/TimeTrace.h"
+#include "clang/Lex/Preprocessor.h"
+using namespace clang;
+
+namespace {
+/// Traces each included file from the point it is entered to the point it is
+/// exited, which includes the time spent parsing what it declares. The main
+/// file is already covered by the "Frontend" event, and is never exited.
+class TimeTraceCallback : public PPCallbacks {
+  SourceManager &SM;
+  TimeTraceProfiler &Profiler;
+
+  /// The depths of the events of the files entered and not exited yet, or
+  /// NotTraced for the files which aren't traced.
+  SmallVector<unsigned, 16> Depths;
+
+  enum : unsigned { NotTraced = ~0U };
+
+public:
+  TimeTraceCallback(SourceManager &SM, TimeTraceProfiler &Profiler)
+      : SM(SM), Profiler(Profiler) {}
+
+  void FileChanged(SourceLocation Loc, FileChangeReason Reason,
+                   SrcMgr::CharacteristicKind FileType,
+                   FileID PrevFID) override {
+    if (Reason == EnterFile) {
+      if (SM.getIncludeLoc(SM.getFileID(Loc)).isInvalid()) {
+        Depths.push_back(NotTraced);
+        return;
+      }
+      PresumedLoc Presumed = SM.getPresumedLoc(Loc);
+      Depths.push_back(Profiler.begin(
+          "Source", Presumed.isValid() ? Presumed.getFilename() : ""));
+    } else if (Reason == ExitFile && !Depths.empty()) {
+      unsigned Depth = Depths.pop_back_val();
+      if (Depth != NotTraced)
+        Profiler.end(Depth);
+    }
+  }
+};
+}
+
+void clang::AttachTimeTraceGen(Preprocessor &PP) {
+  if (TimeTraceProfiler *Profiler = TimeTraceProfiler::get())
+    PP.addPPCallbacks(llvm::make_unique<TimeTraceCallback>(
+        PP.getSourceManager(), *Profiler));
+}
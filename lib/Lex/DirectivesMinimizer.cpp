@@ -0,0 +1,72 @@
+//===--- DirectivesMinimizer.cpp - Strip a file to its directives ---------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+//  This file implements minimizeSourceToDirectives, which is used to find the
+//  dependencies of a file without preprocessing all of its tokens.
+//
+//===----------------------------------------------------------------------===//
+
+#include "clang/Lex/DirectivesMinimizer.h"
+#include "clang/Basic/CharInfo.h"
+#include "clang/Lex/Lexer.h"
+#include "llvm/ADT/StringSwitch.h"
+#include "llvm/Support/MemoryBuffer.h"
+using namespace clang;
+
+static bool isIncludeDirective(StringRef Name) {
+  return llvm::StringSwitch<bool>(Name)
+      .Cases("include", "include_next", "import", "__include_macros", true)
+      .Default(false);
+}
+
+void clang::minimizeSourceToDirectives(const llvm::MemoryBuffer &Input,
+                                       const LangOptions &LangOpts,
+                                       SmallVectorImpl<char> &Output) {
+  // Lexing the file in raw mode is much cheaper than preprocessing it, and
+  // takes care of the comments, string literals and escaped newlines that may
+  // hide a '#'.
+  const char *BufStart = Input.getBufferStart();
+  Lexer L(SourceLocation(), LangOpts, BufStart, BufStart, Input.getBufferEnd());
+
+  Token Tok;
+  L.LexFromRawLexer(Tok);
+  while (Tok.isNot(tok::eof)) {
+    if (Tok.isNot(tok::hash) || !Tok.isAtStartOfLine()) {
+      L.LexFromRawLexer(Tok);
+      continue;
+    }
+
+    // Lex the rest of the directive the way the preprocessor does, so that
+    // the end of the line ends it.
+    const char *DirectiveStart = L.getBufferLocation() - Tok.getLength();
+    L.setParsingPreprocessorDirective(true);
+    L.LexFromRawLexer(Tok);
+
+    // A file name in angle brackets isn't made of regular tokens; it may
+    // contain "//", for instance.
+    if (Tok.is(tok::raw_identifier) &&
+        isIncludeDirective(Tok.getRawIdentifier())) {
+      const char *Ptr = L.getBufferLocation();
+      while (isHorizontalWhitespace(*Ptr))
+        ++Ptr;
+      if (*Ptr == '<')
+        L.LexIncludeFilename(Tok);
+    }
+
+    while (Tok.isNot(tok::eod))
+      L.LexFromRawLexer(Tok);
+
+    // Copy the directive, including the newline which ended it.
+    Output.append(DirectiveStart, L.getBufferLocation());
+    if (!isVerticalWhitespace(Output.back()))
+      Output.push_back('\n');
+
+    L.LexFromRawLexer(Tok);
+  }
+}
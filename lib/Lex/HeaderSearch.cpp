@@ -25,6 +25,8 @@
 #include "llvm/ADT/SmallString.h"
 #include "llvm/Support/Capacity.h"
 #include "llvm/Support/FileSystem.h"
+#include "llvm/Support/LockFileManager.h"
+#include "llvm/Support/MemoryBuffer.h"
 #include "llvm/Support/Path.h"
 #include "llvm/Support/raw_ostream.h"
 #include <cstdio>
@@ -66,7 +68,10 @@ HeaderSearch::HeaderSearch(IntrusiveRefCntPtr<HeaderSearchOptions> HSOpts,
   ExternalSource = nullptr;
   NumIncluded = 0;
   NumMultiIncludeFileOptzn = 0;
+  NumHeaderGuardCacheOptzn = 0;
+  HeaderGuardCacheLoaded = false;
   NumFrameworkLookups = NumSubFrameworkLookups = 0;
+  NumDirLookupsAvoided = 0;
 }
 
 HeaderSearch::~HeaderSearch() {
@@ -92,9 +97,13 @@ void HeaderSearch::PrintStats() {
   fprintf(stderr, "  %d #include/#include_next/#import.\n", NumIncluded);
   fprintf(stderr, "    %d #includes skipped due to"
           " the multi-include optimization.\n", NumMultiIncludeFileOptzn);
+  fprintf(stderr, "    %d #includes skipped due to"
+          " the header guard cache.\n", NumHeaderGuardCacheOptzn);
 
   fprintf(stderr, "%d framework lookups.\n", NumFrameworkLookups);
   fprintf(stderr, "%d subframework lookups.\n", NumSubFrameworkLookups);
+  fprintf(stderr, "%d search directory lookups avoided by directory"
+          " listings.\n", NumDirLookupsAvoided);
 }
 
 /// CreateHeaderMap - This method returns a HeaderMap for the specified
@@ -266,6 +275,20 @@ const FileEntry *HeaderSearch::getFileAndSuggestModule(
   return File;
 }
 
+bool HeaderSearch::mayContainFile(const DirectoryEntry *Dir,
+                                  StringRef Filename) {
+  // Directory listings don't see the files of a virtual file system overlay.
+  if (!HSOpts->VFSOverlayFiles.empty())
+    return true;
+
+  StringRef FirstComponent = *llvm::sys::path::begin(Filename);
+  if (getFileMgr().mayContainEntry(Dir, FirstComponent))
+    return true;
+
+  ++NumDirLookupsAvoided;
+  return false;
+}
+
 /// LookupFile - Lookup the specified file in this search path, returning it
 /// if it exists or returning null if not.
 const FileEntry *DirectoryLookup::LookupFile(
@@ -283,6 +306,9 @@ const FileEntry *DirectoryLookup::LookupFile(
 
   SmallString<1024> TmpDir;
   if (isNormalDir()) {
+    if (!HS.mayContainFile(getDir(), Filename))
+      return nullptr;
+
     // Concatenate the requested file onto the directory.
     TmpDir = getDir()->getName();
     llvm::sys::path::append(TmpDir, Filename);
@@ -1067,6 +1093,19 @@ bool HeaderSearch::ShouldEnterIncludeFile(Preprocessor &PP,
       ++NumMultiIncludeFileOptzn;
       return false;
     }
+  } else if (!M && !FileInfo.NumIncludes &&
+             !HSOpts->HeaderGuardCachePath.empty()) {
+    // We haven't seen this header yet, but a previous compilation may have
+    // found its controlling macro. If that macro is already defined, we know
+    // the #include has no effect without opening the header.
+    if (const IdentifierInfo *ControllingMacro =
+            getCachedControllingMacro(PP, File)) {
+      if (PP.isMacroDefined(ControllingMacro)) {
+        FileInfo.ControllingMacro = ControllingMacro;
+        ++NumHeaderGuardCacheOptzn;
+        return false;
+      }
+    }
   }
 
   // Increment the number of times this file has been included.
@@ -1075,6 +1114,163 @@ bool HeaderSearch::ShouldEnterIncludeFile(Preprocessor &PP,
   return true;
 }
 
+/// Compute the key of \p File in the header guard cache, which doesn't depend
+/// on the working directory or the search path the header was found through.
+static void getHeaderGuardCacheKey(FileManager &FileMgr, const FileEntry *File,
+                                   SmallVectorImpl<char> &Key) {
+  Key.clear();
+  Key.append(File->getName(), File->getName() + strlen(File->getName()));
+  FileMgr.makeAbsolutePath(Key);
+  llvm::sys::path::remove_dots(Key, /*remove_dot_dot=*/true);
+}
+
+void HeaderSearch::readHeaderGuardCache(
+    llvm::StringMap<HeaderGuardCacheEntry> &Cache) {
+  llvm::ErrorOr<std::unique_ptr<llvm::MemoryBuffer>> Buffer =
+      llvm::MemoryBuffer::getFile(HSOpts->HeaderGuardCachePath);
+  if (!Buffer)
+    return;
+
+  // Each line of the cache file describes one header, as
+  // "<modification time> <size> <controlling macro> <path>".
+  SmallVector<StringRef, 64> Lines;
+  (*Buffer)->getBuffer().split(Lines, '\n', /*MaxSplit=*/-1,
+                               /*KeepEmpty=*/false);
+  for (StringRef Line : Lines) {
+    StringRef ModTime, Size, Macro;
+    std::tie(ModTime, Line) = Line.split(' ');
+    std::tie(Size, Line) = Line.split(' ');
+    std::tie(Macro, Line) = Line.split(' ');
+
+    // Ignore malformed lines; the cache is only an optimization.
+    HeaderGuardCacheEntry Entry;
+    if (ModTime.getAsInteger(10, Entry.ModTime) ||
+        Size.getAsInteger(10, Entry.Size) || Macro.empty() || Line.empty())
+      continue;
+    Entry.ControllingMacro = Macro;
+    Cache[Line] = std::move(Entry);
+  }
+}
+
+const IdentifierInfo *
+HeaderSearch::getCachedControllingMacro(Preprocessor &PP,
+                                        const FileEntry *File) {
+  if (!HeaderGuardCacheLoaded) {
+    HeaderGuardCacheLoaded = true;
+    readHeaderGuardCache(HeaderGuardCache);
+  }
+  if (HeaderGuardCache.empty())
+    return nullptr;
+
+  SmallString<256> Key;
+  getHeaderGuardCacheKey(FileMgr, File, Key);
+  auto Known = HeaderGuardCache.find(Key);
+  if (Known == HeaderGuardCache.end())
+    return nullptr;
+
+  // The controlling macro only holds for the contents of the header the
+  // previous compilation saw.
+  const HeaderGuardCacheEntry &Entry = Known->second;
+  if (Entry.ModTime != (uint64_t)File->getModificationTime() ||
+      Entry.Size != (uint64_t)File->getSize())
+    return nullptr;
+
+  return PP.getIdentifierInfo(Entry.ControllingMacro);
+}
+
+void HeaderSearch::writeHeaderGuardCache() {
+  // Update the cache file under a lock, so that another compilation can't
+  // replace it between our read and our rename and lose the headers we
+  // recorded, or we the headers it recorded.
+  while (1) {
+    llvm::LockFileManager Locked(HSOpts->HeaderGuardCachePath);
+    switch (Locked) {
+    case llvm::LockFileManager::LFS_Error:
+      // The cache is only an optimization.
+      return;
+
+    case llvm::LockFileManager::LFS_Owned:
+      updateHeaderGuardCache();
+      return;
+
+    case llvm::LockFileManager::LFS_Shared:
+      // Someone else is updating the cache. Wait for them to finish, then
+      // merge our headers into what they wrote.
+      switch (Locked.waitForUnlock()) {
+      case llvm::LockFileManager::Res_Success:
+      case llvm::LockFileManager::Res_OwnerDied:
+        continue; // try again to get the lock.
+      case llvm::LockFileManager::Res_Timeout:
+        // Clear the lock file so that future compilations can make progress.
+        Locked.unsafeRemoveLockFile();
+        return;
+      }
+    }
+  }
+}
+
+void HeaderSearch::updateHeaderGuardCache() {
+  // Start from the current contents of the cache file rather than from what
+  // we loaded, so that we keep the headers other compilations recorded in the
+  // meantime.
+  llvm::StringMap<HeaderGuardCacheEntry> Cache;
+  readHeaderGuardCache(Cache);
+
+  SmallVector<const FileEntry *, 16> FilesByUID;
+  FileMgr.GetUniqueIDMapping(FilesByUID);
+
+  bool Changed = false;
+  for (unsigned UID = 0, E = std::min(FilesByUID.size(), FileInfo.size());
+       UID != E; ++UID) {
+    const FileEntry *File = FilesByUID[UID];
+    if (!File)
+      continue;
+    const IdentifierInfo *ControllingMacro =
+        FileInfo[UID].getControllingMacro(ExternalLookup);
+    if (!ControllingMacro)
+      continue;
+
+    SmallString<256> Key;
+    getHeaderGuardCacheKey(FileMgr, File, Key);
+    HeaderGuardCacheEntry &Entry = Cache[Key];
+    uint64_t ModTime = File->getModificationTime();
+    uint64_t Size = File->getSize();
+    if (Entry.ModTime == ModTime && Entry.Size == Size &&
+        Entry.ControllingMacro == ControllingMacro->getName())
+      continue;
+
+    Entry.ModTime = ModTime;
+    Entry.Size = Size;
+    Entry.ControllingMacro = ControllingMacro->getName();
+    Changed = true;
+  }
+
+  if (!Changed)
+    return;
+
+  // Write the cache to a temporary file first, so that concurrent compilations
+  // never see a partially written cache.
+  StringRef Path = HSOpts->HeaderGuardCachePath;
+  SmallString<128> TempPath;
+  int FD;
+  if (llvm::sys::fs::createUniqueFile(Path + "-%%%%%%%%", FD, TempPath))
+    return;
+
+  bool Failed;
+  {
+    llvm::raw_fd_ostream OS(FD, /*shouldClose=*/true);
+    for (const auto &Header : Cache)
+      OS << Header.second.ModTime << ' ' << Header.second.Size << ' '
+         << Header.second.ControllingMacro << ' ' << Header.getKey() << '\n';
+    OS.close();
+    Failed = OS.has_error();
+    OS.clear_error();
+  }
+
+  if (Failed || llvm::sys::fs::rename(TempPath, Path))
+    llvm::sys::fs::remove(TempPath);
+}
+
 size_t HeaderSearch::getTotalMemory() const {
   return SearchDirs.capacity()
     + llvm::capacity_in_bytes(FileInfo)
@@ -0,0 +1,129 @@
+//===--- HeaderTokenCache.cpp - Shared cache of header tokens -------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+//  This file implements the HeaderTokenCache class.
+//
+//===----------------------------------------------------------------------===//
+
+#include "clang/Lex/HeaderTokenCache.h"
+#include "clang/Basic/SourceManager.h"
+#include "clang/Lex/PTHLexer.h"
+#include "clang/Lex/PTHManager.h"
+#include "clang/Lex/Preprocessor.h"
+#include "llvm/Support/MD5.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/Path.h"
+#include "llvm/Support/raw_ostream.h"
+using namespace clang;
+
+static std::string hashToString(llvm::MD5 &Hash) {
+  llvm::MD5::MD5Result Result;
+  Hash.final(Result);
+  SmallString<32> Str;
+  llvm::MD5::stringifyResult(Result, Str);
+  return Str.str();
+}
+
+HeaderTokenCache::HeaderTokenCache(Preprocessor &PP, StringRef Dir)
+    : PP(PP), Dir(Dir), NumHits(0), NumMisses(0) {
+  // The cached tokens depend on these options: the lexer looks at them, and
+  // the identifier table at those which enable keywords, as identifiers are
+  // cached as the keywords they were looked up as. The PTH format is part of
+  // the hash as well.
+  const LangOptions &LangOpts = PP.getLangOpts();
+  unsigned Options[] = {
+    PTHManager::Version, LangOpts.AltiVec, LangOpts.AsmPreprocessor,
+    LangOpts.Bool, LangOpts.Borland, LangOpts.C99, LangOpts.C11,
+    LangOpts.ConceptsTS, LangOpts.Coroutines, LangOpts.CPlusPlus,
+    LangOpts.CPlusPlus11, LangOpts.CPlusPlus14, LangOpts.CPlusPlus1z,
+    LangOpts.CUDA, LangOpts.CXXOperatorNames, LangOpts.DeclSpecKeyword,
+    LangOpts.Digraphs, LangOpts.DollarIdents, LangOpts.GNUKeywords,
+    LangOpts.Half, LangOpts.LineComment, LangOpts.MicrosoftExt,
+    LangOpts.MSCompatibilityVersion, LangOpts.MSVCCompat, LangOpts.ObjC1,
+    LangOpts.ObjC2, LangOpts.OpenCL, LangOpts.ParseUnknownAnytype,
+    LangOpts.TraditionalCPP, LangOpts.Trigraphs, LangOpts.WChar
+  };
+  std::string Str;
+  llvm::raw_string_ostream OS(Str);
+  for (unsigned Option : Options)
+    OS << Option << ',';
+
+  llvm::MD5 Hash;
+  Hash.update(OS.str());
+  LangOptsHash = hashToString(Hash);
+}
+
+HeaderTokenCache::~HeaderTokenCache() {}
+
+std::string HeaderTokenCache::getKey(const llvm::MemoryBuffer &Buf) const {
+  llvm::MD5 Hash;
+  Hash.update(LangOptsHash);
+  Hash.update(Buf.getBuffer());
+  return hashToString(Hash);
+}
+
+std::string HeaderTokenCache::getPath(StringRef Key) const {
+  SmallString<128> Path(Dir);
+  llvm::sys::path::append(Path, Key + ".pth");
+  return Path.str();
+}
+
+PTHLexer *HeaderTokenCache::CreateLexer(FileID FID) {
+  // The main file is the one most likely to change between compilations.
+  // Cached tokens have neither comments nor locations to complete code at.
+  SourceManager &SM = PP.getSourceManager();
+  if (FID == SM.getMainFileID() || !SM.getFileEntryForID(FID) ||
+      PP.getCommentRetentionState() || PP.isCodeCompletionEnabled())
+    return nullptr;
+
+  bool Invalid = false;
+  const llvm::MemoryBuffer *Buf = SM.getBuffer(FID, &Invalid);
+  if (Invalid)
+    return nullptr;
+
+  std::string Key = getKey(*Buf);
+  auto Known = Files.find(Key);
+  if (Known == Files.end()) {
+    std::unique_ptr<PTHManager> File;
+    llvm::ErrorOr<std::unique_ptr<llvm::MemoryBuffer>> FileOrErr =
+        llvm::MemoryBuffer::getFile(getPath(Key));
+    if (FileOrErr)
+      File.reset(PTHManager::CreateForHeader(std::move(*FileOrErr)));
+    if (File)
+      File->setPreprocessor(&PP);
+    Known = Files.insert(std::make_pair(Key, std::move(File))).first;
+  }
+
+  PTHLexer *L = nullptr;
+  if (PTHManager *File = Known->second.get())
+    L = File->CreateLexer(FID, Key);
+
+  if (L) {
+    ++NumHits;
+  } else {
+    ++NumMisses;
+    MissedFiles.push_back(std::make_pair(FID, Key));
+  }
+  return L;
+}
+
+void HeaderTokenCache::noteLexerDiagnostic(SourceLocation Loc) {
+  if (Loc.isFileID())
+    UncacheableFiles.insert(PP.getSourceManager().getFileID(Loc));
+}
+
+void HeaderTokenCache::noteSkippedBlock(SourceLocation IfLoc) {
+  if (IfLoc.isFileID())
+    UncacheableFiles.insert(PP.getSourceManager().getFileID(IfLoc));
+}
+
+void HeaderTokenCache::PrintStats() const {
+  llvm::errs() << NumHits << " headers lexed from the header token cache, "
+               << NumMisses << " not found in it.\n";
+}
@@ -16,14 +16,17 @@
 #include "clang/Basic/CharInfo.h"
 #include "clang/Basic/SourceManager.h"
 #include "clang/Lex/CodeCompletionHandler.h"
+#include "clang/Lex/HeaderTokenCache.h"
 #include "clang/Lex/LexDiagnostic.h"
 #include "clang/Lex/LiteralSupport.h"
 #include "clang/Lex/Preprocessor.h"
 #include "llvm/ADT/STLExtras.h"
 #include "llvm/ADT/StringExtras.h"
+#include "llvm/ADT/StringMap.h"
 #include "llvm/ADT/StringSwitch.h"
 #include "llvm/Support/Compiler.h"
 #include "llvm/Support/ConvertUTF.h"
+#include "llvm/Support/Host.h"
 #include "llvm/Support/MemoryBuffer.h"
 #include <cstring>
 using namespace clang;
@@ -1087,7 +1090,10 @@ SourceLocation Lexer::getSourceLocation(const char *Loc,
 /// Diag - Forwarding function for diagnostics.  This translate a source
 /// position in the current buffer into a SourceLocation object for rendering.
 DiagnosticBuilder Lexer::Diag(const char *Loc, unsigned DiagID) const {
-  return PP->Diag(getSourceLocation(Loc), DiagID);
+  SourceLocation DiagLoc = getSourceLocation(Loc);
+  if (HeaderTokenCache *Cache = PP->getHeaderTokenCache())
+    Cache->noteLexerDiagnostic(DiagLoc);
+  return PP->Diag(DiagLoc, DiagID);
 }
 
 //===----------------------------------------------------------------------===//
@@ -1421,8 +1427,14 @@ static inline CharSourceRange makeCharRange(Lexer &L, const char *Begin,
                                        L.getSourceLocation(End));
 }
 
-static void maybeDiagnoseIDCharCompat(DiagnosticsEngine &Diags, uint32_t C,
+static void maybeDiagnoseIDCharCompat(Preprocessor &PP, uint32_t C,
                                       CharSourceRange Range, bool IsFirst) {
+  // Whether these are diagnosed depends on the warning flags, which the
+  // header token cache doesn't know about.
+  if (HeaderTokenCache *Cache = PP.getHeaderTokenCache())
+    Cache->noteLexerDiagnostic(Range.getBegin());
+
+  DiagnosticsEngine &Diags = PP.getDiagnostics();
   // Check C99 compatibility.
   if (!Diags.isIgnored(diag::warn_c99_compat_unicode_id, Range.getBegin())) {
     enum {
@@ -1464,7 +1476,7 @@ bool Lexer::tryConsumeIdentifierUCN(const char *&CurPtr, unsigned Size,
     return false;
 
   if (!isLexingRawMode())
-    maybeDiagnoseIDCharCompat(PP->getDiagnostics(), CodePoint,
+    maybeDiagnoseIDCharCompat(*PP, CodePoint,
                               makeCharRange(*this, CurPtr, UCNPtr),
                               /*IsFirst=*/false);
 
@@ -1491,7 +1503,7 @@ bool Lexer::tryConsumeIdentifierUTF8Char(const char *&CurPtr) {
     return false;
 
   if (!isLexingRawMode())
-    maybeDiagnoseIDCharCompat(PP->getDiagnostics(), CodePoint,
+    maybeDiagnoseIDCharCompat(*PP, CodePoint,
                               makeCharRange(*this, CurPtr, UnicodePtr),
                               /*IsFirst=*/false);
 
@@ -1499,9 +1511,234 @@ bool Lexer::tryConsumeIdentifierUTF8Char(const char *&CurPtr) {
   return true;
 }
 
+#ifdef __SSE2__
+#include <emmintrin.h>
+#elif __ALTIVEC__
+#include <altivec.h>
+#undef bool
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
+// The following functions skip over runs of characters 16 at a time. They
+// only skip whole chunks that end before BufferEnd, and stop at or before the
+// first character not in the run, so their callers still have to finish the
+// run one character at a time. None of the runs include '\0', so they also
+// stop at the code-completion point.
+
+/// Skip over spaces, tabs, '\f' and '\v'.
+static const char *skipHorizontalWhitespaceChunks(const char *CurPtr,
+                                                  const char *BufferEnd) {
+#ifdef __SSE2__
+  const __m128i Spaces = _mm_set1_epi8(' ');
+  const __m128i Tabs = _mm_set1_epi8('\t');
+  const __m128i FFs = _mm_set1_epi8('\f');
+  const __m128i VTabs = _mm_set1_epi8('\v');
+  while (CurPtr + 16 <= BufferEnd) {
+    __m128i Chunk = _mm_loadu_si128((const __m128i *)CurPtr);
+    __m128i Cmp =
+        _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(Chunk, Spaces),
+                                  _mm_cmpeq_epi8(Chunk, Tabs)),
+                     _mm_or_si128(_mm_cmpeq_epi8(Chunk, FFs),
+                                  _mm_cmpeq_epi8(Chunk, VTabs)));
+    unsigned Mask = _mm_movemask_epi8(Cmp);
+    if (Mask != 0xFFFF)
+      return CurPtr + llvm::countTrailingZeros(~Mask);
+    CurPtr += 16;
+  }
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+  while (CurPtr + 16 <= BufferEnd) {
+    uint8x16_t Chunk = vld1q_u8((const uint8_t *)CurPtr);
+    uint8x16_t Cmp =
+        vorrq_u8(vorrq_u8(vceqq_u8(Chunk, vdupq_n_u8(' ')),
+                          vceqq_u8(Chunk, vdupq_n_u8('\t'))),
+                 vorrq_u8(vceqq_u8(Chunk, vdupq_n_u8('\f')),
+                          vceqq_u8(Chunk, vdupq_n_u8('\v'))));
+    if (vminvq_u8(Cmp) == 0)
+      break;
+    CurPtr += 16;
+  }
+#endif
+  return CurPtr;
+}
+
+/// Skip over the characters of a line comment, up to a newline or '\0'.
+static const char *skipLineCommentChunks(const char *CurPtr,
+                                         const char *BufferEnd) {
+#ifdef __SSE2__
+  const __m128i Zeros = _mm_setzero_si128();
+  const __m128i LFs = _mm_set1_epi8('\n');
+  const __m128i CRs = _mm_set1_epi8('\r');
+  while (CurPtr + 16 <= BufferEnd) {
+    __m128i Chunk = _mm_loadu_si128((const __m128i *)CurPtr);
+    __m128i Cmp = _mm_or_si128(_mm_cmpeq_epi8(Chunk, Zeros),
+                               _mm_or_si128(_mm_cmpeq_epi8(Chunk, LFs),
+                                            _mm_cmpeq_epi8(Chunk, CRs)));
+    unsigned Mask = _mm_movemask_epi8(Cmp);
+    if (Mask != 0)
+      return CurPtr + llvm::countTrailingZeros(Mask);
+    CurPtr += 16;
+  }
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+  while (CurPtr + 16 <= BufferEnd) {
+    uint8x16_t Chunk = vld1q_u8((const uint8_t *)CurPtr);
+    uint8x16_t Cmp = vorrq_u8(vceqq_u8(Chunk, vdupq_n_u8(0)),
+                              vorrq_u8(vceqq_u8(Chunk, vdupq_n_u8('\n')),
+                                       vceqq_u8(Chunk, vdupq_n_u8('\r'))));
+    if (vmaxvq_u8(Cmp) != 0)
+      break;
+    CurPtr += 16;
+  }
+#endif
+  return CurPtr;
+}
+
+/// Skip over the characters in [_A-Za-z0-9].
+static const char *skipIdentifierBodyChunks(const char *CurPtr,
+                                            const char *BufferEnd) {
+#ifdef __SSE2__
+  while (CurPtr + 16 <= BufferEnd) {
+    __m128i Chunk = _mm_loadu_si128((const __m128i *)CurPtr);
+    // Characters with the high bit set are negative, so they never match.
+    __m128i Lower = _mm_or_si128(Chunk, _mm_set1_epi8(0x20));
+    __m128i Letters =
+        _mm_and_si128(_mm_cmpgt_epi8(Lower, _mm_set1_epi8('a' - 1)),
+                      _mm_cmpgt_epi8(_mm_set1_epi8('z' + 1), Lower));
+    __m128i Digits =
+        _mm_and_si128(_mm_cmpgt_epi8(Chunk, _mm_set1_epi8('0' - 1)),
+                      _mm_cmpgt_epi8(_mm_set1_epi8('9' + 1), Chunk));
+    __m128i Underscores = _mm_cmpeq_epi8(Chunk, _mm_set1_epi8('_'));
+    unsigned Mask = _mm_movemask_epi8(
+        _mm_or_si128(Letters, _mm_or_si128(Digits, Underscores)));
+    if (Mask != 0xFFFF)
+      return CurPtr + llvm::countTrailingZeros(~Mask);
+    CurPtr += 16;
+  }
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+  while (CurPtr + 16 <= BufferEnd) {
+    uint8x16_t Chunk = vld1q_u8((const uint8_t *)CurPtr);
+    uint8x16_t Lower = vorrq_u8(Chunk, vdupq_n_u8(0x20));
+    uint8x16_t Letters =
+        vcleq_u8(vsubq_u8(Lower, vdupq_n_u8('a')), vdupq_n_u8('z' - 'a'));
+    uint8x16_t Digits =
+        vcleq_u8(vsubq_u8(Chunk, vdupq_n_u8('0')), vdupq_n_u8('9' - '0'));
+    uint8x16_t Underscores = vceqq_u8(Chunk, vdupq_n_u8('_'));
+    if (vminvq_u8(vorrq_u8(Letters, vorrq_u8(Digits, Underscores))) == 0)
+      break;
+    CurPtr += 16;
+  }
+#endif
+  return CurPtr;
+}
+
+// On x86, the chunk scanners also come in 32-byte AVX2 versions. Only these
+// functions are compiled for AVX2, and they are only used if the host CPU
+// supports it. They finish with the 16-byte versions.
+#if defined(__SSE2__) && !defined(_MSC_VER) &&                               \
+    (LLVM_GNUC_PREREQ(4, 9, 0) ||                                            \
+     (defined(__clang__) &&                                                  \
+      (__clang_major__ > 3 || (__clang_major__ == 3 && __clang_minor__ >= 8))))
+#define LEXER_HAS_AVX2_SCANNERS
+#include <immintrin.h>
+
+__attribute__((target("avx2"))) static const char *
+skipHorizontalWhitespaceChunksAVX2(const char *CurPtr, const char *BufferEnd) {
+  const __m256i Spaces = _mm256_set1_epi8(' ');
+  const __m256i Tabs = _mm256_set1_epi8('\t');
+  const __m256i FFs = _mm256_set1_epi8('\f');
+  const __m256i VTabs = _mm256_set1_epi8('\v');
+  while (CurPtr + 32 <= BufferEnd) {
+    __m256i Chunk = _mm256_loadu_si256((const __m256i *)CurPtr);
+    __m256i Cmp =
+        _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(Chunk, Spaces),
+                                        _mm256_cmpeq_epi8(Chunk, Tabs)),
+                        _mm256_or_si256(_mm256_cmpeq_epi8(Chunk, FFs),
+                                        _mm256_cmpeq_epi8(Chunk, VTabs)));
+    unsigned Mask = _mm256_movemask_epi8(Cmp);
+    if (Mask != 0xFFFFFFFF)
+      return CurPtr + llvm::countTrailingZeros(~Mask);
+    CurPtr += 32;
+  }
+  return skipHorizontalWhitespaceChunks(CurPtr, BufferEnd);
+}
+
+__attribute__((target("avx2"))) static const char *
+skipLineCommentChunksAVX2(const char *CurPtr, const char *BufferEnd) {
+  const __m256i Zeros = _mm256_setzero_si256();
+  const __m256i LFs = _mm256_set1_epi8('\n');
+  const __m256i CRs = _mm256_set1_epi8('\r');
+  while (CurPtr + 32 <= BufferEnd) {
+    __m256i Chunk = _mm256_loadu_si256((const __m256i *)CurPtr);
+    __m256i Cmp =
+        _mm256_or_si256(_mm256_cmpeq_epi8(Chunk, Zeros),
+                        _mm256_or_si256(_mm256_cmpeq_epi8(Chunk, LFs),
+                                        _mm256_cmpeq_epi8(Chunk, CRs)));
+    unsigned Mask = _mm256_movemask_epi8(Cmp);
+    if (Mask != 0)
+      return CurPtr + llvm::countTrailingZeros(Mask);
+    CurPtr += 32;
+  }
+  return skipLineCommentChunks(CurPtr, BufferEnd);
+}
+
+__attribute__((target("avx2"))) static const char *
+skipIdentifierBodyChunksAVX2(const char *CurPtr, const char *BufferEnd) {
+  while (CurPtr + 32 <= BufferEnd) {
+    __m256i Chunk = _mm256_loadu_si256((const __m256i *)CurPtr);
+    // Characters with the high bit set are negative, so they never match.
+    __m256i Lower = _mm256_or_si256(Chunk, _mm256_set1_epi8(0x20));
+    __m256i Letters = _mm256_and_si256(
+        _mm256_cmpgt_epi8(Lower, _mm256_set1_epi8('a' - 1)),
+        _mm256_cmpgt_epi8(_mm256_set1_epi8('z' + 1), Lower));
+    __m256i Digits = _mm256_and_si256(
+        _mm256_cmpgt_epi8(Chunk, _mm256_set1_epi8('0' - 1)),
+        _mm256_cmpgt_epi8(_mm256_set1_epi8('9' + 1), Chunk));
+    __m256i Underscores = _mm256_cmpeq_epi8(Chunk, _mm256_set1_epi8('_'));
+    unsigned Mask = _mm256_movemask_epi8(
+        _mm256_or_si256(Letters, _mm256_or_si256(Digits, Underscores)));
+    if (Mask != 0xFFFFFFFF)
+      return CurPtr + llvm::countTrailingZeros(~Mask);
+    CurPtr += 32;
+  }
+  return skipIdentifierBodyChunks(CurPtr, BufferEnd);
+}
+#endif
+
+namespace {
+/// The chunk scanners used by the lexer, chosen once for the host CPU.
+struct ChunkScanners {
+  typedef const char *(*ScanFn)(const char *CurPtr, const char *BufferEnd);
+  ScanFn SkipHorizontalWhitespace;
+  ScanFn SkipLineComment;
+  ScanFn SkipIdentifierBody;
+};
+} // end anonymous namespace
+
+static ChunkScanners selectChunkScanners() {
+#ifdef LEXER_HAS_AVX2_SCANNERS
+  llvm::StringMap<bool> HostFeatures;
+  if (llvm::sys::getHostCPUFeatures(HostFeatures) &&
+      HostFeatures.lookup("avx2")) {
+    ChunkScanners AVX2 = {skipHorizontalWhitespaceChunksAVX2,
+                          skipLineCommentChunksAVX2,
+                          skipIdentifierBodyChunksAVX2};
+    return AVX2;
+  }
+#endif
+  ChunkScanners Default = {skipHorizontalWhitespaceChunks,
+                           skipLineCommentChunks, skipIdentifierBodyChunks};
+  return Default;
+}
+
+static const ChunkScanners &getChunkScanners() {
+  static const ChunkScanners Scanners = selectChunkScanners();
+  return Scanners;
+}
+
 bool Lexer::LexIdentifier(Token &Result, const char *CurPtr) {
   // Match [_A-Za-z0-9]*, we have already matched [_A-Za-z$]
   unsigned Size;
+  CurPtr = getChunkScanners().SkipIdentifierBody(CurPtr, BufferEnd);
   unsigned char C = *CurPtr++;
   while (isIdentifierBody(C))
     C = *CurPtr++;
@@ -1993,7 +2230,12 @@ bool Lexer::SkipWhitespace(Token &Result, const char *CurPtr,
 
   // Skip consecutive spaces efficiently.
   while (1) {
-    // Skip horizontal whitespace very aggressively.
+    // Skip horizontal whitespace very aggressively. Most runs are a single
+    // space, which isn't worth a vector compare.
+    if (isHorizontalWhitespace(Char) && isHorizontalWhitespace(CurPtr[1])) {
+      CurPtr = getChunkScanners().SkipHorizontalWhitespace(CurPtr, BufferEnd);
+      Char = *CurPtr;
+    }
     while (isHorizontalWhitespace(Char))
       Char = *++CurPtr;
 
@@ -2060,8 +2302,9 @@ bool Lexer::SkipLineComment(Token &Result, const char *CurPtr,
   // them.  As such, optimize for this case with the inner loop.
   char C;
   do {
-    C = *CurPtr;
     // Skip over characters in the fast loop.
+    CurPtr = getChunkScanners().SkipLineComment(CurPtr, BufferEnd);
+    C = *CurPtr;
     while (C != 0 &&                // Potentially EOF.
            C != '\n' && C != '\r')  // Newline or DOS-style newline.
       C = *++CurPtr;
@@ -2265,13 +2508,6 @@ static bool isEndOfBlockCommentWithEscapedNewLine(const char *CurPtr,
   return true;
 }
 
-#ifdef __SSE2__
-#include <emmintrin.h>
-#elif __ALTIVEC__
-#include <altivec.h>
-#undef bool
-#endif
-
 /// We have just read from input the / and * characters that started a comment.
 /// Read until we find the * and / characters that terminate the comment.
 /// Note that we don't bother decoding trigraphs or escaped newlines in block
@@ -2851,7 +3087,7 @@ bool Lexer::LexUnicode(Token &Result, uint32_t C, const char *CurPtr) {
   if (isAllowedIDChar(C, LangOpts) && isAllowedInitiallyIDChar(C, LangOpts)) {
     if (!isLexingRawMode() && !ParsingPreprocessorDirective &&
         !PP->isPreprocessedOutput()) {
-      maybeDiagnoseIDCharCompat(PP->getDiagnostics(), C,
+      maybeDiagnoseIDCharCompat(*PP, C,
                                 makeCharRange(*this, BufferPtr, CurPtr),
                                 /*IsFirst=*/true);
     }
@@ -978,7 +978,7 @@ namespace clang {
       RSquare
     } Kind;
     
-    unsigned Location;
+    SourceLocation::UIntTy Location;
     unsigned StringLength;
     const char *StringData;
     
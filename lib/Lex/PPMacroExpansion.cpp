@@ -22,6 +22,7 @@
 #include "clang/Lex/LexDiagnostic.h"
 #include "clang/Lex/MacroArgs.h"
 #include "clang/Lex/MacroInfo.h"
+#include "clang/Lex/PreprocessorOptions.h"
 #include "llvm/ADT/STLExtras.h"
 #include "llvm/ADT/SmallString.h"
 #include "llvm/ADT/StringSwitch.h"
@@ -51,6 +52,7 @@ void Preprocessor::appendMacroDirective(IdentifierInfo *II, MacroDirective *MD){
   MD->setPrevious(OldMD);
   StoredMD.setLatest(MD);
   StoredMD.overrideActiveModuleMacros(*this, II);
+  ++MacroDefinitionGeneration;
 
   if (needModuleMacros()) {
     // Track that we created a new macro directive, so we know we should
@@ -74,6 +76,7 @@ void Preprocessor::setLoadedMacroDirective(IdentifierInfo *II,
   assert(!StoredMD.getLatest() &&
          "the macro history was modified before initializing it from a pch");
   StoredMD = MD;
+  ++MacroDefinitionGeneration;
   // Setup the identifier as having associated macro history.
   II->setHasMacroDefinition(true);
   if (!MD->isDefined() && LeafModuleMacros.find(II) == LeafModuleMacros.end())
@@ -469,6 +472,10 @@ bool Preprocessor::HandleMacroExpandedIdentifier(Token &Identifier,
   SourceLocation ExpandLoc = Identifier.getLocation();
   SourceRange ExpansionRange(ExpandLoc, ExpansionEnd);
 
+  if (RecordedMacroExpansions)
+    RecordedMacroExpansions->push_back(
+        std::make_pair(Identifier, ExpansionRange));
+
   if (Callbacks) {
     if (InMacroArgs) {
       // We can have macro expansion inside a conditional directive while
@@ -566,11 +573,413 @@ bool Preprocessor::HandleMacroExpandedIdentifier(Token &Identifier,
     return true;
   }
 
+  // If the expansion of the macro only depends on the macro definitions and on
+  // the spelling of its arguments, replay it from the cache.
+  if (EnterCachedMacroExpansion(Identifier, ExpansionEnd, MI, Args))
+    return false;
+
   // Start expanding the macro.
   EnterMacro(Identifier, ExpansionEnd, MI, Args);
   return false;
 }
 
+static bool isContextIndependentExpansion(Preprocessor &PP, MacroInfo *MI,
+                                          SmallVectorImpl<MacroInfo *> &Stack,
+                                          SmallVectorImpl<MacroInfo *> &Nested,
+                                          bool &ExpandsToTokens);
+
+/// isContextIndependentTokens - Return true if expanding Toks only depends on
+/// the definitions of the macros they refer to, and add these macros to Nested.
+/// Identifiers naming a parameter of ParamsOf are replaced by an argument
+/// rather than expanded, and are skipped.
+static bool isContextIndependentTokens(Preprocessor &PP, ArrayRef<Token> Toks,
+                                       const MacroInfo *ParamsOf,
+                                       SmallVectorImpl<MacroInfo *> &Stack,
+                                       SmallVectorImpl<MacroInfo *> &Nested,
+                                       bool &ExpandsToTokens) {
+  for (const Token &Tok : Toks) {
+    // Pasted tokens are spelled in the scratch buffer.
+    if (Tok.is(tok::hashhash))
+      return false;
+    // The end of a macro argument.
+    if (Tok.is(tok::eof))
+      continue;
+
+    IdentifierInfo *II = Tok.getIdentifierInfo();
+    if (II && ParamsOf && ParamsOf->getArgumentNum(II) != -1)
+      continue;
+    if (!II || !II->isHandleIdentifierCase()) {
+      // 'defined' in a #if directive keeps the identifier following it from
+      // being expanded.
+      if (II && II->getPPKeywordID() == tok::pp_defined)
+        return false;
+      ExpandsToTokens = true;
+      continue;
+    }
+
+    // Identifiers which need handling for another reason than being a macro
+    // may be diagnosed.
+    if (II->isPoisoned() || II->isExtensionToken() || II->isOutOfDate() ||
+        II->isFutureCompatKeyword() || II->isModulesImport())
+      return false;
+    MacroInfo *NestedMI = PP.getMacroInfo(II);
+    if (!NestedMI ||
+        !isContextIndependentExpansion(PP, NestedMI, Stack, Nested,
+                                       ExpandsToTokens))
+      return false;
+    if (std::find(Nested.begin(), Nested.end(), NestedMI) == Nested.end())
+      Nested.push_back(NestedMI);
+  }
+  return true;
+}
+
+/// isContextIndependentExpansion - Return true if expanding the object-like
+/// macro MI only depends on the definitions of the macros it refers to, and
+/// add these macros to Nested. Stack holds the macros being expanded, which a
+/// reference to would not be expanded. ExpandsToTokens is set if the expansion
+/// produces any token.
+static bool isContextIndependentExpansion(Preprocessor &PP, MacroInfo *MI,
+                                          SmallVectorImpl<MacroInfo *> &Stack,
+                                          SmallVectorImpl<MacroInfo *> &Nested,
+                                          bool &ExpandsToTokens) {
+  // Builtin macros like __LINE__ depend on where they are expanded, and
+  // function-like macros on the tokens following their name.
+  if (!MI->isObjectLike() || MI->isBuiltinMacro() || !MI->isEnabled() ||
+      std::find(Stack.begin(), Stack.end(), MI) != Stack.end())
+    return false;
+
+  Stack.push_back(MI);
+  if (!isContextIndependentTokens(PP, MI->tokens(), /*ParamsOf=*/nullptr,
+                                  Stack, Nested, ExpandsToTokens))
+    return false;
+  Stack.pop_back();
+  return true;
+}
+
+/// getUnexpandedTokens - Return the unexpanded tokens of all the arguments of
+/// a macro invocation, each argument followed by an EOF token.
+static ArrayRef<Token> getUnexpandedTokens(const MacroArgs *Args) {
+  return ArrayRef<Token>(Args->getUnexpArgument(0), Args->getNumArguments());
+}
+
+/// isContextIndependentInvocation - Return true if expanding the macro MI with
+/// the arguments Args, if it is function-like, only depends on the definitions
+/// of the macros they refer to, and add these macros to Nested.
+static bool
+isContextIndependentInvocation(Preprocessor &PP, MacroInfo *MI,
+                               const MacroArgs *Args,
+                               SmallVectorImpl<MacroInfo *> &Nested) {
+  SmallVector<MacroInfo *, 4> Stack;
+  bool ExpandsToTokens = false;
+  if (!Args)
+    return isContextIndependentExpansion(PP, MI, Stack, Nested,
+                                         ExpandsToTokens) &&
+           ExpandsToTokens;
+
+  // The arguments are pre-expanded outside of the macro, but the result is
+  // rescanned with the macro disabled.
+  Stack.push_back(MI);
+  return isContextIndependentTokens(PP, MI->tokens(), MI, Stack, Nested,
+                                    ExpandsToTokens) &&
+         isContextIndependentTokens(PP, getUnexpandedTokens(Args),
+                                    /*ParamsOf=*/nullptr, Stack, Nested,
+                                    ExpandsToTokens) &&
+         ExpandsToTokens;
+}
+
+/// getMacroExpansionCacheKey - Compute in Key what the expansion of MI at
+/// Identifier depends on besides the macro definitions: the macro itself and,
+/// for a function-like macro, the spelling and layout of its arguments up to
+/// ExpansionEnd. Return false if the arguments are not all spelled in the file
+/// the macro name is spelled in.
+static bool getMacroExpansionCacheKey(const SourceManager &SM,
+                                      const Token &Identifier,
+                                      SourceLocation ExpansionEnd,
+                                      const MacroInfo *MI,
+                                      const MacroArgs *Args,
+                                      SmallVectorImpl<char> &Key) {
+  auto Append = [&Key](const void *Data, size_t Size) {
+    Key.append(static_cast<const char *>(Data),
+               static_cast<const char *>(Data) + Size);
+  };
+  Append(&MI, sizeof(MI));
+  if (!Args)
+    return true;
+
+  // The argument tokens are identified by their offset from the macro name, so
+  // that replaying the expansion can locate them in this invocation.
+  SourceLocation ExpandLoc = Identifier.getLocation();
+  if (!ExpandLoc.isFileID())
+    return false;
+  std::pair<FileID, unsigned> Start = SM.getDecomposedLoc(ExpandLoc);
+  auto getOffset = [&](SourceLocation Loc, unsigned &Offset) {
+    if (!Loc.isFileID())
+      return false;
+    std::pair<FileID, unsigned> Decomposed = SM.getDecomposedLoc(Loc);
+    if (Decomposed.first != Start.first || Decomposed.second < Start.second)
+      return false;
+    Offset = Decomposed.second - Start.second;
+    return true;
+  };
+
+  unsigned Offset;
+  if (!getOffset(ExpansionEnd, Offset))
+    return false;
+  Append(&Offset, sizeof(Offset));
+  bool VarargsElided = Args->isVarargsElidedUse();
+  Append(&VarargsElided, sizeof(VarargsElided));
+
+  for (const Token &Tok : getUnexpandedTokens(Args)) {
+    tok::TokenKind Kind = Tok.getKind();
+    Append(&Kind, sizeof(Kind));
+    if (Tok.is(tok::eof))
+      continue;
+    if (!getOffset(Tok.getLocation(), Offset))
+      return false;
+    unsigned Flags = Tok.getFlags(), Length = Tok.getLength();
+    Append(&Offset, sizeof(Offset));
+    Append(&Flags, sizeof(Flags));
+    Append(&Length, sizeof(Length));
+    if (IdentifierInfo *II = Tok.getIdentifierInfo())
+      Append(&II, sizeof(II));
+    else if (Tok.isLiteral() && Tok.getLiteralData())
+      Append(Tok.getLiteralData(), Length);
+  }
+  return true;
+}
+
+bool Preprocessor::EnterCachedMacroExpansion(Token &Identifier,
+                                             SourceLocation ExpansionEnd,
+                                             MacroInfo *MI, MacroArgs *Args) {
+  // Leave alone the macros expanded while reading or pre-expanding macro
+  // arguments, or while recording another expansion. Macros from modules can
+  // become visible without being defined.
+  if (!getPreprocessorOpts().CacheMacroExpansions || InMacroArgs ||
+      InMacroArgPreExpansion || RecordedMacroExpansions || InCachingLexMode() ||
+      isCodeCompletionEnabled() || getLangOpts().Modules)
+    return false;
+
+  SmallString<64> Key;
+  if (!getMacroExpansionCacheKey(SourceMgr, Identifier, ExpansionEnd, MI, Args,
+                                 Key))
+    return false;
+
+  CachedMacroExpansion &Cached = MacroExpansionCache[Key];
+  if (Cached.Generation != MacroDefinitionGeneration) {
+    Cached = CachedMacroExpansion();
+    Cached.Generation = MacroDefinitionGeneration;
+    Cached.IsCacheable =
+        isContextIndependentInvocation(*this, MI, Args, Cached.NestedMacros);
+    // Wait for the invocation to be repeated before recording it.
+    if (Args)
+      return false;
+  }
+
+  if (!Cached.IsCacheable)
+    return false;
+  if (!Cached.IsRecorded) {
+    RecordMacroExpansion(Identifier, ExpansionEnd, MI, Args, Cached);
+    return true;
+  }
+  for (MacroInfo *NestedMI : Cached.NestedMacros)
+    if (!NestedMI->isEnabled())
+      return false;
+
+  // Recreate the SLocEntries of the expansion, relative to this expansion of
+  // the macro.
+  SourceLocation ExpandLoc = Identifier.getLocation();
+  SmallVector<SourceLocation, 4> EntryStarts;
+  auto getLoc = [&](CachedMacroExpansion::RelativeLoc Loc) {
+    if (Loc.Entry == ~0U)
+      return ExpandLoc.getLocWithOffset(Loc.Offset);
+    return EntryStarts[Loc.Entry].getLocWithOffset(Loc.Offset);
+  };
+  for (const auto &Entry : Cached.Entries) {
+    SourceLocation SpellingLoc = Entry.SpellingLoc.isValid()
+                                     ? Entry.SpellingLoc
+                                     : getLoc(Entry.Spelling);
+    if (Entry.IsMacroArg)
+      EntryStarts.push_back(SourceMgr.createMacroArgExpansionLoc(
+          SpellingLoc, getLoc(Entry.ExpansionStart), Entry.Length));
+    else
+      EntryStarts.push_back(SourceMgr.createExpansionLoc(
+          SpellingLoc, getLoc(Entry.ExpansionStart),
+          getLoc(Entry.ExpansionEnd), Entry.Length));
+  }
+
+  if (Callbacks) {
+    for (const auto &Expansion : Cached.NestedExpansions) {
+      Token MacroNameTok = Expansion.MacroNameTok;
+      MacroNameTok.setLocation(getLoc(Expansion.Start));
+      Callbacks->MacroExpands(
+          MacroNameTok,
+          getMacroDefinition(MacroNameTok.getIdentifierInfo()),
+          SourceRange(getLoc(Expansion.Start), getLoc(Expansion.End)),
+          /*Args=*/nullptr);
+    }
+  }
+
+  unsigned NumToks = Cached.Tokens.size();
+  auto Toks = llvm::make_unique<Token[]>(NumToks);
+  for (unsigned i = 0; i != NumToks; ++i) {
+    Toks[i] = Cached.Tokens[i];
+    Toks[i].setLocation(getLoc(Cached.TokenLocs[i]));
+  }
+
+  // The first token gets the lexical properties of the macro identifier.
+  Toks[0].setFlagValue(Token::StartOfLine, Identifier.isAtStartOfLine());
+  Toks[0].setFlagValue(Token::LeadingSpace, Identifier.hasLeadingSpace());
+
+  EnterTokenStream(std::move(Toks), NumToks, /*DisableMacroExpansion=*/true);
+  if (Args) {
+    Args->destroy(*this);
+    ++NumCachedFnMacroExpanded;
+  } else {
+    ++NumCachedMacroExpanded;
+  }
+  return true;
+}
+
+void Preprocessor::RecordMacroExpansion(Token &Identifier,
+                                        SourceLocation ExpansionEnd,
+                                        MacroInfo *MI, MacroArgs *Args,
+                                        CachedMacroExpansion &Cached) {
+  SourceLocation ExpandLoc = Identifier.getLocation();
+  unsigned FirstEntry = SourceMgr.local_sloc_entry_size();
+
+  // Expand the macro the way macro arguments are pre-expanded: lex from it
+  // until we reach the EOF token of a token stream underneath it. Entering
+  // the macro pre-expands its arguments, which may expand other macros.
+  Token EofTok;
+  EofTok.startToken();
+  EofTok.setKind(tok::eof);
+  EofTok.setLocation(ExpandLoc);
+  EnterTokenStream(&EofTok, 1, /*DisableMacroExpansion=*/true,
+                   /*OwnsTokens=*/false);
+  SmallVector<std::pair<Token, SourceRange>, 4> Expansions;
+  SmallVector<Token, 16> Tokens;
+  RecordedMacroExpansions = &Expansions;
+  EnterMacro(Identifier, ExpansionEnd, MI, Args);
+  while (true) {
+    Token Tok;
+    Lex(Tok);
+    if (Tok.is(tok::eof))
+      break;
+    Tokens.push_back(Tok);
+  }
+  RecordedMacroExpansions = nullptr;
+  RemoveTopOfLexerStack();
+
+  // Every location the expansion produced is in one of the SLocEntries it
+  // created, or in the macro invocation, which is only the macro name for an
+  // object-like macro.
+  unsigned EndEntry = SourceMgr.local_sloc_entry_size();
+  std::pair<FileID, unsigned> InvocationStart, InvocationEnd;
+  if (Args) {
+    InvocationStart = SourceMgr.getDecomposedLoc(ExpandLoc);
+    InvocationEnd = SourceMgr.getDecomposedLoc(ExpansionEnd);
+  }
+  auto getRelativeLoc = [&](SourceLocation Loc,
+                            CachedMacroExpansion::RelativeLoc &Result) {
+    if (Loc == ExpandLoc) {
+      Result.Entry = ~0U;
+      Result.Offset = 0;
+      return true;
+    }
+    std::pair<FileID, unsigned> Decomposed = SourceMgr.getDecomposedLoc(Loc);
+    if (Loc.isFileID()) {
+      // getMacroExpansionCacheKey checked that the arguments are in the file
+      // of the macro name.
+      if (!Args || Decomposed.first != InvocationStart.first ||
+          Decomposed.second < InvocationStart.second ||
+          Decomposed.second > InvocationEnd.second)
+        return false;
+      Result.Entry = ~0U;
+      Result.Offset = Decomposed.second - InvocationStart.second;
+      return true;
+    }
+    unsigned Index = Decomposed.first.getHashValue();
+    if (Index < FirstEntry || Index >= EndEntry)
+      return false;
+    Result.Entry = Index - FirstEntry;
+    Result.Offset = Decomposed.second;
+    return true;
+  };
+
+  bool IsReplayable = !Tokens.empty();
+  for (unsigned Index = FirstEntry; IsReplayable && Index != EndEntry;
+       ++Index) {
+    const SrcMgr::SLocEntry &Entry = SourceMgr.getLocalSLocEntry(Index);
+    if (!Entry.isExpansion()) {
+      IsReplayable = false;
+      break;
+    }
+    SourceLocation::UIntTy NextOffset =
+        Index + 1 == EndEntry
+            ? SourceMgr.getNextLocalOffset()
+            : SourceMgr.getLocalSLocEntry(Index + 1).getOffset();
+    const SrcMgr::ExpansionInfo &Info = Entry.getExpansion();
+    CachedMacroExpansion::ExpansionEntry CachedEntry;
+    CachedEntry.Length = NextOffset - Entry.getOffset() - 1;
+    CachedEntry.IsMacroArg = Info.isMacroArgExpansion();
+    // An entry can only refer to the entries created before it. Entries
+    // spelled outside of the expansion are spelled in a macro definition or
+    // in the scratch buffer, which outlive it.
+    unsigned Current = Index - FirstEntry;
+    auto isEarlier = [Current](CachedMacroExpansion::RelativeLoc Loc) {
+      return Loc.Entry == ~0U || Loc.Entry < Current;
+    };
+    SourceLocation SpellingLoc = Info.getSpellingLoc();
+    if (getRelativeLoc(SpellingLoc, CachedEntry.Spelling)) {
+      IsReplayable = isEarlier(CachedEntry.Spelling);
+    } else {
+      CachedEntry.SpellingLoc = SpellingLoc;
+      IsReplayable = SpellingLoc.isFileID();
+    }
+    IsReplayable =
+        IsReplayable &&
+        getRelativeLoc(Info.getExpansionLocStart(),
+                       CachedEntry.ExpansionStart) &&
+        isEarlier(CachedEntry.ExpansionStart) &&
+        (CachedEntry.IsMacroArg ||
+         (getRelativeLoc(Info.getExpansionLocEnd(),
+                         CachedEntry.ExpansionEnd) &&
+          isEarlier(CachedEntry.ExpansionEnd)));
+    Cached.Entries.push_back(CachedEntry);
+  }
+
+  for (unsigned i = 0, e = Expansions.size(); IsReplayable && i != e; ++i) {
+    CachedMacroExpansion::NestedExpansion Expansion;
+    Expansion.MacroNameTok = Expansions[i].first;
+    IsReplayable =
+        getRelativeLoc(Expansions[i].second.getBegin(), Expansion.Start) &&
+        getRelativeLoc(Expansions[i].second.getEnd(), Expansion.End);
+    Cached.NestedExpansions.push_back(Expansion);
+  }
+
+  for (unsigned i = 0, e = Tokens.size(); IsReplayable && i != e; ++i) {
+    CachedMacroExpansion::RelativeLoc Loc;
+    IsReplayable = getRelativeLoc(Tokens[i].getLocation(), Loc) &&
+                   Loc.Entry != ~0U;
+    Cached.TokenLocs.push_back(Loc);
+  }
+
+  if (IsReplayable) {
+    Cached.Tokens.append(Tokens.begin(), Tokens.end());
+    Cached.IsRecorded = true;
+    ++NumMacroExpansionsCached;
+  } else {
+    Cached = CachedMacroExpansion();
+    Cached.Generation = MacroDefinitionGeneration;
+  }
+
+  // Enter the expanded tokens in place of the macro.
+  auto Toks = llvm::make_unique<Token[]>(Tokens.size());
+  std::copy(Tokens.begin(), Tokens.end(), Toks.get());
+  EnterTokenStream(std::move(Toks), Tokens.size(),
+                   /*DisableMacroExpansion=*/true);
+}
+
 enum Bracket {
   Brace,
   Paren
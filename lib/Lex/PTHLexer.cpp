@@ -20,6 +20,7 @@
 #include "clang/Lex/PTHManager.h"
 #include "clang/Lex/Preprocessor.h"
 #include "clang/Lex/Token.h"
+#include "llvm/ADT/SmallString.h"
 #include "llvm/ADT/StringExtras.h"
 #include "llvm/ADT/StringMap.h"
 #include "llvm/Support/EndianStream.h"
@@ -422,13 +423,21 @@ PTHManager::PTHManager(
     : Buf(std::move(buf)), PerIDCache(std::move(perIDCache)),
       FileLookup(std::move(fileLookup)), IdDataTable(idDataTable),
       StringIdLookup(std::move(stringIdLookup)), NumIds(numIds), PP(nullptr),
-      SpellingBase(spellingBase), OriginalSourceFile(originalSourceFile) {}
+      SpellingBase(spellingBase), OriginalSourceFile(originalSourceFile),
+      UsesPPIdentifiers(false) {}
 
 PTHManager::~PTHManager() {
 }
 
-static void InvalidPTH(DiagnosticsEngine &Diags, const char *Msg) {
-  Diags.Report(Diags.getCustomDiagID(DiagnosticsEngine::Error, "%0")) << Msg;
+static void InvalidPTH(DiagnosticsEngine *Diags, const char *Msg) {
+  if (Diags)
+    Diags->Report(Diags->getCustomDiagID(DiagnosticsEngine::Error, "%0"))
+        << Msg;
+}
+
+static void InvalidPTHFile(DiagnosticsEngine *Diags, StringRef file) {
+  if (Diags)
+    Diags->Report(diag::err_invalid_pth_file) << file;
 }
 
 PTHManager *PTHManager::Create(StringRef file, DiagnosticsEngine &Diags) {
@@ -441,8 +450,19 @@ PTHManager *PTHManager::Create(StringRef file, DiagnosticsEngine &Diags) {
     Diags.Report(diag::err_invalid_pth_file) << file;
     return nullptr;
   }
-  std::unique_ptr<llvm::MemoryBuffer> File = std::move(FileOrErr.get());
+  return Create(std::move(FileOrErr.get()), file, &Diags);
+}
 
+PTHManager *
+PTHManager::CreateForHeader(std::unique_ptr<llvm::MemoryBuffer> File) {
+  PTHManager *PTHMgr = Create(std::move(File), StringRef(), nullptr);
+  if (PTHMgr)
+    PTHMgr->UsesPPIdentifiers = true;
+  return PTHMgr;
+}
+
+PTHManager *PTHManager::Create(std::unique_ptr<llvm::MemoryBuffer> File,
+                               StringRef file, DiagnosticsEngine *Diags) {
   using namespace llvm::support;
 
   // Get the buffer ranges and check if there are at least three 32-bit
@@ -453,7 +473,7 @@ PTHManager *PTHManager::Create(StringRef file, DiagnosticsEngine &Diags) {
   // Check the prologue of the file.
   if ((BufEnd - BufBeg) < (signed)(sizeof("cfe-pth") + 4 + 4) ||
       memcmp(BufBeg, "cfe-pth", sizeof("cfe-pth")) != 0) {
-    Diags.Report(diag::err_invalid_pth_file) << file;
+    InvalidPTHFile(Diags, file);
     return nullptr;
   }
 
@@ -473,7 +493,7 @@ PTHManager *PTHManager::Create(StringRef file, DiagnosticsEngine &Diags) {
   const unsigned char *PrologueOffset = p;
 
   if (PrologueOffset >= BufEnd) {
-    Diags.Report(diag::err_invalid_pth_file) << file;
+    InvalidPTHFile(Diags, file);
     return nullptr;
   }
 
@@ -484,7 +504,7 @@ PTHManager *PTHManager::Create(StringRef file, DiagnosticsEngine &Diags) {
       BufBeg + endian::readNext<uint32_t, little, aligned>(FileTableOffset);
 
   if (!(FileTable > BufBeg && FileTable < BufEnd)) {
-    Diags.Report(diag::err_invalid_pth_file) << file;
+    InvalidPTHFile(Diags, file);
     return nullptr; // FIXME: Proper error diagnostic?
   }
 
@@ -502,7 +522,7 @@ PTHManager *PTHManager::Create(StringRef file, DiagnosticsEngine &Diags) {
       BufBeg + endian::readNext<uint32_t, little, aligned>(IDTableOffset);
 
   if (!(IData >= BufBeg && IData < BufEnd)) {
-    Diags.Report(diag::err_invalid_pth_file) << file;
+    InvalidPTHFile(Diags, file);
     return nullptr;
   }
 
@@ -512,7 +532,7 @@ PTHManager *PTHManager::Create(StringRef file, DiagnosticsEngine &Diags) {
   const unsigned char *StringIdTable =
       BufBeg + endian::readNext<uint32_t, little, aligned>(StringIdTableOffset);
   if (!(StringIdTable >= BufBeg && StringIdTable < BufEnd)) {
-    Diags.Report(diag::err_invalid_pth_file) << file;
+    InvalidPTHFile(Diags, file);
     return nullptr;
   }
 
@@ -524,7 +544,7 @@ PTHManager *PTHManager::Create(StringRef file, DiagnosticsEngine &Diags) {
   const unsigned char *spellingBase =
       BufBeg + endian::readNext<uint32_t, little, aligned>(spellingBaseOffset);
   if (!(spellingBase >= BufBeg && spellingBase < BufEnd)) {
-    Diags.Report(diag::err_invalid_pth_file) << file;
+    InvalidPTHFile(Diags, file);
     return nullptr;
   }
 
@@ -565,6 +585,13 @@ IdentifierInfo* PTHManager::LazilyCreateIdentifierInfo(unsigned PersistentID) {
       endian::readNext<uint32_t, little, aligned>(TableEntry);
   assert(IDData < (const unsigned char*)Buf->getBufferEnd());
 
+  if (UsesPPIdentifiers) {
+    assert(PP && "No preprocessor set yet!");
+    IdentifierInfo *II = PP->getIdentifierInfo((const char *)IDData);
+    PerIDCache[PersistentID] = II;
+    return II;
+  }
+
   // Allocate the object.
   std::pair<IdentifierInfo,const unsigned char*> *Mem =
     Alloc.Allocate<std::pair<IdentifierInfo,const unsigned char*> >();
@@ -597,8 +624,6 @@ PTHLexer *PTHManager::CreateLexer(FileID FID) {
   if (!FE)
     return nullptr;
 
-  using namespace llvm::support;
-
   // Lookup the FileEntry object in our file lookup data structure.  It will
   // return a variant that indicates whether or not there is an offset within
   // the PTH file that contains cached tokens.
@@ -608,13 +633,34 @@ PTHLexer *PTHManager::CreateLexer(FileID FID) {
     return nullptr;
 
   const PTHFileData& FileData = *I;
+  return createLexerAt(FID, FileData.getTokenOffset(),
+                       FileData.getPPCondOffset());
+}
+
+PTHLexer *PTHManager::CreateLexer(FileID FID, StringRef Name) {
+  // File names are stored null-terminated.
+  SmallString<64> Key(Name);
+  PTHFileLookup::iterator I = FileLookup->find_hashed(
+      std::make_pair((unsigned char)0x1, Key.c_str()), llvm::HashString(Name));
+
+  if (I == FileLookup->end()) // No tokens available?
+    return nullptr;
+
+  const PTHFileData& FileData = *I;
+  return createLexerAt(FID, FileData.getTokenOffset(),
+                       FileData.getPPCondOffset());
+}
+
+PTHLexer *PTHManager::createLexerAt(FileID FID, uint32_t TokenOffset,
+                                    uint32_t PPCondOffset) {
+  using namespace llvm::support;
 
   const unsigned char *BufStart = (const unsigned char *)Buf->getBufferStart();
   // Compute the offset of the token data within the buffer.
-  const unsigned char* data = BufStart + FileData.getTokenOffset();
+  const unsigned char* data = BufStart + TokenOffset;
 
   // Get the location of pp-conditional table.
-  const unsigned char* ppcond = BufStart + FileData.getPPCondOffset();
+  const unsigned char* ppcond = BufStart + PPCondOffset;
   uint32_t Len = endian::readNext<uint32_t, little, aligned>(ppcond);
   if (Len == 0) ppcond = nullptr;
 
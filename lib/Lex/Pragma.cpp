@@ -410,6 +410,7 @@ void Preprocessor::HandlePragmaPoison(Token &PoisonTok) {
 
     // Finally, poison it!
     II->setIsPoisoned();
+    ++MacroDefinitionGeneration;
     if (II->isFromAST())
       II->setChangedSinceDeserialization();
   }
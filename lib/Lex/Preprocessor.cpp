@@ -33,6 +33,8 @@
 #include "clang/Lex/CodeCompletionHandler.h"
 #include "clang/Lex/ExternalPreprocessorSource.h"
 #include "clang/Lex/HeaderSearch.h"
+#include "clang/Lex/HeaderSearchOptions.h"
+#include "clang/Lex/HeaderTokenCache.h"
 #include "clang/Lex/LexDiagnostic.h"
 #include "clang/Lex/LiteralSupport.h"
 #include "clang/Lex/MacroArgs.h"
@@ -90,6 +92,8 @@ Preprocessor::Preprocessor(IntrusiveRefCntPtr<PreprocessorOptions> PPOpts,
   NumFastMacroExpanded = NumTokenPaste = NumFastTokenPaste = 0;
   MaxIncludeStackDepth = 0;
   NumSkipped = 0;
+  NumMacroExpansionsCached = NumCachedMacroExpanded = 0;
+  NumCachedFnMacroExpanded = 0;
   
   // Default to discarding comments.
   KeepComments = false;
@@ -101,6 +105,8 @@ Preprocessor::Preprocessor(IntrusiveRefCntPtr<PreprocessorOptions> PPOpts,
   MacroExpansionInDirectivesOverride = false;
   InMacroArgs = false;
   InMacroArgPreExpansion = false;
+  MacroDefinitionGeneration = 0;
+  RecordedMacroExpansions = nullptr;
   NumCachedTokenLexers = 0;
   PragmasEnabled = true;
   ParsingIfOrElifDirective = false;
@@ -210,6 +216,11 @@ void Preprocessor::setPTHManager(PTHManager* pm) {
   FileMgr.addStatCache(PTH->createStatCache());
 }
 
+void Preprocessor::setHeaderTokenCache(
+    std::unique_ptr<HeaderTokenCache> Cache) {
+  HeaderTokens = std::move(Cache);
+}
+
 void Preprocessor::DumpToken(const Token &Tok, bool DumpFlags) const {
   llvm::errs() << tok::getTokenName(Tok.getKind()) << " '"
                << getSpelling(Tok) << "'";
@@ -267,12 +278,20 @@ void Preprocessor::PrintStats() {
   llvm::errs() << (NumFastTokenPaste+NumTokenPaste)
              << " token paste (##) operations performed, "
              << NumFastTokenPaste << " on the fast path.\n";
+  llvm::errs() << NumCachedMacroExpanded << " obj and "
+             << NumCachedFnMacroExpanded
+             << " fn macros expanded from the expansion cache, "
+             << NumMacroExpansionsCached << " expansions cached.\n";
+  if (HeaderTokens)
+    HeaderTokens->PrintStats();
 
   llvm::errs() << "\nPreprocessor Memory: " << getTotalMemory() << "B total";
 
   llvm::errs() << "\n  BumpPtr: " << BP.getTotalMemory();
   llvm::errs() << "\n  Macro Expanded Tokens: "
                << llvm::capacity_in_bytes(MacroExpandedTokens);
+  llvm::errs() << "\n  Macro Expansion Cache: "
+               << getMacroExpansionCacheMemory();
   llvm::errs() << "\n  Predefines Buffer: " << Predefines.capacity();
   // FIXME: List information for all submodules.
   llvm::errs() << "\n  Macros: "
@@ -303,6 +322,7 @@ Preprocessor::macro_begin(bool IncludeExternalMacros) const {
 size_t Preprocessor::getTotalMemory() const {
   return BP.getTotalMemory()
     + llvm::capacity_in_bytes(MacroExpandedTokens)
+    + getMacroExpansionCacheMemory()
     + Predefines.capacity() /* Predefines buffer. */
     // FIXME: Include sizes from all submodules, and include MacroInfo sizes,
     // and ModuleMacros.
@@ -312,6 +332,20 @@ size_t Preprocessor::getTotalMemory() const {
     + llvm::capacity_in_bytes(CommentHandlers);
 }
 
+size_t Preprocessor::getMacroExpansionCacheMemory() const {
+  size_t Size = MacroExpansionCache.getNumBuckets() * sizeof(void *);
+  for (const auto &Entry : MacroExpansionCache) {
+    const CachedMacroExpansion &Cached = Entry.getValue();
+    Size += sizeof(Entry) + Entry.getKeyLength() +
+            llvm::capacity_in_bytes(Cached.NestedMacros) +
+            llvm::capacity_in_bytes(Cached.Entries) +
+            llvm::capacity_in_bytes(Cached.NestedExpansions) +
+            llvm::capacity_in_bytes(Cached.Tokens) +
+            llvm::capacity_in_bytes(Cached.TokenLocs);
+  }
+  return Size;
+}
+
 Preprocessor::macro_iterator
 Preprocessor::macro_end(bool IncludeExternalMacros) const {
   if (IncludeExternalMacros && ExternalSource &&
@@ -533,6 +567,10 @@ void Preprocessor::EndSourceFile() {
   // Notify the client that we reached the end of the source file.
   if (Callbacks)
     Callbacks->EndOfMainFile();
+
+  // Remember the include guards we found for later compilations.
+  if (!HeaderInfo.getHeaderSearchOpts().HeaderGuardCachePath.empty())
+    HeaderInfo.writeHeaderGuardCache();
 }
 
 //===----------------------------------------------------------------------===//
@@ -587,6 +625,7 @@ void Preprocessor::PoisonSEHIdentifiers(bool Poison) {
   Ident__abnormal_termination->setIsPoisoned(Poison);
   Ident___abnormal_termination->setIsPoisoned(Poison);
   Ident_AbnormalTermination->setIsPoisoned(Poison);
+  ++MacroDefinitionGeneration;
 }
 
 void Preprocessor::HandlePoisonedIdentifier(Token & Identifier) {
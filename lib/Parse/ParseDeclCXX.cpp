@@ -2167,7 +2167,7 @@ void Parser::MaybeParseAndDiagnoseDeclSpecAfterCXX11VirtSpecifierSeq(
       auto DeclSpecCheck = [&] (DeclSpec::TQ TypeQual,
                                 const char *FixItName,
                                 SourceLocation SpecLoc,
-                                unsigned* QualifierLoc) {
+                                SourceLocation::UIntTy *QualifierLoc) {
         FixItHint Insertion;
         if (DS.getTypeQualifiers() & TypeQual) {
           if (!(Function.TypeQuals & TypeQual)) {
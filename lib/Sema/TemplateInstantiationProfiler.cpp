@@ -0,0 +1,137 @@
+//===--- TemplateInstantiationProfiler.cpp - Cost of instantiations -------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+//  This file implements the TemplateInstantiationProfiler class.
+//
+//===----------------------------------------------------------------------===//
+
+#include "clang/Sema/TemplateInstantiationProfiler.h"
+#include "clang/AST/ASTContext.h"
+#include "clang/AST/DeclTemplate.h"
+#include "llvm/Support/Format.h"
+#include "llvm/Support/raw_ostream.h"
+#include <algorithm>
+using namespace clang;
+
+/// \brief Returns the template whose instantiations \p Instantiation is
+/// counted with.
+static const NamedDecl *getProfiledTemplate(const Decl *Instantiation) {
+  const RedeclarableTemplateDecl *Template = nullptr;
+  if (auto *Spec = dyn_cast<ClassTemplateSpecializationDecl>(Instantiation))
+    Template = Spec->getSpecializedTemplate();
+  else if (auto *Function = dyn_cast<FunctionDecl>(Instantiation))
+    Template = Function->getPrimaryTemplate();
+
+  if (Template) {
+    // A member template of a class template specialization is counted with
+    // the member template of the class template.
+    while (const RedeclarableTemplateDecl *From =
+               Template->getInstantiatedFromMemberTemplate())
+      Template = From;
+    return cast<NamedDecl>(Template->getCanonicalDecl());
+  }
+
+  if (auto *Function = dyn_cast<FunctionDecl>(Instantiation)) {
+    if (const FunctionDecl *Pattern =
+            Function->getTemplateInstantiationPattern())
+      return Pattern->getCanonicalDecl();
+    return Function->getCanonicalDecl();
+  }
+
+  auto *Record = cast<CXXRecordDecl>(Instantiation);
+  if (const CXXRecordDecl *Pattern = Record->getTemplateInstantiationPattern())
+    return Pattern->getCanonicalDecl();
+  return Record->getCanonicalDecl();
+}
+
+template <typename Duration> static double toMilliseconds(Duration D) {
+  return std::chrono::duration<double, std::milli>(D).count();
+}
+
+void TemplateInstantiationProfiler::begin(const Decl *Instantiation) {
+  ++NumInstantiations;
+  Frame F;
+  F.Template = getProfiledTemplate(Instantiation);
+  F.Children = Clock::duration::zero();
+  F.Bytes = Context.getASTAllocatedBytes();
+  F.Instantiations = NumInstantiations;
+  F.Start = Clock::now();
+  Stack.push_back(F);
+}
+
+void TemplateInstantiationProfiler::end() {
+  Clock::time_point Now = Clock::now();
+  Frame F = Stack.pop_back_val();
+  Clock::duration Duration = Now - F.Start;
+  if (!Stack.empty())
+    Stack.back().Children += Duration;
+
+  Entry &E = Entries[F.Template];
+  if (!E.Template) {
+    E.Template = F.Template;
+    E.Count = E.Nested = 0;
+    E.Bytes = 0;
+    E.Total = E.Self = Clock::duration::zero();
+  }
+  ++E.Count;
+  E.Self += Duration - F.Children;
+
+  // Whatever this instantiation did is already accounted for by an enclosing
+  // instantiation of the same template.
+  if (std::any_of(Stack.begin(), Stack.end(), [&](const Frame &Outer) {
+        return Outer.Template == F.Template;
+      }))
+    return;
+  E.Nested += NumInstantiations - F.Instantiations;
+  E.Bytes += Context.getASTAllocatedBytes() - F.Bytes;
+  E.Total += Duration;
+}
+
+std::vector<TemplateInstantiationProfiler::Entry>
+TemplateInstantiationProfiler::getEntries() const {
+  std::vector<Entry> Result;
+  Result.reserve(Entries.size());
+  for (const auto &E : Entries)
+    Result.push_back(E.second);
+  std::sort(Result.begin(), Result.end(), [](const Entry &A, const Entry &B) {
+    if (A.Total != B.Total)
+      return A.Total > B.Total;
+    return A.Count > B.Count;
+  });
+  return Result;
+}
+
+void TemplateInstantiationProfiler::printText(raw_ostream &OS) const {
+  OS << "\n*** Template instantiation profile:\n";
+  OS << "  Total (ms)   Self (ms)    Count   Nested    AST bytes  Template\n";
+  for (const Entry &E : getEntries())
+    OS << llvm::format("%12.3f%12.3f%9u%9u%13llu  ", toMilliseconds(E.Total),
+                       toMilliseconds(E.Self), E.Count, E.Nested,
+                       static_cast<unsigned long long>(E.Bytes))
+       << E.Template->getQualifiedNameAsString() << '\n';
+}
+
+void TemplateInstantiationProfiler::printJSON(raw_ostream &OS) const {
+  OS << "{\"templates\":[";
+  bool First = true;
+  for (const Entry &E : getEntries()) {
+    OS << (First ? "\n" : ",\n") << "{\"name\":\"";
+    First = false;
+    for (char C : E.Template->getQualifiedNameAsString()) {
+      if (C == '"' || C == '\\')
+        OS << '\\';
+      OS << C;
+    }
+    OS << "\",\"count\":" << E.Count << ",\"nested\":" << E.Nested
+       << ",\"bytes\":" << E.Bytes
+       << llvm::format(",\"total_ms\":%.3f,\"self_ms\":%.3f}",
+                       toMilliseconds(E.Total), toMilliseconds(E.Self));
+  }
+  OS << "\n]}\n";
+}
@@ -1238,7 +1238,7 @@ bool ASTReader::ReadSLocEntry(int ID) {
   ModuleFile *F = GlobalSLocEntryMap.find(-ID)->second;
   F->SLocEntryCursor.JumpToBit(F->SLocEntryOffsets[ID - F->SLocEntryBaseID]);
   BitstreamCursor &SLocEntryCursor = F->SLocEntryCursor;
-  unsigned BaseOffset = F->SLocEntryBaseOffset;
+  SourceLocation::UIntTy BaseOffset = F->SLocEntryBaseOffset;
 
   ++NumSLocEntriesRead;
   llvm::BitstreamEntry Entry = SLocEntryCursor.advance();
@@ -1279,7 +1279,8 @@ bool ASTReader::ReadSLocEntry(int ID) {
                                         ID, BaseOffset + Record[0]);
     SrcMgr::FileInfo &FileInfo =
           const_cast<SrcMgr::FileInfo&>(SourceMgr.getSLocEntry(FID).getFile());
-    FileInfo.NumCreatedFIDs = Record[5];
+    if (Record[5])
+      SourceMgr.setNumCreatedFIDsForFileID(FID, Record[5]);
     if (Record[3])
       FileInfo.setHasLineDirectives();
 
@@ -1308,7 +1309,7 @@ bool ASTReader::ReadSLocEntry(int ID) {
 
   case SM_SLOC_BUFFER_ENTRY: {
     const char *Name = Blob.data();
-    unsigned Offset = Record[0];
+    SourceLocation::UIntTy Offset = Record[0];
     SrcMgr::CharacteristicKind
       FileCharacter = (SrcMgr::CharacteristicKind)Record[2];
     SourceLocation IncludeLoc = ReadSourceLocation(*F, Record[1]);
@@ -2813,7 +2814,7 @@ ASTReader::ReadASTBlock(ModuleFile &F, unsigned ClientLoadCapabilities) {
     case SOURCE_LOCATION_OFFSETS: {
       F.SLocEntryOffsets = (const uint32_t *)Blob.data();
       F.LocalNumSLocEntries = Record[0];
-      unsigned SLocSpaceSize = Record[1];
+      SourceLocation::UIntTy SLocSpaceSize = Record[1];
       std::tie(F.SLocEntryBaseID, F.SLocEntryBaseOffset) =
           SourceMgr.AllocateLoadedSLocEntries(F.LocalNumSLocEntries,
                                               SLocSpaceSize);
@@ -2830,7 +2831,7 @@ ASTReader::ReadASTBlock(ModuleFile &F, unsigned ClientLoadCapabilities) {
       F.FirstLoc = SourceLocation::getFromRawEncoding(F.SLocEntryBaseOffset);
 
       // SLocEntryBaseOffset is lower than MaxLoadedOffset and decreasing.
-      assert((F.SLocEntryBaseOffset & (1U << 31U)) == 0);
+      assert(F.SLocEntryBaseOffset < SourceManager::MaxLoadedOffset);
       GlobalSLocOffsetMap.insert(
           std::make_pair(SourceManager::MaxLoadedOffset - F.SLocEntryBaseOffset
                            - SLocSpaceSize,&F));
@@ -2839,8 +2840,8 @@ ASTReader::ReadASTBlock(ModuleFile &F, unsigned ClientLoadCapabilities) {
       // Invalid stays invalid.
       F.SLocRemap.insertOrReplace(std::make_pair(0U, 0));
       // This module. Base was 2 when being compiled.
-      F.SLocRemap.insertOrReplace(std::make_pair(2U,
-                                  static_cast<int>(F.SLocEntryBaseOffset - 2)));
+      F.SLocRemap.insertOrReplace(std::make_pair(
+          2U, static_cast<SourceLocation::IntTy>(F.SLocEntryBaseOffset - 2)));
       
       TotalNumSLocEntries += F.LocalNumSLocEntries;
       break;
@@ -2858,9 +2859,11 @@ ASTReader::ReadASTBlock(ModuleFile &F, unsigned ClientLoadCapabilities) {
       }
 
       // Continuous range maps we may be updating in our module.
+      typedef ContinuousRangeMap<SourceLocation::UIntTy, SourceLocation::IntTy,
+                                 2>::Builder SLocRemapBuilder;
       typedef ContinuousRangeMap<uint32_t, int, 2>::Builder
           RemapBuilder;
-      RemapBuilder SLocRemap(F.SLocRemap);
+      SLocRemapBuilder SLocRemap(F.SLocRemap);
       RemapBuilder IdentifierRemap(F.IdentifierRemap);
       RemapBuilder MacroRemap(F.MacroRemap);
       RemapBuilder PreprocessedEntityRemap(F.PreprocessedEntityRemap);
@@ -2880,8 +2883,8 @@ ASTReader::ReadASTBlock(ModuleFile &F, unsigned ClientLoadCapabilities) {
           return Failure;
         }
 
-        uint32_t SLocOffset =
-            endian::readNext<uint32_t, little, unaligned>(Data);
+        SourceLocation::UIntTy SLocOffset =
+            endian::readNext<SourceLocation::UIntTy, little, unaligned>(Data);
         uint32_t IdentifierIDOffset =
             endian::readNext<uint32_t, little, unaligned>(Data);
         uint32_t MacroIDOffset =
@@ -2905,7 +2908,10 @@ ASTReader::ReadASTBlock(ModuleFile &F, unsigned ClientLoadCapabilities) {
             Remap.insert(std::make_pair(Offset,
                                         static_cast<int>(BaseOffset - Offset)));
         };
-        mapOffset(SLocOffset, OM->SLocEntryBaseOffset, SLocRemap);
+        if (SLocOffset != std::numeric_limits<SourceLocation::UIntTy>::max())
+          SLocRemap.insert(std::make_pair(
+              SLocOffset, static_cast<SourceLocation::IntTy>(
+                              OM->SLocEntryBaseOffset - SLocOffset)));
         mapOffset(IdentifierIDOffset, OM->BaseIdentifierID, IdentifierRemap);
         mapOffset(MacroIDOffset, OM->BaseMacroID, MacroRemap);
         mapOffset(PreprocessedEntityIDOffset, OM->BasePreprocessedEntityID,
@@ -1957,7 +1957,7 @@ void ASTWriter::WriteSourceManagerBlock(SourceManager &SourceMgr,
         assert(InputFileIDs[Content->OrigEntry] != 0 && "Missed file entry");
         Record.push_back(InputFileIDs[Content->OrigEntry]);
 
-        Record.push_back(File.NumCreatedFIDs);
+        Record.push_back(SourceMgr.getNumCreatedFIDsForFileID(FID));
         
         FileDeclIDsTy::iterator FDI = FileDeclIDs.find(FID);
         if (FDI != FileDeclIDs.end()) {
@@ -2023,7 +2023,7 @@ void ASTWriter::WriteSourceManagerBlock(SourceManager &SourceMgr,
                         Record);
 
       // Compute the token length for this macro expansion.
-      unsigned NextOffset = SourceMgr.getNextLocalOffset();
+      SourceLocation::UIntTy NextOffset = SourceMgr.getNextLocalOffset();
       if (I + 1 != N)
         NextOffset = SourceMgr.getLocalSLocEntry(I + 1).getOffset();
       Record.push_back(NextOffset - SLoc->getOffset() - 1);
@@ -4432,8 +4432,12 @@ uint64_t ASTWriter::WriteASTCore(Sema &SemaRef, StringRef isysroot,
         };
 
         // These values should be unique within a chain, since they will be read
-        // as keys into ContinuousRangeMaps.
-        writeBaseIDOrNone(M->SLocEntryBaseOffset, M->LocalNumSLocEntries);
+        // as keys into ContinuousRangeMaps. Source location offsets are as
+        // wide as source locations.
+        LE.write<SourceLocation::UIntTy>(
+            M->LocalNumSLocEntries
+                ? M->SLocEntryBaseOffset
+                : std::numeric_limits<SourceLocation::UIntTy>::max());
         writeBaseIDOrNone(M->BaseIdentifierID, M->LocalNumIdentifiers);
         writeBaseIDOrNone(M->BaseMacroID, M->LocalNumMacros);
         writeBaseIDOrNone(M->BasePreprocessedEntityID,
@@ -4759,8 +4763,10 @@ void ASTWriter::WriteDeclUpdatesBlocks(RecordDataImpl &OffsetsRecord) {
 }
 
 void ASTWriter::AddSourceLocation(SourceLocation Loc, RecordDataImpl &Record) {
-  uint32_t Raw = Loc.getRawEncoding();
-  Record.push_back((Raw << 1) | (Raw >> 31));
+  // Rotate the macro bit to the bottom, so that small file locations stay
+  // small VBR values.
+  SourceLocation::UIntTy Raw = Loc.getRawEncoding();
+  Record.push_back((Raw << 1) | (Raw >> (8 * sizeof(Raw) - 1)));
 }
 
 void ASTWriter::AddSourceRange(SourceRange Range, RecordDataImpl &Record) {
@@ -289,6 +289,10 @@ unsigned AnalyzerOptions::getGraphTrimInterval() {
   return GraphTrimInterval.getValue();
 }
 
+bool AnalyzerOptions::shouldCompactGraph() {
+  return getBooleanOption(CompactGraph, "compact-graph", /*Default=*/false);
+}
+
 unsigned AnalyzerOptions::getMaxTimesInlineLarge() {
   if (!MaxTimesInlineLarge.hasValue())
     MaxTimesInlineLarge = getOptionAsInteger("max-times-inline-large", 32);
@@ -344,3 +348,19 @@ bool AnalyzerOptions::shouldWidenLoops() {
     WidenLoops = getBooleanOption("widen-loops", /*Default=*/false);
   return WidenLoops.getValue();
 }
+
+unsigned AnalyzerOptions::getShardCount() {
+  if (!ShardCount.hasValue())
+    ShardCount = std::max(getOptionAsInteger("shard-count", 1), 1);
+  return ShardCount.getValue();
+}
+
+unsigned AnalyzerOptions::getShardIndex() {
+  if (!ShardIndex.hasValue())
+    ShardIndex = std::max(getOptionAsInteger("shard-index", 0), 0);
+  return ShardIndex.getValue();
+}
+
+StringRef AnalyzerOptions::getSummaryCacheDir() {
+  return getOptionAsString("summary-cache-dir", "");
+}
@@ -26,6 +26,15 @@
 using namespace clang;
 using namespace ento;
 
+#define DEBUG_TYPE "ExplodedGraph"
+
+STATISTIC(NumReclaimedNodes, "The # of exploded nodes reclaimed");
+STATISTIC(NumReclaimedPendingNodes,
+          "The # of exploded nodes reclaimed after getting a successor");
+STATISTIC(NumReclaimedCompactNodes,
+          "The # of exploded nodes reclaimed only because the graph is "
+          "compacted");
+
 //===----------------------------------------------------------------------===//
 // Node auditing.
 //===----------------------------------------------------------------------===//
@@ -48,7 +57,7 @@ void ExplodedNode::SetAuditor(ExplodedNode::Auditor* A) {
 //===----------------------------------------------------------------------===//
 
 ExplodedGraph::ExplodedGraph()
-  : NumNodes(0), ReclaimNodeInterval(0) {}
+  : NumNodes(0), ReclaimNodeInterval(0), CompactNodes(false) {}
 
 ExplodedGraph::~ExplodedGraph() {}
 
@@ -93,6 +102,9 @@ bool ExplodedGraph::shouldCollect(const ExplodedNode *node) {
   // (10) The successor is neither a CallExpr StmtPoint nor a CallEnter or
   //      PreImplicitCall (so that we would be able to find it when retrying a
   //      call with no inlining).
+  //
+  // Conditions 8 and 9 only make path notes more precise. When the graph is
+  // compacted, they are skipped.
   // FIXME: It may be safe to reclaim PreCall and PostCall nodes as well.
 
   // Conditions 1 and 2.
@@ -137,15 +149,18 @@ bool ExplodedGraph::shouldCollect(const ExplodedNode *node) {
   // Condition 8.
   // Do not collect nodes for "interesting" lvalue expressions since they are
   // used extensively for generating path diagnostics.
-  if (isInterestingLValueExpr(Ex))
-    return false;
+  bool KeptForPathNotes = isInterestingLValueExpr(Ex);
 
   // Condition 9.
   // Do not collect nodes for non-consumed Stmt or Expr to ensure precise
   // diagnostic generation; specifically, so that we could anchor arrows
   // pointing to the beginning of statements (as written in code).
-  ParentMap &PM = progPoint.getLocationContext()->getParentMap();
-  if (!PM.isConsumedExpr(Ex))
+  if (!KeptForPathNotes) {
+    ParentMap &PM = progPoint.getLocationContext()->getParentMap();
+    KeptForPathNotes = !PM.isConsumedExpr(Ex);
+  }
+
+  if (KeptForPathNotes && !CompactNodes)
     return false;
 
   // Condition 10.
@@ -158,6 +173,8 @@ bool ExplodedGraph::shouldCollect(const ExplodedNode *node) {
   if (SuccLoc.getAs<CallEnter>() || SuccLoc.getAs<PreImplicitCall>())
     return false;
 
+  if (KeptForPathNotes)
+    ++NumReclaimedCompactNodes;
   return true;
 }
 
@@ -174,6 +191,7 @@ void ExplodedGraph::collectNode(ExplodedNode *node) {
   FreeNodes.push_back(node);
   Nodes.RemoveNode(node);
   --NumNodes;
+  ++NumReclaimedNodes;
   node->~ExplodedNode();
 }
 
@@ -189,11 +207,23 @@ void ExplodedGraph::reclaimRecentlyAllocatedNodes() {
     return;
   ReclaimCounter = ReclaimNodeInterval;
 
+  // The nodes created right before the previous reclamation had no successor
+  // yet. Most of them have one by now.
+  for (ExplodedNode *node : PendingNodes) {
+    if (shouldCollect(node)) {
+      collectNode(node);
+      ++NumReclaimedPendingNodes;
+    }
+  }
+  PendingNodes.clear();
+
   for (NodeVector::iterator it = ChangedNodes.begin(), et = ChangedNodes.end();
        it != et; ++it) {
     ExplodedNode *node = *it;
     if (shouldCollect(node))
       collectNode(node);
+    else if (node->succ_empty() && !node->isSink())
+      PendingNodes.push_back(node);
   }
   ChangedNodes.clear();
 }
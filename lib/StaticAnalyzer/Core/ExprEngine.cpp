@@ -52,6 +52,18 @@ STATISTIC(NumMaxBlockCountReachedInInlined,
             "an inlined function");
 STATISTIC(NumTimesRetriedWithoutInlining,
             "The # of times we re-evaluated a call without inlining");
+STATISTIC(MaxGraphMemory,
+            "The maximum # of bytes allocated for the exploded graph, states "
+            "and values of a top level function");
+STATISTIC(MaxEnvironmentMemory,
+            "The maximum # of bytes allocated for the environments of a top "
+            "level function");
+STATISTIC(MaxStoreMemory,
+            "The maximum # of bytes allocated for the stores of a top level "
+            "function");
+STATISTIC(MaxGDMMemory,
+            "The maximum # of bytes allocated for the generic data maps of a "
+            "top level function");
 
 typedef std::pair<const CXXBindTemporaryExpr *, const StackFrameContext *>
     CXXBindTemporaryContext;
@@ -90,12 +102,22 @@ ExprEngine::ExprEngine(AnalysisManager &mgr, bool gcEnabled,
   unsigned TrimInterval = mgr.options.getGraphTrimInterval();
   if (TrimInterval != 0) {
     // Enable eager node reclaimation when constructing the ExplodedGraph.
-    G.enableNodeReclamation(TrimInterval);
+    G.enableNodeReclamation(TrimInterval, mgr.options.shouldCompactGraph());
   }
 }
 
 ExprEngine::~ExprEngine() {
   BR.FlushReports();
+
+  // The allocators never shrink, so their current size is the peak.
+  auto UpdateMax = [](llvm::Statistic &Max, size_t Bytes) {
+    if (Bytes > Max)
+      Max = static_cast<unsigned>(Bytes);
+  };
+  UpdateMax(MaxGraphMemory, G.getAllocator().getTotalMemory());
+  UpdateMax(MaxEnvironmentMemory, StateMgr.getEnvironmentMemory());
+  UpdateMax(MaxStoreMemory, StateMgr.getStoreMemory());
+  UpdateMax(MaxGDMMemory, StateMgr.getGDMMemory());
 }
 
 //===----------------------------------------------------------------------===//
@@ -72,7 +72,7 @@ ProgramStateManager::ProgramStateManager(ASTContext &Ctx,
                                          ConstraintManagerCreator CreateCMgr,
                                          llvm::BumpPtrAllocator &alloc,
                                          SubEngine *SubEng)
-  : Eng(SubEng), EnvMgr(alloc), GDMFactory(alloc),
+  : Eng(SubEng), EnvMgr(EnvironmentAlloc), GDMFactory(GDMAlloc),
     svalBuilder(createSimpleSValBuilder(alloc, Ctx, *this)),
     CallEventMgr(new CallEventManager(alloc)), Alloc(alloc) {
   StoreMgr = (*CreateSMgr)(*this);
@@ -474,7 +474,7 @@ ProgramStateManager::FindGDMContext(void *K,
 
   std::pair<void*, void (*)(void*)>& p = GDMContexts[K];
   if (!p.first) {
-    p.first = CreateContext(Alloc);
+    p.first = CreateContext(GDMAlloc);
     p.second = DeleteContext;
   }
 
@@ -17,7 +17,8 @@
 #include "clang/StaticAnalyzer/Core/PathSensitive/ProgramState.h"
 #include "clang/StaticAnalyzer/Core/PathSensitive/ProgramStateTrait.h"
 #include "llvm/ADT/FoldingSet.h"
-#include "llvm/ADT/ImmutableSet.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/Support/Allocator.h"
 #include "llvm/Support/Debug.h"
 #include "llvm/Support/raw_ostream.h"
 
@@ -55,68 +56,114 @@ public:
 };
 
 
-class RangeTrait : public llvm::ImutContainerInfo<Range> {
-public:
-  // When comparing if one Range is less than another, we should compare
-  // the actual APSInt values instead of their pointers.  This keeps the order
-  // consistent (instead of comparing by pointer values) and can potentially
-  // be used to speed up some of the operations in RangeSet.
-  static inline bool isLess(key_type_ref lhs, key_type_ref rhs) {
-    return *lhs.first < *rhs.first || (!(*rhs.first < *lhs.first) &&
-                                       *lhs.second < *rhs.second);
-  }
-};
-
 /// RangeSet contains a set of ranges. If the set is empty, then
 ///  there the value of a symbol is overly constrained and there are no
 ///  possible values for that symbol.
+///
+/// The ranges are kept sorted and disjoint in a flat array. The arrays are
+/// uniqued by the Factory, so two RangeSets are equal exactly when they point
+/// to the same array, and a RangeSet is as cheap to copy, compare and hash as
+/// a pointer.
 class RangeSet {
-  typedef llvm::ImmutableSet<Range, RangeTrait> PrimRangeSet;
-  PrimRangeSet ranges; // no need to make const, since it is an
-                       // ImmutableSet - this allows default operator=
-                       // to work.
+  /// A uniqued, immutable array of ranges.
+  class RangeList : public llvm::FoldingSetNode {
+    const Range *Begin;
+    unsigned Size;
+
+  public:
+    RangeList(const Range *Begin, unsigned Size) : Begin(Begin), Size(Size) {}
+
+    ArrayRef<Range> ranges() const { return llvm::makeArrayRef(Begin, Size); }
+
+    static void Profile(llvm::FoldingSetNodeID &ID, ArrayRef<Range> Ranges) {
+      for (const Range &R : Ranges)
+        R.Profile(ID);
+    }
+    void Profile(llvm::FoldingSetNodeID &ID) const { Profile(ID, ranges()); }
+  };
+
+  /// The ranges of the set, or null if the set is empty.
+  const RangeList *List;
+
+  explicit RangeSet(const RangeList *List) : List(List) {}
+
 public:
-  typedef PrimRangeSet::Factory Factory;
-  typedef PrimRangeSet::iterator iterator;
+  class Factory {
+    llvm::BumpPtrAllocator Alloc;
+    llvm::FoldingSet<RangeList> Lists;
+
+  public:
+    RangeSet getEmptySet() { return RangeSet(nullptr); }
+
+    /// Returns the set of the given sorted, disjoint ranges.
+    RangeSet getRangeSet(ArrayRef<Range> Ranges) {
+      if (Ranges.empty())
+        return getEmptySet();
+
+      llvm::FoldingSetNodeID ID;
+      RangeList::Profile(ID, Ranges);
+      void *InsertPos;
+      if (RangeList *L = Lists.FindNodeOrInsertPos(ID, InsertPos))
+        return RangeSet(L);
+
+      Range *Copy = Alloc.Allocate<Range>(Ranges.size());
+      std::uninitialized_copy(Ranges.begin(), Ranges.end(), Copy);
+      RangeList *L = new (Alloc.Allocate<RangeList>())
+          RangeList(Copy, Ranges.size());
+      Lists.InsertNode(L, InsertPos);
+      return RangeSet(L);
+    }
+  };
 
-  RangeSet(PrimRangeSet RS) : ranges(RS) {}
+  typedef const Range *iterator;
 
   /// Create a new set with all ranges of this set and RS.
-  /// Possible intersections are not checked here.
+  /// Ranges present in both sets are added once; other possible
+  /// intersections are not checked here.
   RangeSet addRange(Factory &F, const RangeSet &RS) {
-    PrimRangeSet Ranges(RS.ranges);
-    for (const auto &range : ranges)
-      Ranges = F.add(Ranges, range);
-    return RangeSet(Ranges);
+    SmallVector<Range, 8> Ranges;
+    std::merge(begin(), end(), RS.begin(), RS.end(),
+               std::back_inserter(Ranges),
+               [](const Range &LHS, const Range &RHS) {
+                 return LHS.From() < RHS.From() ||
+                        (!(RHS.From() < LHS.From()) && LHS.To() < RHS.To());
+               });
+    Ranges.erase(std::unique(Ranges.begin(), Ranges.end(),
+                             [](const Range &LHS, const Range &RHS) {
+                               return LHS.From() == RHS.From() &&
+                                      LHS.To() == RHS.To();
+                             }),
+                 Ranges.end());
+    return F.getRangeSet(Ranges);
   }
 
-  iterator begin() const { return ranges.begin(); }
-  iterator end() const { return ranges.end(); }
+  iterator begin() const { return List ? List->ranges().begin() : nullptr; }
+  iterator end() const { return List ? List->ranges().end() : nullptr; }
 
-  bool isEmpty() const { return ranges.isEmpty(); }
+  bool isEmpty() const { return !List; }
 
   /// Construct a new RangeSet representing '{ [from, to] }'.
   RangeSet(Factory &F, const llvm::APSInt &from, const llvm::APSInt &to)
-    : ranges(F.add(F.getEmptySet(), Range(from, to))) {}
+    : RangeSet(F.getRangeSet(Range(from, to))) {}
 
   /// Profile - Generates a hash profile of this RangeSet for use
   ///  by FoldingSet.
-  void Profile(llvm::FoldingSetNodeID &ID) const { ranges.Profile(ID); }
+  void Profile(llvm::FoldingSetNodeID &ID) const { ID.AddPointer(List); }
 
   /// getConcreteValue - If a symbol is contrained to equal a specific integer
   ///  constant then this method returns that value.  Otherwise, it returns
   ///  NULL.
   const llvm::APSInt* getConcreteValue() const {
-    return ranges.isSingleton() ? ranges.begin()->getConcreteValue() : nullptr;
+    return List && List->ranges().size() == 1 ? begin()->getConcreteValue()
+                                              : nullptr;
   }
 
 private:
-  void IntersectInRange(BasicValueFactory &BV, Factory &F,
+  void IntersectInRange(BasicValueFactory &BV,
                         const llvm::APSInt &Lower,
                         const llvm::APSInt &Upper,
-                        PrimRangeSet &newRanges,
-                        PrimRangeSet::iterator &i,
-                        PrimRangeSet::iterator &e) const {
+                        SmallVectorImpl<Range> &newRanges,
+                        iterator &i, iterator e) const {
     // There are six cases for each range R in the set:
     //   1. R is entirely before the intersection range.
     //   2. R is entirely after the intersection range.
@@ -135,24 +182,23 @@ private:
 
       if (i->Includes(Lower)) {
         if (i->Includes(Upper)) {
-          newRanges = F.add(newRanges, Range(BV.getValue(Lower),
-                                             BV.getValue(Upper)));
+          newRanges.push_back(Range(BV.getValue(Lower), BV.getValue(Upper)));
           break;
         } else
-          newRanges = F.add(newRanges, Range(BV.getValue(Lower), i->To()));
+          newRanges.push_back(Range(BV.getValue(Lower), i->To()));
       } else {
         if (i->Includes(Upper)) {
-          newRanges = F.add(newRanges, Range(i->From(), BV.getValue(Upper)));
+          newRanges.push_back(Range(i->From(), BV.getValue(Upper)));
           break;
         } else
-          newRanges = F.add(newRanges, *i);
+          newRanges.push_back(*i);
       }
     }
   }
 
   const llvm::APSInt &getMinValue() const {
     assert(!isEmpty());
-    return ranges.begin()->From();
+    return begin()->From();
   }
 
   bool pin(llvm::APSInt &Lower, llvm::APSInt &Upper) const {
@@ -249,20 +295,20 @@ public:
     if (!pin(Lower, Upper))
       return F.getEmptySet();
 
-    PrimRangeSet newRanges = F.getEmptySet();
+    SmallVector<Range, 8> newRanges;
 
-    PrimRangeSet::iterator i = begin(), e = end();
+    iterator i = begin(), e = end();
     if (Lower <= Upper)
-      IntersectInRange(BV, F, Lower, Upper, newRanges, i, e);
+      IntersectInRange(BV, Lower, Upper, newRanges, i, e);
     else {
       // The order of the next two statements is important!
-      // IntersectInRange() does not reset the iteration state for i and e.
+      // IntersectInRange() does not reset the iteration state for i.
       // Therefore, the lower range most be handled first.
-      IntersectInRange(BV, F, BV.getMinValue(Upper), Upper, newRanges, i, e);
-      IntersectInRange(BV, F, Lower, BV.getMaxValue(Lower), newRanges, i, e);
+      IntersectInRange(BV, BV.getMinValue(Upper), Upper, newRanges, i, e);
+      IntersectInRange(BV, Lower, BV.getMaxValue(Lower), newRanges, i, e);
     }
 
-    return newRanges;
+    return F.getRangeSet(newRanges);
   }
 
   void print(raw_ostream &os) const {
@@ -281,7 +327,7 @@ public:
   }
 
   bool operator==(const RangeSet &other) const {
-    return ranges == other.ranges;
+    return List == other.List;
   }
 };
 } // end anonymous namespace
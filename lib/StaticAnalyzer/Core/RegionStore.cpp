@@ -316,6 +316,10 @@ class RegionStoreManager : public StoreManager {
 public:
   const RegionStoreFeatures Features;
 
+  /// Holds the binding maps, apart from the other analysis data so that
+  /// their size can be reported.
+  llvm::BumpPtrAllocator BindingsAlloc;
+
   RegionBindings::Factory RBFactory;
   mutable ClusterBindings::Factory CBFactory;
 
@@ -344,7 +348,7 @@ private:
 public:
   RegionStoreManager(ProgramStateManager& mgr, const RegionStoreFeatures &f)
     : StoreManager(mgr), Features(f),
-      RBFactory(mgr.getAllocator()), CBFactory(mgr.getAllocator()),
+      RBFactory(BindingsAlloc), CBFactory(BindingsAlloc),
       SmallStructLimit(0) {
     if (SubEngine *Eng = StateMgr.getOwningEngine()) {
       AnalyzerOptions &Options = Eng->getAnalysisManager().options;
@@ -575,6 +579,10 @@ public: // Part of public interface to class.
                              RBFactory.getTreeFactory());
   }
 
+  size_t getTotalMemory() const override {
+    return BindingsAlloc.getTotalMemory();
+  }
+
   void print(Store store, raw_ostream &Out, const char* nl,
              const char *sep) override;
 
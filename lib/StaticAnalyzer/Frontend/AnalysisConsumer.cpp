@@ -12,6 +12,7 @@
 //===----------------------------------------------------------------------===//
 
 #include "clang/StaticAnalyzer/Frontend/AnalysisConsumer.h"
+#include "AnalysisSummaryCache.h"
 #include "ModelInjector.h"
 #include "clang/AST/ASTConsumer.h"
 #include "clang/AST/RecursiveASTVisitor.h"
@@ -26,6 +27,7 @@
 #include "clang/Basic/FileManager.h"
 #include "clang/Basic/SourceManager.h"
 #include "clang/Frontend/CompilerInstance.h"
+#include "clang/Index/USRGeneration.h"
 #include "clang/Lex/Preprocessor.h"
 #include "clang/StaticAnalyzer/Checkers/LocalCheckers.h"
 #include "clang/StaticAnalyzer/Core/AnalyzerOptions.h"
@@ -37,9 +39,12 @@
 #include "clang/StaticAnalyzer/Core/PathSensitive/ExprEngine.h"
 #include "clang/StaticAnalyzer/Frontend/CheckerRegistration.h"
 #include "llvm/ADT/DepthFirstIterator.h"
+#include "llvm/ADT/EquivalenceClasses.h"
+#include "llvm/ADT/MapVector.h"
 #include "llvm/ADT/PostOrderIterator.h"
 #include "llvm/ADT/SmallPtrSet.h"
 #include "llvm/ADT/Statistic.h"
+#include "llvm/ADT/StringMap.h"
 #include "llvm/Support/FileSystem.h"
 #include "llvm/Support/Path.h"
 #include "llvm/Support/Program.h"
@@ -64,6 +69,9 @@ STATISTIC(NumBlocksInAnalyzedFunctions,
                       "The # of basic blocks in the analyzed functions.");
 STATISTIC(PercentReachableBlocks, "The % of reachable basic blocks.");
 STATISTIC(MaxCFGSize, "The maximum number of basic blocks in a function.");
+STATISTIC(NumFunctionsSkippedFromSummaryCache,
+                      "The # of functions not analyzed because the summary "
+                      "cache showed that they have no bugs.");
 
 //===----------------------------------------------------------------------===//
 // Special PathDiagnosticConsumers.
@@ -161,6 +169,7 @@ public:
   AnalyzerOptionsRef Opts;
   ArrayRef<std::string> Plugins;
   CodeInjector *Injector;
+  std::unique_ptr<AnalysisSummaryCache> SummaryCache;
 
   /// \brief Stores the declarations from the local translation unit.
   /// Note, we pre-compute the local declarations at parse time as an
@@ -185,13 +194,18 @@ public:
   /// translation unit.
   FunctionSummariesTy FunctionSummaries;
 
+  /// The number of bug reports found by the path-sensitive analyzes so far.
+  unsigned NumPathSensitiveReports;
+
   AnalysisConsumer(const Preprocessor& pp,
                    const std::string& outdir,
                    AnalyzerOptionsRef opts,
                    ArrayRef<std::string> plugins,
-                   CodeInjector *injector)
+                   CodeInjector *injector,
+                   std::unique_ptr<AnalysisSummaryCache> summaryCache)
     : RecVisitorMode(0), RecVisitorBR(nullptr), Ctx(nullptr), PP(pp),
-      OutDir(outdir), Opts(opts), Plugins(plugins), Injector(injector) {
+      OutDir(outdir), Opts(opts), Plugins(plugins), Injector(injector),
+      SummaryCache(std::move(summaryCache)), NumPathSensitiveReports(0) {
     DigestAnalyzerOptions();
     if (Opts->PrintStats) {
       llvm::EnableStatistics();
@@ -454,6 +468,64 @@ AnalysisConsumer::getInliningModeForFunction(const Decl *D,
   return ExprEngine::Inline_Regular;
 }
 
+/// \brief Splits the functions of a call graph into \p NumShards groups of
+/// about the same size.
+///
+/// Functions connected by calls end up in the same shard, so that inlining
+/// and the "do not reanalyze previously inlined function" heuristic work as
+/// if the whole translation unit was analyzed at once. The assignment only
+/// depends on the order of \p Nodes, which is the same in every analyzer
+/// invocation on the translation unit.
+static llvm::DenseMap<const Decl *, unsigned>
+assignShards(ArrayRef<CallGraphNode *> Nodes, unsigned NumShards) {
+  // Calls to functions without a body can't be inlined, so they don't tie
+  // their callers together.
+  llvm::EquivalenceClasses<const Decl *> Components;
+  for (CallGraphNode *N : Nodes) {
+    const Decl *D = N->getDecl();
+    if (!D || !D->hasBody())
+      continue;
+    Components.insert(D);
+    for (CallGraphNode *Callee : *N) {
+      const Decl *CalleeD = Callee->getDecl();
+      if (CalleeD && CalleeD->hasBody())
+        Components.unionSets(D, CalleeD);
+    }
+  }
+
+  llvm::MapVector<const Decl *, unsigned> ComponentSizes;
+  for (CallGraphNode *N : Nodes) {
+    const Decl *D = N->getDecl();
+    if (D && D->hasBody())
+      ++ComponentSizes[Components.getLeaderValue(D)];
+  }
+
+  // Hand out the largest components first, each to the least loaded shard.
+  std::vector<std::pair<const Decl *, unsigned>> Sorted(ComponentSizes.begin(),
+                                                        ComponentSizes.end());
+  std::stable_sort(Sorted.begin(), Sorted.end(),
+                   [](const std::pair<const Decl *, unsigned> &LHS,
+                      const std::pair<const Decl *, unsigned> &RHS) {
+                     return LHS.second > RHS.second;
+                   });
+  std::vector<unsigned> ShardSizes(NumShards, 0);
+  llvm::DenseMap<const Decl *, unsigned> ShardOfComponent;
+  for (const auto &Component : Sorted) {
+    unsigned Shard = std::min_element(ShardSizes.begin(), ShardSizes.end()) -
+                     ShardSizes.begin();
+    ShardSizes[Shard] += Component.second;
+    ShardOfComponent[Component.first] = Shard;
+  }
+
+  llvm::DenseMap<const Decl *, unsigned> ShardOfDecl;
+  for (CallGraphNode *N : Nodes) {
+    const Decl *D = N->getDecl();
+    if (D && D->hasBody())
+      ShardOfDecl[D] = ShardOfComponent[Components.getLeaderValue(D)];
+  }
+  return ShardOfDecl;
+}
+
 void AnalysisConsumer::HandleDeclsCallGraph(const unsigned LocalTUDeclsSize) {
   // Build the Call Graph by adding all the top level declarations to the graph.
   // Note: CallGraph can trigger deserialization of more items from a pch
@@ -473,6 +545,26 @@ void AnalysisConsumer::HandleDeclsCallGraph(const unsigned LocalTUDeclsSize) {
   SetOfConstDecls Visited;
   SetOfConstDecls VisitedAsTopLevel;
   llvm::ReversePostOrderTraversal<clang::CallGraph*> RPOT(&CG);
+
+  // If the functions are split into shards, only analyze our own.
+  const unsigned NumShards = Opts->getShardCount();
+  llvm::DenseMap<const Decl *, unsigned> ShardOfDecl;
+  if (NumShards > 1)
+    ShardOfDecl = assignShards(
+        SmallVector<CallGraphNode *, 32>(RPOT.begin(), RPOT.end()), NumShards);
+
+  // The summary cache refers to the functions inlined by a previous analysis
+  // by their USRs.
+  llvm::StringMap<const Decl *> DeclsByUSR;
+  if (SummaryCache) {
+    for (CallGraphNode *N : RPOT) {
+      const Decl *D = N->getDecl();
+      SmallString<128> USR;
+      if (D && !index::generateUSRForDecl(D, USR))
+        DeclsByUSR[USR] = D;
+    }
+  }
+
   for (llvm::ReversePostOrderTraversal<clang::CallGraph*>::rpo_iterator
          I = RPOT.begin(), E = RPOT.end(); I != E; ++I) {
     NumFunctionTopLevel++;
@@ -484,16 +576,37 @@ void AnalysisConsumer::HandleDeclsCallGraph(const unsigned LocalTUDeclsSize) {
     if (!D)
       continue;
 
+    if (NumShards > 1 && ShardOfDecl.lookup(D) != Opts->getShardIndex())
+      continue;
+
     // Skip the functions which have been processed already or previously
     // inlined.
     if (shouldSkipFunction(D, Visited, VisitedAsTopLevel))
       continue;
 
-    // Analyze the function.
-    SetOfConstDecls VisitedCallees;
+    // Only functions analyzed path-sensitively may be found in the summary
+    // cache, or added to it.
+    const FunctionDecl *CachedFD = nullptr;
+    if (SummaryCache && checkerMgr->hasPathSensitiveCheckers() &&
+        (getModeForDecl(D, AM_Path) & AM_Path))
+      CachedFD = dyn_cast<FunctionDecl>(D);
 
-    HandleCode(D, AM_Path, getInliningModeForFunction(D, Visited),
-               (Mgr->options.InliningMode == All ? nullptr : &VisitedCallees));
+    // Analyze the function, unless a previous analysis found no bugs.
+    SetOfConstDecls VisitedCallees;
+    std::vector<std::string> InlinedUSRs;
+    if (CachedFD && SummaryCache->lookup(CachedFD, InlinedUSRs)) {
+      ++NumFunctionsSkippedFromSummaryCache;
+      for (const std::string &USR : InlinedUSRs)
+        if (const Decl *Callee = DeclsByUSR.lookup(USR))
+          VisitedCallees.insert(Callee);
+    } else {
+      unsigned NumReportsBefore = NumPathSensitiveReports;
+      HandleCode(D, AM_Path, getInliningModeForFunction(D, Visited),
+                 (Mgr->options.InliningMode == All ? nullptr
+                                                   : &VisitedCallees));
+      if (CachedFD && NumPathSensitiveReports == NumReportsBefore)
+        SummaryCache->store(CachedFD, VisitedCallees);
+    }
 
     // Add the visited callees to the global visited set.
     for (const Decl *Callee : VisitedCallees)
@@ -522,7 +635,12 @@ void AnalysisConsumer::HandleTranslationUnit(ASTContext &C) {
     // Introduce a scope to destroy BR before Mgr.
     BugReporter BR(*Mgr);
     TranslationUnitDecl *TU = C.getTranslationUnitDecl();
-    checkerMgr->runCheckersOnASTDecl(TU, *Mgr, BR);
+
+    // If the functions are split into shards, the checks that don't belong
+    // to a shard only run in the first one.
+    const bool IsFirstShard = Opts->getShardIndex() == 0;
+    if (IsFirstShard)
+      checkerMgr->runCheckersOnASTDecl(TU, *Mgr, BR);
 
     // Run the AST-only checks using the order in which functions are defined.
     // If inlining is not turned on, use the simplest function order for path
@@ -539,15 +657,18 @@ void AnalysisConsumer::HandleTranslationUnit(ASTContext &C) {
     // random access.  By doing so, we automatically compensate for iterators
     // possibly being invalidated, although this is a bit slower.
     const unsigned LocalTUDeclsSize = LocalTUDecls.size();
-    for (unsigned i = 0 ; i < LocalTUDeclsSize ; ++i) {
-      TraverseDecl(LocalTUDecls[i]);
+    if (IsFirstShard) {
+      for (unsigned i = 0 ; i < LocalTUDeclsSize ; ++i) {
+        TraverseDecl(LocalTUDecls[i]);
+      }
     }
 
     if (Mgr->shouldInlineCall())
       HandleDeclsCallGraph(LocalTUDeclsSize);
 
     // After all decls handled, run checkers on the entire TranslationUnit.
-    checkerMgr->runCheckersOnEndOfTranslationUnit(TU, *Mgr, BR);
+    if (IsFirstShard)
+      checkerMgr->runCheckersOnEndOfTranslationUnit(TU, *Mgr, BR);
 
     RecVisitorBR = nullptr;
   }
@@ -673,7 +794,10 @@ void AnalysisConsumer::ActionExprEngine(Decl *D, bool ObjCGCEnabled,
     Eng.ViewGraph(Mgr->options.TrimGraph);
 
   // Display warnings.
-  Eng.getBugReporter().FlushReports();
+  BugReporter &BR = Eng.getBugReporter();
+  BR.FlushReports();
+  NumPathSensitiveReports +=
+      std::distance(BR.EQClasses_begin(), BR.EQClasses_end());
 }
 
 void AnalysisConsumer::RunPathSensitiveChecks(Decl *D,
@@ -700,6 +824,15 @@ void AnalysisConsumer::RunPathSensitiveChecks(Decl *D,
 // AnalysisConsumer creation.
 //===----------------------------------------------------------------------===//
 
+/// \brief Returns the path each shard writes its output file to, so that
+/// shards analyzing the same translation unit concurrently don't overwrite
+/// each other's reports: \c "out.plist" becomes \c "out.shard1.plist".
+static std::string getShardOutputPath(StringRef Path, unsigned ShardIndex) {
+  StringRef Extension = llvm::sys::path::extension(Path);
+  return (Path.drop_back(Extension.size()) + ".shard" + Twine(ShardIndex) +
+          Extension).str();
+}
+
 std::unique_ptr<AnalysisASTConsumer>
 ento::CreateAnalysisConsumer(CompilerInstance &CI) {
   // Disable the effects of '-Werror' when using the AnalysisConsumer.
@@ -708,10 +841,22 @@ ento::CreateAnalysisConsumer(CompilerInstance &CI) {
   AnalyzerOptionsRef analyzerOpts = CI.getAnalyzerOpts();
   bool hasModelPath = analyzerOpts->Config.count("model-path") > 0;
 
+  std::unique_ptr<AnalysisSummaryCache> summaryCache;
+  StringRef summaryCacheDir = analyzerOpts->getSummaryCacheDir();
+  if (!summaryCacheDir.empty())
+    summaryCache = llvm::make_unique<AnalysisSummaryCache>(CI, summaryCacheDir);
+
+  // HTML reports get unique names in the output directory, so the shards can
+  // share it (and scan-build finds all their reports there).
+  std::string outputPath = CI.getFrontendOpts().OutputFile;
+  if (analyzerOpts->getShardCount() > 1 && !outputPath.empty() &&
+      analyzerOpts->AnalysisDiagOpt != PD_HTML)
+    outputPath = getShardOutputPath(outputPath, analyzerOpts->getShardIndex());
+
   return llvm::make_unique<AnalysisConsumer>(
-      CI.getPreprocessor(), CI.getFrontendOpts().OutputFile, analyzerOpts,
+      CI.getPreprocessor(), outputPath, analyzerOpts,
       CI.getFrontendOpts().Plugins,
-      hasModelPath ? new ModelInjector(CI) : nullptr);
+      hasModelPath ? new ModelInjector(CI) : nullptr, std::move(summaryCache));
 }
 
 //===----------------------------------------------------------------------===//
@@ -0,0 +1,350 @@
+//===-- AnalysisSummaryCache.cpp --------------------------------*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "AnalysisSummaryCache.h"
+#include "clang/AST/DeclCXX.h"
+#include "clang/AST/ExprCXX.h"
+#include "clang/AST/ExprObjC.h"
+#include "clang/AST/RecursiveASTVisitor.h"
+#include "clang/AST/PrettyPrinter.h"
+#include "clang/Frontend/CompilerInstance.h"
+#include "clang/Index/USRGeneration.h"
+#include "clang/StaticAnalyzer/Core/AnalyzerOptions.h"
+#include "llvm/ADT/SetVector.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/MD5.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/Path.h"
+#include "llvm/Support/raw_ostream.h"
+#include <algorithm>
+
+using namespace clang;
+using namespace ento;
+
+static std::string hashToString(llvm::MD5 &Hash) {
+  llvm::MD5::MD5Result Result;
+  Hash.final(Result);
+  SmallString<32> Str;
+  llvm::MD5::stringifyResult(Result, Str);
+  return Str.str();
+}
+
+static bool getUSR(const Decl *D, SmallVectorImpl<char> &USR) {
+  return !index::generateUSRForDecl(D, USR);
+}
+
+namespace {
+/// Collects the declarations the analysis of a function may look at: the
+/// functions it may inline, transitively, and the variables and types they
+/// refer to.
+class DependencyCollector : public RecursiveASTVisitor<DependencyCollector> {
+  llvm::SetVector<const Decl *> Dependencies;
+  SmallVector<const FunctionDecl *, 16> Worklist;
+  bool HasDynamicDispatch;
+
+  void addFunction(const FunctionDecl *FD) {
+    const FunctionDecl *Definition = nullptr;
+    if (FD->hasBody(Definition))
+      FD = Definition;
+    if (Dependencies.insert(FD) && Definition)
+      Worklist.push_back(FD);
+  }
+
+  void addDecl(const Decl *D) {
+    if (const FunctionDecl *FD = dyn_cast<FunctionDecl>(D)) {
+      if (const CXXMethodDecl *MD = dyn_cast<CXXMethodDecl>(FD))
+        if (MD->isVirtual())
+          HasDynamicDispatch = true;
+      addFunction(FD);
+      return;
+    }
+    // Parameters are part of the function, which is a dependency already.
+    if (isa<ParmVarDecl>(D))
+      return;
+    if (isa<FieldDecl>(D) || isa<IndirectFieldDecl>(D) ||
+        isa<EnumConstantDecl>(D))
+      D = cast<Decl>(D->getDeclContext());
+    if (const VarDecl *VD = dyn_cast<VarDecl>(D))
+      if (const VarDecl *Definition = VD->getDefinition())
+        D = Definition;
+    Dependencies.insert(D);
+  }
+
+  void addType(QualType T) {
+    // The typedefs and alias templates a type is spelled with are
+    // declarations too, and their text may change without the type's.
+    while (true) {
+      const Type *Ty = T.getTypePtr();
+      if (const TypedefType *TT = dyn_cast<TypedefType>(Ty)) {
+        Dependencies.insert(TT->getDecl());
+      } else if (const TemplateSpecializationType *TST =
+                     dyn_cast<TemplateSpecializationType>(Ty)) {
+        if (TST->isTypeAlias())
+          if (const TemplateDecl *TD =
+                  TST->getTemplateName().getAsTemplateDecl())
+            Dependencies.insert(TD);
+      }
+      QualType Desugared = Ty->getLocallyUnqualifiedSingleStepDesugaredType();
+      if (Desugared.getTypePtr() == Ty)
+        break;
+      T = Desugared;
+    }
+
+    QualType Pointee = T->getPointeeType();
+    if (!Pointee.isNull())
+      addType(Pointee);
+    else if (const ArrayType *AT = dyn_cast<ArrayType>(T.getTypePtr()))
+      addType(AT->getElementType());
+
+    if (const CXXRecordDecl *RD = T->getAsCXXRecordDecl()) {
+      if (RD->hasDefinition()) {
+        RD = RD->getDefinition();
+        if (const CXXDestructorDecl *DD = RD->getDestructor())
+          addDecl(DD);
+      }
+      Dependencies.insert(RD);
+    } else if (const TagDecl *TD = T->getAsTagDecl()) {
+      if (const TagDecl *Definition = TD->getDefinition())
+        TD = Definition;
+      Dependencies.insert(TD);
+    }
+  }
+
+public:
+  DependencyCollector() : HasDynamicDispatch(false) {}
+
+  /// Returns false if the dependencies of \p FD can't be determined.
+  bool collect(const FunctionDecl *FD) {
+    addFunction(FD);
+    while (!Worklist.empty() && !HasDynamicDispatch)
+      TraverseDecl(const_cast<FunctionDecl *>(Worklist.pop_back_val()));
+    return !HasDynamicDispatch;
+  }
+
+  const llvm::SetVector<const Decl *> &getDependencies() const {
+    return Dependencies;
+  }
+
+  bool shouldVisitImplicitCode() const { return true; }
+  bool shouldVisitTemplateInstantiations() const { return true; }
+
+  bool VisitDeclRefExpr(DeclRefExpr *E) {
+    addDecl(E->getDecl());
+    return true;
+  }
+
+  bool VisitMemberExpr(MemberExpr *E) {
+    addDecl(E->getMemberDecl());
+    return true;
+  }
+
+  bool VisitCXXConstructExpr(CXXConstructExpr *E) {
+    addDecl(E->getConstructor());
+    return true;
+  }
+
+  bool VisitCXXNewExpr(CXXNewExpr *E) {
+    if (FunctionDecl *OperatorNew = E->getOperatorNew())
+      addDecl(OperatorNew);
+    return true;
+  }
+
+  bool VisitCXXDeleteExpr(CXXDeleteExpr *E) {
+    if (FunctionDecl *OperatorDelete = E->getOperatorDelete())
+      addDecl(OperatorDelete);
+    addType(E->getDestroyedType());
+    return true;
+  }
+
+  bool VisitExpr(Expr *E) {
+    addType(E->getType());
+    return true;
+  }
+
+  bool VisitUnaryExprOrTypeTraitExpr(UnaryExprOrTypeTraitExpr *E) {
+    if (E->isArgumentType())
+      addType(E->getArgumentType());
+    return true;
+  }
+
+  bool VisitExplicitCastExpr(ExplicitCastExpr *E) {
+    addType(E->getTypeAsWritten());
+    return true;
+  }
+
+  bool VisitDeclStmt(DeclStmt *S) {
+    for (const Decl *D : S->decls())
+      if (const VarDecl *VD = dyn_cast<VarDecl>(D))
+        addType(VD->getType());
+    return true;
+  }
+
+  bool VisitObjCMessageExpr(ObjCMessageExpr *E) {
+    HasDynamicDispatch = true;
+    return true;
+  }
+};
+} // end anonymous namespace
+
+AnalysisSummaryCache::AnalysisSummaryCache(CompilerInstance &CI, StringRef Dir)
+    : Dir(Dir) {
+  // Hash everything that affects the outcome of the analysis, other than the
+  // code being analyzed. The module hash covers the compiler version, the
+  // language and target options, and the macros defined on the command line.
+  llvm::MD5 Hash;
+  Hash.update(CI.getInvocation().getModuleHash());
+
+  const AnalyzerOptions &Opts = *CI.getAnalyzerOpts();
+  for (const auto &Checker : Opts.CheckersControlList) {
+    Hash.update(Checker.first);
+    Hash.update(Checker.second ? "+" : "-");
+  }
+  for (const std::string &Plugin : CI.getFrontendOpts().Plugins)
+    Hash.update(Plugin);
+
+  // The options which only decide which functions this invocation analyzes
+  // don't change the outcome of analyzing a function.
+  std::vector<std::pair<StringRef, StringRef>> Config;
+  for (const auto &Option : Opts.Config)
+    if (Option.getKey() != "summary-cache-dir" &&
+        Option.getKey() != "shard-count" && Option.getKey() != "shard-index")
+      Config.push_back(std::make_pair(Option.getKey(), Option.getValue()));
+  std::sort(Config.begin(), Config.end());
+  for (const auto &Option : Config) {
+    Hash.update(Option.first);
+    Hash.update("=");
+    Hash.update(Option.second);
+    Hash.update("\n");
+  }
+
+  std::string Flags;
+  llvm::raw_string_ostream OS(Flags);
+  OS << Opts.AnalysisStoreOpt << ',' << Opts.AnalysisConstraintsOpt << ','
+     << Opts.AnalysisPurgeOpt << ',' << Opts.maxBlockVisitOnPath << ','
+     << Opts.AnalyzeAll << ',' << Opts.AnalyzeNestedBlocks << ','
+     << Opts.eagerlyAssumeBinOpBifurcation << ',' << Opts.UnoptimizedCFG << ','
+     << Opts.NoRetryExhausted << ',' << Opts.InlineMaxStackDepth << ','
+     << Opts.InliningMode;
+  Hash.update(OS.str());
+
+  ConfigHash = hashToString(Hash);
+}
+
+std::string AnalysisSummaryCache::getDeclHash(const Decl *D) {
+  std::string &DeclHash = DeclHashes[D];
+  if (DeclHash.empty()) {
+    // Declarations are hashed as the compiler sees them, so that changes to
+    // the macros they use are noticed.
+    std::string Text;
+    llvm::raw_string_ostream OS(Text);
+    SmallString<128> USR;
+    if (getUSR(D, USR))
+      OS << USR << '\n';
+    D->print(OS, PrintingPolicy(D->getASTContext().getLangOpts()));
+
+    llvm::MD5 Hash;
+    Hash.update(OS.str());
+    DeclHash = hashToString(Hash);
+  }
+  return DeclHash;
+}
+
+Optional<std::string> AnalysisSummaryCache::getKey(const FunctionDecl *D) {
+  DependencyCollector Collector;
+  if (!Collector.collect(D))
+    return None;
+
+  // The key doesn't depend on the order in which the dependencies were found,
+  // nor on where they are, so that a function gets the same key in every
+  // translation unit that contains it.
+  std::vector<std::string> Hashes;
+  for (const Decl *Dependency : Collector.getDependencies())
+    Hashes.push_back(getDeclHash(Dependency));
+  std::sort(Hashes.begin(), Hashes.end());
+
+  llvm::MD5 Hash;
+  Hash.update(ConfigHash);
+  for (const std::string &DeclHash : Hashes)
+    Hash.update(DeclHash);
+  return hashToString(Hash);
+}
+
+std::string AnalysisSummaryCache::getSummaryPath(StringRef USR) {
+  llvm::MD5 Hash;
+  Hash.update(USR);
+  SmallString<128> Path(Dir);
+  llvm::sys::path::append(Path, hashToString(Hash) + ".summary");
+  return Path.str();
+}
+
+bool AnalysisSummaryCache::lookup(const FunctionDecl *D,
+                                  std::vector<std::string> &InlinedUSRs) {
+  SmallString<128> USR;
+  if (!getUSR(D, USR))
+    return false;
+
+  llvm::ErrorOr<std::unique_ptr<llvm::MemoryBuffer>> Summary =
+      llvm::MemoryBuffer::getFile(getSummaryPath(USR));
+  if (!Summary)
+    return false;
+
+  // The first line of a summary is the key the function had when it was
+  // analyzed, and the following lines the USRs of the inlined functions.
+  SmallVector<StringRef, 16> Lines;
+  (*Summary)->getBuffer().split(Lines, '\n', /*MaxSplit=*/-1,
+                                /*KeepEmpty=*/false);
+  if (Lines.empty())
+    return false;
+
+  Optional<std::string> Key = getKey(D);
+  if (!Key || Lines[0] != *Key)
+    return false;
+
+  InlinedUSRs.assign(Lines.begin() + 1, Lines.end());
+  return true;
+}
+
+void AnalysisSummaryCache::store(const FunctionDecl *D,
+                                 const SetOfConstDecls &Inlined) {
+  SmallString<128> USR;
+  if (!getUSR(D, USR))
+    return;
+
+  Optional<std::string> Key = getKey(D);
+  if (!Key)
+    return;
+
+  if (llvm::sys::fs::create_directories(Dir))
+    return;
+
+  // Write the summary to a temporary file first, so that concurrent analyzer
+  // invocations never see a partially written summary.
+  std::string Path = getSummaryPath(USR);
+  SmallString<128> TempPath;
+  int FD;
+  if (llvm::sys::fs::createUniqueFile(Path + "-%%%%%%%%", FD, TempPath))
+    return;
+
+  bool Failed;
+  {
+    llvm::raw_fd_ostream OS(FD, /*shouldClose=*/true);
+    OS << *Key << '\n';
+    for (const Decl *Callee : Inlined) {
+      SmallString<128> CalleeUSR;
+      if (getUSR(Callee, CalleeUSR))
+        OS << CalleeUSR << '\n';
+    }
+    OS.close();
+    Failed = OS.has_error();
+    OS.clear_error();
+  }
+
+  if (Failed || llvm::sys::fs::rename(TempPath, Path))
+    llvm::sys::fs::remove(TempPath);
+}
@@ -0,0 +1,83 @@
+//===-- AnalysisSummaryCache.h ----------------------------------*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file
+/// \brief This file defines the clang::ento::AnalysisSummaryCache class, which
+/// remembers the outcome of analyzing top level functions between analyzer
+/// invocations.
+///
+/// A summary is kept on disk for every function that was analyzed without
+/// finding bugs. It is keyed by the USR of the function, and records a hash of
+/// the analyzer configuration and of everything the analysis of the function
+/// may have looked at: the function, the functions it may inline, and the
+/// variables and types they refer to. As long as this hash does not change,
+/// analyzing the function again would not find bugs either, so the function
+/// can be skipped, in this or in any other translation unit.
+///
+/// Functions whose analysis depends on dynamic dispatch are never cached, as
+/// the analyzer may inline method definitions they don't refer to.
+///
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_CLANG_SA_FRONTEND_ANALYSISSUMMARYCACHE_H
+#define LLVM_CLANG_SA_FRONTEND_ANALYSISSUMMARYCACHE_H
+
+#include "clang/Basic/LLVM.h"
+#include "clang/StaticAnalyzer/Core/PathSensitive/FunctionSummary.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/Optional.h"
+#include <string>
+#include <vector>
+
+namespace clang {
+
+class CompilerInstance;
+class Decl;
+class FunctionDecl;
+
+namespace ento {
+class AnalysisSummaryCache {
+public:
+  /// \brief Creates a cache which keeps its summaries in \p Dir.
+  AnalysisSummaryCache(CompilerInstance &CI, StringRef Dir);
+
+  /// \brief Checks whether a previous analysis of \p D found no bugs, and
+  /// nothing it depends on has changed since.
+  ///
+  /// \param InlinedUSRs - The output parameter, which is populated with the
+  /// USRs of the functions the previous analysis inlined.
+  bool lookup(const FunctionDecl *D, std::vector<std::string> &InlinedUSRs);
+
+  /// \brief Records that analyzing \p D found no bugs.
+  ///
+  /// \param Inlined - The functions inlined while analyzing \p D.
+  void store(const FunctionDecl *D, const SetOfConstDecls &Inlined);
+
+private:
+  /// \brief Computes the hash of everything the analysis of \p D depends on,
+  /// or None if \p D can't be cached.
+  Optional<std::string> getKey(const FunctionDecl *D);
+
+  /// \brief Returns the hash of the definition of \p D.
+  std::string getDeclHash(const Decl *D);
+
+  /// \brief Returns the path of the summary of the function with USR \p USR.
+  std::string getSummaryPath(StringRef USR);
+
+  std::string Dir;
+
+  /// The hash of the compiler and analyzer configuration.
+  std::string ConfigHash;
+
+  llvm::DenseMap<const Decl *, std::string> DeclHashes;
+};
+}
+}
+
+#endif
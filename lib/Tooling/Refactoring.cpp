@@ -33,6 +33,11 @@ RefactoringTool::RefactoringTool(
 
 Replacements &RefactoringTool::getReplacements() { return Replace; }
 
+void RefactoringTool::addReplacements(const Replacements &Replaces) {
+  llvm::sys::ScopedLock Guard(ReplaceLock);
+  Replace.insert(Replaces.begin(), Replaces.end());
+}
+
 int RefactoringTool::runAndSave(FrontendActionFactory *ActionFactory) {
   if (int Result = run(ActionFactory)) {
     return Result;
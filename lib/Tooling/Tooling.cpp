@@ -16,6 +16,7 @@
 #include "clang/AST/ASTConsumer.h"
 #include "clang/Driver/Compilation.h"
 #include "clang/Driver/Driver.h"
+#include "clang/Driver/Options.h"
 #include "clang/Driver/Tool.h"
 #include "clang/Driver/ToolChain.h"
 #include "clang/Frontend/ASTUnit.h"
@@ -26,11 +27,18 @@
 #include "clang/Tooling/CompilationDatabase.h"
 #include "llvm/ADT/STLExtras.h"
 #include "llvm/Config/llvm-config.h"
+#include "llvm/Option/ArgList.h"
+#include "llvm/Option/OptTable.h"
 #include "llvm/Option/Option.h"
 #include "llvm/Support/Debug.h"
 #include "llvm/Support/FileSystem.h"
 #include "llvm/Support/Host.h"
+#include "llvm/Support/Mutex.h"
+#include "llvm/Support/ThreadPool.h"
 #include "llvm/Support/raw_ostream.h"
+#include <atomic>
+#include <list>
+#include <thread>
 
 #define DEBUG_TYPE "clang-tooling"
 
@@ -315,7 +323,7 @@ ClangTool::ClangTool(const CompilationDatabase &Compilations,
       OverlayFileSystem(new vfs::OverlayFileSystem(vfs::getRealFileSystem())),
       InMemoryFileSystem(new vfs::InMemoryFileSystem),
       Files(new FileManager(FileSystemOptions(), OverlayFileSystem)),
-      DiagConsumer(nullptr) {
+      DiagConsumer(nullptr), NumThreads(1) {
   OverlayFileSystem->pushOverlay(InMemoryFileSystem);
   appendArgumentsAdjuster(getClangStripOutputAdjuster());
   appendArgumentsAdjuster(getClangSyntaxOnlyAdjuster());
@@ -338,6 +346,21 @@ void ClangTool::clearArgumentsAdjusters() {
   ArgsAdjuster = nullptr;
 }
 
+void ClangTool::setNumThreads(unsigned NumThreads) {
+  this->NumThreads = NumThreads;
+}
+
+void ClangTool::setFileSystemCache(
+    IntrusiveRefCntPtr<vfs::SharedFileSystemCache> Cache) {
+  FileSystemCache = std::move(Cache);
+  IntrusiveRefCntPtr<vfs::FileSystem> BaseFS = vfs::getRealFileSystem();
+  if (FileSystemCache)
+    BaseFS = new vfs::CachingFileSystem(FileSystemCache, BaseFS);
+  OverlayFileSystem = new vfs::OverlayFileSystem(BaseFS);
+  OverlayFileSystem->pushOverlay(InMemoryFileSystem);
+  Files = new FileManager(FileSystemOptions(), OverlayFileSystem);
+}
+
 static void injectResourceDir(CommandLineArguments &Args, const char *Argv0,
                               void *MainAddr) {
   // Allow users to override the resource dir.
@@ -350,10 +373,13 @@ static void injectResourceDir(CommandLineArguments &Args, const char *Argv0,
                  CompilerInvocation::GetResourcesPath(Argv0, MainAddr));
 }
 
+// Exists solely for the purpose of lookup of the resource path.
+// This just needs to be some symbol in the binary.
+static int StaticSymbol;
+
 int ClangTool::run(ToolAction *Action) {
-  // Exists solely for the purpose of lookup of the resource path.
-  // This just needs to be some symbol in the binary.
-  static int StaticSymbol;
+  if (NumThreads != 1)
+    return runInParallel([&] { return Action; });
 
   llvm::SmallString<128> InitialDirectory;
   if (std::error_code EC = llvm::sys::fs::current_path(InitialDirectory))
@@ -453,6 +479,218 @@ int ClangTool::run(ToolAction *Action) {
 
 namespace {
 
+/// \brief The client-provided consumer of a parallel ClangTool::run, and the
+/// translation unit whose source file it is currently in.
+struct SharedDiagnosticTarget {
+  DiagnosticConsumer &Target;
+  llvm::sys::Mutex Lock;
+  const DiagnosticConsumer *Current;
+
+  explicit SharedDiagnosticTarget(DiagnosticConsumer &Target)
+      : Target(Target), Current(nullptr) {}
+};
+
+/// \brief Forwards the diagnostics of one translation unit of a parallel
+/// ClangTool::run to the consumer shared by all of them.
+///
+/// The shared consumer is only ever in the source file of one translation
+/// unit. It is moved into the source file of whichever translation unit
+/// reports a diagnostic next, under the lock, so that one translation unit
+/// ending never tears down the state another one is printing with. As in a
+/// serial run, the shared consumer is told to finish after each translation
+/// unit.
+class LockedDiagnosticConsumer : public DiagnosticConsumer {
+  SharedDiagnosticTarget &Shared;
+  LangOptions DefaultLangOpts;
+  const LangOptions *LangOpts;
+  const Preprocessor *PP;
+
+  /// \brief Leaves the source file of this translation unit, if the shared
+  /// consumer is in it. Requires the lock.
+  void leaveSourceFile() {
+    if (Shared.Current != this)
+      return;
+    Shared.Target.EndSourceFile();
+    Shared.Current = nullptr;
+  }
+
+public:
+  explicit LockedDiagnosticConsumer(SharedDiagnosticTarget &Shared)
+      : Shared(Shared), LangOpts(nullptr), PP(nullptr) {}
+
+  ~LockedDiagnosticConsumer() override {
+    llvm::sys::ScopedLock Guard(Shared.Lock);
+    leaveSourceFile();
+  }
+
+  void BeginSourceFile(const LangOptions &LangOpts,
+                       const Preprocessor *PP) override {
+    // Diagnostics reported before this, e.g. by the driver, were forwarded
+    // with default language options; don't keep using them.
+    llvm::sys::ScopedLock Guard(Shared.Lock);
+    leaveSourceFile();
+    this->LangOpts = &LangOpts;
+    this->PP = PP;
+  }
+
+  void EndSourceFile() override {
+    llvm::sys::ScopedLock Guard(Shared.Lock);
+    leaveSourceFile();
+    LangOpts = nullptr;
+    PP = nullptr;
+  }
+
+  void finish() override {
+    llvm::sys::ScopedLock Guard(Shared.Lock);
+    leaveSourceFile();
+    Shared.Target.finish();
+  }
+
+  bool IncludeInDiagnosticCounts() const override {
+    return Shared.Target.IncludeInDiagnosticCounts();
+  }
+
+  void HandleDiagnostic(DiagnosticsEngine::Level DiagLevel,
+                        const Diagnostic &Info) override {
+    DiagnosticConsumer::HandleDiagnostic(DiagLevel, Info);
+    llvm::sys::ScopedLock Guard(Shared.Lock);
+    if (Shared.Current != this) {
+      if (Shared.Current)
+        Shared.Target.EndSourceFile();
+      Shared.Target.BeginSourceFile(LangOpts ? *LangOpts : DefaultLangOpts,
+                                    PP);
+      Shared.Current = this;
+    }
+    Shared.Target.HandleDiagnostic(DiagLevel, Info);
+  }
+};
+
+/// \brief Parses the options of the diagnostic printer out of a driver
+/// command line, as the clang driver does.
+IntrusiveRefCntPtr<DiagnosticOptions>
+createDiagnosticOptions(ArrayRef<std::string> CommandLine) {
+  std::vector<const char *> Argv;
+  for (const std::string &Str : CommandLine.slice(1))
+    Argv.push_back(Str.c_str());
+  IntrusiveRefCntPtr<DiagnosticOptions> DiagOpts = new DiagnosticOptions();
+  std::unique_ptr<llvm::opt::OptTable> Opts(driver::createDriverOptTable());
+  unsigned MissingArgIndex, MissingArgCount;
+  llvm::opt::InputArgList Args =
+      Opts->ParseArgs(Argv, MissingArgIndex, MissingArgCount);
+  // Any error in the arguments is diagnosed when the job is run.
+  (void)ParseDiagnosticArgs(*DiagOpts, Args);
+  return DiagOpts;
+}
+
+/// \brief A single compile command scheduled by ClangTool::runInParallel.
+struct ParallelToolJob {
+  std::string File;
+  std::string Directory;
+  std::vector<std::string> CommandLine;
+};
+
+} // end anonymous namespace
+
+int ClangTool::runInParallel(llvm::function_ref<ToolAction *()> NextAction) {
+  // Collect all jobs up front. getCompileCommands is not required to be
+  // thread-safe, and it may prepare the file system for the commands it
+  // returns, so query the database serially before starting any work.
+  std::vector<ParallelToolJob> Jobs;
+  for (const auto &SourcePath : SourcePaths) {
+    std::string File(getAbsolutePath(SourcePath));
+    std::vector<CompileCommand> CompileCommandsForFile =
+        Compilations.getCompileCommands(File);
+    if (CompileCommandsForFile.empty()) {
+      llvm::errs() << "Skipping " << File << ". Compile command not found.\n";
+      continue;
+    }
+    for (CompileCommand &CompileCommand : CompileCommandsForFile) {
+      ParallelToolJob Job;
+      Job.File = File;
+      Job.Directory = CompileCommand.Directory;
+      Job.CommandLine = CompileCommand.CommandLine;
+      if (ArgsAdjuster)
+        Job.CommandLine = ArgsAdjuster(Job.CommandLine, CompileCommand.Filename);
+      assert(!Job.CommandLine.empty());
+      injectResourceDir(Job.CommandLine, "clang_tool", &StaticSymbol);
+      Jobs.push_back(std::move(Job));
+    }
+  }
+
+  unsigned ThreadCount = NumThreads;
+  if (ThreadCount == 0)
+    ThreadCount = std::max(1u, std::thread::hardware_concurrency());
+
+  llvm::sys::Mutex OutputLock;
+  std::unique_ptr<SharedDiagnosticTarget> SharedTarget;
+  if (DiagConsumer)
+    SharedTarget.reset(new SharedDiagnosticTarget(*DiagConsumer));
+  std::atomic<bool> ProcessingFailed(false);
+
+  llvm::ThreadPool Pool(ThreadCount);
+  for (const ParallelToolJob &Job : Jobs) {
+    ToolAction *Action = NextAction();
+    Pool.async([&, Action, this]() {
+      // Every job gets its own view of the file system, so that neither the
+      // working directory nor the FileManager caches are shared between
+      // threads.
+      IntrusiveRefCntPtr<vfs::FileSystem> BaseFS =
+          vfs::createPhysicalFileSystem();
+      if (FileSystemCache)
+        BaseFS = new vfs::CachingFileSystem(FileSystemCache, BaseFS);
+      IntrusiveRefCntPtr<vfs::OverlayFileSystem> JobFileSystem(
+          new vfs::OverlayFileSystem(BaseFS));
+      IntrusiveRefCntPtr<vfs::InMemoryFileSystem> JobInMemoryFileSystem(
+          new vfs::InMemoryFileSystem);
+      JobFileSystem->pushOverlay(JobInMemoryFileSystem);
+      if (JobFileSystem->setCurrentWorkingDirectory(Job.Directory))
+        llvm::report_fatal_error("Cannot chdir into \"" +
+                                 Twine(Job.Directory) + "\n!");
+      for (const auto &MappedFile : MappedFileContents)
+        JobInMemoryFileSystem->addFile(
+            MappedFile.first, 0,
+            llvm::MemoryBuffer::getMemBuffer(MappedFile.second));
+      IntrusiveRefCntPtr<FileManager> JobFiles(
+          new FileManager(FileSystemOptions(), JobFileSystem));
+
+      // Without a client-provided consumer, buffer the diagnostics of this
+      // translation unit and print them in one piece once it is done.
+      std::string DiagnosticOutput;
+      llvm::raw_string_ostream DiagnosticStream(DiagnosticOutput);
+      IntrusiveRefCntPtr<DiagnosticOptions> DiagOpts =
+          createDiagnosticOptions(Job.CommandLine);
+      TextDiagnosticPrinter BufferedPrinter(DiagnosticStream, &*DiagOpts);
+      std::unique_ptr<LockedDiagnosticConsumer> LockedConsumer;
+      if (SharedTarget)
+        LockedConsumer.reset(new LockedDiagnosticConsumer(*SharedTarget));
+
+      DEBUG({
+        llvm::sys::ScopedLock Guard(OutputLock);
+        llvm::dbgs() << "Processing: " << Job.File << ".\n";
+      });
+      ToolInvocation Invocation(Job.CommandLine, Action, JobFiles.get(),
+                                PCHContainerOps);
+      if (LockedConsumer)
+        Invocation.setDiagnosticConsumer(LockedConsumer.get());
+      else
+        Invocation.setDiagnosticConsumer(&BufferedPrinter);
+      bool Success = Invocation.run();
+      if (!Success)
+        ProcessingFailed = true;
+
+      DiagnosticStream.flush();
+      llvm::sys::ScopedLock Guard(OutputLock);
+      llvm::errs() << DiagnosticOutput;
+      if (!Success)
+        llvm::errs() << "Error while processing " << Job.File << ".\n";
+    });
+  }
+  Pool.wait();
+  return ProcessingFailed ? 1 : 0;
+}
+
+namespace {
+
 class ASTBuilderAction : public ToolAction {
   std::vector<std::unique_ptr<ASTUnit>> &ASTs;
 
@@ -479,8 +717,25 @@ public:
 }
 
 int ClangTool::buildASTs(std::vector<std::unique_ptr<ASTUnit>> &ASTs) {
-  ASTBuilderAction Action(ASTs);
-  return run(&Action);
+  if (NumThreads == 1) {
+    ASTBuilderAction Action(ASTs);
+    return run(&Action);
+  }
+
+  // Parallel jobs finish in an arbitrary order. Each job gets its own action
+  // and its own list of ASTs, so that the ASTs come out in the order of the
+  // jobs, as they do in a serial run.
+  std::list<std::vector<std::unique_ptr<ASTUnit>>> JobASTs;
+  std::list<ASTBuilderAction> JobActions;
+  int Result = runInParallel([&]() -> ToolAction * {
+    JobASTs.emplace_back();
+    JobActions.emplace_back(JobASTs.back());
+    return &JobActions.back();
+  });
+  for (auto &ASTsOfJob : JobASTs)
+    for (auto &AST : ASTsOfJob)
+      ASTs.push_back(std::move(AST));
+  return Result;
 }
 
 std::unique_ptr<ASTUnit>
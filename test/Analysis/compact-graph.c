@@ -0,0 +1,22 @@
+// REQUIRES: asserts
+// RUN: %clang_cc1 -analyze -analyzer-checker=core -analyzer-config graph-trim-interval=1 -analyzer-stats -verify %s 2>&1 | FileCheck -check-prefix=DEFAULT %s
+// RUN: %clang_cc1 -analyze -analyzer-checker=core -analyzer-config graph-trim-interval=1,compact-graph=true -analyzer-stats -verify %s 2>&1 | FileCheck -check-prefix=COMPACT %s
+
+// Compacting the graph finds the same bugs. The size of the exploded graph
+// with and without compaction is reported by the ExprEngine statistics.
+
+void use(int);
+
+int f(int x) {
+  int y = x + 1;
+  int z = y * 2;
+  use(z);
+  int *p = 0;
+  return *p + z; // expected-warning{{Dereference of null pointer}}
+}
+
+// DEFAULT-NOT: reclaimed only because the graph is compacted
+// DEFAULT: ExprEngine - The maximum # of bytes allocated for the exploded graph
+
+// COMPACT: ExplodedGraph - The # of exploded nodes reclaimed only because the graph is compacted
+// COMPACT: ExprEngine - The maximum # of bytes allocated for the exploded graph
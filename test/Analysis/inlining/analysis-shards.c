@@ -0,0 +1,44 @@
+// RUN: %clang_cc1 -analyze -analyzer-checker=core -analyzer-display-progress -analyzer-config shard-count=2,shard-index=0 %s 2>&1 | FileCheck -check-prefix=SHARD0 %s
+// RUN: %clang_cc1 -analyze -analyzer-checker=core -analyzer-display-progress -analyzer-config shard-count=2,shard-index=1 %s 2>&1 | FileCheck -check-prefix=SHARD1 %s
+
+// RUN: rm -rf %t && mkdir %t
+// RUN: %clang_cc1 -analyze -analyzer-checker=core -analyzer-output=plist -analyzer-config shard-count=2,shard-index=0 -o %t/out.plist %s
+// RUN: %clang_cc1 -analyze -analyzer-checker=core -analyzer-output=plist -analyzer-config shard-count=2,shard-index=1 -o %t/out.plist %s
+// RUN: ls %t | FileCheck -check-prefix=OUTPUT %s
+// OUTPUT-NOT: out.plist
+// OUTPUT: out.shard0.plist
+// OUTPUT-NEXT: out.shard1.plist
+
+// HTML reports have unique names, so the shards share the output directory.
+// RUN: %clang_cc1 -analyze -analyzer-checker=core -analyzer-output=html -analyzer-config shard-count=2,shard-index=0 -o %t/html %s
+// RUN: %clang_cc1 -analyze -analyzer-checker=core -analyzer-output=html -analyzer-config shard-count=2,shard-index=1 -o %t/html %s
+// RUN: ls %t/html | grep report | count 2
+
+// RUN: not %clang_cc1 -analyze -analyzer-checker=core -analyzer-config shard-count=2,shard-index=2 %s 2>&1 | FileCheck -check-prefix=RANGE %s
+// RUN: not %clang_cc1 -analyze -analyzer-checker=core -analyzer-config shard-index=1 %s 2>&1 | FileCheck -check-prefix=NOCOUNT %s
+// RANGE: error: analyzer-config option 'shard-index=2' must be less than 'shard-count' (2)
+// NOCOUNT: error: analyzer-config option 'shard-index=1' must be less than 'shard-count' (1)
+
+// Functions that call each other are analyzed in the same shard, so that
+// a_mid() and a_leaf() are only analyzed inlined into a_top().
+void a_leaf() { int *p = 0; *p = 1; }
+void a_mid() { a_leaf(); }
+void a_top() { a_mid(); }
+
+void b_leaf() { int *p = 0; *p = 1; }
+void b_top() { b_leaf(); }
+
+// Calls to functions without a body don't tie their callers together.
+void external();
+void lone() { external(); }
+
+// SHARD0-NOT: ANALYZE (Path
+// SHARD0: ANALYZE (Path, {{.*}} a_top
+// SHARD0-NOT: ANALYZE (Path
+
+// Only the first shard runs the checks that are not path-sensitive.
+// SHARD1-NOT: (Syntax)
+// SHARD1-NOT: a_
+// SHARD1-DAG: ANALYZE (Path, {{.*}} b_top
+// SHARD1-DAG: ANALYZE (Path, {{.*}} lone
+// SHARD1-NOT: a_
@@ -6,4 +6,5 @@ void foo() {
 }
 // CHECK: ... Statistics Collected ...
 // CHECK:100 AnalysisConsumer - The % of reachable basic blocks.
+// CHECK:ExprEngine - The maximum # of bytes allocated for the exploded graph
 // CHECK:The # of times RemoveDeadBindings is called
@@ -0,0 +1,48 @@
+// RUN: rm -rf %t && mkdir %t
+// RUN: cp %s %t/summary-cache.c
+// RUN: %clang_cc1 -analyze -analyzer-checker=core -analyzer-config summary-cache-dir=%t/cache -analyzer-display-progress %t/summary-cache.c 2>&1 | FileCheck -check-prefix=FIRST %s
+// RUN: %clang_cc1 -analyze -analyzer-checker=core -analyzer-config summary-cache-dir=%t/cache -analyzer-display-progress %t/summary-cache.c 2>&1 | FileCheck -check-prefix=SECOND %s
+// RUN: sed -e 's/^typedef int Counter;/typedef char Counter;/' %s > %t/summary-cache.c
+// RUN: %clang_cc1 -analyze -analyzer-checker=core -analyzer-config summary-cache-dir=%t/cache -analyzer-display-progress %t/summary-cache.c 2>&1 | FileCheck -check-prefix=TYPEDEF %s
+// RUN: %clang_cc1 -analyze -analyzer-checker=core -analyzer-config summary-cache-dir=%t/cache -analyzer-display-progress -DOFFSET=1 %t/summary-cache.c 2>&1 | FileCheck -check-prefix=FIRST %s
+
+#ifndef OFFSET
+#define OFFSET 0
+#endif
+
+static int callee(int x) {
+  return x + OFFSET;
+}
+
+int functionWithoutBugs(int x) {
+  return callee(x) * 2;
+}
+
+typedef int Counter;
+
+int functionWithLocal(int x) {
+  Counter c = x;
+  return c / 2;
+}
+
+int functionWithBug(int x) {
+  int y = 0;
+  return x / y;
+}
+
+// The functions without bugs are only analyzed again if they changed, here
+// through the definition of a macro they use, or of a typedef only a local
+// variable is declared with. The function with a bug is analyzed every time,
+// so that the bug is reported every time.
+
+// FIRST: ANALYZE (Path,  Inline_Regular): {{.*}} functionWithoutBugs
+// FIRST: ANALYZE (Path,  Inline_Regular): {{.*}} functionWithBug
+
+// SECOND-NOT: Path, {{.*}} {{functionWithoutBugs|functionWithLocal|callee}}
+// SECOND: ANALYZE (Path,  Inline_Regular): {{.*}} functionWithBug
+// SECOND-NOT: Path, {{.*}} {{functionWithoutBugs|functionWithLocal|callee}}
+
+// TYPEDEF-NOT: Path, {{.*}} {{functionWithoutBugs|callee}}
+// TYPEDEF-DAG: ANALYZE (Path,  Inline_Regular): {{.*}} functionWithLocal
+// TYPEDEF-DAG: ANALYZE (Path,  Inline_Regular): {{.*}} functionWithBug
+// TYPEDEF-NOT: Path, {{.*}} {{functionWithoutBugs|callee}}
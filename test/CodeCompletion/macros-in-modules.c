@@ -9,3 +9,4 @@ int x =
 /*here*/1;
 
 // CHECK: FOO_MACRO
+// REQUIRES: libclang
@@ -8,3 +8,4 @@ int x =
 /*here*/1;
 
 // CHECK: FOO_MACRO
+// REQUIRES: libclang
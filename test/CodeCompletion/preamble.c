@@ -5,3 +5,4 @@ void foo() {
 
 // RUN: env CINDEXTEST_EDITING=1 c-index-test -code-completion-at=%s:4:5 -Xclang -code-completion-patterns  %s | FileCheck -check-prefix=CHECK-CC1 %s
 // CHECK-CC1: FieldDecl:{ResultType int}{TypedText m} (35)
+// REQUIRES: libclang
@@ -1,2 +1,4 @@
 // RUN: cd %S && %clang -### -g %s -c 2>&1 | FileCheck -check-prefix=CHECK-PWD %s
 // CHECK-PWD: {{"-fdebug-compilation-dir" ".*Driver.*"}}
+// RUN: rm -rf %t && mkdir -p %t/comp-dir && cd %t/comp-dir && %clang -### -g %s -c 2>&1 | FileCheck -check-prefix=CHECK-DIR %s
+// CHECK-DIR: "-fdebug-compilation-dir" "{{.*}}{{/|\\\\}}comp-dir"
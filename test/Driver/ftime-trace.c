@@ -0,0 +1,5 @@
+// RUN: %clang -### -c -ftime-trace %s -o foo.o 2>&1 | FileCheck -check-prefix=OUTPUT %s
+// RUN: %clang -### -fsyntax-only -ftime-trace %s 2>&1 | FileCheck -check-prefix=INPUT %s
+
+// OUTPUT: "-ftime-trace=foo.json"
+// INPUT: "-ftime-trace=ftime-trace.json"
@@ -0,0 +1,17 @@
+// RUN: %clang -### -parallel-jobs=4 -fsyntax-only %s 2>&1 | FileCheck %s
+// CHECK-NOT: argument unused during compilation
+// CHECK: "-cc1"
+
+// RUN: not %clang -parallel-jobs=0 -fsyntax-only %s 2>&1 \
+// RUN:   | FileCheck -check-prefix=INVALID %s
+// INVALID: error: invalid integral value '0' in '-parallel-jobs=0'
+
+// Preprocessed output of independent jobs is replayed in input order.
+// RUN: %clang -parallel-jobs=4 -E -P -DFIRST %s -x c %S/Inputs/parallel-jobs-second.c \
+// RUN:   | FileCheck -check-prefix=ORDER %s
+// ORDER: int first_input;
+// ORDER: int second_input;
+
+#ifdef FIRST
+int first_input;
+#endif
@@ -82,3 +82,13 @@
 // RUN:   | FileCheck %s -check-prefix=CHECK-SAVE-TEMPS
 // CHECK-SAVE-TEMPS: "-cc1as"
 // CHECK-SAVE-TEMPS: "-dwarf-version={{.}}"
+
+// A temporary file which would overwrite the input file in the working
+// directory gets a temporary name instead.
+// RUN: rm -rf %t && mkdir -p %t && touch %t/conflict.s
+// RUN: cd %t && %clang -target x86_64-apple-darwin -save-temps \
+// RUN:   -x assembler-with-cpp -c conflict.s -### 2>&1 \
+// RUN:   | FileCheck %s -check-prefix=CHECK-CONFLICT
+// CHECK-CONFLICT: "-E"
+// CHECK-CONFLICT-NOT: "-o" "conflict.s"
+// CHECK-CONFLICT: "-o" "{{[^"]*}}conflict-{{[^"]*}}.s"
@@ -0,0 +1 @@
+template <typename T> struct Box { T Value; };
@@ -0,0 +1,18 @@
+// RUN: %clang_cc1 -std=c++11 -fsyntax-only -I %S/Inputs -ftime-trace=%t.json %s
+// RUN: FileCheck %s < %t.json
+// RUN: FileCheck -check-prefix=NO-MAIN %s < %t.json
+
+#include "ftime-trace.h"
+template <typename T> T get(Box<T> B) { return B.Value; }
+int main() { return get(Box<int>{1}); }
+
+// CHECK: "traceEvents"
+// CHECK-DAG: "name":"Frontend","args":{"detail":"{{.*}}ftime-trace.cpp"
+// CHECK-DAG: "name":"Source","args":{"detail":"{{.*}}ftime-trace.h"
+// CHECK-DAG: "name":"InstantiateClass","args":{"detail":"Box<int>"
+// CHECK-DAG: "name":"InstantiateFunction","args":{"detail":"get<int>","ast_bytes":{{[0-9]+}}}
+// CHECK-DAG: "name":"PerformPendingInstantiations","args":{"ast_bytes":{{[1-9][0-9]*}}}
+// CHECK-DAG: "name":"Total InstantiateFunction","args":{"count":1}
+
+// The main file is covered by the Frontend event.
+// NO-MAIN-NOT: "name":"Source","args":{"detail":"{{[^"]*}}ftime-trace.cpp"
@@ -18,3 +18,4 @@ void foo() {
   int voodoo;
   voodoo = voodoo + 1;
 }
+// REQUIRES: libclang
@@ -6,3 +6,4 @@
 
 // CHECK: warning: unknown warning option '-Wblahblah'
 // CHECK: Number of diagnostics: 1
+// REQUIRES: libclang
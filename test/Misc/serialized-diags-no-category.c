@@ -10,3 +10,4 @@
 // CHECK: {{.*[/\\]}}serialized-diags-no-category.c:1:2: error: foo []
 // CHECK: Number of diagnostics: 2
 
+// REQUIRES: libclang
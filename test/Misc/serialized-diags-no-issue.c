@@ -8,3 +8,4 @@ void foo();
 // that serialize diagnostics work in the absence of any issues.
 
 // CHECK: Number of diagnostics: 0
+// REQUIRES: libclang
@@ -28,3 +28,4 @@ void foo() {
   // CHECK: [[@LINE+1]]:20: note: in instantiation of member function
   int e = MyTS<2>::callme();
 }
+// REQUIRES: libclang
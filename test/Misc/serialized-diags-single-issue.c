@@ -34,3 +34,4 @@ void foo() {
 // CHECK-MULT: +-FIXIT: ({{.*}}serialized-diags-single-issue.c:2:13 - {{.*}}serialized-diags-single-issue.c:2:13): " = 0"
 
 // CHECK-MULT: Number of diagnostics: 2
+// REQUIRES: libclang
@@ -18,3 +18,4 @@ typedef int bar;
 
 
 // CHECK-LABEL: Number of diagnostics: 2
+// REQUIRES: libclang
@@ -64,3 +64,4 @@ void rdar11040133() {
 // CHECK: {{.*[/\\]}}serialized-diags.c:30:12: warning: unused variable 'x'
 // CHECK: Number FIXITs = 0
 // CHECK: Number of diagnostics: 6
+// REQUIRES: libclang
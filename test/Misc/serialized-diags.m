@@ -28,3 +28,4 @@
 // CHECK: +-{{.*[/\\]}}serialized-diags.m:1:15: note: add a super class to fix this problem [] [Semantic Issue]
 // CHECK: Number FIXITs = 0
 // CHECK: Number of diagnostics: 2
+// REQUIRES: libclang
@@ -24,3 +24,4 @@
 // RUN: not c-index-test -write-pch %t.pch -fmodules -fimplicit-module-maps -fmodules-cache-path=%t \
 // RUN: %s -Xclang -fdisable-module-hash -F %S/Inputs 2>&1 | FileCheck %s
 // CHECK: {{^}}Failure: AST deserialization error occurred{{$}}
+// REQUIRES: libclang
@@ -30,3 +30,4 @@ double *double_ptr = &float_val;
 // CHECK-WITH-ERRORS: serialized-diags.m:4:9: fatal: could not build module 'HasErrors'
 // CHECK-WITH-ERRORS: Number of diagnostics: 3
 
+// REQUIRES: libclang
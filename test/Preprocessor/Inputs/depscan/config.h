@@ -0,0 +1,9 @@
+#ifndef CONFIG_H
+#define CONFIG_H
+
+#define FEATURE 1
+#define HEADER "enabled.h"
+
+int config(void);
+
+#endif
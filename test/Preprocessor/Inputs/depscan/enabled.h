@@ -0,0 +1,3 @@
+#pragma once
+#include <nested//nested.h> // Not a comment.
+/* #include "commented.h" */
@@ -0,0 +1 @@
+#define NESTED 1
@@ -0,0 +1,11 @@
+#ifndef CACHED_H
+#define CACHED_H
+
+#if VALUE > 1
+#define BIG 1
+#endif
+
+#define GREETING "hello"
+int cached_value = VALUE;
+
+#endif
@@ -0,0 +1,2 @@
+/* The lexer diagnoses this /* within a block comment. */
+int lexer_warning;
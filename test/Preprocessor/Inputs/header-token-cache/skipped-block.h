@@ -0,0 +1,4 @@
+#ifdef SKIPPED_BLOCK_WARNS
+/* The lexer diagnoses this /* within a block comment. */
+#endif
+int skipped_block;
@@ -0,0 +1,30 @@
+// RUN: %clang_cc1 -depscan -I %S/Inputs/depscan -dependency-file - -MT depscan.o %s | FileCheck %s
+
+// Only the directives are preprocessed, but they are evaluated as usual.
+
+#include "config.h"
+#include "config.h"
+
+#if FEATURE
+#include HEADER
+#else
+#error not reached
+#include "disabled.h"
+#endif
+
+/*
+#include "commented.h"
+*/
+const char *s = "\
+#include \"string.h\"";
+#define STR(x) #x
+const char *t = STR(#include "macro-argument.h");
+
+int f(int x) { return x + config(); }
+
+// CHECK: depscan.o:
+// CHECK-SAME: depscan.c
+// CHECK-NEXT: {{.*}}config.h
+// CHECK-NEXT: {{.*}}enabled.h
+// CHECK-NEXT: {{.*}}nested.h
+// CHECK-NOT: .h
@@ -0,0 +1,25 @@
+// RUN: rm -f %t.cache
+// RUN: %clang_cc1 -fsyntax-only -header-guard-cache %t.cache -I %S/Inputs/header-guard-cache %s -print-stats 2>&1 | FileCheck -check-prefix=FIRST %s
+// RUN: FileCheck -check-prefix=CACHE %s < %t.cache
+// RUN: not grep unguarded %t.cache
+
+// When the guard macro is already defined, the header isn't entered at all,
+// but it is still a dependency.
+// RUN: %clang_cc1 -fsyntax-only -header-guard-cache %t.cache -I %S/Inputs/header-guard-cache %s -DGUARDED_H -dependency-file %t.d -MT header-guard-cache.o -print-stats 2>&1 | FileCheck -check-prefix=SECOND %s
+// RUN: FileCheck -check-prefix=DEPS %s < %t.d
+
+#include "guarded.h"
+#include "guarded.h"
+#include "unguarded.h"
+
+// FIRST: 1 #includes skipped due to the multi-include optimization.
+// FIRST: 0 #includes skipped due to the header guard cache.
+
+// CACHE: GUARDED_H {{.*}}guarded.h
+
+// SECOND: 1 #includes skipped due to the multi-include optimization.
+// SECOND: 1 #includes skipped due to the header guard cache.
+
+// DEPS: header-guard-cache.o:
+// DEPS: guarded.h
+// DEPS: unguarded.h
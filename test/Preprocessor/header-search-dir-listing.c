@@ -0,0 +1,13 @@
+// RUN: %clang_cc1 -fsyntax-only -I %S/Inputs/header-guard-cache -I %S/Inputs/depscan %s -print-stats 2>&1 | FileCheck %s
+
+// The first search directory doesn't contain these headers, which its listing
+// tells without looking them up.
+#include "config.h"
+#include "nested/nested.h"
+#include "guarded.h"
+
+#if !FEATURE || !NESTED
+#error headers not found
+#endif
+
+// CHECK: 2 search directory lookups avoided by directory listings.
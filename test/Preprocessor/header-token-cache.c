@@ -0,0 +1,32 @@
+// RUN: rm -rf %t
+// RUN: %clang_cc1 -fsyntax-only -token-cache-dir %t -I %S/Inputs/header-token-cache %s -print-stats 2>&1 | FileCheck -check-prefix=FIRST %s
+// RUN: %clang_cc1 -fsyntax-only -token-cache-dir %t -I %S/Inputs/header-token-cache %s -print-stats 2>&1 | FileCheck -check-prefix=SECOND %s
+// RUN: %clang_cc1 -E -token-cache-dir %t -I %S/Inputs/header-token-cache %s | FileCheck -check-prefix=EXPAND %s
+// RUN: %clang_cc1 -fsyntax-only -token-cache-dir %t -I %S/Inputs/header-token-cache -DSKIPPED_BLOCK_WARNS %s 2>&1 | FileCheck -check-prefix=ENTERED %s
+
+#define VALUE 2
+#include "cached.h"
+#include "cached.h"
+
+// Headers the lexer diagnosed are not cached, so that the diagnostics are
+// issued by every compilation.
+#include "lexer-warning.h"
+
+// Neither are headers with skipped conditional blocks, which the lexer
+// doesn't diagnose, so that compilations entering the blocks diagnose them.
+#include "skipped-block.h"
+
+const char *s = GREETING;
+int big = BIG;
+
+// FIRST: lexer-warning.h:1:{{[0-9]+}}: warning: '/*' within block comment
+// FIRST-NOT: skipped-block.h
+// FIRST: 0 headers lexed from the header token cache, 3 not found in it.
+// SECOND: lexer-warning.h:1:{{[0-9]+}}: warning: '/*' within block comment
+// SECOND-NOT: skipped-block.h
+// SECOND: 1 headers lexed from the header token cache, 2 not found in it.
+// ENTERED: skipped-block.h:2:{{[0-9]+}}: warning: '/*' within block comment
+
+// EXPAND: int cached_value = 2;
+// EXPAND: const char *s = "hello";
+// EXPAND: int big = 1;
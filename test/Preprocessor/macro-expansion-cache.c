@@ -0,0 +1,73 @@
+// RUN: %clang_cc1 -E -cache-macro-expansions %s | FileCheck -check-prefix=EXPAND %s
+// RUN: %clang_cc1 -E %s | FileCheck -check-prefix=EXPAND %s
+// RUN: %clang_cc1 -fsyntax-only -cache-macro-expansions %s -print-stats 2>&1 | FileCheck -check-prefix=STATS %s
+// RUN: %clang_cc1 -fsyntax-only %s -print-stats 2>&1 | FileCheck -check-prefix=NOCACHE %s
+// RUN: %clang_cc1 -fsyntax-only -cache-macro-expansions -fno-caret-diagnostics %s 2>&1 | FileCheck -check-prefix=DIAG %s
+
+#define A B + C
+#define B 1
+#define C (B * 2)
+
+int x = A;
+int y = A;
+int z = A;
+// EXPAND: int x = 1 + (1 * 2);
+// EXPAND: int y = 1 + (1 * 2);
+// EXPAND: int z = 1 + (1 * 2);
+
+// Redefining a macro the expansion depends on invalidates the cache.
+#undef B
+#define B 3
+int v = A;
+int w = A;
+// EXPAND: int v = 3 + (3 * 2);
+// EXPAND: int w = 3 + (3 * 2);
+
+// Expansions depending on where they happen are not cached.
+#define LINE __LINE__
+int l1 = LINE;
+int l2 = LINE;
+// EXPAND: int l1 = [[@LINE-2]];
+// EXPAND: int l2 = [[@LINE-2]];
+
+// Invocations of function-like macros are cached per spelling of their
+// arguments, and replayed from the third identical one.
+#define SQ(x) ((x) * (x))
+#define STR(x) #x
+int s1 = SQ(B);
+int s2 = SQ(B);
+int s3 = SQ(B);
+int s4 = SQ(2);
+// EXPAND: int s1 = ((3) * (3));
+// EXPAND: int s2 = ((3) * (3));
+// EXPAND: int s3 = ((3) * (3));
+// EXPAND: int s4 = ((2) * (2));
+const char *t1 = STR(a + b);
+const char *t2 = STR(a + b);
+const char *t3 = STR(a + b);
+// EXPAND: const char *t1 = "a + b";
+// EXPAND: const char *t2 = "a + b";
+// EXPAND: const char *t3 = "a + b";
+int l3 = SQ(__LINE__);
+int l4 = SQ(__LINE__);
+int l5 = SQ(__LINE__);
+// EXPAND: int l3 = (([[@LINE-3]]) * ([[@LINE-3]]));
+// EXPAND: int l4 = (([[@LINE-3]]) * ([[@LINE-3]]));
+// EXPAND: int l5 = (([[@LINE-3]]) * ([[@LINE-3]]));
+
+// Diagnostics in a replayed expansion have the same macro backtrace as in the
+// recorded one.
+#define ZERO 0
+#define DIV_BY_ZERO 1 / ZERO
+#define RATIO DIV_BY_ZERO
+int f1(void) { return RATIO; }
+int f2(void) { return RATIO; }
+// DIAG: macro-expansion-cache.c:[[@LINE-2]]:23: warning: division by zero is undefined
+// DIAG-NEXT: macro-expansion-cache.c:[[@LINE-4]]:15: note: expanded from macro 'RATIO'
+// DIAG-NEXT: macro-expansion-cache.c:[[@LINE-6]]:23: note: expanded from macro 'DIV_BY_ZERO'
+// DIAG-NEXT: macro-expansion-cache.c:[[@LINE-4]]:23: warning: division by zero is undefined
+// DIAG-NEXT: macro-expansion-cache.c:[[@LINE-7]]:15: note: expanded from macro 'RATIO'
+// DIAG-NEXT: macro-expansion-cache.c:[[@LINE-9]]:23: note: expanded from macro 'DIV_BY_ZERO'
+
+// STATS: 4 obj and 2 fn macros expanded from the expansion cache, 5 expansions cached.
+// NOCACHE: 0 obj and 0 fn macros expanded from the expansion cache, 0 expansions cached.
@@ -1115,3 +1115,4 @@ template <class T> T test_function (T arg);
 /*!     @function test_function<int>
 */
 template <> int test_function<int> (int arg);
+// REQUIRES: libclang
@@ -0,0 +1,111 @@
+// RUN: %clang_cc1 -std=c++14 -fsyntax-only -verify %s
+// RUN: %clang_cc1 -std=c++14 -fsyntax-only -verify %s -fexperimental-constexpr-interpreter
+
+// The interpreter evaluates the calls below which it supports, and leaves the
+// others to the tree-walking evaluator. Either way, the results and the
+// diagnostics must be the same.
+
+constexpr unsigned long long fib(unsigned n) {
+  unsigned long long a = 0, b = 1;
+  while (n--) {
+    unsigned long long t = a + b;
+    a = b;
+    b = t;
+  }
+  return a;
+}
+static_assert(fib(90) == 2880067194370816120ULL, "");
+
+constexpr int fibRec(int n) { return n < 2 ? n : fibRec(n - 1) + fibRec(n - 2); }
+static_assert(fibRec(20) == 6765, "");
+
+constexpr bool isPrime(int n) {
+  if (n < 2)
+    return false;
+  for (int d = 2; d * d <= n; ++d)
+    if (n % d == 0)
+      return false;
+  return true;
+}
+constexpr int countPrimes(int n) {
+  int count = 0;
+  for (int i = 0; i < n; ++i)
+    count += isPrime(i);
+  return count;
+}
+static_assert(countPrimes(10000) == 1229, "");
+
+constexpr int collatz(long long n) {
+  int steps = 0;
+  do {
+    if (n == 1)
+      break;
+    n = n % 2 ? 3 * n + 1 : n / 2;
+  } while (++steps);
+  return steps;
+}
+static_assert(collatz(27) == 111, "");
+
+constexpr unsigned gcd(unsigned a, unsigned b) { return b ? gcd(b, a % b) : a; }
+static_assert(gcd(1071, 462) == 21, "");
+
+constexpr unsigned popcount(unsigned long long v) {
+  unsigned n = 0;
+  for (; v; v >>= 1) {
+    if (!(v & 1))
+      continue;
+    ++n;
+  }
+  return n;
+}
+static_assert(popcount(~0ULL) == 64, "");
+
+constexpr unsigned char wrap(unsigned char c) { return c + 1; }
+static_assert(wrap(255) == 0, "");
+constexpr unsigned wrapUnsigned(unsigned u) { return u * 3 - 4; }
+static_assert(wrapUnsigned(1) == 0xFFFFFFFF, "");
+constexpr short narrow(int i) { short s = 0; s += i; return s; }
+static_assert(narrow(0x12345) == 0x2345, "");
+constexpr int shifts(int a, unsigned b) { return (a << 3) + (-a >> 2) + (b >> 31); }
+static_assert(shifts(8, 0x80000000u) == 63, "");
+
+enum class Color : unsigned char { Red, Green = 7, Blue };
+constexpr Color next(Color c) { return static_cast<Color>(static_cast<int>(c) + 1); }
+static_assert(next(Color::Green) == Color::Blue, "");
+
+constexpr int kTable = 42;
+template <int N> constexpr int scaled(int x = 2) { return x * N + kTable + sizeof(long long); }
+static_assert(scaled<3>() == 56, "");
+
+constexpr bool logic(int a, int b) { return (a && b) || !a; }
+static_assert(logic(0, 0) && logic(1, 1) && !logic(1, 0), "");
+
+constexpr int compound(int x) {
+  int y = 10;
+  y -= x, y *= 3, y /= 2, y %= 7;
+  y <<= 2;
+  y |= 1;
+  y ^= 3;
+  y &= ~4;
+  int z = y++;
+  return z + y;
+}
+static_assert(compound(4) == 21, "");
+
+// Failures are diagnosed by the tree-walking evaluator.
+constexpr int overflow(int n) { return n * 65536 * 65536; } // expected-note {{value 4294967296 is outside the range}}
+static_assert(overflow(1), ""); // expected-error {{constant expression}} expected-note {{in call to 'overflow(1)'}}
+
+constexpr int divide(int a, int b) { return a / b; } // expected-note {{division by zero}}
+static_assert(divide(1, 0), ""); // expected-error {{constant expression}} expected-note {{in call to 'divide(1, 0)'}}
+
+constexpr int shiftOut(int a, int b) { return a << b; } // expected-note {{shift count 40 >= width of type 'int' (32 bits)}}
+static_assert(shiftOut(1, 40), ""); // expected-error {{constant expression}} expected-note {{in call to 'shiftOut(1, 40)'}}
+
+constexpr int noReturn(int a) { if (a) return 1; } // expected-warning {{control may reach end of non-void function}} expected-note {{control reached end of constexpr function}}
+static_assert(noReturn(0), ""); // expected-error {{constant expression}} expected-note {{in call to 'noReturn(0)'}}
+
+int nonConstant = 1; // expected-note {{declared here}}
+constexpr int readGlobal(int a) { return a ? nonConstant : 0; } // expected-note {{read of non-const variable}}
+static_assert(readGlobal(0) == 0, "");
+static_assert(readGlobal(1), ""); // expected-error {{constant expression}} expected-note {{in call to 'readGlobal(1)'}}
@@ -0,0 +1,23 @@
+// RUN: %clang_cc1 -std=c++14 -fsyntax-only -verify %s -fconstexpr-steps 1000
+// RUN: %clang_cc1 -std=c++14 -fsyntax-only -verify %s -fconstexpr-steps 1000 -fexperimental-constexpr-interpreter
+// RUN: not %clang_cc1 -std=c++14 -fsyntax-only %s -fconstexpr-steps 1000 -print-stats 2>&1 | FileCheck %s
+
+// Calls to fib(12) take 930 steps. The second evaluation reuses the result of
+// the first, and the recursive calls of the first reuse each other's results.
+constexpr int fib(int n) { return n < 2 ? n : fib(n - 1) + fib(n - 2); }
+static_assert(fib(12) == 144, "");
+static_assert(fib(12) == 144, "");
+
+// A memoized result is still charged the steps of its evaluation.
+constexpr int steps(int n) { for (int i = 0; i < n; ++i) {} return n; } // expected-note {{step limit}}
+static_assert(steps(500) == 500, "");
+static_assert(steps(500) + steps(500) == 1000, ""); // expected-error {{constant expression}} expected-note {{in call to 'steps(500)'}}
+
+// A call which overflows outside of a constant expression warns every time.
+constexpr int twice(int n) { return n * 2; } // expected-warning 2 {{overflow in expression; result is -2147483648 with type 'int'}}
+void overflows() {
+  (void)(twice(0x40000000) + 1);
+  (void)(twice(0x40000000) + 1);
+}
+
+// CHECK: {{[1-9][0-9]*}}/{{[0-9]+}} constexpr calls reused a memoized result, {{[1-9][0-9]*}} results memoized, 0 flushes
@@ -0,0 +1,36 @@
+// RUN: %clang_cc1 -std=c++11 -fsyntax-only -print-template-profile %s 2>&1 | FileCheck %s
+// RUN: %clang_cc1 -std=c++11 -fsyntax-only -template-profile-json=%t.json %s
+// RUN: FileCheck --check-prefix=JSON %s < %t.json
+
+namespace ns {
+template <int N> struct Fib {
+  static const int value = Fib<N - 1>::value + Fib<N - 2>::value;
+};
+template <> struct Fib<1> { static const int value = 1; };
+template <> struct Fib<0> { static const int value = 0; };
+}
+
+// Fib<10> instantiates Fib<9> down to Fib<2> in turn.
+int fib = ns::Fib<10>::value;
+
+template <typename T> T twice(T t) { return t + t; }
+int two = twice(1) + twice(1.0);
+
+template <typename T> struct Box {
+  T get() { return T(); }
+};
+int box = Box<int>().get();
+
+// CHECK: *** Template instantiation profile:
+// CHECK-NEXT: Total (ms)   Self (ms)    Count   Nested    AST bytes  Template
+// CHECK-DAG: {{^ +[0-9.]+ +[0-9.]+ +9 +8 +[1-9][0-9]*  ns::Fib$}}
+// CHECK-DAG: {{^ +[0-9.]+ +[0-9.]+ +2 +0 +[0-9]+  twice$}}
+// CHECK-DAG: {{^ +[0-9.]+ +[0-9.]+ +1 +0 +[0-9]+  Box$}}
+// CHECK-DAG: {{^ +[0-9.]+ +[0-9.]+ +1 +0 +[0-9]+  Box::get$}}
+
+// JSON: {"templates":[
+// JSON-DAG: {"name":"ns::Fib","count":9,"nested":8,"bytes":{{[1-9][0-9]*}},"total_ms":{{[0-9.]+}},"self_ms":{{[0-9.]+}}}
+// JSON-DAG: {"name":"twice","count":2,"nested":0,
+// JSON-DAG: {"name":"Box","count":1,"nested":0,
+// JSON-DAG: {"name":"Box::get","count":1,"nested":0,
+// JSON: ]}
@@ -0,0 +1,43 @@
+// RUN: %clang_cc1 -std=c++14 -fsyntax-only -verify %s
+// expected-no-diagnostics
+
+// Enough specializations of each template, with long argument packs, that
+// their sets grow several times; each must still be found again afterwards.
+
+template <int... Ns> struct list {};
+
+template <int N, int... Ns> struct make : make<N - 1, N, Ns...> {};
+template <int... Ns> struct make<0, Ns...> { typedef list<0, Ns...> type; };
+
+template <typename T, typename U> struct is_same {
+  static const bool value = false;
+};
+template <typename T> struct is_same<T, T> {
+  static const bool value = true;
+};
+
+template <int N> using make_t = typename make<N>::type;
+
+template <int N> struct check {
+  static_assert(is_same<make_t<N>, typename make<N>::type>::value, "");
+  static_assert(!is_same<make_t<N>, make_t<N + 1>>::value, "");
+  static const bool value = check<N - 1>::value;
+};
+template <> struct check<0> { static const bool value = true; };
+
+static_assert(check<100>::value, "");
+
+template <int... Ns> constexpr int sum(list<Ns...>) {
+  int Values[] = {Ns...};
+  int S = 0;
+  for (int N : Values)
+    S += N;
+  return S;
+}
+static_assert(sum(make_t<150>()) == 150 * 151 / 2, "");
+static_assert(sum(make_t<150>()) == sum(typename make<150>::type()), "");
+
+template <typename... Ts> constexpr int count = sizeof...(Ts);
+template <int... Ns> constexpr int count<list<Ns...>> = sizeof...(Ns);
+static_assert(count<make_t<100>> == 101, "");
+static_assert(count<make_t<100>, make_t<99>> == 2, "");
@@ -80,6 +80,13 @@ static cl::opt<bool> FixWhatYouCan(
     cl::desc(Options->getOptionHelpText(options::OPT_fix_what_you_can)),
     cl::cat(ClangCheckCategory));
 
+static cl::opt<unsigned> NumThreads(
+    "j",
+    cl::desc("Number of translation units to check in parallel (0 = one per "
+             "hardware thread). Only used when checking syntax or running "
+             "the analyzer."),
+    cl::init(1), cl::cat(ClangCheckCategory));
+
 namespace {
 
 // FIXME: Move FixItRewriteInPlace from lib/Rewrite/Frontend/FrontendActions.cpp
@@ -182,5 +189,15 @@ int main(int argc, const char **argv) {
   else
     FrontendFactory = newFrontendActionFactory(&CheckFactory);
 
+  // -fixit rewrites shared files in place and the AST printers write to
+  // stdout, so only plain checking is safe to spread across threads.
+  if (!Fixit && !ASTList && !ASTDump && !ASTPrint)
+    Tool.setNumThreads(NumThreads);
+
+  // Share header stats and contents between translation units, unless
+  // -fixit may change the files underneath us.
+  if (!Fixit)
+    Tool.setFileSystemCache(new clang::vfs::SharedFileSystemCache);
+
   return Tool.run(FrontendFactory.get());
 }
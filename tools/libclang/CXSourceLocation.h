@@ -19,6 +19,12 @@
 #include "clang/Basic/LangOptions.h"
 #include "clang/Basic/SourceLocation.h"
 
+// CXSourceLocation and CXToken keep raw source location encodings in unsigned
+// fields, which is part of the stable C API.
+#ifdef CLANG_ENABLE_64_BIT_SOURCE_LOCATIONS
+#error "libclang cannot be built with 64-bit source locations"
+#endif
+
 namespace clang {
 
 class SourceManager;
@@ -15,6 +15,7 @@
 #include "llvm/ADT/Triple.h"
 #include "llvm/Support/Host.h"
 #include "gtest/gtest.h"
+#include <thread>
 
 namespace clang {
 namespace ast_matchers {
@@ -5250,6 +5251,139 @@ TEST(MatchFinder, CheckProfiling) {
   EXPECT_EQ("MyID", Records.begin()->getKey());
 }
 
+TEST(MatchFinder, IndexesMatchersByName) {
+  struct RecordMatches : public MatchFinder::MatchCallback {
+    RecordMatches(std::string ID, std::vector<std::string> &Matches)
+        : ID(std::move(ID)), Matches(Matches) {}
+    void run(const MatchFinder::MatchResult &Result) override {
+      Matches.push_back(
+          ID + ":" +
+          Result.Nodes.getNodeAs<NamedDecl>("decl")->getNameAsString());
+    }
+    std::string ID;
+    std::vector<std::string> &Matches;
+  };
+  std::vector<std::string> Matches;
+  RecordMatches Named("named", Matches), Any("any", Matches),
+      AnyOf("anyOf", Matches), Ctor("ctor", Matches);
+  MatchFinder Finder;
+  Finder.addMatcher(functionDecl(hasName("::ns::f")).bind("decl"), &Named);
+  Finder.addMatcher(functionDecl(unless(hasName("f"))).bind("decl"), &Any);
+  Finder.addMatcher(
+      functionDecl(anyOf(hasName("f"), hasName("g"))).bind("decl"), &AnyOf);
+  Finder.addMatcher(cxxConstructorDecl(hasName("X")).bind("decl"), &Ctor);
+  std::unique_ptr<FrontendActionFactory> Factory(
+      newFrontendActionFactory(&Finder));
+  ASSERT_TRUE(tooling::runToolOnCode(
+      Factory->create(),
+      "namespace ns { void f(); void g(); struct X { X(); }; }"));
+  std::vector<std::string> Expected = {"named:f", "anyOf:f", "any:g",
+                                       "anyOf:g", "any:X", "ctor:X"};
+  EXPECT_EQ(Expected, Matches);
+}
+
+TEST(MatchFinder, BoundsMemoizationCache) {
+  struct CountMatches : public MatchFinder::MatchCallback {
+    CountMatches() : Count(0) {}
+    void run(const MatchFinder::MatchResult &Result) override { ++Count; }
+    unsigned Count;
+  };
+  std::string Code = "void f() {";
+  for (int I = 0; I < 200; ++I) {
+    std::string Var = "x" + std::to_string(I);
+    Code += "{ int " + Var + " = 0; { " + Var + " = " + Var + " + 1; } }";
+  }
+  Code += "}";
+  auto Matcher = declRefExpr(hasAncestor(functionDecl(hasName("f"))));
+
+  auto Run = [&](unsigned MaxEntries,
+                 MatchFinder::MatchFinderOptions::MemoizationStatistics &Stats) {
+    MatchFinder::MatchFinderOptions Options;
+    Options.MaxMemoizationEntries = MaxEntries;
+    Options.MemoizationStats = &Stats;
+    MatchFinder Finder(std::move(Options));
+    CountMatches Callback;
+    Finder.addMatcher(Matcher, &Callback);
+    std::unique_ptr<FrontendActionFactory> Factory(
+        newFrontendActionFactory(&Finder));
+    EXPECT_TRUE(tooling::runToolOnCode(Factory->create(), Code));
+    return Callback.Count;
+  };
+
+  MatchFinder::MatchFinderOptions::MemoizationStatistics Unbounded, Bounded;
+  EXPECT_EQ(400u, Run(1000000, Unbounded));
+  EXPECT_EQ(400u, Run(16, Bounded));
+  EXPECT_EQ(0u, Unbounded.Evictions);
+  EXPECT_LT(0u, Unbounded.Hits);
+  EXPECT_LT(0u, Bounded.Evictions);
+  // Siblings share their ancestors, which stay in the cache while their
+  // subtree is being matched.
+  EXPECT_LT(0u, Bounded.Hits);
+  EXPECT_GE(Unbounded.Hits, Bounded.Hits);
+}
+
+TEST(MatchFinder, MatchesInParallel) {
+  struct RecordNames : public MatchFinder::MatchCallback {
+    void run(const MatchFinder::MatchResult &Result) override {
+      Names.push_back(
+          Result.Nodes.getNodeAs<NamedDecl>("decl")->getNameAsString());
+    }
+    std::vector<std::string> Names;
+  };
+  std::string Code = "typedef int Int;";
+  for (int I = 0; I < 100; ++I)
+    Code += "void f" + std::to_string(I) + "() { Int x" + std::to_string(I) +
+            "; }";
+  auto Matcher = varDecl(hasType(typedefType())).bind("decl");
+
+  RecordNames Serial;
+  MatchFinder SerialFinder;
+  SerialFinder.addMatcher(Matcher, &Serial);
+  std::unique_ptr<FrontendActionFactory> SerialFactory(
+      newFrontendActionFactory(&SerialFinder));
+  ASSERT_TRUE(tooling::runToolOnCode(SerialFactory->create(), Code));
+  EXPECT_EQ(100u, Serial.Names.size());
+
+  MatchFinder::MatchFinderOptions Options;
+  Options.NumThreads = 4;
+  RecordNames Parallel;
+  MatchFinder ParallelFinder(std::move(Options));
+  ParallelFinder.addMatcher(Matcher, &Parallel);
+  std::unique_ptr<FrontendActionFactory> ParallelFactory(
+      newFrontendActionFactory(&ParallelFinder));
+  ASSERT_TRUE(tooling::runToolOnCode(ParallelFactory->create(), Code));
+  EXPECT_EQ(Serial.Names, Parallel.Names);
+}
+
+TEST(MatchFinder, RunsCallbacksOnCallingThreadInParallel) {
+  struct RecordThreads : public MatchFinder::MatchCallback {
+    void run(const MatchFinder::MatchResult &Result) override {
+      const auto *F = Result.Nodes.getNodeAs<FunctionDecl>("f");
+      if (Result.SourceManager->isInMainFile(F->getLocation()))
+        Threads.push_back(std::this_thread::get_id());
+    }
+    std::vector<std::thread::id> Threads;
+  } Callback;
+  MatchFinder::MatchFinderOptions Options;
+  Options.NumThreads = 4;
+  MatchFinder Finder(std::move(Options));
+  // These matchers query the SourceManager, the linkage and the constant
+  // evaluator, which all cache their results.
+  Finder.addMatcher(
+      functionDecl(isExpansionInMainFile(), isExternC(), isNoThrow()).bind("f"),
+      &Callback);
+  std::string Code;
+  for (int I = 0; I < 100; ++I)
+    Code += "extern \"C\" void f" + std::to_string(I) +
+            "() noexcept(sizeof(int) > 1);";
+  std::unique_ptr<FrontendActionFactory> Factory(
+      newFrontendActionFactory(&Finder));
+  ASSERT_TRUE(tooling::runToolOnCode(Factory->create(), Code));
+  ASSERT_EQ(100u, Callback.Threads.size());
+  for (std::thread::id Thread : Callback.Threads)
+    EXPECT_EQ(std::this_thread::get_id(), Thread);
+}
+
 class VerifyStartOfTranslationUnit : public MatchFinder::MatchCallback {
 public:
   VerifyStartOfTranslationUnit() : Called(false) {}
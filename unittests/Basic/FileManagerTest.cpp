@@ -12,6 +12,9 @@
 #include "clang/Basic/FileSystemStatCache.h"
 #include "llvm/ADT/STLExtras.h"
 #include "llvm/Config/llvm-config.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/raw_ostream.h"
 #include "gtest/gtest.h"
 
 using namespace llvm;
@@ -237,6 +240,116 @@ TEST_F(FileManagerTest, getFileReturnsSameFileEntryForAliasedVirtualFiles) {
   EXPECT_EQ(manager.getFile("abc/foo.cpp"), manager.getFile("abc/bar.cpp"));
 }
 
+// mayContainEntry() rules out the entries that are not in the directory
+// listing, ignoring case, and knows about virtual files.
+TEST_F(FileManagerTest, mayContainEntryUsesDirectoryListing) {
+  IntrusiveRefCntPtr<vfs::InMemoryFileSystem> FS(new vfs::InMemoryFileSystem);
+  FS->addFile("/abc/Foo.h", 0, llvm::MemoryBuffer::getMemBuffer(""));
+  FS->addFile("/abc/sub/bar.h", 0, llvm::MemoryBuffer::getMemBuffer(""));
+  FileManager fileMgr(options, FS);
+
+  const DirectoryEntry *dir = fileMgr.getDirectory("/abc");
+  ASSERT_TRUE(dir != nullptr);
+  EXPECT_TRUE(fileMgr.mayContainEntry(dir, "Foo.h"));
+  EXPECT_TRUE(fileMgr.mayContainEntry(dir, "foo.h"));
+  EXPECT_TRUE(fileMgr.mayContainEntry(dir, "sub"));
+  EXPECT_TRUE(fileMgr.mayContainEntry(dir, ".."));
+  EXPECT_FALSE(fileMgr.mayContainEntry(dir, "bar.h"));
+
+  fileMgr.getVirtualFile("/abc/virtual.h", 100, 0);
+  EXPECT_TRUE(fileMgr.mayContainEntry(dir, "virtual.h"));
+}
+
+// invalidateCache() forgets the listing of the file's directory, so that
+// entries created since it was read are found again.
+TEST_F(FileManagerTest, invalidateCacheForgetsDirectoryListing) {
+  IntrusiveRefCntPtr<vfs::InMemoryFileSystem> FS(new vfs::InMemoryFileSystem);
+  FS->addFile("/abc/foo.h", 0, llvm::MemoryBuffer::getMemBuffer(""));
+  FileManager fileMgr(options, FS);
+
+  const FileEntry *file = fileMgr.getFile("/abc/foo.h");
+  ASSERT_TRUE(file != nullptr);
+  const DirectoryEntry *dir = file->getDir();
+  EXPECT_FALSE(fileMgr.mayContainEntry(dir, "bar.h"));
+
+  FS->addFile("/abc/bar.h", 0, llvm::MemoryBuffer::getMemBuffer(""));
+  EXPECT_FALSE(fileMgr.mayContainEntry(dir, "bar.h"));
+  fileMgr.invalidateCache(file);
+  EXPECT_TRUE(fileMgr.mayContainEntry(dir, "bar.h"));
+}
+
+// getSharedBufferForFile() hands out buffers which stay valid after the
+// FileManager is gone.
+TEST_F(FileManagerTest, getSharedBufferForFileOutlivesFileManager) {
+  IntrusiveRefCntPtr<vfs::InMemoryFileSystem> FS(new vfs::InMemoryFileSystem);
+  FS->addFile("/abc/foo.h", 0, llvm::MemoryBuffer::getMemBuffer("int x;"));
+
+  std::unique_ptr<llvm::MemoryBuffer> First, Second, Volatile;
+  {
+    FileManager fileMgr(options, FS);
+    const FileEntry *file = fileMgr.getFile("/abc/foo.h");
+    ASSERT_TRUE(file != nullptr);
+
+    auto Buf = fileMgr.getSharedBufferForFile(file);
+    ASSERT_TRUE(bool(Buf));
+    First = std::move(*Buf);
+    Buf = fileMgr.getSharedBufferForFile(file);
+    ASSERT_TRUE(bool(Buf));
+    Second = std::move(*Buf);
+    Buf = fileMgr.getSharedBufferForFile(file, /*isVolatile=*/true);
+    ASSERT_TRUE(bool(Buf));
+    Volatile = std::move(*Buf);
+  }
+
+  EXPECT_EQ("int x;", First->getBuffer());
+  EXPECT_EQ("int x;", Second->getBuffer());
+  EXPECT_EQ("int x;", Volatile->getBuffer());
+}
+
+// getSharedBufferForFile() only shares the contents of a file while a buffer
+// still refers to them.
+TEST_F(FileManagerTest, getSharedBufferForFileReleasesContents) {
+  IntrusiveRefCntPtr<vfs::InMemoryFileSystem> FS(new vfs::InMemoryFileSystem);
+  FS->addFile("/abc/foo.h", 0, llvm::MemoryBuffer::getMemBuffer("int x;"));
+  FileManager fileMgr(options, FS);
+  const FileEntry *file = fileMgr.getFile("/abc/foo.h");
+  ASSERT_TRUE(file != nullptr);
+
+  auto First = fileMgr.getSharedBufferForFile(file);
+  ASSERT_TRUE(bool(First));
+  auto Second = fileMgr.getSharedBufferForFile(file);
+  ASSERT_TRUE(bool(Second));
+  EXPECT_EQ((*First)->getBufferStart(), (*Second)->getBufferStart());
+
+  First->reset();
+  Second->reset();
+  auto Third = fileMgr.getSharedBufferForFile(file);
+  ASSERT_TRUE(bool(Third));
+  EXPECT_EQ("int x;", (*Third)->getBuffer());
+}
+
+// With MapSharedFiles, getSharedBufferForFile() maps even small real files.
+TEST_F(FileManagerTest, getSharedBufferForFileMapsSmallFiles) {
+  int FD;
+  SmallString<64> Path;
+  ASSERT_FALSE(llvm::sys::fs::createTemporaryFile("shared", "h", FD, Path));
+  {
+    llvm::raw_fd_ostream OS(FD, /*shouldClose=*/true);
+    OS << "int x;";
+  }
+
+  options.MapSharedFiles = true;
+  FileManager fileMgr(options);
+  const FileEntry *file = fileMgr.getFile(Path);
+  ASSERT_TRUE(file != nullptr);
+  auto Buf = fileMgr.getSharedBufferForFile(file);
+  ASSERT_TRUE(bool(Buf));
+  EXPECT_EQ(llvm::MemoryBuffer::MemoryBuffer_MMap, (*Buf)->getBufferKind());
+  EXPECT_EQ("int x;", (*Buf)->getBuffer());
+  Buf->reset();
+  llvm::sys::fs::remove(Path);
+}
+
 TEST_F(FileManagerTest, addRemoveStatCache) {
   manager.addStatCache(llvm::make_unique<FakeStatCache>());
   auto statCacheOwner = llvm::make_unique<FakeStatCache>();
@@ -246,6 +359,22 @@ TEST_F(FileManagerTest, addRemoveStatCache) {
   manager.removeStatCache(statCache);
 }
 
+// makeAbsolutePath() resolves relative paths against the working directory of
+// the file system, not the one of the process.
+TEST_F(FileManagerTest, makeAbsolutePathUsesVFSWorkingDirectory) {
+  IntrusiveRefCntPtr<vfs::InMemoryFileSystem> FS(new vfs::InMemoryFileSystem);
+  FS->setCurrentWorkingDirectory("/build");
+  FileManager fileMgr(options, FS);
+
+  SmallString<64> Path("foo.h");
+  EXPECT_TRUE(fileMgr.makeAbsolutePath(Path));
+  EXPECT_EQ("/build/foo.h", Path.str());
+
+  Path = "/abc/foo.h";
+  EXPECT_FALSE(fileMgr.makeAbsolutePath(Path));
+  EXPECT_EQ("/abc/foo.h", Path.str());
+}
+
 #endif  // !LLVM_ON_WIN32
 
 } // anonymous namespace
@@ -171,6 +171,56 @@ TEST_F(SourceManagerTest, getColumnNumber) {
   EXPECT_EQ(1U, SourceMgr.getColumnNumber(MainFileID, 0, nullptr));
 }
 
+TEST_F(SourceManagerTest, prefetchLineTable) {
+  std::string Source;
+  for (unsigned I = 0; I != 1000; ++I)
+    Source += I % 3 ? "int x;\n" : "\r\n";
+
+  std::unique_ptr<llvm::MemoryBuffer> Buf =
+      llvm::MemoryBuffer::getMemBuffer(Source);
+  FileID MainFileID = SourceMgr.createFileID(std::move(Buf));
+  SourceMgr.setMainFileID(MainFileID);
+  SourceMgr.prefetchLineTable(MainFileID);
+
+  unsigned Line = 1;
+  for (unsigned Offset = 0; Offset != Source.size(); ++Offset) {
+    bool Invalid = false;
+    EXPECT_EQ(Line, SourceMgr.getLineNumber(MainFileID, Offset, &Invalid));
+    EXPECT_FALSE(Invalid);
+    if (Source[Offset] == '\n')
+      ++Line;
+  }
+}
+
+// Looks up the FileIDs of many locations spread over many SLocEntries, which
+// exercises the binary search of getFileIDLocal.
+TEST_F(SourceManagerTest, getFileIDWithManyEntries) {
+  std::unique_ptr<llvm::MemoryBuffer> Buf =
+      llvm::MemoryBuffer::getMemBuffer("int x;");
+  FileID MainFileID = SourceMgr.createFileID(std::move(Buf));
+  SourceMgr.setMainFileID(MainFileID);
+  SourceLocation FileLoc = SourceMgr.getLocForStartOfFile(MainFileID);
+
+  const unsigned NumExpansions = 100000;
+  std::vector<SourceLocation> Expansions;
+  for (unsigned I = 0; I != NumExpansions; ++I)
+    Expansions.push_back(
+        SourceMgr.createExpansionLoc(FileLoc, FileLoc, FileLoc, I % 7 + 1));
+
+  unsigned Seed = 1;
+  for (unsigned I = 0; I != 1000000; ++I) {
+    Seed = Seed * 1103515245 + 12345;
+    unsigned Index = (Seed >> 8) % NumExpansions;
+    unsigned Offset = (Seed >> 4) % (Index % 7 + 1);
+    SourceLocation Loc = Expansions[Index].getLocWithOffset(Offset);
+    std::pair<FileID, unsigned> Decomposed = SourceMgr.getDecomposedLoc(Loc);
+    // The expansions got the FileIDs following the one of the main file.
+    ASSERT_EQ(MainFileID.getHashValue() + 1 + Index,
+              Decomposed.first.getHashValue());
+    ASSERT_EQ(Offset, Decomposed.second);
+  }
+}
+
 #if defined(LLVM_ON_UNIX)
 
 TEST_F(SourceManagerTest, getMacroArgExpandedLocation) {
@@ -645,6 +645,41 @@ TEST_F(InMemoryFileSystemTest, WorkingDirectory) {
                       NormalizedFS.getCurrentWorkingDirectory().get()));
 }
 
+TEST(CachingFileSystemTest, SharesStatusAndContents) {
+  IntrusiveRefCntPtr<vfs::InMemoryFileSystem> Lower(
+      new vfs::InMemoryFileSystem);
+  Lower->addFile("/a/header.h", 0, MemoryBuffer::getMemBuffer("int x;"));
+  IntrusiveRefCntPtr<vfs::SharedFileSystemCache> Cache(
+      new vfs::SharedFileSystemCache);
+  vfs::CachingFileSystem FS1(Cache, Lower);
+  vfs::CachingFileSystem FS2(Cache, Lower);
+  FS2.setCurrentWorkingDirectory("/a");
+
+  auto Stat = FS1.status("/a/header.h");
+  ASSERT_FALSE(Stat.getError());
+  EXPECT_EQ(1u, Cache->getNumStatMisses());
+  Stat = FS2.status("header.h");
+  ASSERT_FALSE(Stat.getError());
+  EXPECT_EQ("header.h", Stat->getName());
+  EXPECT_EQ(1u, Cache->getNumStatHits());
+
+  // Missing files are remembered as well.
+  EXPECT_FALSE(FS1.status("/a/missing.h"));
+  EXPECT_FALSE(FS2.status("missing.h"));
+  EXPECT_EQ(2u, Cache->getNumStatHits());
+
+  // The first open goes to the file system, later ones share one buffer.
+  for (unsigned I = 0; I != 3; ++I) {
+    auto F = FS2.openFileForRead("header.h");
+    ASSERT_FALSE(F.getError());
+    auto Buf = (*F)->getBuffer("header.h");
+    ASSERT_FALSE(Buf.getError());
+    EXPECT_EQ("int x;", (*Buf)->getBuffer());
+  }
+  EXPECT_EQ(1u, Cache->getNumBufferHits());
+  EXPECT_EQ(6u, Cache->getNumBytesCached());
+}
+
 // NOTE: in the tests below, we use '//root/' as our root directory, since it is
 // a legal *absolute* path on Windows as well as *nix.
 class VFSFromYAMLTest : public ::testing::Test {
@@ -117,4 +117,42 @@ TEST(ToolChainTest, VFSGCCInstallationRelativeDir) {
             S);
 }
 
+// Relative paths in the cc1 command line are resolved against the working
+// directory of the driver's file system, not the one of the process.
+TEST(ToolChainTest, VFSWorkingDirectory) {
+  IntrusiveRefCntPtr<DiagnosticOptions> DiagOpts = new DiagnosticOptions();
+
+  IntrusiveRefCntPtr<DiagnosticIDs> DiagID(new DiagnosticIDs());
+  struct TestDiagnosticConsumer : public DiagnosticConsumer {};
+  DiagnosticsEngine Diags(DiagID, &*DiagOpts, new TestDiagnosticConsumer);
+  IntrusiveRefCntPtr<vfs::InMemoryFileSystem> InMemoryFileSystem(
+      new vfs::InMemoryFileSystem);
+  InMemoryFileSystem->setCurrentWorkingDirectory("/build");
+  InMemoryFileSystem->addFile("/build/foo.c", 0,
+                              llvm::MemoryBuffer::getMemBuffer("\n"));
+  Driver TheDriver("/bin/clang", "x86_64-linux-gnu", Diags,
+                   InMemoryFileSystem);
+  TheDriver.setCheckInputsExist(false);
+
+  std::unique_ptr<Compilation> C(TheDriver.BuildCompilation(
+      {"clang", "-g", "--coverage", "-c", "foo.c", "-o", "out/foo.o"}));
+  ASSERT_TRUE(C);
+  ASSERT_FALSE(C->getJobs().empty());
+
+  const llvm::opt::ArgStringList &Args = C->getJobs().begin()->getArguments();
+  auto getValue = [&](StringRef Flag) -> std::string {
+    for (size_t I = 0; I + 1 < Args.size(); ++I)
+      if (Flag == Args[I]) {
+        std::string Value = Args[I + 1];
+#if LLVM_ON_WIN32
+        std::replace(Value.begin(), Value.end(), '\\', '/');
+#endif
+        return Value;
+      }
+    return std::string();
+  };
+  EXPECT_EQ("/build", getValue("-fdebug-compilation-dir"));
+  EXPECT_EQ("/build/out/foo.o", getValue("-coverage-file"));
+}
+
 } // end anonymous namespace
@@ -20,7 +20,12 @@
 #include "clang/Lex/ModuleLoader.h"
 #include "clang/Lex/Preprocessor.h"
 #include "clang/Lex/PreprocessorOptions.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/Program.h"
+#include "llvm/Support/Timer.h"
+#include "llvm/Support/raw_ostream.h"
 #include "gtest/gtest.h"
+#include <cstdlib>
 
 using namespace clang;
 
@@ -358,4 +363,81 @@ TEST_F(LexerTest, LexAPI) {
   EXPECT_EQ("N", Lexer::getImmediateMacroName(idLoc4, SourceMgr, LangOpts));
 }
 
+TEST_F(LexerTest, LexLongRuns) {
+  std::vector<tok::TokenKind> ExpectedTokens;
+  ExpectedTokens.push_back(tok::identifier);
+  ExpectedTokens.push_back(tok::equal);
+  ExpectedTokens.push_back(tok::numeric_constant);
+  ExpectedTokens.push_back(tok::semi);
+  ExpectedTokens.push_back(tok::identifier);
+  ExpectedTokens.push_back(tok::semi);
+
+  // The whitespace, the identifier and the comment span several 16-byte
+  // chunks, and the comment is continued by an escaped newline.
+  std::string LongIdentifier =
+      std::string(37, 'a') + "_Z9" + std::string(20, 'B');
+  std::string Source = std::string(35, ' ') + LongIdentifier +
+                       std::string(18, '\t') + "= 1; // " +
+                       std::string(50, 'x') + "\\\n" + std::string(20, 'y') +
+                       "\r\n\f\v  \t b;" + std::string(40, ' ');
+  std::vector<Token> toks = CheckLex(Source, ExpectedTokens);
+
+  EXPECT_EQ(LongIdentifier.size(), toks[0].getLength());
+  EXPECT_TRUE(toks[1].hasLeadingSpace());
+  EXPECT_EQ(1u, toks[4].getLength());
+  EXPECT_TRUE(toks[4].isAtStartOfLine());
+}
+
+// Reports the raw lexing throughput in MB/s. The input is the files listed in
+// the CLANG_LEXER_BENCHMARK_FILES environment variable (e.g. large generated
+// headers), or else a synthetic header with long comments, indentation and
+// identifiers. Run it with --gtest_also_run_disabled_tests.
+TEST_F(LexerTest, DISABLED_RawLexThroughput) {
+  std::vector<std::string> Inputs;
+  if (const char *Files = ::getenv("CLANG_LEXER_BENCHMARK_FILES")) {
+    SmallVector<StringRef, 8> Paths;
+    StringRef(Files).split(Paths, llvm::sys::EnvPathSeparator, -1, false);
+    for (StringRef Path : Paths) {
+      auto Buf = llvm::MemoryBuffer::getFile(Path);
+      ASSERT_TRUE(bool(Buf)) << "cannot read " << Path.str();
+      Inputs.push_back((*Buf)->getBuffer());
+    }
+  } else {
+    std::string Header;
+    for (int I = 0; I < 20000; ++I) {
+      std::string N = std::to_string(I);
+      Header += "// Generated declaration number " + N +
+                " of the synthetic benchmark header.\n"
+                "struct generated_record_type_" + N + " {\n"
+                "    unsigned long long generated_field_member_" + N + ";\n"
+                "};\n\n";
+    }
+    Inputs.push_back(Header);
+  }
+
+  const unsigned Iterations = 10;
+  size_t Bytes = 0;
+  unsigned NumTokens = 0;
+  llvm::TimeRecord Start = llvm::TimeRecord::getCurrentTime(true);
+  for (unsigned I = 0; I != Iterations; ++I) {
+    for (const std::string &Input : Inputs) {
+      Lexer L(SourceLocation(), LangOpts, Input.c_str(), Input.c_str(),
+              Input.c_str() + Input.size());
+      Token Tok;
+      do {
+        L.LexFromRawLexer(Tok);
+        ++NumTokens;
+      } while (Tok.isNot(tok::eof));
+      Bytes += Input.size();
+    }
+  }
+  double Seconds = llvm::TimeRecord::getCurrentTime(false).getWallTime() -
+                   Start.getWallTime();
+
+  EXPECT_LT(0u, NumTokens);
+  llvm::outs() << "Lexed " << Bytes << " bytes (" << NumTokens
+               << " tokens) at " << (Seconds ? Bytes / Seconds / 1e6 : 0.0)
+               << " MB/s\n";
+}
+
 } // anonymous namespace
@@ -644,5 +644,51 @@ TEST_F(MergeReplacementsTest, OverlappingRanges) {
                       {{"", 0, 3, "cc"}, {"", 3, 3, "dd"}});
 }
 
+#ifndef LLVM_ON_WIN32
+namespace {
+/// Adds a replacement at the start of the main file of each translation unit.
+class AddReplacementAction : public ToolAction {
+  RefactoringTool &Tool;
+
+public:
+  explicit AddReplacementAction(RefactoringTool &Tool) : Tool(Tool) {}
+
+  bool runInvocation(CompilerInvocation *Invocation, FileManager *Files,
+                     std::shared_ptr<PCHContainerOperations> PCHContainerOps,
+                     DiagnosticConsumer *DiagConsumer) override {
+    Replacements Replaces;
+    Replaces.insert(Replacement(
+        Invocation->getFrontendOpts().Inputs[0].getFile(), 0, 0, "// x\n"));
+    Tool.addReplacements(Replaces);
+    return true;
+  }
+};
+} // end anonymous namespace
+
+// Replacements added by concurrent translation units are all kept, and the
+// result is the same as that of a serial run.
+TEST(RefactoringTool, AddReplacementsInParallel) {
+  FixedCompilationDatabase Compilations("/", std::vector<std::string>());
+  std::vector<std::string> Sources;
+  for (unsigned I = 0; I != 8; ++I)
+    Sources.push_back("/f" + std::to_string(I) + ".cc");
+
+  RefactoringTool SerialTool(Compilations, Sources);
+  RefactoringTool ParallelTool(Compilations, Sources);
+  ParallelTool.setNumThreads(4);
+  for (const std::string &Source : Sources) {
+    SerialTool.mapVirtualFile(Source, "int x;");
+    ParallelTool.mapVirtualFile(Source, "int x;");
+  }
+  AddReplacementAction SerialAction(SerialTool);
+  AddReplacementAction ParallelAction(ParallelTool);
+  EXPECT_EQ(0, SerialTool.run(&SerialAction));
+  EXPECT_EQ(0, ParallelTool.run(&ParallelAction));
+
+  EXPECT_EQ(8u, ParallelTool.getReplacements().size());
+  EXPECT_TRUE(SerialTool.getReplacements() == ParallelTool.getReplacements());
+}
+#endif
+
 } // end namespace tooling
 } // end namespace clang
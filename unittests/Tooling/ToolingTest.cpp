@@ -14,6 +14,7 @@
 #include "clang/Frontend/CompilerInstance.h"
 #include "clang/Frontend/FrontendAction.h"
 #include "clang/Frontend/FrontendActions.h"
+#include "clang/Frontend/TextDiagnosticPrinter.h"
 #include "clang/Tooling/CompilationDatabase.h"
 #include "clang/Tooling/Tooling.h"
 #include "llvm/ADT/STLExtras.h"
@@ -405,13 +406,37 @@ TEST(ClangToolTest, BuildASTs) {
   EXPECT_EQ(2u, ASTs.size());
 }
 
+TEST(ClangToolTest, BuildASTsInParallel) {
+  FixedCompilationDatabase Compilations("/", std::vector<std::string>());
+
+  std::vector<std::string> Sources;
+  Sources.push_back("/b.cc");
+  Sources.push_back("/a.cc");
+  Sources.push_back("/c.cc");
+  ClangTool Tool(Compilations, Sources);
+  Tool.setNumThreads(3);
+
+  Tool.mapVirtualFile("/a.cc", "void a() {}");
+  Tool.mapVirtualFile("/b.cc", "void b() {}");
+  Tool.mapVirtualFile("/c.cc", "void c() {}");
+
+  std::vector<std::unique_ptr<ASTUnit>> ASTs;
+  EXPECT_EQ(0, Tool.buildASTs(ASTs));
+  ASSERT_EQ(3u, ASTs.size());
+  EXPECT_TRUE(ASTs[0]->getMainFileName().endswith("b.cc"));
+  EXPECT_TRUE(ASTs[1]->getMainFileName().endswith("a.cc"));
+  EXPECT_TRUE(ASTs[2]->getMainFileName().endswith("c.cc"));
+}
+
 struct TestDiagnosticConsumer : public DiagnosticConsumer {
-  TestDiagnosticConsumer() : NumDiagnosticsSeen(0) {}
+  TestDiagnosticConsumer() : NumDiagnosticsSeen(0), NumFinishes(0) {}
   void HandleDiagnostic(DiagnosticsEngine::Level DiagLevel,
                         const Diagnostic &Info) override {
     ++NumDiagnosticsSeen;
   }
+  void finish() override { ++NumFinishes; }
   unsigned NumDiagnosticsSeen;
+  unsigned NumFinishes;
 };
 
 TEST(ClangToolTest, InjectDiagnosticConsumer) {
@@ -426,6 +451,76 @@ TEST(ClangToolTest, InjectDiagnosticConsumer) {
   EXPECT_EQ(1u, Consumer.NumDiagnosticsSeen);
 }
 
+TEST(ClangToolTest, InjectDiagnosticConsumerInParallel) {
+  FixedCompilationDatabase Compilations("/", std::vector<std::string>());
+  std::vector<std::string> Sources;
+  Sources.push_back("/a.cc");
+  Sources.push_back("/b.cc");
+  ClangTool Tool(Compilations, Sources);
+  Tool.setNumThreads(2);
+  Tool.mapVirtualFile("/a.cc", "int x = undeclared;");
+  Tool.mapVirtualFile("/b.cc", "int y = undeclared;");
+  TestDiagnosticConsumer Consumer;
+  Tool.setDiagnosticConsumer(&Consumer);
+  std::unique_ptr<FrontendActionFactory> Action(
+      newFrontendActionFactory<SyntaxOnlyAction>());
+  EXPECT_EQ(1, Tool.run(Action.get()));
+  EXPECT_EQ(2u, Consumer.NumDiagnosticsSeen);
+}
+
+// The consumer is told to finish once per translation unit, whether they are
+// processed in parallel or not.
+TEST(ClangToolTest, FinishDiagnosticConsumerInParallel) {
+  FixedCompilationDatabase Compilations("/", std::vector<std::string>());
+  std::vector<std::string> Sources;
+  Sources.push_back("/a.cc");
+  Sources.push_back("/b.cc");
+  Sources.push_back("/c.cc");
+  for (unsigned NumThreads : {1u, 3u}) {
+    ClangTool Tool(Compilations, Sources);
+    Tool.setNumThreads(NumThreads);
+    for (const std::string &Source : Sources)
+      Tool.mapVirtualFile(Source, "int x;");
+    TestDiagnosticConsumer Consumer;
+    Tool.setDiagnosticConsumer(&Consumer);
+    std::unique_ptr<FrontendActionFactory> Action(
+        newFrontendActionFactory<SyntaxOnlyAction>());
+    EXPECT_EQ(0, Tool.run(Action.get()));
+    EXPECT_EQ(3u, Consumer.NumFinishes);
+  }
+}
+
+TEST(ClangToolTest, InjectTextDiagnosticPrinterInParallel) {
+  // One translation unit ending must not tear down the printer while another
+  // one is still printing its diagnostics.
+  FixedCompilationDatabase Compilations("/", std::vector<std::string>());
+  std::vector<std::string> Sources;
+  std::string Code;
+  for (unsigned I = 0; I != 10; ++I)
+    Code += "int x" + std::to_string(I) + " = undeclared;\n";
+  for (unsigned I = 0; I != 8; ++I)
+    Sources.push_back("/f" + std::to_string(I) + ".cc");
+  ClangTool Tool(Compilations, Sources);
+  Tool.setNumThreads(8);
+  for (const std::string &Source : Sources)
+    Tool.mapVirtualFile(Source, Code);
+  std::string Output;
+  llvm::raw_string_ostream OS(Output);
+  IntrusiveRefCntPtr<DiagnosticOptions> DiagOpts = new DiagnosticOptions();
+  TextDiagnosticPrinter Printer(OS, &*DiagOpts);
+  Tool.setDiagnosticConsumer(&Printer);
+  std::unique_ptr<FrontendActionFactory> Action(
+      newFrontendActionFactory<SyntaxOnlyAction>());
+  EXPECT_EQ(1, Tool.run(Action.get()));
+  OS.flush();
+  size_t NumErrors = 0;
+  for (size_t Pos = Output.find("error: use of undeclared identifier");
+       Pos != std::string::npos;
+       Pos = Output.find("error: use of undeclared identifier", Pos + 1))
+    ++NumErrors;
+  EXPECT_EQ(8u * 10u, NumErrors);
+}
+
 TEST(ClangToolTest, InjectDiagnosticConsumerInBuildASTs) {
   FixedCompilationDatabase Compilations("/", std::vector<std::string>());
   ClangTool Tool(Compilations, std::vector<std::string>(1, "/a.cc"));